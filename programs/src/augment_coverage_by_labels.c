@@ -137,14 +137,14 @@ int main(int argc, char *argv[]) {
     // add truth labels
     if (truthPath != NULL) {
         isLabelTruth = true;
-        stHash *blockTableTruth = ptBlock_parse_inference_label_blocks(truthPath, isLabelTruth);
+        stHash *blockTableTruth = ptBlock_parse_inference_label_blocks(truthPath, isLabelTruth, threads);
         // add truth labels to the block table
         ptBlock_extend_block_tables(blockTable, blockTableTruth);
     }
     // add prediction labels
     if (predictionPath != NULL) {
         isLabelTruth = false;
-        stHash *blockTablePrediction = ptBlock_parse_inference_label_blocks(predictionPath, isLabelTruth);
+        stHash *blockTablePrediction = ptBlock_parse_inference_label_blocks(predictionPath, isLabelTruth, threads);
         // add prediction labels to the block table
         ptBlock_extend_block_tables(blockTable, blockTablePrediction);
     }
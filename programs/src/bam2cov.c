@@ -147,9 +147,13 @@ int main(int argc, char *argv[]) {
                         "         -j, --annotationJson\n"
                         "                           Json file for the annotation bed files. At least one BED \n"
                         "                           file should be in this json and it can be a BED file \n"
-                        "                           covering the whole genome/assembly [maximum 58 bed files\n"
-                        "                           can be given and the keys can be any number between 1-58 \n"
-                        "                           for example {\"1\":\"/path/to/1.bed\", \"2\":\"/path/to/2.bed\"}]\n");
+                        "                           covering the whole genome/assembly [for example \n"
+                        "                           {\"1\":\"/path/to/1.bed\", \"2\":\"/path/to/2.bed\"}]. Up to 57 bed\n"
+                        "                           files are kept inline in the annotation flags and more bed files\n"
+                        "                           are supported with a small overhead.\n"
+                        "                           An index of the annotations is saved in <JSON_FILE>.index\n"
+                        "                           and it is reused by the next runs until the json or bed files\n"
+                        "                           change (it can also be created with index_annotations)\n");
                 fprintf(stderr,
                         "         -m, --mapqThreshold\n"
                         "                           Minimum mapq for the measuring the coverage of the alignments\n"
@@ -297,7 +301,8 @@ int main(int argc, char *argv[]) {
                                                  ctgToLen);
 
         BiasDetector_setStatisticsPerAnnotation(biasDetector,
-                                                blockTable);
+                                                blockTable,
+                                                threads);
 
         // make a file name for saving bias detection table
         char *prefix = copyString(outPath);
@@ -330,7 +335,7 @@ int main(int argc, char *argv[]) {
                                                             averageAlignmentLength,
                                                             startOnlyMode,
                                                             ctgToLen);
-        BiasDetector_setStatisticsPerAnnotation(biasDetector, blockTable);
+        BiasDetector_setStatisticsPerAnnotation(biasDetector, blockTable, threads);
 
         annotationToRegionMap = Int_construct1DArray(stList_length(annotationNames));
         coveragePerRegion = Int_construct1DArray(1);
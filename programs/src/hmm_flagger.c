@@ -1,4 +1,5 @@
 #include <time.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
@@ -12,6 +13,7 @@
 #include "common.h"
 #include "chunk.h"
 #include "summary_table.h"
+#include "bgzf.h"
 
 ChunksCreator *getChunksCreator(char *inputPath,
                                 int chunkCanonicalLen,
@@ -66,9 +68,8 @@ int getBestNumberOfCollapsedComps(ChunksCreator *chunksCreator) {
     return numberOfCollapsedComps;
 }
 
-double getRandomNumber(double start, double end) {
-    srand(time(NULL));
-    return (double) rand() / (double) (RAND_MAX / (end - start)) + start;
+double getRandomNumber(double start, double end, unsigned int *seedPtr) {
+    return (double) rand_r(seedPtr) / (double) (RAND_MAX / (end - start)) + start;
 }
 
 
@@ -124,7 +125,8 @@ HMM *createModel(ModelType modelType,
                  double maxHighMapqRatio,
                  double minHighMapqRatio,
                  int windowLen,
-                 double initialDeviation) {
+                 double initialDeviation,
+                 unsigned int *seedPtr) {
     // calculate initial mean coverages for all region classes
     int numberOfStates = 4; // Err, Dup, Hap, and Col
     int numberOfRegions = header->numberOfRegions;
@@ -167,12 +169,12 @@ HMM *createModel(ModelType modelType,
     }
     // ERR_COMP_BINDING_COEF is 0.1 (defined in hmm_utils.h)
     means[STATE_ERR][0] =
-            medianCoverage * ERR_COMP_BINDING_COEF * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation);
-    means[STATE_DUP][0] = medianCoverage * 0.5 * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation);
-    means[STATE_HAP][0] = medianCoverage * 1.0 * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation);
+            medianCoverage * ERR_COMP_BINDING_COEF * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation, seedPtr);
+    means[STATE_DUP][0] = medianCoverage * 0.5 * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation, seedPtr);
+    means[STATE_HAP][0] = medianCoverage * 1.0 * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation, seedPtr);
     for (int i = 0; i < numberOfCompsPerState[STATE_COL]; i++) {
         means[STATE_COL][i] =
-                means[STATE_HAP][0] * (i + 2) * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation);
+                means[STATE_HAP][0] * (i + 2) * getRandomNumber(1.0 - initialDeviation, 1.0 + initialDeviation, seedPtr);
     }
 
     double minHighlyClippedRatio = 1.0; // Msj is not supported now
@@ -193,103 +195,250 @@ HMM *createModel(ModelType modelType,
 }
 
 
-void writePosteriorIntoBED(ChunksCreator *chunksCreator, stList* emPerChunk, char *outputDir) {
+// Open a bgzf-compressed bed file for writing the posterior probabilities and the prediction per window
+BGZF *openPosteriorBED(HMM *model, char *outputDir) {
     char outputPath[1000];
-    sprintf(outputPath, "%s/posterior_prediction_final.bed", outputDir);
+    sprintf(outputPath, "%s/posterior_prediction_final.bed.gz", outputDir);
     fprintf(stderr, "[%s] Writing posterior bed : %s\n", get_timestamp(), outputPath);
-    // open file for writing bed
-    FILE *fout = fopen(outputPath, "w+");
+    BGZF *fout = bgzf_open(outputPath, "w");
     if (fout == NULL) {
         fprintf(stderr, "[%s] Error: %s cannot be opened.\n", get_timestamp(), outputPath);
         exit(EXIT_FAILURE);
     }
-
-    EM* em = stList_get(emPerChunk, 0);
-    HMM *model = em->model;
     // write header
-    fprintf(fout, "#ctg\tstart\tend\t");
+    char header[1000];
+    int len = sprintf(header, "#ctg\tstart\tend\t");
     for (int state = 0; state < model->numberOfStates; state++) {
         const char *stateName = EmissionDistSeries_getStateName(state);
-        fprintf(fout, "posterior_%s_%d\t", stateName, state);
+        len += sprintf(header + len, "posterior_%s_%d\t", stateName, state);
+    }
+    len += sprintf(header + len, "prediction\n");
+    if (bgzf_write(fout, header, len) < 0) {
+        fprintf(stderr, "[%s] Error: Failed to write into %s.\n", get_timestamp(), outputPath);
+        exit(EXIT_FAILURE);
     }
-    fprintf(fout, "prediction\n");
+    return fout;
+}
 
-    stList *chunks = chunksCreator->chunks;
-    int numberOfChunks = stList_length(chunks);
-    // iterate over chunks
-    for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
-        Chunk *chunk = stList_get(chunks, chunkIndex);
-        em = stList_get(emPerChunk, chunkIndex);
-        // iterate over windows
-        for(int i=0; i < chunk->coverageInfoSeqLen; i++){
-            int start = chunk->s + i * chunk->windowLen; //0-based inclusive
-            int end = min(chunk->s + (i + 1) * chunk->windowLen - 1, chunk->e); //0-based inclusive
-            fprintf(fout, "%s\t%d\t%d\t",chunk->ctg, start, end+1);
-            double *posterior = EM_getPosterior(em, i);
-            int prediction = EM_getMostProbableState(em, i);
-            for (int state = 0; state < model->numberOfStates; state++) {
-                fprintf(fout, "%.2f\t", posterior[state]);
-            }
-            fprintf(fout, "%s\n", EmissionDistSeries_getStateName(prediction));
-            free(posterior);
+// Write the posterior probabilities and the prediction of the windows of one chunk
+// (forward and backward matrices of its EM should be available)
+void writeChunkPosteriorIntoBED(BGZF *fout, Chunk *chunk, EM *em) {
+    HMM *model = em->model;
+    char line[2000];
+    // iterate over windows
+    for (int i = 0; i < chunk->coverageInfoSeqLen; i++) {
+        int start = chunk->s + i * chunk->windowLen; //0-based inclusive
+        int end = min(chunk->s + (i + 1) * chunk->windowLen - 1, chunk->e); //0-based inclusive
+        int len = snprintf(line, sizeof(line), "%s\t%d\t%d\t", chunk->ctg, start, end + 1);
+        double *posterior = EM_getPosterior(em, em->coreStart + i);
+        int prediction = Double_getArgMaxIndex1DArray(posterior, model->numberOfStates);
+        for (int state = 0; state < model->numberOfStates; state++) {
+            len += snprintf(line + len, sizeof(line) - len, "%.2f\t", posterior[state]);
+        }
+        len += snprintf(line + len, sizeof(line) - len, "%s\n", EmissionDistSeries_getStateName(prediction));
+        free(posterior);
+        if (bgzf_write(fout, line, len) < 0) {
+            fprintf(stderr, "[%s] Error: Failed to write the posteriors of the chunk %s:%d-%d.\n",
+                    get_timestamp(), chunk->ctg, chunk->s, chunk->e);
+            exit(EXIT_FAILURE);
         }
     }
-    fclose(fout);
 }
 
+void closePosteriorBED(BGZF *fout) {
+    if (bgzf_close(fout) != 0) {
+        fprintf(stderr, "[%s] Error: Failed to close the posterior bed file.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+}
 
-void runHMMFlagger(ChunksCreator *chunksCreator,
-                   HMM **modelPtr,
-                   int numberOfIterations,
-                   double convergenceTol,
-                   char *outputDir,
-                   int threads,
-                   bool writeParameterStatsPerIteration,
-                   bool writeBenchmarkingStatsPerIteration,
-                   bool writePosteriorProbs,
-                   stList *labelNamesWithUnknown,
-                   char *binArrayFilePath,
-                   double overlapRatioThreshold,
-                   bool acceleration) {
+// Free the forward and backward matrices of all EMs; they are allocated again by the next forward pass
+void releaseMatricesOfEMs(stList *emPerChunk) {
+    for (int chunkIndex = 0; chunkIndex < stList_length(emPerChunk); chunkIndex++) {
+        EM_releaseMatrices(stList_get(emPerChunk, chunkIndex));
+    }
+}
 
-    HMM *model = *modelPtr;
 
-    char loglikelihoodPath[2000];
-    sprintf(loglikelihoodPath, "%s/loglikelihood.tsv", outputDir);
-    fprintf(stderr, "[%s] Opening file for writing loglikelihood value per EM iteration...\n", get_timestamp());
-    FILE *loglikelihoodTsvFile = fopen(loglikelihoodPath, "w+");
-    // write header for loglikelihood tsv
-    fprintf(loglikelihoodTsvFile, "#Iteration\tEffective_Iteration\tLoglikelihood\n");
+// step size of mini-batch EM in the t-th mini-batch iteration (t starts from 0)
+// is (t + MINI_BATCH_STEP_DELAY)^(-MINI_BATCH_STEP_POWER)
+#define MINI_BATCH_STEP_DELAY 2.0
+#define MINI_BATCH_STEP_POWER 0.6
+// switch to full-batch EM once the parameter changes are below this factor times the convergence tolerance
+#define MINI_BATCH_SWITCH_TOL_FACTOR 10.0
+#define MINI_BATCH_SEED 1
+
+// select a random subset of EMs; the returned list does not own the EMs
+stList *getRandomSubsetOfEMs(stList *emList, double fraction, unsigned int *seedPtr) {
+    int numberOfEMs = stList_length(emList);
+    int subsetSize = (int) ceil(fraction * numberOfEMs);
+    subsetSize = subsetSize < 1 ? 1 : subsetSize;
+    stList *shuffled = stList_copy(emList, NULL);
+    // partial Fisher-Yates shuffle
+    for (int i = 0; i < subsetSize; i++) {
+        int j = i + rand_r(seedPtr) % (numberOfEMs - i);
+        void *temp = stList_get(shuffled, i);
+        stList_set(shuffled, i, stList_get(shuffled, j));
+        stList_set(shuffled, j, temp);
+    }
+    stList *subset = stList_construct3(0, NULL);
+    for (int i = 0; i < subsetSize; i++) {
+        stList_append(subset, stList_get(shuffled, i));
+    }
+    stList_destruct(shuffled);
+    return subset;
+}
 
-    char suffix[200];
-    stList *chunks = chunksCreator->chunks;
-    int numberOfChunks = stList_length(chunks);
+int64_t getTotalSeqLenOfEMs(stList *emList) {
+    int64_t totalSeqLen = 0;
+    for (int i = 0; i < stList_length(emList); i++) {
+        EM *em = stList_get(emList, i);
+        // flanks are counted in the adjacent chunks
+        totalSeqLen += em->coreEnd - em->coreStart;
+    }
+    return totalSeqLen;
+}
 
+// With adaptive freezing (--freezeTol) the loglikelihood tsv has extra columns with the per-chunk
+// convergence stats: the number of chunks that ran forward-backward or reused their cached statistics
+// and the largest changes of the chunk loglikelihoods (relative) and posteriors (mean total variation distance)
+void writeLoglikelihoodHeader(FILE *fout, bool addChunkStats) {
+    fprintf(fout, "#Iteration\tEffective_Iteration\tLoglikelihood");
+    if (addChunkStats) {
+        fprintf(fout, "\tRefreshed_Chunks\tFrozen_Chunks\tMax_Chunk_Loglikelihood_Change\tMax_Chunk_Posterior_Change");
+    }
+    fprintf(fout, "\n");
+}
 
-    fprintf(stderr, "[%s] Creating EM arrays (for %d chunks) ...\n",
-            get_timestamp(),
-            numberOfChunks);
+// chunk stats are written as NA if they are not available (mini-batch iterations)
+void writeLoglikelihoodRow(FILE *fout, int iteration, bool acceleration, double loglikelihood,
+                           stList *emPerChunk, bool chunkStatsAvailable) {
+    fprintf(fout, "%d\t%d\t%.4f", iteration, acceleration ? 3 * iteration : iteration, loglikelihood);
+    EM *firstEM = stList_get(emPerChunk, 0);
+    if (firstEM->freezingEnabled && chunkStatsAvailable) {
+        int numberOfRefreshedChunks = 0;
+        double maxLoglikelihoodChange = -1.0;
+        double maxPosteriorChange = -1.0;
+        for (int chunkIndex = 0; chunkIndex < stList_length(emPerChunk); chunkIndex++) {
+            EM *em = stList_get(emPerChunk, chunkIndex);
+            if (em->reusedCachedStats) continue;
+            numberOfRefreshedChunks += 1;
+            maxLoglikelihoodChange = fmax(maxLoglikelihoodChange, em->loglikelihoodChange);
+            maxPosteriorChange = fmax(maxPosteriorChange, em->posteriorChange);
+        }
+        fprintf(fout, "\t%d\t%d", numberOfRefreshedChunks, stList_length(emPerChunk) - numberOfRefreshedChunks);
+        if (0.0 <= maxLoglikelihoodChange) {
+            fprintf(fout, "\t%.3e\t%.3e", maxLoglikelihoodChange, maxPosteriorChange);
+        } else { // no chunk has been run twice yet
+            fprintf(fout, "\tNA\tNA");
+        }
+    } else if (firstEM->freezingEnabled) {
+        fprintf(fout, "\tNA\tNA\tNA\tNA");
+    }
+    fprintf(fout, "\n");
+}
 
+// EMs run on the chunks extended with flanking windows but only the windows
+// of each chunk contribute to the statistics and predictions
+stList *constructEMPerChunk(stList *flankedSeqs, HMM *model, EMPrecision precision) {
     stList *emPerChunk = stList_construct3(0, EM_destruct);
-    for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
-        Chunk *chunk = stList_get(chunks, chunkIndex);
-        EM *em = EM_construct(chunk->coverageInfoSeq, chunk->coverageInfoSeqLen, model);
+    for (int chunkIndex = 0; chunkIndex < stList_length(flankedSeqs); chunkIndex++) {
+        ChunkFlankedSeq *flankedSeq = stList_get(flankedSeqs, chunkIndex);
+        EM *em = EM_construct(flankedSeq->coverageInfoSeq, flankedSeq->coverageInfoSeqLen, model, precision);
+        EM_setCore(em, flankedSeq->coreStart, flankedSeq->coreEnd);
         stList_append(emPerChunk, em);
     }
+    return emPerChunk;
+}
 
-    // write initial parameter values in a tsv file
-    writeParameterStats(model, outputDir, "initial");
+// Run EM iterations on the given EMs until the parameters converge or numberOfIterations is reached.
+// The model is updated in place (SQUAREM copies the accelerated parameters into it).
+// With freezeTol > 0 a chunk whose loglikelihood and posteriors changed less than freezeTol in a full-batch
+// iteration reuses its cached sufficient statistics for the next freezeIterations iterations.
+// Returns the number of iterations that were run.
+int trainHMM(ChunksCreator *chunksCreator,
+             stList *emPerChunk,
+             HMM **modelPtr,
+             wstpool_t *threadPool,
+             int threads,
+             FILE *loglikelihoodTsvFile,
+             int numberOfIterations,
+             double convergenceTol,
+             char *outputDir,
+             bool writeParameterStatsPerIteration,
+             bool writeBenchmarkingStatsPerIteration,
+             stList *labelNamesWithUnknown,
+             char *binArrayFilePath,
+             double overlapRatioThreshold,
+             bool acceleration,
+             double miniBatchFraction,
+             int maxMiniBatchIterations,
+             double freezeTol,
+             int freezeIterations,
+             bool updatePredictions,
+             bool *convergedPtr) {
+
+    HMM *model = *modelPtr;
+    char suffix[200];
+    int numberOfChunks = stList_length(emPerChunk);
+
+    // In mini-batch mode each iteration runs EM on a random subset of chunks and
+    // the running sufficient statistics are updated with a decreasing step size
+    bool miniBatchMode = miniBatchFraction < 1.0;
+    int miniBatchIter = 0;
+    unsigned int miniBatchSeed = MINI_BATCH_SEED;
+    int64_t totalSeqLen = getTotalSeqLenOfEMs(emPerChunk);
+    HMM *runningEstimates = NULL;
+    if (miniBatchMode) {
+        runningEstimates = HMM_copy(model);
+        HMM_resetEstimators(runningEstimates);
+    }
+
+    bool freezing = 0.0 < freezeTol;
+    if (freezing) {
+        for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+            EM_enableFreezing(stList_get(emPerChunk, chunkIndex));
+        }
+    }
+
+    // model buffers of the accelerator are reused in all iterations
+    SquareAccelerator *accelerator = acceleration ? SquareAccelerator_construct() : NULL;
 
     int iter = 1;
     bool converged = false;
     while (iter <= numberOfIterations && converged == false) {
-        fprintf(stderr, "[%s] [Iteration %s = %d] Running EM jobs for %d chunks (with %d threads) ...\n",
-                get_timestamp(),
-                acceleration ? "accelerated" : "",
-                iter,
-                numberOfChunks,
-                threads);
-        EM_runOneIterationForList(emPerChunk, model, threads);
+        bool isMiniBatchIteration = miniBatchMode;
+        if (isMiniBatchIteration) {
+            stList *emBatch = getRandomSubsetOfEMs(emPerChunk, miniBatchFraction, &miniBatchSeed);
+            fprintf(stderr, "[%s] [Iteration %s = %d] Running mini-batch EM jobs for %ld of %d chunks (with %d threads) ...\n",
+                    get_timestamp(),
+                    acceleration ? "accelerated" : "",
+                    iter,
+                    stList_length(emBatch),
+                    numberOfChunks,
+                    threads);
+            EM_runOneIterationForList(emBatch, model, threadPool);
+            // scale the statistics of the batch to the whole genome
+            double batchScale = (double) totalSeqLen / getTotalSeqLenOfEMs(emBatch);
+            double stepSize = pow(miniBatchIter + MINI_BATCH_STEP_DELAY, -1 * MINI_BATCH_STEP_POWER);
+            // loglikelihood is also extrapolated to the whole genome
+            model->loglikelihood *= batchScale;
+            // running = (1 - stepSize) * running + stepSize * batchScale * batch
+            HMM_scaleEstimators(model, stepSize * batchScale);
+            HMM_scaleEstimators(runningEstimates, 1.0 - stepSize);
+            HMM_updateEstimatorsFromOtherModel(model, runningEstimates);
+            HMM_resetEstimators(runningEstimates);
+            HMM_updateEstimatorsFromOtherModel(runningEstimates, model);
+            stList_destruct(emBatch);
+        } else {
+            fprintf(stderr, "[%s] [Iteration %s = %d] Running EM jobs for %d chunks (with %d threads) ...\n",
+                    get_timestamp(),
+                    acceleration ? "accelerated" : "",
+                    iter,
+                    numberOfChunks,
+                    threads);
+            EM_runOneIterationForList(emPerChunk, model, threadPool);
+        }
 
 
         fprintf(stderr, "[%s] [Iteration %s = %d] EM jobs are all finished.\n",
@@ -297,16 +446,32 @@ void runHMMFlagger(ChunksCreator *chunksCreator,
                 acceleration ? "accelerated" : "",
                 iter);
 
+        int numberOfFrozenChunks = 0;
+        if (freezing && !isMiniBatchIteration) {
+            for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+                EM *em = stList_get(emPerChunk, chunkIndex);
+                numberOfFrozenChunks += em->reusedCachedStats ? 1 : 0;
+            }
+            fprintf(stderr, "[%s] [Iteration %s = %d] %d of %d chunks reused their cached statistics.\n",
+                    get_timestamp(),
+                    acceleration ? "accelerated" : "",
+                    iter,
+                    numberOfFrozenChunks,
+                    numberOfChunks);
+        }
+
         // chunks now definitely contain prediction labels
-        chunksCreator->header->isPredictionAvailable = true;
-        chunksCreator->header->numberOfLabels = 4;
+        if (updatePredictions) {
+            chunksCreator->header->isPredictionAvailable = true;
+            chunksCreator->header->numberOfLabels = 4;
+        }
 
         // save loglikelihood
-        fprintf(loglikelihoodTsvFile, "%d\t%d\t%.4f\n", iter - 1, acceleration ? 3 * (iter - 1) : iter - 1,
-                model->loglikelihood);
+        writeLoglikelihoodRow(loglikelihoodTsvFile, iter - 1, acceleration, model->loglikelihood, emPerChunk,
+                              !isMiniBatchIteration);
 
-        // write benchmarking stats
-        if (writeBenchmarkingStatsPerIteration || iter == 1) {
+        // write benchmarking stats (not for mini-batch iterations since only some chunks have updated labels)
+        if ((writeBenchmarkingStatsPerIteration || iter == 1) && !isMiniBatchIteration && updatePredictions) {
             if (iter == 1) {
                 strcpy(suffix, "initial");
             } else {
@@ -327,11 +492,11 @@ void runHMMFlagger(ChunksCreator *chunksCreator,
         }
 
         // if acceleration is true it will run two more EM update per iteration
-        if (acceleration) {
+        // (only for full-batch iterations)
+        if (acceleration && !isMiniBatchIteration) {
             fprintf(stderr, "[%s] [Iteration %s = %d] Running SQUAREM acceleration.\n", get_timestamp(),
                     acceleration ? "accelerated" : "",
                     iter);
-            SquareAccelerator *accelerator = SquareAccelerator_construct();
             // set model 0
             SquareAccelerator_setModel0(accelerator, model);
             // compute and set model 1
@@ -339,32 +504,57 @@ void runHMMFlagger(ChunksCreator *chunksCreator,
             SquareAccelerator_setModel1(accelerator, model);
             // compute and set model 2
             HMM_resetEstimators(model);
-            EM_runOneIterationForList(emPerChunk, model, threads);
+            EM_runOneIterationForList(emPerChunk, model, threadPool);
             HMM_estimateParameters(model, convergenceTol);
             SquareAccelerator_setModel2(accelerator, model);
             // get model prime and run an additional round of EM on it
-            HMM *modelPrime = SquareAccelerator_getModelPrime(accelerator, emPerChunk, threads);
-            // run EM on model prime
-            HMM_resetEstimators(modelPrime);
-            EM_runOneIterationForList(emPerChunk, modelPrime, threads);
-            // destruct old model and replace with a copy of the final model after acceleration
-            HMM_destruct(model);
-            model = HMM_copy(modelPrime);
-            *modelPtr = model;
-            // update model object in em objects
-            for (int chunkIndex = 0; chunkIndex < stList_length(emPerChunk); chunkIndex++) {
-                EM *em = stList_get(emPerChunk, chunkIndex);
-                EM_renewParametersAndEstimatorsFromModel(em, model);
-            }
-            // destruct accelerator
-            SquareAccelerator_destruct(accelerator);
+            // (parameters are copied into the model so no model is allocated per iteration)
+            HMM *modelPrime = SquareAccelerator_getModelPrime(accelerator, emPerChunk, threadPool);
+            HMM_copyParameters(model, modelPrime);
+            HMM_resetEstimators(model);
+            EM_runOneIterationForList(emPerChunk, model, threadPool);
             fprintf(stderr, "[%s] [Iteration %s = %d] Finished SQUAREM acceleration.\n", get_timestamp(),
                     acceleration ? "accelerated" : "",
                     iter);
         }
 
         // update parameters
-        converged = HMM_estimateParameters(model, convergenceTol);
+        if (isMiniBatchIteration) {
+            // stochastic updates are noisy so the looser tolerance is only used for switching to full-batch EM
+            miniBatchIter += 1;
+            bool nearConvergence = HMM_estimateParameters(model, MINI_BATCH_SWITCH_TOL_FACTOR * convergenceTol);
+            if (nearConvergence || maxMiniBatchIterations <= miniBatchIter) {
+                fprintf(stderr, "[%s] [Iteration %s = %d] Switching to full-batch EM after %d mini-batch iterations.\n",
+                        get_timestamp(),
+                        acceleration ? "accelerated" : "",
+                        iter,
+                        miniBatchIter);
+                miniBatchMode = false;
+            }
+        } else {
+            converged = HMM_estimateParameters(model, convergenceTol);
+            if (freezing && converged && 0 < numberOfFrozenChunks) {
+                // statistics of the frozen chunks are stale so convergence is checked again after refreshing all chunks
+                fprintf(stderr, "[%s] [Iteration %s = %d] Parameters converged with %d frozen chunks; all chunks will be refreshed.\n",
+                        get_timestamp(),
+                        acceleration ? "accelerated" : "",
+                        iter,
+                        numberOfFrozenChunks);
+                converged = false;
+                for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+                    EM_unfreeze(stList_get(emPerChunk, chunkIndex));
+                }
+            } else if (freezing) {
+                for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+                    EM *em = stList_get(emPerChunk, chunkIndex);
+                    if (em->reusedCachedStats == false &&
+                        0.0 <= em->loglikelihoodChange && em->loglikelihoodChange < freezeTol &&
+                        0.0 <= em->posteriorChange && em->posteriorChange < freezeTol) {
+                        EM_freeze(em, freezeIterations);
+                    }
+                }
+            }
+        }
         fprintf(stderr, "[%s] [Iteration %s = %d] Parameters are estimated and updated.\n",
                 get_timestamp(),
                 acceleration ? "accelerated" : "",
@@ -392,6 +582,7 @@ void runHMMFlagger(ChunksCreator *chunksCreator,
         iter += 1;
     }
 
+    *convergedPtr = converged;
     if (converged == true) {
         fprintf(stderr, "[%s] Parameters converged after %d iterations (tol=%.2e)\n",
                 get_timestamp(),
@@ -405,22 +596,133 @@ void runHMMFlagger(ChunksCreator *chunksCreator,
                 convergenceTol);
     }
 
-    fprintf(stderr, "[%s] [Final Inference] Running EM jobs for %d chunks (with %d threads) ...\n",
-            get_timestamp(),
-            numberOfChunks,
-            threads);
-    EM_runOneIterationForList(emPerChunk, model, threads);
-    fprintf(stderr, "[%s] [Final Inference] EM jobs are all finished.\n", get_timestamp());
+    // the final inference runs forward-backward on all chunks
+    for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+        EM_unfreeze(stList_get(emPerChunk, chunkIndex));
+    }
 
-    fprintf(loglikelihoodTsvFile, "%d\t%d\t%.4f\n", iter - 1, acceleration ? 3 * (iter - 1) : iter - 1,
-            model->loglikelihood);
+    if (accelerator != NULL) {
+        SquareAccelerator_destruct(accelerator);
+    }
+    if (runningEstimates != NULL) {
+        HMM_destruct(runningEstimates);
+    }
+    return iter - 1;
+}
 
+// A forward-backward job of decodeChunks; done is set (under mutex) once the posteriors are ready
+typedef struct DecodeJob {
+    work_arg_t arg;
+    bool done;
+    pthread_mutex_t *mutex;
+    pthread_cond_t *doneCond;
+} DecodeJob;
+
+void runDecodeJobForThreadPool(void *arg_) {
+    DecodeJob *job = arg_;
+    EM_runForwardBackwardAndUpdatePredictionsForThreadPool(&job->arg);
+    pthread_mutex_lock(job->mutex);
+    job->done = true;
+    pthread_cond_broadcast(job->doneCond);
+    pthread_mutex_unlock(job->mutex);
+}
 
+// Decode all chunks with the given model; prediction labels are saved in the chunks.
+// Posterior decoding keeps a sliding window of at most #threads chunks in flight in the order of the chunks
+// (sorted by contig); once the oldest chunk is finished its posteriors are written into posteriorBed (if it is
+// not NULL), its matrices are released and the next chunk is submitted. Therefore at most #threads chunks hold
+// their matrices at the same time and the posteriors are written in order
+void decodeChunks(ChunksCreator *chunksCreator,
+                  stList *emPerChunk,
+                  HMM *model,
+                  wstpool_t *threadPool,
+                  int threads,
+                  DecodeType decodeType,
+                  BGZF *posteriorBed) {
+    int numberOfChunks = stList_length(emPerChunk);
+    chunksCreator->header->isPredictionAvailable = true;
+    chunksCreator->header->numberOfLabels = 4;
+    // matrices of the training iterations are not needed anymore
+    releaseMatricesOfEMs(emPerChunk);
+
+    if (decodeType == DECODE_VITERBI) {
+        fprintf(stderr, "[%s] [Final Inference] Running Viterbi jobs for %d chunks (with %d threads) ...\n",
+                get_timestamp(),
+                numberOfChunks,
+                threads);
+        EM_runViterbiForList(emPerChunk, model, threadPool);
+        fprintf(stderr, "[%s] [Final Inference] Viterbi jobs are all finished.\n", get_timestamp());
+    } else {
+        fprintf(stderr, "[%s] [Final Inference] Running forward-backward jobs for %d chunks (at most %d in flight with %d threads) ...\n",
+                get_timestamp(),
+                numberOfChunks,
+                threads,
+                threads);
+        // the work-stealing pool only starts jobs in batches so a plain pool is used
+        // for submitting each chunk as soon as a slot in the window is free
+        tpool_t *decodePool = tpool_create(threads);
+        pthread_mutex_t mutex;
+        pthread_cond_t doneCond;
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&doneCond, NULL);
+        DecodeJob *jobs = malloc(numberOfChunks * sizeof(DecodeJob));
+        int nextChunkIndex = 0;
+        for (int oldestChunkIndex = 0; oldestChunkIndex < numberOfChunks; oldestChunkIndex++) {
+            for (; nextChunkIndex < min(oldestChunkIndex + threads, numberOfChunks); nextChunkIndex++) {
+                EM *em = stList_get(emPerChunk, nextChunkIndex);
+                EM_renewParametersAndEstimatorsFromModel(em, model);
+                // allocated here so the memory released by the finished chunks is reused
+                EM_allocateMatrices(em);
+                DecodeJob *job = &jobs[nextChunkIndex];
+                job->arg.data = (void *) em;
+                job->done = false;
+                job->mutex = &mutex;
+                job->doneCond = &doneCond;
+                tpool_add_work(decodePool, runDecodeJobForThreadPool, job);
+            }
+            pthread_mutex_lock(&mutex);
+            while (jobs[oldestChunkIndex].done == false) {
+                pthread_cond_wait(&doneCond, &mutex);
+            }
+            pthread_mutex_unlock(&mutex);
+            EM *em = stList_get(emPerChunk, oldestChunkIndex);
+            if (posteriorBed != NULL) {
+                writeChunkPosteriorIntoBED(posteriorBed, stList_get(chunksCreator->chunks, oldestChunkIndex), em);
+            }
+            EM_releaseMatrices(em);
+        }
+        tpool_wait(decodePool);
+        tpool_destroy(decodePool);
+        pthread_cond_destroy(&doneCond);
+        pthread_mutex_destroy(&mutex);
+        free(jobs);
+        model->loglikelihood = 0.0;
+        for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+            EM *em = stList_get(emPerChunk, chunkIndex);
+            model->loglikelihood += em->loglikelihood;
+        }
+        fprintf(stderr, "[%s] [Final Inference] Forward-backward jobs are all finished.\n", get_timestamp());
+    }
+}
+
+// Write the final parameters, model and benchmarking stats after decoding
+void writeFinalOutputs(ChunksCreator *chunksCreator,
+                       HMM *model,
+                       int threads,
+                       char *outputDir,
+                       stList *labelNamesWithUnknown,
+                       char *binArrayFilePath,
+                       double overlapRatioThreshold) {
+    char suffix[200];
     sprintf(suffix, "final");
     fprintf(stderr,
             "[%s] [Final Inference] Writing final parameter and benchmarking stats into tsv file.\n",
             get_timestamp());
     writeParameterStats(model, outputDir, suffix);
+    char modelPath[2000];
+    sprintf(modelPath, "%s/model_final.bin", outputDir);
+    fprintf(stderr, "[%s] [Final Inference] Saving final model into %s\n", get_timestamp(), modelPath);
+    HMM_writeIntoBinaryFile(model, modelPath);
     writeBenchmarkingStats(chunksCreator,
                            outputDir,
                            suffix,
@@ -428,13 +730,729 @@ void runHMMFlagger(ChunksCreator *chunksCreator,
                            binArrayFilePath,
                            overlapRatioThreshold,
                            threads);
-    if(writePosteriorProbs){
-        writePosteriorIntoBED(chunksCreator, emPerChunk, outputDir);
+}
+
+// Decode all chunks with the final model (prediction labels are saved in the chunks)
+// and write the final parameters, model and benchmarking stats (and posteriors if asked)
+void runFinalInference(ChunksCreator *chunksCreator,
+                       stList *emPerChunk,
+                       HMM *model,
+                       wstpool_t *threadPool,
+                       int threads,
+                       FILE *loglikelihoodTsvFile,
+                       int numberOfIterationsRun,
+                       char *outputDir,
+                       bool writePosteriorProbs,
+                       stList *labelNamesWithUnknown,
+                       char *binArrayFilePath,
+                       double overlapRatioThreshold,
+                       bool acceleration,
+                       DecodeType decodeType) {
+    BGZF *posteriorBed = writePosteriorProbs ? openPosteriorBED(model, outputDir) : NULL;
+    decodeChunks(chunksCreator, emPerChunk, model, threadPool, threads, decodeType, posteriorBed);
+    if (posteriorBed != NULL) {
+        closePosteriorBED(posteriorBed);
     }
+    // Viterbi does not compute the loglikelihood so no final row is added to the loglikelihood tsv
+    if (decodeType == DECODE_POSTERIOR) {
+        writeLoglikelihoodRow(loglikelihoodTsvFile, numberOfIterationsRun, acceleration, model->loglikelihood,
+                              emPerChunk, true);
+    }
+    writeFinalOutputs(chunksCreator,
+                      model,
+                      threads,
+                      outputDir,
+                      labelNamesWithUnknown,
+                      binArrayFilePath,
+                      overlapRatioThreshold);
+}
+
+void runHMMFlagger(ChunksCreator *chunksCreator,
+                   HMM **modelPtr,
+                   int numberOfIterations,
+                   double convergenceTol,
+                   char *outputDir,
+                   int threads,
+                   bool writeParameterStatsPerIteration,
+                   bool writeBenchmarkingStatsPerIteration,
+                   bool writePosteriorProbs,
+                   stList *labelNamesWithUnknown,
+                   char *binArrayFilePath,
+                   double overlapRatioThreshold,
+                   bool acceleration,
+                   DecodeType decodeType,
+                   double miniBatchFraction,
+                   int maxMiniBatchIterations,
+                   double freezeTol,
+                   int freezeIterations,
+                   int chunkFlankLen,
+                   EMPrecision precision) {
+
+    char loglikelihoodPath[2000];
+    sprintf(loglikelihoodPath, "%s/loglikelihood.tsv", outputDir);
+    fprintf(stderr, "[%s] Opening file for writing loglikelihood value per EM iteration...\n", get_timestamp());
+    FILE *loglikelihoodTsvFile = fopen(loglikelihoodPath, "w+");
+    // write header for loglikelihood tsv
+    writeLoglikelihoodHeader(loglikelihoodTsvFile, 0.0 < freezeTol);
+
+    int numberOfChunks = stList_length(chunksCreator->chunks);
+
+    fprintf(stderr, "[%s] Creating EM arrays (for %d chunks) ...\n",
+            get_timestamp(),
+            numberOfChunks);
+
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, chunkFlankLen);
+    stList *emPerChunk = constructEMPerChunk(flankedSeqs, *modelPtr, precision);
+
+    // one pool for the whole run; it is reused by all EM iterations and SQUAREM steps
+    wstpool_t *threadPool = wstpool_create(threads);
+
+    // write initial parameter values in a tsv file
+    writeParameterStats(*modelPtr, outputDir, "initial");
+
+    bool converged = false;
+    int numberOfIterationsRun = trainHMM(chunksCreator,
+                                         emPerChunk,
+                                         modelPtr,
+                                         threadPool,
+                                         threads,
+                                         loglikelihoodTsvFile,
+                                         numberOfIterations,
+                                         convergenceTol,
+                                         outputDir,
+                                         writeParameterStatsPerIteration,
+                                         writeBenchmarkingStatsPerIteration,
+                                         labelNamesWithUnknown,
+                                         binArrayFilePath,
+                                         overlapRatioThreshold,
+                                         acceleration,
+                                         miniBatchFraction,
+                                         maxMiniBatchIterations,
+                                         freezeTol,
+                                         freezeIterations,
+                                         true,
+                                         &converged);
+
+    runFinalInference(chunksCreator,
+                      emPerChunk,
+                      *modelPtr,
+                      threadPool,
+                      threads,
+                      loglikelihoodTsvFile,
+                      numberOfIterationsRun,
+                      outputDir,
+                      writePosteriorProbs,
+                      labelNamesWithUnknown,
+                      binArrayFilePath,
+                      overlapRatioThreshold,
+                      acceleration,
+                      decodeType);
+
+    wstpool_destroy(threadPool);
     stList_destruct(emPerChunk);
+    stList_destruct(flankedSeqs);
     fclose(loglikelihoodTsvFile);
 }
 
+// One of the models that are trained concurrently on the same chunks (--trainingRuns and --alphaGrid)
+typedef struct TrainingRun {
+    HMM *model;
+    char *name;
+    stList *emPerChunk; // EMs of this run; the coverage info sequences are shared
+    wstpool_t *threadPool;
+    int threads;
+    char outputDir[2000];
+    FILE *loglikelihoodTsvFile;
+    int numberOfIterationsRun;
+    bool converged;
+    double loglikelihood;
+    // options shared by all runs
+    ChunksCreator *chunksCreator;
+    int numberOfIterations;
+    double convergenceTol;
+    bool writeParameterStatsPerIteration;
+    bool acceleration;
+    double miniBatchFraction;
+    int maxMiniBatchIterations;
+    double freezeTol;
+    int freezeIterations;
+} TrainingRun;
+
+void *TrainingRun_train(void *arg_) {
+    TrainingRun *run = arg_;
+    // prediction labels are not updated while training since the chunks are shared with the other runs
+    run->numberOfIterationsRun = trainHMM(run->chunksCreator,
+                                          run->emPerChunk,
+                                          &run->model,
+                                          run->threadPool,
+                                          run->threads,
+                                          run->loglikelihoodTsvFile,
+                                          run->numberOfIterations,
+                                          run->convergenceTol,
+                                          run->outputDir,
+                                          run->writeParameterStatsPerIteration,
+                                          false,
+                                          NULL,
+                                          NULL,
+                                          0.0,
+                                          run->acceleration,
+                                          run->miniBatchFraction,
+                                          run->maxMiniBatchIterations,
+                                          run->freezeTol,
+                                          run->freezeIterations,
+                                          false,
+                                          &run->converged);
+    // score the trained model with one forward pass so the runs can be compared
+    EM_runForwardForList(run->emPerChunk, run->model, run->threadPool);
+    run->loglikelihood = run->model->loglikelihood;
+    return NULL;
+}
+
+void TrainingRun_setUpdatePredictions(TrainingRun *run, bool updatePredictions) {
+    for (int chunkIndex = 0; chunkIndex < stList_length(run->emPerChunk); chunkIndex++) {
+        EM *em = stList_get(run->emPerChunk, chunkIndex);
+        em->updatePredictions = updatePredictions;
+    }
+}
+
+// Make one training run per model. Outputs of each run are written into <outputDir>/<dirPrefix>_<index>
+TrainingRun *constructTrainingRuns(ChunksCreator *chunksCreator,
+                                   stList *models,
+                                   stList *runNames,
+                                   stList *flankedSeqs,
+                                   char *outputDir,
+                                   char *dirPrefix,
+                                   int threadsPerRun,
+                                   int numberOfIterations,
+                                   double convergenceTol,
+                                   bool writeParameterStatsPerIteration,
+                                   bool acceleration,
+                                   double miniBatchFraction,
+                                   int maxMiniBatchIterations,
+                                   double freezeTol,
+                                   int freezeIterations,
+                                   EMPrecision precision) {
+    int numberOfRuns = stList_length(models);
+    TrainingRun *runs = malloc(numberOfRuns * sizeof(TrainingRun));
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        TrainingRun *run = &runs[runIndex];
+        run->model = stList_get(models, runIndex);
+        run->name = stList_get(runNames, runIndex);
+        run->emPerChunk = constructEMPerChunk(flankedSeqs, run->model, precision);
+        TrainingRun_setUpdatePredictions(run, false);
+        run->threads = threadsPerRun;
+        run->threadPool = wstpool_create(threadsPerRun);
+        sprintf(run->outputDir, "%s/%s_%d", outputDir, dirPrefix, runIndex);
+        if (folder_exists(run->outputDir) == false && mkdir(run->outputDir, 0755) != 0) {
+            fprintf(stderr, "[%s] Error: Output directory %s cannot be created.\n", get_timestamp(),
+                    run->outputDir);
+            exit(EXIT_FAILURE);
+        }
+        char loglikelihoodPath[2000];
+        sprintf(loglikelihoodPath, "%s/loglikelihood.tsv", run->outputDir);
+        run->loglikelihoodTsvFile = fopen(loglikelihoodPath, "w+");
+        writeLoglikelihoodHeader(run->loglikelihoodTsvFile, 0.0 < freezeTol);
+        writeParameterStats(run->model, run->outputDir, "initial");
+        run->chunksCreator = chunksCreator;
+        run->numberOfIterations = numberOfIterations;
+        run->convergenceTol = convergenceTol;
+        run->writeParameterStatsPerIteration = writeParameterStatsPerIteration;
+        run->acceleration = acceleration;
+        run->miniBatchFraction = miniBatchFraction;
+        run->maxMiniBatchIterations = maxMiniBatchIterations;
+        run->freezeTol = freezeTol;
+        run->freezeIterations = freezeIterations;
+    }
+    return runs;
+}
+
+// Train all runs concurrently; each run has its own thread and thread pool
+void trainConcurrently(TrainingRun *runs, int numberOfRuns) {
+    fprintf(stderr, "[%s] Training %d models concurrently (with %d threads per model) ...\n",
+            get_timestamp(),
+            numberOfRuns,
+            runs[0].threads);
+    pthread_t *workers = malloc(numberOfRuns * sizeof(pthread_t));
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        if (pthread_create(&workers[runIndex], NULL, TrainingRun_train, &runs[runIndex]) != 0) {
+            fprintf(stderr, "[%s] Error: Failed to create a thread for training run %d.\n", get_timestamp(),
+                    runIndex);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        pthread_join(workers[runIndex], NULL);
+        wstpool_destroy(runs[runIndex].threadPool);
+    }
+    free(workers);
+}
+
+// Train the given models (all of the same type and from different initial means) concurrently on the
+// chunks that are parsed only once. The outputs of each run are written into <outputDir>/run_<index>
+// and the model with the highest loglikelihood is
+// returned (the other models are destructed). The chunks keep the predictions of the returned model.
+HMM *runHMMFlaggerMultiStart(ChunksCreator *chunksCreator,
+                             stList *models,
+                             int numberOfIterations,
+                             double convergenceTol,
+                             char *outputDir,
+                             int threads,
+                             bool writeParameterStatsPerIteration,
+                             bool writePosteriorProbs,
+                             stList *labelNamesWithUnknown,
+                             char *binArrayFilePath,
+                             double overlapRatioThreshold,
+                             bool acceleration,
+                             DecodeType decodeType,
+                             double miniBatchFraction,
+                             int maxMiniBatchIterations,
+                             double freezeTol,
+                             int freezeIterations,
+                             int chunkFlankLen,
+                             EMPrecision precision,
+                             char *trackName,
+                             int *minLenPerState) {
+    int numberOfRuns = stList_length(models);
+    int threadsPerRun = threads / numberOfRuns < 1 ? 1 : threads / numberOfRuns;
+    stList *runNames = stList_construct3(0, free);
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        char *runName = malloc(100);
+        sprintf(runName, "run_%d", runIndex);
+        stList_append(runNames, runName);
+    }
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, chunkFlankLen);
+    TrainingRun *runs = constructTrainingRuns(chunksCreator,
+                                              models,
+                                              runNames,
+                                              flankedSeqs,
+                                              outputDir,
+                                              "run",
+                                              threadsPerRun,
+                                              numberOfIterations,
+                                              convergenceTol,
+                                              writeParameterStatsPerIteration,
+                                              acceleration,
+                                              miniBatchFraction,
+                                              maxMiniBatchIterations,
+                                              freezeTol,
+                                              freezeIterations,
+                                              precision);
+    trainConcurrently(runs, numberOfRuns);
+    // runs are decoded one at a time so the matrices of all runs are released before decoding
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        releaseMatricesOfEMs(runs[runIndex].emPerChunk);
+    }
+
+    // the first run with the highest loglikelihood is selected
+    int bestRunIndex = 0;
+    for (int runIndex = 1; runIndex < numberOfRuns; runIndex++) {
+        if (runs[bestRunIndex].loglikelihood < runs[runIndex].loglikelihood) {
+            bestRunIndex = runIndex;
+        }
+    }
+    fprintf(stderr, "[%s] Training run %d (%s) has the highest loglikelihood (%.4f) and is selected.\n",
+            get_timestamp(),
+            bestRunIndex,
+            runs[bestRunIndex].name,
+            runs[bestRunIndex].loglikelihood);
+
+    // final inference runs one model at a time since predictions are saved in the chunks;
+    // the selected model goes last so its predictions remain
+    wstpool_t *threadPool = wstpool_create(threads);
+    for (int i = 0; i < numberOfRuns; i++) {
+        int runIndex = i < bestRunIndex ? i : (i == numberOfRuns - 1 ? bestRunIndex : i + 1);
+        TrainingRun *run = &runs[runIndex];
+        TrainingRun_setUpdatePredictions(run, true);
+        fprintf(stderr, "[%s] [Final Inference] Training run %d (%s) ...\n", get_timestamp(), runIndex,
+                run->name);
+        runFinalInference(chunksCreator,
+                          run->emPerChunk,
+                          run->model,
+                          threadPool,
+                          threads,
+                          run->loglikelihoodTsvFile,
+                          run->numberOfIterationsRun,
+                          run->outputDir,
+                          writePosteriorProbs,
+                          labelNamesWithUnknown,
+                          binArrayFilePath,
+                          overlapRatioThreshold,
+                          acceleration,
+                          decodeType);
+        char outputBEDPath[2000];
+        sprintf(outputBEDPath, "%s/final_flagger_prediction.bed", run->outputDir);
+        ChunksCreator_writePredictionIntoFinalBED(chunksCreator, outputBEDPath, trackName, minLenPerState);
+        fclose(run->loglikelihoodTsvFile);
+        stList_destruct(run->emPerChunk);
+    }
+    wstpool_destroy(threadPool);
+
+    char summaryPath[2000];
+    sprintf(summaryPath, "%s/training_runs.tsv", outputDir);
+    FILE *summaryTsvFile = fopen(summaryPath, "w+");
+    fprintf(summaryTsvFile, "#Run\tIterations\tConverged\tLoglikelihood\tSelected\n");
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        TrainingRun *run = &runs[runIndex];
+        fprintf(summaryTsvFile, "%d\t%d\t%s\t%.4f\t%s\n",
+                runIndex,
+                run->numberOfIterationsRun,
+                run->converged ? "true" : "false",
+                run->loglikelihood,
+                runIndex == bestRunIndex ? "true" : "false");
+    }
+    fclose(summaryTsvFile);
+
+    HMM *bestModel = runs[bestRunIndex].model;
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        if (runIndex != bestRunIndex) {
+            HMM_destruct(runs[runIndex].model);
+        }
+    }
+    char modelPath[2000];
+    sprintf(modelPath, "%s/model_final.bin", outputDir);
+    HMM_writeIntoBinaryFile(bestModel, modelPath);
+    free(runs);
+    stList_destruct(runNames);
+    stList_destruct(flankedSeqs);
+    return bestModel;
+}
+
+// Score the predictions saved in the chunks against the truth labels the same way as tune_alpha_hmm_flagger.py;
+// (overlap-based F1 + base-level F1 + 100 x auN ratio) / 3 for the given annotation and size bin, where the F1
+// scores are the harmonic means excluding Hap. The summary tables are only kept in memory. The three components
+// are saved in scores; undefined components are set to -1 and they add 0 to the final score
+double getAlphaTuningScore(ChunksCreator *chunksCreator,
+                           IntBinArray *binArray,
+                           stList *labelNamesWithUnknown,
+                           double overlapRatioThreshold,
+                           int threads,
+                           char *annotationName,
+                           char *sizeBinName,
+                           double *scores) {
+    void *iterator = (void *) ChunkIterator_construct(chunksCreator);
+    SummaryTableListFullCatalog *catalog = SummaryTableListFullCatalog_constructAndFillAllTables(iterator,
+                                                                                               ITERATOR_BY_CHUNK,
+                                                                                               chunksCreator->header,
+                                                                                               binArray,
+                                                                                               labelNamesWithUnknown,
+                                                                                               overlapRatioThreshold,
+                                                                                               threads);
+    ChunkIterator_destruct((ChunkIterator *) iterator);
+
+    scores[0] = SummaryTableListFullCatalog_getHarmonicMeanF1Score(catalog, CATEGORY_ANNOTATION, METRIC_OVERLAP_BASED,
+                                                                   annotationName, sizeBinName, true);
+    scores[1] = SummaryTableListFullCatalog_getHarmonicMeanF1Score(catalog, CATEGORY_ANNOTATION, METRIC_BASE_LEVEL,
+                                                                   annotationName, sizeBinName, true);
+    scores[2] = SummaryTableListFullCatalog_getAunRatioHarmonicMean(catalog, CATEGORY_ANNOTATION,
+                                                                    annotationName, sizeBinName);
+    SummaryTableListFullCatalog_destruct(catalog);
+
+    double score = 0.0;
+    score += 0.0 < scores[0] ? scores[0] : 0.0;
+    score += 0.0 < scores[1] ? scores[1] : 0.0;
+    score += 0.0 < scores[2] ? 100.0 * scores[2] : 0.0;
+    return score / 3.0;
+}
+
+void writeAlphaIntoTsv(MatrixDouble *alpha, char *alphaTsvPath) {
+    FILE *fout = fopen(alphaTsvPath, "w+");
+    if (fout == NULL) {
+        fprintf(stderr, "[%s] Error: %s cannot be opened for writing.\n", get_timestamp(), alphaTsvPath);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < alpha->dim1; i++) {
+        for (int j = 0; j < alpha->dim2; j++) {
+            fprintf(fout, j == alpha->dim2 - 1 ? "%.6f\n" : "%.6f\t", alpha->data[i][j]);
+        }
+    }
+    fclose(fout);
+}
+
+void writeScoreIntoTsv(FILE *fout, double score, char *end) {
+    if (score < 0.0) {
+        fprintf(fout, "NA%s", end);
+    } else {
+        fprintf(fout, "%.4f%s", score, end);
+    }
+}
+
+// Train the given models (one per alpha matrix in the grid) concurrently on the chunks that are parsed only once
+// and score the predictions of each model with getAlphaTuningScore. Outputs of each candidate are written into
+// <outputDir>/alpha_<index> and the scores into alpha_grid_scores.tsv. The model with the highest score is
+// returned (the other models are destructed) and the chunks keep its predictions.
+HMM *runHMMFlaggerAlphaGrid(ChunksCreator *chunksCreator,
+                            stList *models,
+                            int numberOfIterations,
+                            double convergenceTol,
+                            char *outputDir,
+                            int threads,
+                            bool writeParameterStatsPerIteration,
+                            bool writePosteriorProbs,
+                            stList *labelNamesWithUnknown,
+                            char *binArrayFilePath,
+                            double overlapRatioThreshold,
+                            bool acceleration,
+                            DecodeType decodeType,
+                            double miniBatchFraction,
+                            int maxMiniBatchIterations,
+                            double freezeTol,
+                            int freezeIterations,
+                            int chunkFlankLen,
+                            EMPrecision precision,
+                            char *scoreAnnotationName,
+                            char *scoreSizeBinName) {
+    int numberOfRuns = stList_length(models);
+    int threadsPerRun = threads / numberOfRuns < 1 ? 1 : threads / numberOfRuns;
+
+    IntBinArray *binArray;
+    if (binArrayFilePath != NULL) {
+        binArray = IntBinArray_constructFromFile(binArrayFilePath);
+    } else {
+        binArray = IntBinArray_constructSingleBin(0, 1e9, "ALL_SIZES");
+    }
+    // check the score category before spending time on training
+    bool annotationFound = false;
+    for (int i = 0; i < stList_length(chunksCreator->header->annotationNames); i++) {
+        if (strcmp(stList_get(chunksCreator->header->annotationNames, i), scoreAnnotationName) == 0) {
+            annotationFound = true;
+        }
+    }
+    bool sizeBinFound = false;
+    for (int i = 0; i < stList_length(binArray->names); i++) {
+        if (strcmp(stList_get(binArray->names, i), scoreSizeBinName) == 0) sizeBinFound = true;
+    }
+    if (annotationFound == false || sizeBinFound == false) {
+        fprintf(stderr, "[%s] Error: The annotation '%s' or the size bin '%s' for scoring alpha candidates does not exist.\n",
+                get_timestamp(),
+                scoreAnnotationName,
+                scoreSizeBinName);
+        exit(EXIT_FAILURE);
+    }
+
+    stList *runNames = stList_construct3(0, free);
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        char *runName = malloc(100);
+        sprintf(runName, "alpha_%d", runIndex);
+        stList_append(runNames, runName);
+    }
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, chunkFlankLen);
+    TrainingRun *runs = constructTrainingRuns(chunksCreator,
+                                              models,
+                                              runNames,
+                                              flankedSeqs,
+                                              outputDir,
+                                              "alpha",
+                                              threadsPerRun,
+                                              numberOfIterations,
+                                              convergenceTol,
+                                              writeParameterStatsPerIteration,
+                                              acceleration,
+                                              miniBatchFraction,
+                                              maxMiniBatchIterations,
+                                              freezeTol,
+                                              freezeIterations,
+                                              precision);
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        char alphaTsvPath[2000];
+        sprintf(alphaTsvPath, "%s/alpha.tsv", runs[runIndex].outputDir);
+        writeAlphaIntoTsv(runs[runIndex].model->alpha, alphaTsvPath);
+    }
+    trainConcurrently(runs, numberOfRuns);
+    // runs are decoded one at a time so the matrices of all runs are released before decoding
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        releaseMatricesOfEMs(runs[runIndex].emPerChunk);
+    }
+
+    // predictions are saved in the shared chunks so the candidates are decoded and scored one at a time
+    // (each one with all threads)
+    wstpool_t *threadPool = wstpool_create(threads);
+    double *scorePerRun = Double_construct1DArray(numberOfRuns);
+    double **componentsPerRun = Double_construct2DArray(numberOfRuns, 3);
+    int bestRunIndex = 0;
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        TrainingRun *run = &runs[runIndex];
+        TrainingRun_setUpdatePredictions(run, true);
+        fprintf(stderr, "[%s] [Alpha Grid] Scoring candidate %d ...\n", get_timestamp(), runIndex);
+        decodeChunks(chunksCreator, run->emPerChunk, run->model, threadPool, threads, decodeType, NULL);
+        if (decodeType == DECODE_POSTERIOR) {
+            writeLoglikelihoodRow(run->loglikelihoodTsvFile, run->numberOfIterationsRun, acceleration,
+                                  run->model->loglikelihood, run->emPerChunk, true);
+        }
+        writeParameterStats(run->model, run->outputDir, "final");
+        scorePerRun[runIndex] = getAlphaTuningScore(chunksCreator,
+                                                    binArray,
+                                                    labelNamesWithUnknown,
+                                                    overlapRatioThreshold,
+                                                    threads,
+                                                    scoreAnnotationName,
+                                                    scoreSizeBinName,
+                                                    componentsPerRun[runIndex]);
+        fprintf(stderr, "[%s] [Alpha Grid] Candidate %d has the score %.4f\n", get_timestamp(), runIndex,
+                scorePerRun[runIndex]);
+        if (scorePerRun[bestRunIndex] < scorePerRun[runIndex]) {
+            bestRunIndex = runIndex;
+        }
+    }
+    fprintf(stderr, "[%s] [Alpha Grid] Candidate %d has the highest score (%.4f) and is selected.\n",
+            get_timestamp(),
+            bestRunIndex,
+            scorePerRun[bestRunIndex]);
+
+    // decode the selected candidate again (unless it was the last one) so its predictions remain in the chunks;
+    // posteriors are written while decoding so it is decoded again if they are asked
+    TrainingRun *bestRun = &runs[bestRunIndex];
+    if (bestRunIndex != numberOfRuns - 1 || writePosteriorProbs) {
+        BGZF *posteriorBed = writePosteriorProbs ? openPosteriorBED(bestRun->model, bestRun->outputDir) : NULL;
+        decodeChunks(chunksCreator, bestRun->emPerChunk, bestRun->model, threadPool, threads, decodeType,
+                     posteriorBed);
+        if (posteriorBed != NULL) {
+            closePosteriorBED(posteriorBed);
+        }
+    }
+    wstpool_destroy(threadPool);
+    writeFinalOutputs(chunksCreator,
+                      bestRun->model,
+                      threads,
+                      bestRun->outputDir,
+                      labelNamesWithUnknown,
+                      binArrayFilePath,
+                      overlapRatioThreshold);
+
+    char scoresPath[2000];
+    sprintf(scoresPath, "%s/alpha_grid_scores.tsv", outputDir);
+    FILE *scoresTsvFile = fopen(scoresPath, "w+");
+    fprintf(scoresTsvFile,
+            "#Candidate\tIterations\tConverged\tLoglikelihood\tOverlap_Based_F1\tBase_Level_F1\tauN_Ratio\tScore\tSelected\n");
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        TrainingRun *run = &runs[runIndex];
+        fprintf(scoresTsvFile, "%d\t%d\t%s\t%.4f\t",
+                runIndex,
+                run->numberOfIterationsRun,
+                run->converged ? "true" : "false",
+                run->loglikelihood);
+        writeScoreIntoTsv(scoresTsvFile, componentsPerRun[runIndex][0], "\t");
+        writeScoreIntoTsv(scoresTsvFile, componentsPerRun[runIndex][1], "\t");
+        writeScoreIntoTsv(scoresTsvFile, componentsPerRun[runIndex][2], "\t");
+        fprintf(scoresTsvFile, "%.4f\t%s\n",
+                scorePerRun[runIndex],
+                runIndex == bestRunIndex ? "true" : "false");
+        fclose(run->loglikelihoodTsvFile);
+        stList_destruct(run->emPerChunk);
+    }
+    fclose(scoresTsvFile);
+
+    HMM *bestModel = bestRun->model;
+    for (int runIndex = 0; runIndex < numberOfRuns; runIndex++) {
+        if (runIndex != bestRunIndex) {
+            HMM_destruct(runs[runIndex].model);
+        }
+    }
+    char modelPath[2000];
+    sprintf(modelPath, "%s/model_final.bin", outputDir);
+    HMM_writeIntoBinaryFile(bestModel, modelPath);
+    free(runs);
+    free(scorePerRun);
+    Double_destruct2DArray(componentsPerRun, numberOfRuns);
+    stList_destruct(runNames);
+    stList_destruct(flankedSeqs);
+    IntBinArray_destruct(binArray);
+    return bestModel;
+}
+
+// Distributed EM: each shard process runs one E-step on its own chunks and saves the
+// sufficient statistics; the reducer sums them, runs the M-step and saves the next model
+void runEStepAndWriteSufficientStats(ChunksCreator *chunksCreator, HMM *model, int threads, char *statsPath,
+                                     int chunkFlankLen, EMPrecision precision) {
+    int numberOfChunks = stList_length(chunksCreator->chunks);
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, chunkFlankLen);
+    stList *emPerChunk = constructEMPerChunk(flankedSeqs, model, precision);
+    wstpool_t *threadPool = wstpool_create(threads);
+
+    fprintf(stderr, "[%s] [E-step] Running EM jobs for %d chunks (with %d threads) ...\n",
+            get_timestamp(),
+            numberOfChunks,
+            threads);
+    HMM_resetEstimators(model);
+    EM_runOneIterationForList(emPerChunk, model, threadPool);
+    fprintf(stderr, "[%s] [E-step] Writing sufficient statistics (loglikelihood = %.4f) into %s\n",
+            get_timestamp(),
+            model->loglikelihood,
+            statsPath);
+    HMM_writeSufficientStatsIntoBinaryFile(model, statsPath);
+
+    wstpool_destroy(threadPool);
+    stList_destruct(emPerChunk);
+    stList_destruct(flankedSeqs);
+}
+
+void reduceSufficientStats(stList *statsPaths, double convergenceTol, char *outputDir) {
+    if (stList_length(statsPaths) == 0) {
+        fprintf(stderr, "[%s] Error: The list of sufficient statistics files is empty.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    // the first file provides the model and the rest are added into it
+    char *firstPath = stList_get(statsPaths, 0);
+    fprintf(stderr, "[%s] [Reduce] Parsing sufficient statistics from %s\n", get_timestamp(), firstPath);
+    HMM *model = HMM_constructFromSufficientStatsBinaryFile(firstPath);
+    for (int i = 1; i < stList_length(statsPaths); i++) {
+        char *statsPath = stList_get(statsPaths, i);
+        fprintf(stderr, "[%s] [Reduce] Parsing sufficient statistics from %s\n", get_timestamp(), statsPath);
+        HMM *shardModel = HMM_constructFromSufficientStatsBinaryFile(statsPath);
+        if (!HMM_hasSameStructure(model, shardModel)) {
+            fprintf(stderr, "[%s] Error: The model in %s does not match the model in %s.\n",
+                    get_timestamp(),
+                    statsPath,
+                    firstPath);
+            exit(EXIT_FAILURE);
+        }
+        HMM_updateEstimatorsFromOtherModel(model, shardModel);
+        model->loglikelihood += shardModel->loglikelihood;
+        HMM_destruct(shardModel);
+    }
+
+    bool converged = HMM_estimateParameters(model, convergenceTol);
+    HMM_resetEstimators(model);
+    fprintf(stderr, "[%s] [Reduce] Parameters are estimated from %d shards (loglikelihood = %.4f, converged = %s).\n",
+            get_timestamp(),
+            stList_length(statsPaths),
+            model->loglikelihood,
+            converged ? "true" : "false");
+
+    char path[2000];
+    sprintf(path, "%s/model_final.bin", outputDir);
+    HMM_writeIntoBinaryFile(model, path);
+    writeParameterStats(model, outputDir, "reduced");
+
+    // the loglikelihood belongs to the model before this M-step
+    sprintf(path, "%s/loglikelihood.tsv", outputDir);
+    FILE *loglikelihoodTsvFile = fopen(path, "w+");
+    fprintf(loglikelihoodTsvFile, "#Loglikelihood\n%.4f\n", model->loglikelihood);
+    fclose(loglikelihoodTsvFile);
+
+    sprintf(path, "%s/converged.txt", outputDir);
+    FILE *convergedFile = fopen(path, "w+");
+    fprintf(convergedFile, "%s\n", converged ? "true" : "false");
+    fclose(convergedFile);
+
+    HMM_destruct(model);
+}
+
+// check all alpha values are between 0 and 1
+void checkAlphaMatrix(MatrixDouble *alpha, char *alphaSourcePath) {
+    for (int i = 0; i < alpha->dim1; i++) {
+        for (int j = 0; j < alpha->dim2; j++) {
+            if (1.0 < alpha->data[i][j] || alpha->data[i][j] < 0.0) {
+                fprintf(stderr, "[%s] Error: There is at least one alpha value in '%s' not between 0 and 1. \n%s\n",
+                        get_timestamp(),
+                        alphaSourcePath,
+                        MatrixDouble_toString(alpha)
+                );
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
 // input can be NULL
 MatrixDouble *getAlphaMatrix(char *alphaTsvPath) {
     if (alphaTsvPath == NULL) {
@@ -447,19 +1465,53 @@ MatrixDouble *getAlphaMatrix(char *alphaTsvPath) {
     // -1 because of ignoring MSJ
     MatrixDouble *alpha = MatrixDouble_parseFromFile(alphaTsvPath, NUMBER_OF_STATES - 1, NUMBER_OF_STATES - 1,
                                                      skipFirstLine);
-    // check all alpha values are between 0 and 1
-    for (int i = 0; i < alpha->dim1; i++) {
-        for (int j = 0; j < alpha->dim2; j++) {
-            if (1.0 < alpha->data[i][j] || alpha->data[i][j] < 0.0) {
-                fprintf(stderr, "[%s] Error: There is at least one alpha value in '%s' not between 0 and 1. \n%s\n",
-                        get_timestamp(),
-                        MatrixDouble_toString(alpha)
-                );
-                exit(EXIT_FAILURE);
+    checkAlphaMatrix(alpha, alphaTsvPath);
+    return alpha;
+}
+
+// Each line of the grid has the values of one alpha matrix separated by tabs (row by row, so
+// (#states - 1) x (#states - 1) values). Empty lines and lines starting with '#' are skipped
+stList *getAlphaMatricesFromGrid(char *alphaGridTsvPath) {
+    FILE *fp = fopen(alphaGridTsvPath, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "[%s] Error: %s cannot be opened.\n", get_timestamp(), alphaGridTsvPath);
+        exit(EXIT_FAILURE);
+    }
+    int dim = NUMBER_OF_STATES - 1; // -1 because of ignoring MSJ
+    stList *alphaMatrices = stList_construct3(0, MatrixDouble_destruct);
+    char *line = NULL;
+    size_t len = 0;
+    ssize_t read;
+    while ((read = getline(&line, &len, fp)) != -1) {
+        if (0 < read && line[read - 1] == '\n') line[read - 1] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+        int numberOfValues = 0;
+        double *values = Splitter_getDoubleArray(line, '\t', &numberOfValues);
+        if (numberOfValues != dim * dim) {
+            fprintf(stderr, "[%s] Error: Each line of the alpha grid '%s' should have %d tab-delimited values not %d.\n",
+                    get_timestamp(),
+                    alphaGridTsvPath,
+                    dim * dim,
+                    numberOfValues);
+            exit(EXIT_FAILURE);
+        }
+        MatrixDouble *alpha = MatrixDouble_construct0(dim, dim);
+        for (int i = 0; i < dim; i++) {
+            for (int j = 0; j < dim; j++) {
+                alpha->data[i][j] = values[i * dim + j];
             }
         }
+        free(values);
+        checkAlphaMatrix(alpha, alphaGridTsvPath);
+        stList_append(alphaMatrices, alpha);
     }
-    return alpha;
+    free(line);
+    fclose(fp);
+    if (stList_length(alphaMatrices) == 0) {
+        fprintf(stderr, "[%s] Error: The alpha grid '%s' is empty.\n", get_timestamp(), alphaGridTsvPath);
+        exit(EXIT_FAILURE);
+    }
+    return alphaMatrices;
 }
 
 
@@ -489,6 +1541,20 @@ static struct option long_options[] =
                 {"dumpBin",                            no_argument,       NULL, 'B'},
                 {"accelerate",                         no_argument,       NULL, 's'},
                 {"minimumLengths",                     required_argument, NULL, 'M'},
+                {"decode",                             required_argument, NULL, 'd'},
+                {"miniBatchFraction",                  required_argument, NULL, 'F'},
+                {"miniBatchIterations",                required_argument, NULL, 'I'},
+                {"loadModel",                          required_argument, NULL, 'L'},
+                {"chunkFlankLen",                      required_argument, NULL, 'f'},
+                {"initModel",                          required_argument, NULL, 'J'},
+                {"eStepOnly",                          required_argument, NULL, 'e'},
+                {"reduceStats",                        required_argument, NULL, 'r'},
+                {"trainingRuns",                       required_argument, NULL, 'T'},
+                {"alphaGrid",                          required_argument, NULL, 'g'},
+                {"alphaGridScoreCategory",             required_argument, NULL, 'G'},
+                {"freezeTol",                          required_argument, NULL, 'z'},
+                {"freezeIterations",                   required_argument, NULL, 'Z'},
+                {"precision",                          required_argument, NULL, 'R'},
                 {NULL,                                 0,                 NULL, 0}
         };
 
@@ -516,9 +1582,25 @@ int main(int argc, char *argv[]) {
     double initialRandomDeviation = 0.0;
     int chunkCanonicalLen = 20000000; //20Mb
     int windowLen = 4000;
+    int chunkFlankLen = 0;
     int threads = 4;
     bool dumpBin = false;
     bool acceleration = false;
+    DecodeType decodeType = DECODE_POSTERIOR;
+    double miniBatchFraction = 1.0;
+    int maxMiniBatchIterations = 20;
+    double freezeTol = 0.0;
+    int freezeIterations = 3;
+    EMPrecision precision = PRECISION_DOUBLE;
+    char *loadModelPath = NULL;
+    char *initModelPath = NULL;
+    char *eStepStatsPath = NULL;
+    char *reduceStatsListPath = NULL;
+    int numberOfTrainingRuns = 0;
+    char *alphaGridPath = NULL;
+    char *scoreAnnotationName = "whole_genome";
+    char *scoreSizeBinName = "ALL_SIZES";
+    stList *scoreCategoryNames = NULL;
     int *minLenPerState = malloc(4 * sizeof(int));
     minLenPerState[0] = 0;
     minLenPerState[1] = 0;
@@ -528,7 +1610,7 @@ int main(int argc, char *argv[]) {
     int *minLenPerStateTemp;
     char *program;
     (program = strrchr(argv[0], '/')) ? ++program : (program = argv[0]);
-    while (~(c = getopt_long(argc, argv, "i:n:t:m:q:C:W:c:@:p:A:a:wkPo:v:l:D:BN:M:s", long_options, NULL))) {
+    while (~(c = getopt_long(argc, argv, "i:n:t:m:q:C:W:c:@:p:A:a:wkPo:v:l:D:BN:M:sd:F:I:L:J:e:r:f:T:g:G:z:Z:R:", long_options, NULL))) {
         switch (c) {
             case 'i':
                 inputPath = optarg;
@@ -600,6 +1682,56 @@ int main(int argc, char *argv[]) {
             case 's':
                 acceleration = true;
                 break;
+            case 'd':
+                decodeType = getDecodeTypeFromString(optarg);
+                break;
+            case 'F':
+                miniBatchFraction = atof(optarg);
+                break;
+            case 'I':
+                maxMiniBatchIterations = atoi(optarg);
+                break;
+            case 'z':
+                freezeTol = atof(optarg);
+                break;
+            case 'Z':
+                freezeIterations = atoi(optarg);
+                break;
+            case 'R':
+                precision = getEMPrecisionFromString(optarg);
+                break;
+            case 'L':
+                loadModelPath = optarg;
+                break;
+            case 'T':
+                numberOfTrainingRuns = atoi(optarg);
+                break;
+            case 'g':
+                alphaGridPath = optarg;
+                break;
+            case 'G':
+                scoreCategoryNames = Splitter_getStringList(optarg, ',');
+                if (stList_length(scoreCategoryNames) != 2) {
+                    fprintf(stderr,
+                            "[%s] Error: --alphaGridScoreCategory should contain an annotation name and a size bin name separated by a comma.\n",
+                            get_timestamp());
+                    exit(EXIT_FAILURE);
+                }
+                scoreAnnotationName = stList_get(scoreCategoryNames, 0);
+                scoreSizeBinName = stList_get(scoreCategoryNames, 1);
+                break;
+            case 'f':
+                chunkFlankLen = atoi(optarg);
+                break;
+            case 'J':
+                initModelPath = optarg;
+                break;
+            case 'e':
+                eStepStatsPath = optarg;
+                break;
+            case 'r':
+                reduceStatsListPath = optarg;
+                break;
             case 'M':
                 minLenPerStateTemp = Splitter_getIntArray(optarg, ',', &arraySize);
                 if (arraySize != 3) {
@@ -629,6 +1761,34 @@ int main(int argc, char *argv[]) {
                         "         --modelType, -m\n"
                         "                           Model type can be either 'gaussian', 'negative_binomial', or \n"
                         "                           'trunc_exp_gaussian' [Default = 'trunc_exp_gaussian']\n");
+                fprintf(stderr,
+                        "         --trainingRuns, -T\n"
+                        "                           Number of models of the type given by --modelType that are trained \n"
+                        "                           from different initial means. The runs are trained concurrently on \n"
+                        "                           the chunks that are parsed only once and the model with the highest \n"
+                        "                           loglikelihood is used for the final BED. Outputs of each run are \n"
+                        "                           written into <outputDir>/run_<index> and a summary into \n"
+                        "                           training_runs.tsv . The initial means are drawn with \n"
+                        "                           --initialRandomDev so it should be greater than 0. \n"
+                        "                           [default: 0 (disabled)]\n");
+                fprintf(stderr,
+                        "         --alphaGrid, -g\n"
+                        "                           Path to a tsv file with one alpha matrix per line; the 16 values \n"
+                        "                           of each matrix are written row by row and separated by tabs. One \n"
+                        "                           model is trained per alpha concurrently on the chunks that are \n"
+                        "                           parsed only once and its predictions are scored against the truth \n"
+                        "                           labels (in the input coverage) like tune_alpha_hmm_flagger.py : \n"
+                        "                           (overlap-based F1 + base-level F1 + 100 x auN ratio) / 3 . \n"
+                        "                           The model with the highest score is used for the final BED. \n"
+                        "                           Outputs of each candidate are written into \n"
+                        "                           <outputDir>/alpha_<index> and the scores into \n"
+                        "                           alpha_grid_scores.tsv . --alphaTsv is not needed. \n"
+                        "                           [default: disabled]\n");
+                fprintf(stderr,
+                        "         --alphaGridScoreCategory, -G\n"
+                        "                           Comma-separated annotation name and size bin name whose benchmarking \n"
+                        "                           stats are used for scoring alpha candidates \n"
+                        "                           [default: 'whole_genome,ALL_SIZES']\n");
                 fprintf(stderr,
                         "         --trackName, -N\n"
                         "                           The track name that will appear in the final BED.[Default = 'final_flagger']\n");
@@ -639,6 +1799,14 @@ int main(int argc, char *argv[]) {
                         "                           genome into chunks is mainly for enabling multi-threading and running \n"
                         "                           this algorithm for multiple parts of the genome simultaneously. \n"
                         "                           [Default = 20000000 (20Mb)]\n");
+                fprintf(stderr,
+                        "         --chunkFlankLen, -f\n"
+                        "                           Length of the flanks (in bases) that are taken from the adjacent \n"
+                        "                           chunks of the same contig. Forward/backward runs on the chunk plus \n"
+                        "                           its flanks and only the results of the chunk itself are kept, so \n"
+                        "                           smaller chunks (more parallelism) can be used with no boundary \n"
+                        "                           artifacts. It works best when chunkLen is a multiple of windowLen. \n"
+                        "                           [Default = 0 (no flanks)]\n");
                 fprintf(stderr,
                         "         --windowLen, -W\n"
                         "                           Window length. Coverage information will be averaged along each window \n"
@@ -695,7 +1863,8 @@ int main(int argc, char *argv[]) {
                 fprintf(stderr,
                         "         --writePosteriorProbs, -P\n"
                         "                           (Optional) Recommended only for development. \n"
-                        "                           Write posterior probabilities in tsv format [Default = disabled].\n");
+                        "                           Write posterior probabilities into a bgzf-compressed bed file \n"
+                        "                           (posterior_prediction_final.bed.gz) [Default = disabled].\n");
                 fprintf(stderr,
                         "         --binArrayFile, -b\n"
                         "                           (Optional) A tsv file (tab-delimited) that contains bin arrays \n"
@@ -739,13 +1908,80 @@ int main(int argc, char *argv[]) {
                         "                           non-Hap short blocks into Hap blocks. Given numbers should be \n"
                         "                           related to states Err, Dup and Col respectively. \n"
                         "                           [default: '0,0,0']\n");
+                fprintf(stderr,
+                        "         --decode, -d\n"
+                        "                           Decoding method for the final inference. It can be either \n"
+                        "                           'posterior' (the most probable state per window) or 'viterbi' \n"
+                        "                           (the most probable path of states; it needs a single pass and \n"
+                        "                           produces more contiguous blocks). 'viterbi' cannot be used with \n"
+                        "                           --writePosteriorProbs. [default: 'posterior']\n");
+                fprintf(stderr,
+                        "         --miniBatchFraction, -F\n"
+                        "                           Fraction of chunks (between 0 and 1) that are randomly selected \n"
+                        "                           in each iteration of mini-batch EM. Mini-batch iterations update \n"
+                        "                           the model with a decreasing step size and they are followed by \n"
+                        "                           full-batch EM once the parameters are close to convergence. \n"
+                        "                           1.0 means mini-batch EM is disabled. [default: 1.0]\n");
+                fprintf(stderr,
+                        "         --miniBatchIterations, -I\n"
+                        "                           Maximum number of mini-batch iterations before switching to \n"
+                        "                           full-batch EM [default: 20]\n");
+                fprintf(stderr,
+                        "         --freezeTol, -z\n"
+                        "                           Chunks whose loglikelihood (relative change) and posteriors (mean \n"
+                        "                           total variation distance) change less than this value in a \n"
+                        "                           full-batch iteration reuse their cached sufficient statistics \n"
+                        "                           instead of running forward-backward for the next few iterations. \n"
+                        "                           Convergence is only accepted after all chunks are refreshed. \n"
+                        "                           Per-chunk convergence stats are added to loglikelihood.tsv . \n"
+                        "                           It is ignored with --accelerate. 0 means disabled. [default: 0]\n");
+                fprintf(stderr,
+                        "         --freezeIterations, -Z\n"
+                        "                           Number of iterations a converged chunk is frozen before it is \n"
+                        "                           refreshed [default: 3]\n");
+                fprintf(stderr,
+                        "         --precision, -R\n"
+                        "                           Precision of the forward and backward matrices. It can be either \n"
+                        "                           'double' or 'float'. With 'float' the matrices take half of the \n"
+                        "                           memory (and memory bandwidth) while each column is still computed \n"
+                        "                           in double and the sufficient statistics are accumulated in double. \n"
+                        "                           [default: 'double']\n");
+                fprintf(stderr,
+                        "         --loadModel, -L\n"
+                        "                           Path to a model saved by a previous run (model_final.bin in its \n"
+                        "                           output dir). Parameter estimation is skipped and only the final \n"
+                        "                           inference is run with the loaded model. Options for creating and \n"
+                        "                           training a model (like --modelType and --alphaTsv) are ignored.\n"
+                        "                           The input coverage should be similar to the one the model was \n"
+                        "                           trained on. [default: disabled]\n");
+                fprintf(stderr,
+                        "         --initModel, -J\n"
+                        "                           (Distributed EM) Create a new model based on the header of the \n"
+                        "                           input coverage file (cov/cov.gz), save it into this path and exit. \n"
+                        "                           It is made once and given to all shards with --loadModel so they \n"
+                        "                           start from the same model. --collapsedComps should be set. \n"
+                        "                           [default: disabled]\n");
+                fprintf(stderr,
+                        "         --eStepOnly, -e\n"
+                        "                           (Distributed EM) Run a single E-step with the model given by \n"
+                        "                           --loadModel (required) and save the sufficient statistics into \n"
+                        "                           this path. Use --contigsList for selecting the contigs of each \n"
+                        "                           shard. [default: disabled]\n");
+                fprintf(stderr,
+                        "         --reduceStats, -r\n"
+                        "                           (Distributed EM) Path to a text file with one sufficient \n"
+                        "                           statistics file (made with --eStepOnly) per line. They are \n"
+                        "                           summed and the next model is estimated and saved into \n"
+                        "                           model_final.bin in the output dir. converged.txt will contain \n"
+                        "                           'true' if the parameters converged. --input is not needed. \n"
+                        "                           [default: disabled]\n");
                 return 1;
         }
     }
 
     double realtimeStart = System_getRealTimePoint();
 
-    if (inputPath == NULL) {
+    if (inputPath == NULL && reduceStatsListPath == NULL) {
         fprintf(stderr, "[%s] Error: Input path cannot be NULL.\n", get_timestamp());
         exit(EXIT_FAILURE);
     }
@@ -755,6 +1991,47 @@ int main(int argc, char *argv[]) {
                 get_timestamp());
         exit(EXIT_FAILURE);
     }
+    if (miniBatchFraction <= 0.0 || miniBatchFraction > 1.0) {
+        fprintf(stderr, "[%s] Error: mini-batch fraction = %.2f should be greater than 0 and at most 1.\n",
+                get_timestamp(),
+                miniBatchFraction);
+        exit(EXIT_FAILURE);
+    }
+    if (decodeType == DECODE_UNDEFINED) {
+        fprintf(stderr,
+                "[%s] Error: Decoding method should be either 'posterior' or 'viterbi'.\n",
+                get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    if (decodeType == DECODE_VITERBI && writePosteriorProbs) {
+        fprintf(stderr,
+                "[%s] Error: --writePosteriorProbs cannot be used with --decode viterbi.\n",
+                get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    if (precision == PRECISION_UNDEFINED) {
+        fprintf(stderr,
+                "[%s] Error: Precision should be either 'double' or 'float'.\n",
+                get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    if (freezeTol < 0.0 || freezeIterations < 1) {
+        fprintf(stderr, "[%s] Error: freeze tol = %.2e cannot be negative and freeze iterations = %d should be at least 1.\n",
+                get_timestamp(),
+                freezeTol,
+                freezeIterations);
+        exit(EXIT_FAILURE);
+    }
+    if (0.0 < freezeTol && acceleration) {
+        fprintf(stderr, "[%s] Warning: --freezeTol is ignored with --accelerate.\n", get_timestamp());
+        freezeTol = 0.0;
+    }
+    if (chunkFlankLen < 0) {
+        fprintf(stderr, "[%s] Error: chunk flank length = %d cannot be negative.\n",
+                get_timestamp(),
+                chunkFlankLen);
+        exit(EXIT_FAILURE);
+    }
     if (convergenceTol <= 0.0 || convergenceTol > 1.0) {
         fprintf(stderr, "[%s] Error: convergence tol = %2.f should be between 0 and 1.\n",
                 get_timestamp(),
@@ -768,6 +2045,99 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "[%s] Error: Output directory %s does not exist!\n", get_timestamp(), outputDir);
         exit(EXIT_FAILURE);
     }
+    if (numberOfTrainingRuns < 0) {
+        fprintf(stderr, "[%s] Error: --trainingRuns should not be negative.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    if (0 < numberOfTrainingRuns) {
+        if (loadModelPath != NULL || eStepStatsPath != NULL || reduceStatsListPath != NULL) {
+            fprintf(stderr,
+                    "[%s] Error: --trainingRuns cannot be used with --loadModel, --eStepOnly or --reduceStats.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        if (1 < numberOfTrainingRuns && initialRandomDeviation == 0.0) {
+            fprintf(stderr,
+                    "[%s] Error: --trainingRuns is greater than 1 but --initialRandomDev is 0 so the runs would be identical.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        if (writeBenchmarkingStatsPerIteration) {
+            fprintf(stderr,
+                    "[%s] Warning: --writeBenchmarkingStatsPerIteration is ignored with --trainingRuns.\n",
+                    get_timestamp());
+        }
+    }
+    if (alphaGridPath != NULL) {
+        if (0 < numberOfTrainingRuns || loadModelPath != NULL || eStepStatsPath != NULL ||
+            reduceStatsListPath != NULL || alphaTsvPath != NULL) {
+            fprintf(stderr,
+                    "[%s] Error: --alphaGrid cannot be used with --trainingRuns, --loadModel, --eStepOnly, --reduceStats or --alphaTsv.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        if (writeBenchmarkingStatsPerIteration) {
+            fprintf(stderr,
+                    "[%s] Warning: --writeBenchmarkingStatsPerIteration is ignored with --alphaGrid.\n",
+                    get_timestamp());
+        }
+    }
+    if (eStepStatsPath != NULL && reduceStatsListPath != NULL) {
+        fprintf(stderr, "[%s] Error: --eStepOnly and --reduceStats cannot be used together.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    // a new model is seeded differently in each process so the shards would not start from the same model
+    if (eStepStatsPath != NULL && loadModelPath == NULL) {
+        fprintf(stderr,
+                "[%s] Error: --eStepOnly needs --loadModel; the initial model can be made once with --initModel.\n",
+                get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    if (initModelPath != NULL) {
+        if (eStepStatsPath != NULL || reduceStatsListPath != NULL || loadModelPath != NULL) {
+            fprintf(stderr,
+                    "[%s] Error: --initModel cannot be used with --eStepOnly, --reduceStats or --loadModel.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        if (numberOfCollapsedComps == -1) {
+            fprintf(stderr, "[%s] Error: --collapsedComps should be set with --initModel.\n", get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        char *initInputExtension = extractFileExtension(inputPath);
+        if (strcmp(initInputExtension, "cov") != 0 && strcmp(initInputExtension, "cov.gz") != 0) {
+            fprintf(stderr, "[%s] Error: --initModel needs a cov/cov.gz input file.\n", get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        free(initInputExtension);
+        // only the header is needed for creating a model
+        CoverageHeader *header = CoverageHeader_construct(inputPath);
+        MatrixDouble *alphaMatrix = getAlphaMatrix(alphaTsvPath);
+        unsigned int randomSeed = time(NULL);
+        HMM *model = createModel(modelType,
+                                 numberOfCollapsedComps,
+                                 header,
+                                 alphaMatrix,
+                                 maxHighMapqRatio,
+                                 minHighMapqRatio,
+                                 windowLen,
+                                 initialRandomDeviation,
+                                 &randomSeed);
+        HMM_writeIntoBinaryFile(model, initModelPath);
+        fprintf(stderr, "[%s] The initial model is saved into %s\n", get_timestamp(), initModelPath);
+        HMM_destruct(model);
+        MatrixDouble_destruct(alphaMatrix);
+        CoverageHeader_destruct(header);
+        fprintf(stderr, "[%s] Done! \n", get_timestamp());
+        return 0;
+    }
+    if (reduceStatsListPath != NULL) {
+        stList *statsPaths = Splitter_parseLinesIntoList(reduceStatsListPath);
+        reduceSufficientStats(statsPaths, convergenceTol, outputDir);
+        stList_destruct(statsPaths);
+        fprintf(stderr, "[%s] Done! \n", get_timestamp());
+        return 0;
+    }
     if (contigListPath != NULL) {
         contigList = Splitter_parseLinesIntoList(contigListPath);
         fprintf(stderr,
@@ -813,7 +2183,9 @@ int main(int argc, char *argv[]) {
             totalLengthOfChunks);
 
     // 2. get maximum coverage and set number of collapsed comps
-    if (numberOfCollapsedComps == -1) {
+    if (loadModelPath != NULL) {
+        // the number of components is taken from the loaded model
+    } else if (numberOfCollapsedComps == -1) {
         fprintf(stderr, "[%s] Determining the number of components for the 'collapsed' state. \n", get_timestamp());
         numberOfCollapsedComps = getBestNumberOfCollapsedComps(chunksCreator);
         // make sure the number of components is not too large or too small
@@ -832,32 +2204,154 @@ int main(int argc, char *argv[]) {
     // 3. create a model
     fprintf(stderr, "[%s] Creating HMM model. \n", get_timestamp());
 
-    MatrixDouble *alphaMatrix = getAlphaMatrix(alphaTsvPath);
-    HMM *model = createModel(modelType,
-                             numberOfCollapsedComps,
-                             chunksCreator->header,
-                             alphaMatrix,
-                             maxHighMapqRatio,
-                             minHighMapqRatio,
-                             chunksCreator->windowLen,
-                             initialRandomDeviation);
+    unsigned int randomSeed = time(NULL);
+    HMM *model = NULL;
+    stList *trainingRunModels = NULL;
+    stList *alphaGridModels = NULL;
+    if (alphaGridPath != NULL) {
+        if (chunksCreator->header->isTruthAvailable == false) {
+            fprintf(stderr, "[%s] Error: --alphaGrid needs truth labels in the input coverage file.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        stList *alphaMatrices = getAlphaMatricesFromGrid(alphaGridPath);
+        fprintf(stderr, "[%s] Parsed %d alpha candidates from %s\n", get_timestamp(),
+                stList_length(alphaMatrices),
+                alphaGridPath);
+        alphaGridModels = stList_construct();
+        for (int i = 0; i < stList_length(alphaMatrices); i++) {
+            stList_append(alphaGridModels, createModel(modelType,
+                                                       numberOfCollapsedComps,
+                                                       chunksCreator->header,
+                                                       stList_get(alphaMatrices, i),
+                                                       maxHighMapqRatio,
+                                                       minHighMapqRatio,
+                                                       chunksCreator->windowLen,
+                                                       initialRandomDeviation,
+                                                       &randomSeed));
+        }
+        stList_destruct(alphaMatrices);
+    } else if (0 < numberOfTrainingRuns) {
+        MatrixDouble *alphaMatrix = getAlphaMatrix(alphaTsvPath);
+        trainingRunModels = stList_construct();
+        for (int i = 0; i < numberOfTrainingRuns; i++) {
+            stList_append(trainingRunModels, createModel(modelType,
+                                                         numberOfCollapsedComps,
+                                                         chunksCreator->header,
+                                                         alphaMatrix,
+                                                         maxHighMapqRatio,
+                                                         minHighMapqRatio,
+                                                         chunksCreator->windowLen,
+                                                         initialRandomDeviation,
+                                                         &randomSeed));
+        }
+        MatrixDouble_destruct(alphaMatrix);
+    } else if (loadModelPath != NULL) {
+        fprintf(stderr, "[%s] Loading HMM model from %s (parameter estimation will be skipped). \n", get_timestamp(),
+                loadModelPath);
+        model = HMM_constructFromBinaryFile(loadModelPath);
+        if (model->numberOfRegions != chunksCreator->header->numberOfRegions) {
+            fprintf(stderr,
+                    "[%s] Error: The loaded model has %d regions but the input coverage file has %d regions.\n",
+                    get_timestamp(),
+                    model->numberOfRegions,
+                    chunksCreator->header->numberOfRegions);
+            exit(EXIT_FAILURE);
+        }
+        // only the final inference is run
+        numberOfIterations = 0;
+    } else {
+        MatrixDouble *alphaMatrix = getAlphaMatrix(alphaTsvPath);
+        model = createModel(modelType,
+                            numberOfCollapsedComps,
+                            chunksCreator->header,
+                            alphaMatrix,
+                            maxHighMapqRatio,
+                            minHighMapqRatio,
+                            chunksCreator->windowLen,
+                            initialRandomDeviation,
+                            &randomSeed);
+    }
+
+    if (eStepStatsPath != NULL) {
+        runEStepAndWriteSufficientStats(chunksCreator, model, threads, eStepStatsPath, chunkFlankLen, precision);
+        ChunksCreator_destruct(chunksCreator);
+        HMM_destruct(model);
+        fprintf(stderr, "[%s] Done! \n", get_timestamp());
+        return 0;
+    }
 
     // 4. run EM for estimating parameters
     fprintf(stderr, "[%s] Running EM for estimating parameters. \n", get_timestamp());
 
-    runHMMFlagger(chunksCreator,
-                  &model,
-                  numberOfIterations,
-                  convergenceTol,
-                  outputDir,
-                  threads,
-                  writeParameterStatsPerIteration,
-                  writeBenchmarkingStatsPerIteration,
-                  writePosteriorProbs,
-                  labelNamesWithUnknown,
-                  binArrayFilePath,
-                  overlapRatioThreshold,
-                  acceleration);
+    if (alphaGridModels != NULL) {
+        model = runHMMFlaggerAlphaGrid(chunksCreator,
+                                       alphaGridModels,
+                                       numberOfIterations,
+                                       convergenceTol,
+                                       outputDir,
+                                       threads,
+                                       writeParameterStatsPerIteration,
+                                       writePosteriorProbs,
+                                       labelNamesWithUnknown,
+                                       binArrayFilePath,
+                                       overlapRatioThreshold,
+                                       acceleration,
+                                       decodeType,
+                                       miniBatchFraction,
+                                       maxMiniBatchIterations,
+                                       freezeTol,
+                                       freezeIterations,
+                                       chunkFlankLen,
+                                       precision,
+                                       scoreAnnotationName,
+                                       scoreSizeBinName);
+        stList_destruct(alphaGridModels);
+    } else if (trainingRunModels != NULL) {
+        model = runHMMFlaggerMultiStart(chunksCreator,
+                                        trainingRunModels,
+                                        numberOfIterations,
+                                        convergenceTol,
+                                        outputDir,
+                                        threads,
+                                        writeParameterStatsPerIteration,
+                                        writePosteriorProbs,
+                                        labelNamesWithUnknown,
+                                        binArrayFilePath,
+                                        overlapRatioThreshold,
+                                        acceleration,
+                                        decodeType,
+                                        miniBatchFraction,
+                                        maxMiniBatchIterations,
+                                        freezeTol,
+                                        freezeIterations,
+                                        chunkFlankLen,
+                                        precision,
+                                        trackName,
+                                        minLenPerState);
+        stList_destruct(trainingRunModels);
+    } else {
+        runHMMFlagger(chunksCreator,
+                      &model,
+                      numberOfIterations,
+                      convergenceTol,
+                      outputDir,
+                      threads,
+                      writeParameterStatsPerIteration,
+                      writeBenchmarkingStatsPerIteration,
+                      writePosteriorProbs,
+                      labelNamesWithUnknown,
+                      binArrayFilePath,
+                      overlapRatioThreshold,
+                      acceleration,
+                      decodeType,
+                      miniBatchFraction,
+                      maxMiniBatchIterations,
+                      freezeTol,
+                      freezeIterations,
+                      chunkFlankLen,
+                      precision);
+    }
 
 
     // 5. write final BED
@@ -0,0 +1,67 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <assert.h>
+#include "sonLib.h"
+#include "common.h"
+#include "ptBlock.h"
+
+
+int main(int argc, char *argv[]) {
+    int c;
+    char *jsonPath = NULL;
+    char *indexPath = NULL;
+    int threads = 4;
+    char *program;
+    (program = strrchr(argv[0], '/')) ? ++program : (program = argv[0]);
+    while (~(c = getopt(argc, argv, "j:o:t:h"))) {
+        switch (c) {
+            case 'j':
+                jsonPath = optarg;
+                break;
+            case 'o':
+                indexPath = optarg;
+                break;
+            case 't':
+                threads = atoi(optarg);
+                break;
+            default:
+                if (c != 'h') fprintf(stderr, "[E::%s] undefined option %c\n", __func__, c);
+            help:
+                fprintf(stderr, "\nUsage: %s  -j <JSON_FILE> [-o <INDEX_FILE>] [-t <THREADS>] \n", program);
+                fprintf(stderr, "Options:\n");
+                fprintf(stderr, "         -j         json file for the annotation bed files (same as bam2cov)\n");
+                fprintf(stderr, "         -o         path to output index [Default = <JSON_FILE>.index, which is\n"
+                                "                    the path bam2cov looks for]\n");
+                fprintf(stderr, "         -t         number of threads for parsing bed files [Default = 4]\n");
+                return 1;
+        }
+    }
+    if (jsonPath == NULL) {
+        fprintf(stderr, "[%s] Error: -j should be given.\n", get_timestamp());
+        goto help;
+    }
+    char defaultIndexPath[1000];
+    if (indexPath == NULL) {
+        sprintf(defaultIndexPath, "%s.index", jsonPath);
+        indexPath = defaultIndexPath;
+    }
+    AnnotationIndex *annotationIndex = AnnotationIndex_constructFromJson(jsonPath, threads);
+    if (!AnnotationIndex_write(annotationIndex, jsonPath, indexPath)) {
+        fprintf(stderr, "[%s] Error: Couldn't write the annotation index into %s\n", get_timestamp(), indexPath);
+        exit(EXIT_FAILURE);
+    }
+    stList *contigNames = ptBlock_get_sorted_contig_list(annotationIndex->segments_per_contig);
+    for (int i = 0; i < stList_length(contigNames); i++) {
+        char *contigName = stList_get(contigNames, i);
+        AnnotationSegmentList *segmentList = AnnotationIndex_getSegments(annotationIndex, contigName);
+        printf("[%s] Contig %s:\t%ld segments\n", get_timestamp(), contigName, segmentList->number_of_segments);
+    }
+    fprintf(stderr, "[%s] Annotation index (%d annotations) is written into %s\n", get_timestamp(),
+            annotationIndex->number_of_annotations, indexPath);
+    stList_destruct(contigNames);
+    AnnotationIndex_destruct(annotationIndex);
+}
@@ -29,9 +29,36 @@ static struct option long_options[] =
                 {"threads",               required_argument, NULL, '@'},
                 {"overlapRatioThreshold", required_argument, NULL, 'v'},
                 {"labelNames",            required_argument, NULL, 'l'},
+                {"predictionBeds",        required_argument, NULL, 'p'},
+                {"predictionNames",       required_argument, NULL, 'n'},
                 {NULL,                    0,                 NULL, 0}
         };
 
+// returns the largest label in the given table of label blocks (-1 if there is no label)
+static int getMaxPredictionLabel(stHash *blocksPerContig) {
+    int maxLabel = -1;
+    stHashIterator *it = stHash_getIterator(blocksPerContig);
+    char *ctg;
+    while ((ctg = stHash_getNext(it)) != NULL) {
+        stList *blocks = stHash_search(blocksPerContig, ctg);
+        for (int i = 0; i < stList_length(blocks); i++) {
+            ptBlock *block = stList_get(blocks, i);
+            int label = get_inference_prediction_label(((CoverageInfo *) block->data)->data);
+            maxLabel = maxLabel < label ? label : maxLabel;
+        }
+    }
+    stHash_destructIterator(it);
+    return maxLabel;
+}
+
+// the block tables parsed from bed files do not free their contig names on destruction
+void destructPredictionBlockTable(stHash *blocksPerContig) {
+    stList *contigNames = stHash_getKeys(blocksPerContig);
+    stList_setDestructor(contigNames, free);
+    stHash_destruct(blocksPerContig);
+    stList_destruct(contigNames);
+}
+
 
 int main(int argc, char *argv[]) {
     int c;
@@ -40,10 +67,12 @@ int main(int argc, char *argv[]) {
     char *outputPath = NULL;
     char *binArrayFilePath = NULL;
     stList *labelNamesWithUnknown = NULL;
+    stList *predictionBedPaths = NULL;
+    stList *predictionNames = NULL;
     int threads = 4;
     char *program;
     (program = strrchr(argv[0], '/')) ? ++program : (program = argv[0]);
-    while (~(c = getopt_long(argc, argv, "i:o:b:@:v:l:h", long_options, NULL))) {
+    while (~(c = getopt_long(argc, argv, "i:o:b:@:v:l:p:n:h", long_options, NULL))) {
         switch (c) {
             case 'i':
                 inputPath = optarg;
@@ -67,6 +96,12 @@ int main(int argc, char *argv[]) {
             case '@':
                 threads = atoi(optarg);
                 break;
+            case 'p':
+                predictionBedPaths = Splitter_getStringList(optarg, ',');
+                break;
+            case 'n':
+                predictionNames = Splitter_getStringList(optarg, ',');
+                break;
             default:
                 if (c != 'h') fprintf(stderr, "[E::%s] undefined option %c\n", __func__, c);
             help:
@@ -95,12 +130,24 @@ int main(int argc, char *argv[]) {
                         "                           label (for example prediction label for recall) [default: 0.4]\n");
                 fprintf(stderr,
                         "         -@, --threads\n"
-                        "                           Number of threads for parallelizing creating table for each annotation/region\n"
+                        "                           Number of threads for creating tables in parallel (blocks are partitioned by contig/chunk)\n"
                         "                           [default: 4]\n");
                 fprintf(stderr,
                         "         -l, --labelNames\n"
                         "                           (Optional) A comma-delimited string of label names (for example 'Err,Dup,Hap,Col').\n"
                         "                           It should match the number of labels in the header of the input file.[default: none]\n");
+                fprintf(stderr,
+                        "         -p, --predictionBeds\n"
+                        "                           (Optional) A comma-delimited list of prediction bed files with integer labels\n"
+                        "                           in the 4th column (for example the outputs of multiple HMM-Flagger runs).\n"
+                        "                           All of them are evaluated against the truth labels of the input file\n"
+                        "                           in a single pass and one summary table is written per bed file with the\n"
+                        "                           path '<OUTPUT_PREFIX>.<PREDICTION_NAME>.tsv'. Input should be cov/cov.gz\n"
+                        "                           and its own prediction labels will be ignored. [default: none]\n");
+                fprintf(stderr,
+                        "         -n, --predictionNames\n"
+                        "                           (Optional) A comma-delimited list of names for the prediction bed files\n"
+                        "                           to be used in the output paths [default: prediction_1,prediction_2,...]\n");
 
                 return 1;
         }
@@ -135,14 +182,36 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    if (predictionBedPaths != NULL) {
+        if (strcmp(inputExtension, "cov") != 0 && strcmp(inputExtension, "cov.gz") != 0) {
+            fprintf(stderr, "[%s] Error: input file should be cov/cov.gz when --predictionBeds is given.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        if (predictionNames != NULL && stList_length(predictionNames) != stList_length(predictionBedPaths)) {
+            fprintf(stderr, "[%s] Error: Number of prediction names %d does not match the number of bed files %d.\n",
+                    get_timestamp(), stList_length(predictionNames), stList_length(predictionBedPaths));
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // define object and functions for iterating blocks
     void *iterator;
     CoverageHeader *header = NULL;
     ChunksCreator *chunksCreator = NULL;
     stHash *blocksPerContig = NULL;
     CovFastReader *covFastReader = NULL;
-    BlockIteratorType blockIteratorType =
-            strcmp(inputExtension, "bin") == 0 ? ITERATOR_BY_CHUNK : ITERATOR_BY_COV_BLOCK;
+    stList *templateChunks = NULL;
+    stList *predictionBlockTables = NULL;
+    // cov files are streamed by chunk without keeping all blocks in memory
+    BlockIteratorType blockIteratorType;
+    if (strcmp(inputExtension, "bin") == 0) {
+        blockIteratorType = ITERATOR_BY_CHUNK;
+    } else if (strcmp(inputExtension, "cov") == 0 || strcmp(inputExtension, "cov.gz") == 0) {
+        blockIteratorType = ITERATOR_BY_COV_STREAM;
+    } else {
+        blockIteratorType = ITERATOR_BY_COV_BLOCK;
+    }
 
     // create block iterator
     if (blockIteratorType == ITERATOR_BY_CHUNK) { // for binary file
@@ -150,7 +219,38 @@ int main(int argc, char *argv[]) {
         ChunksCreator_parseChunksFromBinaryFile(chunksCreator, inputPath);
         iterator = (void *) ChunkIterator_construct(chunksCreator);
         header = chunksCreator->header;
-    } else if (blockIteratorType == ITERATOR_BY_COV_BLOCK) { // for cov or bed file
+    } else if (blockIteratorType == ITERATOR_BY_COV_STREAM) { // for cov file
+        int chunkLen = 40e6;
+        templateChunks = ChunksCreator_constructTemplateChunks(inputPath, NULL, chunkLen);
+        header = CoverageHeader_construct(inputPath);
+        iterator = (void *) CovStreamIterator_construct(inputPath, templateChunks, header);
+        if (predictionBedPaths != NULL) {
+            // parse all prediction bed files; the tracks of the input file will be split at the boundaries
+            // of the prediction blocks while streaming
+            predictionBlockTables = stList_construct3(0, (void (*)(void *)) destructPredictionBlockTable);
+            int maxLabel = -1;
+            for (int i = 0; i < stList_length(predictionBedPaths); i++) {
+                char *bedPath = stList_get(predictionBedPaths, i);
+                fprintf(stderr, "[%s] Parsing prediction labels from %s.\n", get_timestamp(), bedPath);
+                stHash *blocksPerContig = ptBlock_parse_inference_label_blocks(bedPath, false, threads);
+                int maxLabelInBed = getMaxPredictionLabel(blocksPerContig);
+                maxLabel = maxLabel < maxLabelInBed ? maxLabelInBed : maxLabel;
+                stList_append(predictionBlockTables, blocksPerContig);
+            }
+            CovStreamIterator_setPredictionSets((CovStreamIterator *) iterator, predictionBlockTables);
+            if (header->isPredictionAvailable) {
+                fprintf(stderr, "[%s] Warning: The prediction labels of the input file will be ignored.\n",
+                        get_timestamp());
+            }
+            header->isPredictionAvailable = true;
+            if (header->numberOfLabels < maxLabel + 1) {
+                fprintf(stderr,
+                        "[%s] Warning: The number of labels in the header of the input file (%d) is less than the number of labels in the prediction bed files (%d). It will be overwritten to %d.\n",
+                        get_timestamp(), header->numberOfLabels, maxLabel + 1, maxLabel + 1);
+                header->numberOfLabels = maxLabel + 1;
+            }
+        }
+    } else if (blockIteratorType == ITERATOR_BY_COV_BLOCK) { // for bed file
         int chunkLen = 40e6;
         covFastReader =  CovFastReader_construct(inputPath, chunkLen, threads);
         blocksPerContig = CovFastReader_getBlockTablePerContig(covFastReader);
@@ -159,20 +259,61 @@ int main(int argc, char *argv[]) {
     }
 
     // create and write all summary tables with final stats
-    SummaryTableList_createAndWriteAllTables(iterator,
-                                             blockIteratorType,
-                                             header,
-                                             outputPath,
-                                             binArrayFilePath,
-                                             labelNamesWithUnknown,
-                                             overlapRatioThreshold,
-                                             threads);
+    if (predictionBedPaths == NULL) {
+        SummaryTableList_createAndWriteAllTables(iterator,
+                                                 blockIteratorType,
+                                                 header,
+                                                 outputPath,
+                                                 binArrayFilePath,
+                                                 labelNamesWithUnknown,
+                                                 overlapRatioThreshold,
+                                                 threads);
+    } else {
+        // make one output path per prediction set by adding its name before the tsv extension
+        stList *outputPathPerPredictionSet = stList_construct3(0, free);
+        char *outputPrefix = copyString(outputPath);
+        outputPrefix[strlen(outputPrefix) - strlen(".tsv")] = '\0';
+        for (int i = 0; i < stList_length(predictionBedPaths); i++) {
+            char name[200];
+            if (predictionNames != NULL) {
+                snprintf(name, sizeof(name), "%s", (char *) stList_get(predictionNames, i));
+            } else {
+                snprintf(name, sizeof(name), "prediction_%d", i + 1);
+            }
+            char *path = malloc(strlen(outputPrefix) + strlen(name) + 10);
+            sprintf(path, "%s.%s.tsv", outputPrefix, name);
+            fprintf(stderr, "[%s] Summary tables of %s will be written to %s.\n", get_timestamp(),
+                    (char *) stList_get(predictionBedPaths, i), path);
+            stList_append(outputPathPerPredictionSet, path);
+        }
+        SummaryTableList_createAndWriteAllTablesPerPredictionSet(iterator,
+                                                                 blockIteratorType,
+                                                                 header,
+                                                                 outputPathPerPredictionSet,
+                                                                 binArrayFilePath,
+                                                                 labelNamesWithUnknown,
+                                                                 overlapRatioThreshold,
+                                                                 threads);
+        stList_destruct(outputPathPerPredictionSet);
+        free(outputPrefix);
+    }
 
     if (blockIteratorType == ITERATOR_BY_CHUNK) {
         // free iterator
         ChunkIterator_destruct((ChunkIterator *) iterator);
         // free chunks
         ChunksCreator_destruct(chunksCreator);
+    } else if (blockIteratorType == ITERATOR_BY_COV_STREAM) {
+        // free iterator
+        CovStreamIterator_destruct((CovStreamIterator *) iterator);
+        // free template chunks
+        stList_destruct(templateChunks);
+        // free prediction blocks
+        if (predictionBlockTables != NULL) {
+            stList_destruct(predictionBlockTables);
+        }
+        // free header
+        CoverageHeader_destruct(header);
     } else {
         // free iterator
         ptBlockItrPerContig_destruct((ptBlockItrPerContig *) iterator);
@@ -181,6 +322,11 @@ int main(int argc, char *argv[]) {
         // free header
         CoverageHeader_destruct(header);
     }
+    if (predictionBedPaths != NULL) stList_destruct(predictionBedPaths);
+    if (predictionNames != NULL) stList_destruct(predictionNames);
+    if (labelNamesWithUnknown != NULL) stList_destruct(labelNamesWithUnknown);
+    free(inputExtension);
+    free(outputExtension);
     fprintf(stderr, "[%s] Done!\n", get_timestamp());
 
     // log used time/resources
@@ -0,0 +1,116 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "sonLib.h"
+#include "common.h"
+#include "track_reader.h"
+
+
+static struct option long_options[] =
+        {
+                {"input",     required_argument, NULL, 'i'},
+                {"inputList", required_argument, NULL, 'l'},
+                {"output",    required_argument, NULL, 'o'},
+                {"mode",      required_argument, NULL, 'm'},
+                {"threads",   required_argument, NULL, '@'},
+                {NULL,        0,                 NULL, 0}
+        };
+
+
+int main(int argc, char *argv[]) {
+    int c;
+    stList *inputPaths = stList_construct3(0, free);
+    char *inputListPath = NULL;
+    char *outputPath = NULL;
+    char *modeStr = "union";
+    int threads = 4;
+    char *program;
+    (program = strrchr(argv[0], '/')) ? ++program : (program = argv[0]);
+    while (~(c = getopt_long(argc, argv, "i:l:o:m:@:h", long_options, NULL))) {
+        switch (c) {
+            case 'i':
+                stList_append(inputPaths, copyString(optarg));
+                break;
+            case 'l':
+                inputListPath = optarg;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'm':
+                modeStr = optarg;
+                break;
+            case '@':
+                threads = atoi(optarg);
+                break;
+            default:
+                if (c != 'h') fprintf(stderr, "[E::%s] undefined option %c\n", __func__, c);
+            help:
+                fprintf(stderr, "\nUsage: %s  -i <INPUT_1> -i <INPUT_2> ... -o <OUTPUT_FILE> [-m union|sum]\n", program);
+                fprintf(stderr, "Options:\n");
+                fprintf(stderr,
+                        "         --input, -i                  input cov path (can have formats '.cov' or '.cov.gz'). It can be given\n"
+                        "                                      multiple times. Contigs in each input should be sorted by name (as written by bam2cov)\n");
+                fprintf(stderr,
+                        "         --inputList, -l              a text file with one input cov path per line (can be used with or instead of --input)\n");
+                fprintf(stderr,
+                        "         --output, -o                 output path (can have formats '.cov' or '.cov.gz'). '.cov.gz' is written in the BGZF format\n");
+                fprintf(stderr,
+                        "         --mode, -m                   'union': each contig should exist in only one input (for example per-contig shards)\n"
+                        "                                      'sum': coverage values of the inputs are added up (for example shards of reads);\n"
+                        "                                             annotations are merged and region indices and labels are taken from\n"
+                        "                                             the first input that covers each base [Default = union]\n");
+                fprintf(stderr, "         --threads, -@                number of threads for BGZF compression [Default = 4]\n");
+                stList_destruct(inputPaths);
+                return 1;
+        }
+    }
+
+    double realtimeStart = System_getRealTimePoint();
+
+    if (inputListPath != NULL) {
+        stList *listedPaths = Splitter_parseLinesIntoList(inputListPath);
+        for (int i = 0; i < stList_length(listedPaths); i++) {
+            stList_append(inputPaths, copyString(stList_get(listedPaths, i)));
+        }
+        stList_destruct(listedPaths);
+    }
+    if (stList_length(inputPaths) == 0 || outputPath == NULL) {
+        fprintf(stderr, "[%s] Error: At least one input and the output path should be given.\n", get_timestamp());
+        goto help;
+    }
+    CovMergeMode mode;
+    if (strcmp(modeStr, "union") == 0) {
+        mode = COV_MERGE_UNION;
+    } else if (strcmp(modeStr, "sum") == 0) {
+        mode = COV_MERGE_SUM;
+    } else {
+        fprintf(stderr, "[%s] Error: --mode should be either 'union' or 'sum' (%s is given).\n", get_timestamp(),
+                modeStr);
+        exit(EXIT_FAILURE);
+    }
+
+    CovMerger *merger = CovMerger_construct(inputPaths, mode);
+    CovMerger_write(merger, outputPath, threads);
+
+    for (int r = 0; r < merger->header->numberOfRegions; r++) {
+        fprintf(stderr, "[%s] Region %d coverage = %d\n", get_timestamp(), r, merger->header->regionCoverages[r]);
+    }
+    fprintf(stderr, "[%s] Average alignment length = %d\n", get_timestamp(),
+            merger->header->averageAlignmentLength);
+
+    CovMerger_destruct(merger);
+    stList_destruct(inputPaths);
+    fprintf(stderr, "[%s] Done!\n", get_timestamp());
+
+    // log used time/resources
+    double realtime = System_getRealTimePoint() - realtimeStart;
+    double cputime = System_getCpuTime();
+    double rssgb = System_getPeakRSSInGB();
+    double usage = System_getCpuUsage(cputime, realtime);
+    // copied from https://github.com/chhylp123/hifiasm/blob/70fd9a0b1fea45e442eb5f331922ea91ef4f71ae/main.cpp#L73
+    fprintf(stderr, "Real time: %.3f sec; CPU: %.3f sec; Peak RSS: %.3f GB; CPU usage: %.1f\%\n", realtime, cputime,
+            rssgb, usage * 100.0);
+}
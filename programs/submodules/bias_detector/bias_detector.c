@@ -84,12 +84,12 @@ void BiasDetector_destruct(BiasDetector *biasDetector) {
 
 
 
-void BiasDetector_setStatisticsPerAnnotation(BiasDetector *biasDetector, stHash *blockTable) {
+void BiasDetector_setStatisticsPerAnnotation(BiasDetector *biasDetector, stHash *blockTable, int threads) {
     if(biasDetector->startOnlyMode){
-        BiasDetector_setCountDataPerAnnotationForStartOnlyMode(biasDetector, blockTable);
+        BiasDetector_setCountDataPerAnnotationForStartOnlyMode(biasDetector, blockTable, threads);
     }
     else {
-        BiasDetector_setCountDataPerAnnotation(biasDetector, blockTable);
+        BiasDetector_setCountDataPerAnnotation(biasDetector, blockTable, threads);
     }
     BiasDetector_setMostFrequentCoveragePerAnnotation(biasDetector);
     BiasDetector_setMaxCountPerAnnotation(biasDetector);
@@ -97,52 +97,160 @@ void BiasDetector_setStatisticsPerAnnotation(BiasDetector *biasDetector, stHash
     biasDetector->statsAreUpdated = true;
 }
 
+// increment the counts of all annotations overlapping the given coverage info.
+// only the set annotation bits are visited since most blocks have one or two annotations
+static void incrementCountDataOfOverlappingAnnotations(CountData **countDataPerAnnotation,
+                                                       int numberOfAnnotations,
+                                                       CoverageInfo *covInfo,
+                                                       int value,
+                                                       double count) {
+    if (covInfo == NULL) return;
+    uint64_t buffer;
+    int numberOfWords = 0;
+    const uint64_t *words = AnnotationFlag_getWords(covInfo->annotation_flag, &buffer, &numberOfWords);
+    // annotation index 0 is reserved for the bases with no annotation
+    if (CoverageInfo_getFirstAnnotationIndex(covInfo) == 0 && 0 < numberOfAnnotations) {
+        CountData_increment(countDataPerAnnotation[0], value, count);
+    }
+    // wide annotation sets are visited 64 bits at a time
+    for (int w = 0; w < numberOfWords; w++) {
+        uint64_t annotationBits = words[w];
+        while (annotationBits != 0ULL) {
+            int annotationIndex = 64 * w + getFirstIndexWithNonZeroBitFromRight(annotationBits) + 1;
+            // bits are visited in increasing order
+            if (numberOfAnnotations <= annotationIndex) return;
+            CountData_increment(countDataPerAnnotation[annotationIndex], value, count);
+            // clear the lowest set bit
+            annotationBits &= annotationBits - 1;
+        }
+    }
+}
+
+void BiasDetector_updateCountDataByJob(BiasDetectorCountJobArgs *args) {
+    BiasDetector *biasDetector = args->biasDetector;
+    int windowLen = biasDetector->averageAlignmentLength;
+    for (int unitIndex = 0; unitIndex < stList_length(args->units); unitIndex++) {
+        int64_t unitStartIndex = args->firstElementIndexPerUnit[unitIndex];
+        int64_t unitEndIndex = args->firstElementIndexPerUnit[unitIndex + 1];
+        if (unitEndIndex <= args->startIndex) continue;
+        if (args->endIndex <= unitStartIndex) break;
+        // the range of blocks/windows of this unit assigned to this job
+        int from = (args->startIndex < unitStartIndex ? unitStartIndex : args->startIndex) - unitStartIndex;
+        int to = (unitEndIndex < args->endIndex ? unitEndIndex : args->endIndex) - unitStartIndex;
+        if (biasDetector->startOnlyMode) {
+            Chunk *chunk = stList_get(args->units, unitIndex);
+            int chunkLen = chunk->e - chunk->s + 1;
+            int lastWindowActualSize = chunkLen - windowLen * (chunk->coverageInfoSeqLen - 1);
+            for (int windowIndex = from; windowIndex < to; windowIndex++) {
+                CoverageInfo *covInfo = chunk->coverageInfoSeq[windowIndex];
+                int actualWindowSize = windowIndex < chunk->coverageInfoSeqLen - 1 ? windowLen : lastWindowActualSize;
+                // adjust value since the last window might be shorter than windowLen
+                int value = covInfo == NULL ? 0 : covInfo->coverage * windowLen / actualWindowSize;
+                incrementCountDataOfOverlappingAnnotations(args->countDataPerAnnotation,
+                                                           biasDetector->numberOfAnnotations,
+                                                           covInfo,
+                                                           value,
+                                                           (double) actualWindowSize);
+            }
+        } else {
+            stList *blocks = stList_get(args->units, unitIndex);
+            for (int i = from; i < to; i++) {
+                ptBlock *block = stList_get(blocks, i);
+                CoverageInfo *covInfo = (CoverageInfo *) block->data;
+                int count = block->rfe - block->rfs + 1;
+                incrementCountDataOfOverlappingAnnotations(args->countDataPerAnnotation,
+                                                           biasDetector->numberOfAnnotations,
+                                                           covInfo,
+                                                           covInfo->coverage,
+                                                           (double) count);
+            }
+        }
+    }
+}
+
+void BiasDetector_updateCountDataByJobForThreadPool(void *argWork_) {
+    work_arg_t *argWork = argWork_;
+    BiasDetectorCountJobArgs *args = argWork->data;
+    BiasDetector_updateCountDataByJob(args);
+    free(argWork);
+}
+
+// split all blocks/windows of the units into contiguous ranges with equal sizes (one per job).
+// each job fills its own count data and they are added to the count data of the bias detector at the end
+static void BiasDetector_setCountDataPerAnnotationByUnits(BiasDetector *biasDetector,
+                                                          stList *units,
+                                                          int64_t *firstElementIndexPerUnit,
+                                                          int threads) {
+    int64_t totalNumberOfElements = firstElementIndexPerUnit[stList_length(units)];
+    int numberOfJobs = totalNumberOfElements < threads ? (int) totalNumberOfElements : threads;
+    numberOfJobs = numberOfJobs < 1 ? 1 : numberOfJobs;
+    BiasDetectorCountJobArgs *argsPerJob = malloc(numberOfJobs * sizeof(BiasDetectorCountJobArgs));
+    tpool_t *threadPool = tpool_create(numberOfJobs);
+    for (int jobIndex = 0; jobIndex < numberOfJobs; jobIndex++) {
+        BiasDetectorCountJobArgs *args = &argsPerJob[jobIndex];
+        args->biasDetector = biasDetector;
+        args->units = units;
+        args->firstElementIndexPerUnit = firstElementIndexPerUnit;
+        args->startIndex = totalNumberOfElements * jobIndex / numberOfJobs;
+        args->endIndex = totalNumberOfElements * (jobIndex + 1) / numberOfJobs;
+        args->countDataPerAnnotation = CountData_construct1DArray(MAX_COVERAGE_VALUE,
+                                                                  biasDetector->numberOfAnnotations);
+        work_arg_t *argWork = malloc(sizeof(work_arg_t));
+        argWork->data = (void *) args;
+        tpool_add_work(threadPool, BiasDetector_updateCountDataByJobForThreadPool, (void *) argWork);
+    }
+    tpool_wait(threadPool);
+    tpool_destroy(threadPool);
+
+    // merge the counts of all jobs
+    for (int jobIndex = 0; jobIndex < numberOfJobs; jobIndex++) {
+        BiasDetectorCountJobArgs *args = &argsPerJob[jobIndex];
+        for (int annotationIndex = 0; annotationIndex < biasDetector->numberOfAnnotations; annotationIndex++) {
+            CountData_add(biasDetector->countDataPerAnnotation[annotationIndex],
+                          args->countDataPerAnnotation[annotationIndex]);
+        }
+        CountData_destruct1DArray(args->countDataPerAnnotation, biasDetector->numberOfAnnotations);
+    }
+    free(argsPerJob);
+}
 
-void BiasDetector_setCountDataPerAnnotationForStartOnlyMode(BiasDetector *biasDetector, stHash *blockTable) {
+void BiasDetector_setCountDataPerAnnotationForStartOnlyMode(BiasDetector *biasDetector, stHash *blockTable,
+                                                            int threads) {
     int windowLen = biasDetector->averageAlignmentLength;
     stList *chunks = Chunk_parseContigChunkListFromMemory(blockTable,
                                                           biasDetector->contigLengthTable,
                                                           windowLen,
                                                           biasDetector->startOnlyMode);
     // each chunk covers a whole contig
+    int64_t *firstWindowIndexPerChunk = malloc((stList_length(chunks) + 1) * sizeof(int64_t));
+    firstWindowIndexPerChunk[0] = 0;
     for (int chunkIndex = 0; chunkIndex < stList_length(chunks); chunkIndex++) {
         Chunk *chunk = stList_get(chunks, chunkIndex);
-        int chunkLen = chunk->e - chunk->s + 1;
-        int lastWindowActualSize = chunkLen - windowLen * (chunk->coverageInfoSeqLen - 1);
-        for (int windowIndex=0; windowIndex < chunk->coverageInfoSeqLen; windowIndex++){
-            CoverageInfo *covInfo = chunk->coverageInfoSeq[windowIndex];
-            for (int annotationIndex = 0; annotationIndex < biasDetector->numberOfAnnotations; annotationIndex++) {
-                if (CoverageInfo_overlapAnnotationIndex(covInfo,
-                                                        annotationIndex)) { // checking overlap is fast (a few bit-wise operations)
-                    int actualWindowSize = windowIndex < chunk->coverageInfoSeqLen - 1 ? windowLen : lastWindowActualSize;
-                    // adjust value since the last window might be shorter than windowLen
-                    int value = covInfo->coverage * windowLen / actualWindowSize;
-                    CountData_increment(biasDetector->countDataPerAnnotation[annotationIndex], value, (double) actualWindowSize);
-                }
-            }
-        }
+        firstWindowIndexPerChunk[chunkIndex + 1] = firstWindowIndexPerChunk[chunkIndex] + chunk->coverageInfoSeqLen;
     }
+    BiasDetector_setCountDataPerAnnotationByUnits(biasDetector, chunks, firstWindowIndexPerChunk, threads);
+    free(firstWindowIndexPerChunk);
     stList_destruct(chunks);
 }
 
-void BiasDetector_setCountDataPerAnnotation(BiasDetector *biasDetector, stHash *blockTable) {
+void BiasDetector_setCountDataPerAnnotation(BiasDetector *biasDetector, stHash *blockTable, int threads) {
+    // make a list of the block lists of all contigs
+    stList *blocksPerContig = stList_construct();
     stHashIterator *it = stHash_getIterator(blockTable);
     char *contigName;
     while ((contigName = stHash_getNext(it)) != NULL) {
-        stList *blocks = stHash_search(blockTable, contigName);
-        for (int i = 0; i < stList_length(blocks); i++) {
-            ptBlock *block = stList_get(blocks, i);
-            CoverageInfo *covInfo = (CoverageInfo *) block->data;
-            for (int annotationIndex = 0; annotationIndex < biasDetector->numberOfAnnotations; annotationIndex++) {
-                if (CoverageInfo_overlapAnnotationIndex(covInfo,
-                                                        annotationIndex)) { // checking overlap is fast (a few bit-wise operations)
-                    int count = block->rfe - block->rfs + 1;
-                    int value = covInfo->coverage;
-                    CountData_increment(biasDetector->countDataPerAnnotation[annotationIndex], value, (double) count);
-                }
-            }
-        }
+        stList_append(blocksPerContig, stHash_search(blockTable, contigName));
+    }
+    stHash_destructIterator(it);
+    int64_t *firstBlockIndexPerContig = malloc((stList_length(blocksPerContig) + 1) * sizeof(int64_t));
+    firstBlockIndexPerContig[0] = 0;
+    for (int contigIndex = 0; contigIndex < stList_length(blocksPerContig); contigIndex++) {
+        stList *blocks = stList_get(blocksPerContig, contigIndex);
+        firstBlockIndexPerContig[contigIndex + 1] = firstBlockIndexPerContig[contigIndex] + stList_length(blocks);
     }
+    BiasDetector_setCountDataPerAnnotationByUnits(biasDetector, blocksPerContig, firstBlockIndexPerContig, threads);
+    free(firstBlockIndexPerContig);
+    stList_destruct(blocksPerContig);
 }
 
 void BiasDetector_setMostFrequentCoveragePerAnnotation(BiasDetector *biasDetector) {
@@ -79,7 +79,8 @@ BiasDetector *BiasDetector_construct(stList *annotationNames,
 
 void BiasDetector_destruct(BiasDetector *biasDetector);
 
-void BiasDetector_setStatisticsPerAnnotation(BiasDetector *biasDetector, stHash *blockTable);
+// fill the coverage histograms of all annotations with multiple threads and compute their statistics
+void BiasDetector_setStatisticsPerAnnotation(BiasDetector *biasDetector, stHash *blockTable, int threads);
 
 void BiasDetector_setMostFrequentCoveragePerAnnotation(BiasDetector *biasDetector);
 
@@ -91,8 +92,33 @@ void BiasDetector_runBiasDetection(BiasDetector *biasDetector,
                                    stList *annotationNamesToCheck,
                                    const char *tsvPathToWriteTable);
 
-void BiasDetector_setCountDataPerAnnotationForStartOnlyMode(BiasDetector *biasDetector, stHash *blockTable);
+void BiasDetector_setCountDataPerAnnotationForStartOnlyMode(BiasDetector *biasDetector, stHash *blockTable,
+                                                            int threads);
 
-void BiasDetector_setCountDataPerAnnotation(BiasDetector *biasDetector, stHash *blockTable);
+void BiasDetector_setCountDataPerAnnotation(BiasDetector *biasDetector, stHash *blockTable, int threads);
+
+/*! @typedef
+ * @abstract Structure for the arguments of a job that fills coverage histograms for a range of blocks
+ * @field biasDetector                  The bias detector (its count data is not updated by the job)
+ * @field units                         A list of units; each unit is a list of blocks of one contig or
+ *                                      a chunk of windows in the start-only mode
+ * @field firstElementIndexPerUnit      The global index of the first block/window of each unit
+ *                                      (its length is the number of units plus one)
+ * @field startIndex                    The global index of the first block/window of the job
+ * @field endIndex                      The global index after the last block/window of the job
+ * @field countDataPerAnnotation        An array of CountData owned by the job; one per annotation
+ */
+typedef struct {
+    BiasDetector *biasDetector;
+    stList *units;
+    int64_t *firstElementIndexPerUnit;
+    int64_t startIndex;
+    int64_t endIndex;
+    CountData **countDataPerAnnotation;
+} BiasDetectorCountJobArgs;
+
+void BiasDetector_updateCountDataByJob(BiasDetectorCountJobArgs *args);
+
+void BiasDetector_updateCountDataByJobForThreadPool(void *argWork_);
 
 #endif //BIAS_DETECTOR_H
@@ -39,6 +39,7 @@ Chunk *Chunk_construct(int chunkCanonicalLen) {
     chunk->windowSumCoverageHighClip = 0.0;
     chunk->windowRegionArray = NULL;
     chunk->windowTruthArray = NULL;
+    chunk->windowPredictionArray = NULL;
     chunk->fileOffset = 0;
     chunk->startOnlyMode = false;
     return chunk;
@@ -116,6 +117,7 @@ void Chunk_destruct(Chunk *chunk) {
     }*/
     free(chunk->windowRegionArray);
     free(chunk->windowTruthArray);
+    free(chunk->windowPredictionArray);
     free(chunk);
 }
 
@@ -138,48 +140,56 @@ ChunksCreator *ChunksCreator_constructEmpty() {
 }
 
 
-ChunksCreator *
-ChunksCreator_constructFromCov(char *covPath, char *faiPath, int chunkCanonicalLen, int nThreads, int windowLen) {
-    char *extension = extractFileExtension(covPath);
-    if (strcmp(extension, "cov") != 0 &&
-        strcmp(extension, "cov.gz") != 0 &&
-        strcmp(extension, "bed") != 0 &&
-        strcmp(extension, "bed.gz") != 0) {
-        fprintf(stderr,
-                "[%s][Error] Coverage file's extension can be either '.cov', '.cov.gz', 'bed' or 'bed.gz': %s\n",
-                get_timestamp(), covPath);
-        exit(EXIT_FAILURE);
-    }
-    ChunksCreator *chunksCreator = malloc(sizeof(ChunksCreator));
+// parse the template chunks (chunks with no coverage data) from the index of the given cov file.
+// The index will be created if it does not exist or it was created with a different chunk length
+stList *ChunksCreator_constructTemplateChunks(char *covPath, char *faiPath, int chunkCanonicalLen) {
+    stList *templateChunks = NULL;
     char covIndexPath[1000];
     sprintf(covIndexPath, "%s.index", covPath);
     if (!file_exists(covIndexPath)) {
         fprintf(stderr, "[%s] Index file does not exist: expected path %s\n", get_timestamp(), covIndexPath);
         fprintf(stderr, "[%s] Constructing index in memory ... \n", get_timestamp());
-        chunksCreator->templateChunks = ChunksCreator_createCovIndex(covPath, faiPath, chunkCanonicalLen);
+        templateChunks = ChunksCreator_createCovIndex(covPath, faiPath, chunkCanonicalLen);
         fprintf(stderr, "[%s] Index is constructed.\n", get_timestamp());
-        ChunksCreator_writeCovIndex(chunksCreator->templateChunks, covIndexPath);
+        ChunksCreator_writeCovIndex(templateChunks, covIndexPath);
         fprintf(stderr, "[%s] Index is saved into %s (It will skip index construction for next runs).\n", get_timestamp(), covIndexPath);
 
     } else {
         fprintf(stderr, "[%s] Index file exists: %s\n", get_timestamp(), covIndexPath);
         fprintf(stderr, "[%s] Parsing index ... \n", get_timestamp());
-        chunksCreator->templateChunks = ChunksCreator_parseCovIndex(covIndexPath);
+        templateChunks = ChunksCreator_parseCovIndex(covIndexPath);
         fprintf(stderr, "[%s] Index is parsed from disk.\n", get_timestamp());
 
         // check canonical chunk length and reindex if necessary
-        Chunk *firstChunk = stList_get(chunksCreator->templateChunks, 0);
+        Chunk *firstChunk = stList_get(templateChunks, 0);
         if (firstChunk->chunkCanonicalLen != chunkCanonicalLen) {
             fprintf(stderr,
                     "[%s] Warning: Chunk length of the parsed index is %d which does not match the expected value %d\n",
                     get_timestamp(), firstChunk->chunkCanonicalLen, chunkCanonicalLen);
-            stList_destruct(chunksCreator->templateChunks);
+            stList_destruct(templateChunks);
             fprintf(stderr, "[%s] Constructing index in memory for chunk length of %d  ...\n", get_timestamp(),
                     chunkCanonicalLen);
-            chunksCreator->templateChunks = ChunksCreator_createCovIndex(covPath, faiPath, chunkCanonicalLen);
+            templateChunks = ChunksCreator_createCovIndex(covPath, faiPath, chunkCanonicalLen);
             fprintf(stderr, "[%s] New index is constructed.\n", get_timestamp());
         }
     }
+    return templateChunks;
+}
+
+ChunksCreator *
+ChunksCreator_constructFromCov(char *covPath, char *faiPath, int chunkCanonicalLen, int nThreads, int windowLen) {
+    char *extension = extractFileExtension(covPath);
+    if (strcmp(extension, "cov") != 0 &&
+        strcmp(extension, "cov.gz") != 0 &&
+        strcmp(extension, "bed") != 0 &&
+        strcmp(extension, "bed.gz") != 0) {
+        fprintf(stderr,
+                "[%s][Error] Coverage file's extension can be either '.cov', '.cov.gz', 'bed' or 'bed.gz': %s\n",
+                get_timestamp(), covPath);
+        exit(EXIT_FAILURE);
+    }
+    ChunksCreator *chunksCreator = malloc(sizeof(ChunksCreator));
+    chunksCreator->templateChunks = ChunksCreator_constructTemplateChunks(covPath, faiPath, chunkCanonicalLen);
     chunksCreator->covPath = copyString(covPath);
     // parse attributes from header lines
     fprintf(stderr, "[%s] Parsing header info for ChunksCreator.\n", get_timestamp());
@@ -451,27 +461,33 @@ int Chunk_addTrack(Chunk *chunk, TrackReader *trackReader) {
     assert(canonicalStart == max(trackReader->s, chunk->s));
     int canonicalBasesToAdd = min(trackReader->e, chunk->e) - max(trackReader->s, chunk->s) + 1;
     if (canonicalBasesToAdd <= 0) return 0;
+    // the attrbs in the trackReader include coverage values and region index
+    // they are the same for all bases of the track so they are parsed once
+    double coverage = atof(trackReader->attrbs[0]);
+    double coverageHighMapq = atof(trackReader->attrbs[1]);
+    double coverageHighClip = atof(trackReader->attrbs[2]);
+    // get annotation indices
+    int len = 0;
+    int *annotationIndices = Splitter_getIntArray(trackReader->attrbs[3], ',', &len);
+    uint64_t annotationFlag = CoverageInfo_getAnnotationFlagFromArray(annotationIndices, len);
+    free(annotationIndices);
+    // the first attribute right after annotation indices is the region index
+    int regionIndex = atoi(trackReader->attrbs[4]);
+    // parse truth and prediction labels if they exist (optional attributes)
+    int truth = 6 <= trackReader->attrbsLen ? atoi(trackReader->attrbs[5]) : -1;
+    int prediction = 7 <= trackReader->attrbsLen ? atoi(trackReader->attrbs[6]) : -1;
     for (int i = 0; i < canonicalBasesToAdd; i++) {
         // windowItr initial value is -1
         chunk->windowItr += 1;
         chunk->windowItr %= chunk->windowLen;
-        // the attrbs in the trackReader include coverage values and region index
-        chunk->windowSumCoverage += atof(trackReader->attrbs[0]);
-        chunk->windowSumCoverageHighMapq += atof(trackReader->attrbs[1]);
-        chunk->windowSumCoverageHighClip += atof(trackReader->attrbs[2]);
-        // get annotation indices and update window flag for annotation
-        int len = 0;
-        int *annotationIndices = Splitter_getIntArray(trackReader->attrbs[3], ',', &len);
+        chunk->windowSumCoverage += coverage;
+        chunk->windowSumCoverageHighMapq += coverageHighMapq;
+        chunk->windowSumCoverageHighClip += coverageHighClip;
         // use OR operation to keep all overlapping annotations
-        chunk->windowAnnotationFlag |= CoverageInfo_getAnnotationFlagFromArray(annotationIndices, len);
-        free(annotationIndices);
-        // the first attribute right after annotation indices is the region index
-        chunk->windowRegionArray[chunk->windowItr] = atoi(trackReader->attrbs[4]);
-        // parse truth label if it exists (optional attribute)
-        chunk->windowTruthArray[chunk->windowItr] = 6 <= trackReader->attrbsLen ? atoi(trackReader->attrbs[5]) : -1;
-        // parse prediction label if it exists (optional attribute)
-        chunk->windowPredictionArray[chunk->windowItr] =
-                7 <= trackReader->attrbsLen ? atoi(trackReader->attrbs[6]) : -1;
+        chunk->windowAnnotationFlag = AnnotationFlag_or(chunk->windowAnnotationFlag, annotationFlag);
+        chunk->windowRegionArray[chunk->windowItr] = regionIndex;
+        chunk->windowTruthArray[chunk->windowItr] = truth;
+        chunk->windowPredictionArray[chunk->windowItr] = prediction;
         if (chunk->windowItr == chunk->windowLen - 1) { // the window is fully iterated
             int ret = Chunk_addWindow(chunk);
             if (ret == 1) {
@@ -593,6 +609,76 @@ stList *Chunk_parseContigChunkListFromMemory(stHash* coverageBlockTable,
     return chunks;
 }
 
+// replace the interned ids of the annotation sets that are not inline in the given flags with their
+// indices in the returned list (interned ids are only valid within one process)
+stList *Chunk_getWideAnnotationSets(uint64_t *annotationArray, int len) {
+    stList *wideSets = stList_construct();
+    for (int i = 0; i < len; i++) {
+        if (!AnnotationFlag_isSpilled(annotationArray[i])) continue;
+        uint64_t annotationFlag = annotationArray[i] & ~ANNOTATION_FLAG_REGION_MASK;
+        // chunks usually have a handful of distinct sets
+        int localId = 0;
+        while (localId < stList_length(wideSets) && (uint64_t) stList_get(wideSets, localId) != annotationFlag) {
+            localId++;
+        }
+        if (localId == stList_length(wideSets)) {
+            stList_append(wideSets, (void *) annotationFlag);
+        }
+        annotationArray[i] = (annotationArray[i] & ANNOTATION_FLAG_REGION_MASK) | ANNOTATION_FLAG_SPILL_BIT |
+                             (uint64_t) localId;
+    }
+    return wideSets;
+}
+
+// write the annotation sets returned by Chunk_getWideAnnotationSets
+void Chunk_writeWideAnnotationSets(stList *wideSets, FILE *fp) {
+    int32_t numberOfWordsPerSet = 0;
+    for (int s = 0; s < stList_length(wideSets); s++) {
+        uint64_t buffer;
+        int numberOfWords = 0;
+        AnnotationFlag_getWords((uint64_t) stList_get(wideSets, s), &buffer, &numberOfWords);
+        numberOfWordsPerSet = max(numberOfWordsPerSet, numberOfWords);
+    }
+    int32_t numberOfWideSets = stList_length(wideSets);
+    fwrite(&numberOfWideSets, sizeof(int32_t), 1, fp);
+    fwrite(&numberOfWordsPerSet, sizeof(int32_t), 1, fp);
+    uint64_t *setWords = malloc(max(numberOfWordsPerSet, 1) * sizeof(uint64_t));
+    for (int s = 0; s < numberOfWideSets; s++) {
+        uint64_t buffer;
+        int numberOfWords = 0;
+        const uint64_t *words = AnnotationFlag_getWords((uint64_t) stList_get(wideSets, s), &buffer, &numberOfWords);
+        memset(setWords, 0, numberOfWordsPerSet * sizeof(uint64_t));
+        memcpy(setWords, words, numberOfWords * sizeof(uint64_t));
+        fwrite(setWords, sizeof(uint64_t), numberOfWordsPerSet, fp);
+    }
+    free(setWords);
+}
+
+// read the table written by Chunk_writeWideAnnotationSets and intern the sets in the given flags
+void Chunk_readWideAnnotationSets(uint64_t *annotationArray, int len, FILE *fp) {
+    int32_t numberOfWideSets = 0;
+    int32_t numberOfWordsPerSet = 0;
+    fread(&numberOfWideSets, sizeof(int32_t), 1, fp);
+    fread(&numberOfWordsPerSet, sizeof(int32_t), 1, fp);
+    uint64_t *flagPerWideSet = malloc(max(numberOfWideSets, 1) * sizeof(uint64_t));
+    uint64_t *setWords = malloc(max(numberOfWordsPerSet, 1) * sizeof(uint64_t));
+    for (int s = 0; s < numberOfWideSets; s++) {
+        fread(setWords, sizeof(uint64_t), numberOfWordsPerSet, fp);
+        flagPerWideSet[s] = AnnotationFlag_constructFromWords(setWords, numberOfWordsPerSet);
+    }
+    for (int i = 0; i < len; i++) {
+        if (!AnnotationFlag_isSpilled(annotationArray[i])) continue;
+        int localId = annotationArray[i] & ANNOTATION_FLAG_INLINE_MASK;
+        if (numberOfWideSets <= localId) {
+            fprintf(stderr, "[%s] Error: The bin file has an invalid annotation set.\n", get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        annotationArray[i] = (annotationArray[i] & ANNOTATION_FLAG_REGION_MASK) | flagPerWideSet[localId];
+    }
+    free(flagPerWideSet);
+    free(setWords);
+}
+
 void ChunksCreator_writeChunksIntoBinaryFile(ChunksCreator *chunksCreator, char *binPath) {
     stList *chunks = chunksCreator->chunks;
     int chunkCanonicalLen = chunksCreator->chunkCanonicalLen;
@@ -687,6 +773,12 @@ void ChunksCreator_writeChunksIntoBinaryFile(ChunksCreator *chunksCreator, char
                 predictionArray[i] = -1;
             }
         }
+        // annotation sets that do not fit inline in the flags are written after the arrays
+        // (only when there are more annotations than the inline capacity)
+        stList *wideSets = NULL;
+        if (MAX_NUMBER_OF_INLINE_ANNOTATIONS < numberOfAnnotations) {
+            wideSets = Chunk_getWideAnnotationSets(annotationArray, chunk->coverageInfoSeqLen);
+        }
         // write arrays
         fwrite(covArray1, sizeof(uint16_t), chunk->coverageInfoSeqLen, fp);
         fwrite(covArray2, sizeof(uint16_t), chunk->coverageInfoSeqLen, fp);
@@ -694,6 +786,10 @@ void ChunksCreator_writeChunksIntoBinaryFile(ChunksCreator *chunksCreator, char
         fwrite(annotationArray, sizeof(uint64_t), chunk->coverageInfoSeqLen, fp);
         fwrite(truthArray, sizeof(int8_t), chunk->coverageInfoSeqLen, fp);
         fwrite(predictionArray, sizeof(int8_t), chunk->coverageInfoSeqLen, fp);
+        if (wideSets != NULL) {
+            Chunk_writeWideAnnotationSets(wideSets, fp);
+            stList_destruct(wideSets);
+        }
         // free buffers
         free(covArray1);
         free(covArray2);
@@ -802,6 +898,9 @@ void ChunksCreator_parseChunksFromBinaryFile(ChunksCreator *chunksCreator, char
         fread(annotationArray, sizeof(uint64_t), chunk->coverageInfoSeqLen, fp);
         fread(truthArray, sizeof(int8_t), chunk->coverageInfoSeqLen, fp);
         fread(predictionArray, sizeof(int8_t), chunk->coverageInfoSeqLen, fp);
+        if (MAX_NUMBER_OF_INLINE_ANNOTATIONS < header->numberOfAnnotations) {
+            Chunk_readWideAnnotationSets(annotationArray, chunk->coverageInfoSeqLen, fp);
+        }
         for (int i = 0; i < chunk->coverageInfoSeqLen; i++) {
             chunk->coverageInfoSeq[i]->coverage = covArray1[i];
             chunk->coverageInfoSeq[i]->coverage_high_mapq = covArray2[i];
@@ -908,6 +1007,26 @@ void ChunkIterator_destruct(ChunkIterator *chunkIterator) {
     free(chunkIterator);
 }
 
+void ChunkIterator_seek(ChunkIterator *chunkIterator, int chunkIndex, int windowIndex) {
+    chunkIterator->nextChunkIndex = chunkIndex;
+    chunkIterator->nextWindowIndex = windowIndex;
+}
+
+int ChunkIterator_getChunkIndex(ChunkIterator *chunkIterator) {
+    // the chunk index is increased only when the next block is requested
+    return chunkIterator->nextChunkIndex;
+}
+
+int *ChunkIterator_getNumberOfBlocksPerChunk(ChunkIterator *chunkIterator, int *numberOfChunks) {
+    *numberOfChunks = chunkIterator->numberOfChunks;
+    int *numberOfBlocksPerChunk = Int_construct1DArray(chunkIterator->numberOfChunks);
+    for (int chunkIndex = 0; chunkIndex < chunkIterator->numberOfChunks; chunkIndex++) {
+        Chunk *chunk = stList_get(chunkIterator->chunksCreator->chunks, chunkIndex);
+        numberOfBlocksPerChunk[chunkIndex] = chunk->coverageInfoSeqLen;
+    }
+    return numberOfBlocksPerChunk;
+}
+
 ptBlock *ChunkIterator_getNextPtBlock(ChunkIterator *chunkIterator, char *ctg_name) {
     if (chunkIterator->nextChunkIndex == chunkIterator->numberOfChunks) {
         ctg_name[0] = '\0';
@@ -1119,6 +1238,69 @@ void ChunksCreator_writePredictionIntoFinalBED(ChunksCreator *chunksCreator, cha
     ChunkIterator_destruct(iterator);
 }
 
+void ChunkFlankedSeq_destruct(ChunkFlankedSeq *flankedSeq) {
+    free(flankedSeq->coverageInfoSeq);
+    free(flankedSeq);
+}
+
+static bool Chunk_isFollowedBy(Chunk *chunk, Chunk *nextChunk) {
+    return strcmp(chunk->ctg, nextChunk->ctg) == 0 && chunk->e + 1 == nextChunk->s;
+}
+
+stList *ChunksCreator_constructFlankedSeqs(ChunksCreator *chunksCreator, int flankLen) {
+    stList *chunks = chunksCreator->chunks;
+    int numberOfChunks = stList_length(chunks);
+    // number of windows needed in each flank
+    int flankWindows = (flankLen + chunksCreator->windowLen - 1) / chunksCreator->windowLen;
+    stList *flankedSeqs = stList_construct3(0, (void (*)(void *)) ChunkFlankedSeq_destruct);
+    for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+        Chunk *chunk = stList_get(chunks, chunkIndex);
+        // walk over the adjacent chunks of the same contig until the flanks are long enough
+        int leftWindows = 0;
+        int leftIndex = chunkIndex;
+        while (leftWindows < flankWindows && 0 < leftIndex &&
+               Chunk_isFollowedBy(stList_get(chunks, leftIndex - 1), stList_get(chunks, leftIndex))) {
+            leftIndex -= 1;
+            leftWindows += ((Chunk *) stList_get(chunks, leftIndex))->coverageInfoSeqLen;
+        }
+        leftWindows = min(leftWindows, flankWindows);
+        int rightWindows = 0;
+        int rightIndex = chunkIndex;
+        while (rightWindows < flankWindows && rightIndex < numberOfChunks - 1 &&
+               Chunk_isFollowedBy(stList_get(chunks, rightIndex), stList_get(chunks, rightIndex + 1))) {
+            rightIndex += 1;
+            rightWindows += ((Chunk *) stList_get(chunks, rightIndex))->coverageInfoSeqLen;
+        }
+        rightWindows = min(rightWindows, flankWindows);
+
+        ChunkFlankedSeq *flankedSeq = malloc(sizeof(ChunkFlankedSeq));
+        flankedSeq->coverageInfoSeqLen = leftWindows + chunk->coverageInfoSeqLen + rightWindows;
+        flankedSeq->coverageInfoSeq = malloc(flankedSeq->coverageInfoSeqLen * sizeof(CoverageInfo *));
+        flankedSeq->coreStart = leftWindows;
+        flankedSeq->coreEnd = leftWindows + chunk->coverageInfoSeqLen;
+        // fill the left flank backward starting from the last window of the previous chunk
+        int pos = leftWindows - 1;
+        for (int i = chunkIndex - 1; 0 <= pos; i--) {
+            Chunk *leftChunk = stList_get(chunks, i);
+            for (int w = leftChunk->coverageInfoSeqLen - 1; 0 <= w && 0 <= pos; w--, pos--) {
+                flankedSeq->coverageInfoSeq[pos] = leftChunk->coverageInfoSeq[w];
+            }
+        }
+        memcpy(flankedSeq->coverageInfoSeq + leftWindows, chunk->coverageInfoSeq,
+               chunk->coverageInfoSeqLen * sizeof(CoverageInfo *));
+        // fill the right flank forward starting from the first window of the next chunk
+        pos = flankedSeq->coreEnd;
+        for (int i = chunkIndex + 1; pos < flankedSeq->coverageInfoSeqLen; i++) {
+            Chunk *rightChunk = stList_get(chunks, i);
+            for (int w = 0; w < rightChunk->coverageInfoSeqLen && pos < flankedSeq->coverageInfoSeqLen; w++, pos++) {
+                flankedSeq->coverageInfoSeq[pos] = rightChunk->coverageInfoSeq[w];
+            }
+        }
+        stList_append(flankedSeqs, flankedSeq);
+    }
+    return flankedSeqs;
+}
+
 int ChunksCreator_getTotalNumberOfChunks(ChunksCreator *chunksCreator) {
     return (int) stList_length(chunksCreator->chunks);
 }
@@ -78,6 +78,8 @@ stList *Chunk_parseContigChunkListFromMemory(stHash* coverageBlockTable,
 
 ChunksCreator *ChunksCreator_constructEmpty();
 
+stList *ChunksCreator_constructTemplateChunks(char *covPath, char *faiPath, int chunkCanonicalLen);
+
 ChunksCreator *
 ChunksCreator_constructFromCov(char *covPath, char *faiPath, int chunkCanonicalLen, int nThreads, int windowLen);
 
@@ -115,6 +117,12 @@ void ChunksCreator_writeChunksIntoBedGraph(ChunksCreator *chunksCreator,
                                            u_int16_t (*getCoverageInfoAttribute)(CoverageInfo *),
                                            const char *color);
 
+stList *Chunk_getWideAnnotationSets(uint64_t *annotationArray, int len);
+
+void Chunk_writeWideAnnotationSets(stList *wideSets, FILE *fp);
+
+void Chunk_readWideAnnotationSets(uint64_t *annotationArray, int len, FILE *fp);
+
 void ChunksCreator_parseChunksFromBinaryFile(ChunksCreator *chunksCreator, char *binPath);
 
 void ChunksCreator_writeChunksIntoBinaryFile(ChunksCreator *chunksCreator, char *binPath);
@@ -123,6 +131,21 @@ void ChunksCreator_writePredictionIntoFinalBED(ChunksCreator *chunksCreator, cha
 
 int ChunksCreator_getTotalNumberOfChunks(ChunksCreator *chunksCreator);
 
+// The coverage info sequence of a chunk extended with the windows of its adjacent chunks
+// on the same contig (flanks). The windows of the chunk itself are in [coreStart, coreEnd)
+typedef struct ChunkFlankedSeq {
+    CoverageInfo **coverageInfoSeq; // pointers to windows owned by the chunks (not copied)
+    int coverageInfoSeqLen;
+    int coreStart;
+    int coreEnd;
+} ChunkFlankedSeq;
+
+void ChunkFlankedSeq_destruct(ChunkFlankedSeq *flankedSeq);
+
+// Create one flanked sequence per chunk (in the same order as chunksCreator->chunks).
+// Each flank covers at least flankLen bases unless the contig ends earlier; flankLen = 0 means no flanks
+stList *ChunksCreator_constructFlankedSeqs(ChunksCreator *chunksCreator, int flankLen);
+
 int64_t ChunksCreator_getTotalLength(ChunksCreator *chunksCreator);
 
 typedef struct ChunkIterator {
@@ -143,4 +166,13 @@ ptBlock *ChunkIterator_getNextPtBlock(ChunkIterator *chunkIterator, char *ctg_na
 
 void ChunkIterator_reset(ChunkIterator *chunkIterator);
 
+// set the iterator to return the window with the given index in the given chunk as the next block
+void ChunkIterator_seek(ChunkIterator *chunkIterator, int chunkIndex, int windowIndex);
+
+// returns the index of the chunk containing the last returned block
+int ChunkIterator_getChunkIndex(ChunkIterator *chunkIterator);
+
+// returns an array with the number of blocks (windows) in each chunk
+int *ChunkIterator_getNumberOfBlocksPerChunk(ChunkIterator *chunkIterator, int *numberOfChunks);
+
 #endif /* CHUNK_H */
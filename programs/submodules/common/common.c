@@ -65,14 +65,10 @@ char *extractFileExtension(char *filePath) {
     return extension;
 }
 
-int getFirstIndexWithNonZeroBitFromRight(int32_t a) {
-    int n = 0;
-    for (; n < 32; n++) {
-        if ((a >> n) & 1) {
-            return n;
-        }
-    }
-    return -1;
+int getFirstIndexWithNonZeroBitFromRight(uint64_t a) {
+    if (a == 0ULL) return -1;
+    // count trailing zeros
+    return __builtin_ctzll(a);
 }
 
 char *copyString(char *str) {
@@ -123,6 +119,27 @@ char *get_timestamp() {
     return timestamp;
 }
 
+uint64_t get_file_content_hash(char *file_path) {
+    FILE *f = fopen(file_path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "[%s] Error: Couldn't open %s\n", get_timestamp(), file_path);
+        exit(EXIT_FAILURE);
+    }
+    size_t buffer_size = 1 << 20;
+    unsigned char *buffer = malloc(buffer_size);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t length;
+    while ((length = fread(buffer, 1, buffer_size, f)) > 0) {
+        for (size_t i = 0; i < length; i++) {
+            hash ^= buffer[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    free(buffer);
+    fclose(f);
+    return hash;
+}
+
 bool file_exists(char *filename) {
     struct stat buffer;
     return (stat(filename, &buffer) == 0);
@@ -215,6 +232,21 @@ double **Double_copy2DArray(double **src, int length1, int length2) {
     return dest;
 }
 
+float **Float_construct2DArray(int length1, int length2) {
+    float **array = malloc(length1 * sizeof(float *));
+    float *block = calloc((size_t) length1 * length2, sizeof(float));
+    for (int i = 0; i < length1; i++) {
+        array[i] = block + (size_t) i * length2;
+    }
+    return array;
+}
+
+void Float_destruct2DArray(float **array) {
+    if (array == NULL) return;
+    free(array[0]);
+    free(array);
+}
+
 
 void Double_multiply1DArray(double *array, int length, double factor) {
     for (int i = 0; i < length; i++) {
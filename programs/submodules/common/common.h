@@ -46,7 +46,7 @@ double get_random_number(double start, double end);
 
 char *extractFileExtension(char *filePath);
 
-int getFirstIndexWithNonZeroBitFromRight(int32_t a);
+int getFirstIndexWithNonZeroBitFromRight(uint64_t a);
 
 char *get_timestamp();
 
@@ -56,6 +56,9 @@ bool folder_exists(char *folderpath);
 
 char *read_whole_file(char *file_path, size_t *length_ptr, char *mode);
 
+// 64-bit FNV-1a hash of the file content (used for detecting changes in the input files of cached indices)
+uint64_t get_file_content_hash(char *file_path);
+
 char *copyString(char *str);
 
 void removeSpacesInPlace(char *s);
@@ -98,6 +101,11 @@ double *Double_copy1DArray(double *src, int length);
 
 double **Double_copy2DArray(double **src, int length1, int length2);
 
+// rows are allocated in one contiguous block and initialized to zero
+float **Float_construct2DArray(int length1, int length2);
+
+void Float_destruct2DArray(float **array);
+
 void Double_multiply1DArray(double *array, int length, double factor);
 
 void Double_multiply2DArray(double **array, int length1, int length2, double factor);
@@ -63,6 +63,15 @@ void CountData_increment(CountData *countData, int value, double count) {
     countData->totalCount += count;
 }
 
+void CountData_add(CountData *dest, CountData *src) {
+    assert(dest->countsLength == src->countsLength);
+    for (int i = 0; i < dest->countsLength; i++) {
+        dest->counts[i] += src->counts[i];
+    }
+    dest->sum += src->sum;
+    dest->totalCount += src->totalCount;
+}
+
 void CountData_reset(CountData *countData) {
     memset(countData->counts, 0, countData->countsLength * sizeof(double));
     countData->sum = 0.0;
@@ -46,6 +46,11 @@ CountData **CountData_copy1DArray(CountData **srcArray, int arrayLength);
  */
 void CountData_increment(CountData * countData, int value, double count);
 
+/*
+ * Add the counts of src to dest (both should have the same length)
+ */
+void CountData_add(CountData *dest, CountData *src);
+
 /*
  * Set all counts and related attributes to zero
  */
@@ -132,3 +132,269 @@ void CovFastReader_destruct(CovFastReader *covFastReader) {
 
 
 
+
+
+CovStreamIterator *CovStreamIterator_construct(char *covPath, stList *templateChunks, CoverageHeader *header) {
+    CovStreamIterator *iterator = malloc(sizeof(CovStreamIterator));
+    iterator->covPath = covPath;
+    iterator->templateChunks = templateChunks;
+    iterator->header = header;
+    bool zeroBasedCoors = true;
+    iterator->trackReader = TrackReader_construct(covPath, NULL, zeroBasedCoors);
+    iterator->predictionBlockTables = NULL;
+    iterator->numberOfPredictionSets = 0;
+    iterator->predictionBlockIndexPerSet = NULL;
+    iterator->predictionLabelPerSet = NULL;
+    iterator->predictionCtg[0] = '\0';
+    iterator->trackBlock = NULL;
+    iterator->subBlockStart = -1;
+    iterator->block = NULL;
+    iterator->preBlock = NULL;
+    CovStreamIterator_reset(iterator);
+    return iterator;
+}
+
+void CovStreamIterator_setPredictionSets(CovStreamIterator *iterator, stList *predictionBlockTables) {
+    free(iterator->predictionBlockIndexPerSet);
+    free(iterator->predictionLabelPerSet);
+    iterator->predictionBlockTables = predictionBlockTables;
+    iterator->numberOfPredictionSets = predictionBlockTables == NULL ? 0 : stList_length(predictionBlockTables);
+    iterator->predictionBlockIndexPerSet = Int_construct1DArray(iterator->numberOfPredictionSets);
+    iterator->predictionLabelPerSet = malloc(iterator->numberOfPredictionSets * sizeof(int8_t));
+    memset(iterator->predictionLabelPerSet, -1, iterator->numberOfPredictionSets * sizeof(int8_t));
+    iterator->predictionCtg[0] = '\0';
+}
+
+int CovStreamIterator_getNumberOfPredictionSets(CovStreamIterator *iterator) {
+    return iterator->numberOfPredictionSets;
+}
+
+int8_t *CovStreamIterator_getPredictionLabels(CovStreamIterator *iterator) {
+    return iterator->predictionLabelPerSet;
+}
+
+CovStreamIterator *CovStreamIterator_copy(CovStreamIterator *src) {
+    CovStreamIterator *dest = CovStreamIterator_construct(src->covPath, src->templateChunks, src->header);
+    if (src->chunkIndex < stList_length(src->templateChunks)) {
+        TrackReader_setFilePosition(dest->trackReader, TrackReader_getFilePosition(src->trackReader));
+        strcpy(dest->trackReader->ctg, src->trackReader->ctg);
+        dest->trackReader->ctgLen = src->trackReader->ctgLen;
+    }
+    dest->chunkIndex = src->chunkIndex;
+    dest->trackFileOffset = src->trackFileOffset;
+    if (src->trackBlock != NULL) {
+        dest->trackBlock = ptBlock_copy(src->trackBlock);
+        dest->subBlockStart = src->subBlockStart;
+    }
+    CovStreamIterator_setPredictionSets(dest, src->predictionBlockTables);
+    return dest;
+}
+
+// jump to the given file offset; the track at this offset should be located in the given chunk or after it
+static void CovStreamIterator_setFilePosition(CovStreamIterator *iterator, int chunkIndex, int64_t fileOffset) {
+    stList *templateChunks = iterator->templateChunks;
+    iterator->chunkIndex = chunkIndex;
+    // the remaining part of the last parsed track is not needed anymore
+    if (iterator->trackBlock != NULL) {
+        ptBlock_destruct(iterator->trackBlock);
+        iterator->trackBlock = NULL;
+    }
+    iterator->predictionCtg[0] = '\0';
+    if (stList_length(templateChunks) <= chunkIndex) return;
+    Chunk *templateChunk = stList_get(templateChunks, chunkIndex);
+    TrackReader_setFilePosition(iterator->trackReader, fileOffset);
+    //set contig name
+    strcpy(iterator->trackReader->ctg, templateChunk->ctg);
+    iterator->trackReader->ctgLen = templateChunk->ctgLen;
+}
+
+void CovStreamIterator_reset(CovStreamIterator *iterator) {
+    CovStreamIterator_seek(iterator, 0, 0);
+}
+
+// read the next track and find the chunk containing it. The tracks located before the current chunk
+// (possible only after seeking) are skipped. Returns false if there is no track left
+static bool CovStreamIterator_readNextTrack(CovStreamIterator *iterator) {
+    stList *templateChunks = iterator->templateChunks;
+    int numberOfChunks = stList_length(templateChunks);
+    TrackReader *trackReader = iterator->trackReader;
+    while (iterator->chunkIndex < numberOfChunks) {
+        iterator->trackFileOffset = TrackReader_getFilePosition(trackReader);
+        if (TrackReader_next(trackReader) <= 0) return false;
+        Chunk *templateChunk = stList_get(templateChunks, iterator->chunkIndex);
+        while (strcmp(trackReader->ctg, templateChunk->ctg) != 0 || templateChunk->e < trackReader->s) {
+            iterator->chunkIndex += 1;
+            if (iterator->chunkIndex == numberOfChunks) return false;
+            templateChunk = stList_get(templateChunks, iterator->chunkIndex);
+        }
+        // same rules as CovFastReaderPerThread_parseBlocks
+        if (templateChunk->s <= trackReader->s && templateChunk->fileOffset <= iterator->trackFileOffset) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// set the prediction label of each set for the block starting at subBlockStart in the last parsed track.
+// Returns the end of this block, which is either the end of the track or the last base before the
+// next boundary of prediction blocks
+static int CovStreamIterator_setPredictionLabels(CovStreamIterator *iterator) {
+    char *ctg = iterator->trackReader->ctg;
+    int start = iterator->subBlockStart;
+    int end = iterator->trackBlock->rfe;
+    bool contigChanged = strcmp(iterator->predictionCtg, ctg) != 0;
+    if (contigChanged) {
+        strcpy(iterator->predictionCtg, ctg);
+    }
+    for (int setIndex = 0; setIndex < iterator->numberOfPredictionSets; setIndex++) {
+        iterator->predictionLabelPerSet[setIndex] = -1;
+        stList *blocks = stHash_search(stList_get(iterator->predictionBlockTables, setIndex), ctg);
+        if (blocks == NULL) continue;
+        int blockIndex = contigChanged ? 0 : iterator->predictionBlockIndexPerSet[setIndex];
+        while (blockIndex < stList_length(blocks) && ((ptBlock *) stList_get(blocks, blockIndex))->rfe < start) {
+            blockIndex++;
+        }
+        iterator->predictionBlockIndexPerSet[setIndex] = blockIndex;
+        if (blockIndex == stList_length(blocks)) continue;
+        ptBlock *predictionBlock = stList_get(blocks, blockIndex);
+        if (predictionBlock->rfs <= start) {
+            CoverageInfo *coverageInfo = predictionBlock->data;
+            iterator->predictionLabelPerSet[setIndex] = get_inference_prediction_label(coverageInfo->data);
+            end = predictionBlock->rfe < end ? predictionBlock->rfe : end;
+        } else {
+            end = predictionBlock->rfs - 1 < end ? predictionBlock->rfs - 1 : end;
+        }
+    }
+    return end;
+}
+
+// find the last track located in a chunk between fromChunkIndex and toChunkIndex (both inclusive)
+// by reading the tracks from the given file offset. Returns false if there is no such track
+static bool CovStreamIterator_findLastTrack(CovStreamIterator *iterator, int fromChunkIndex, int toChunkIndex,
+                                            int64_t fileOffset, int *lastChunkIndex, int64_t *lastFileOffset) {
+    bool found = false;
+    CovStreamIterator_setFilePosition(iterator, fromChunkIndex, fileOffset);
+    while (CovStreamIterator_readNextTrack(iterator) && iterator->chunkIndex <= toChunkIndex) {
+        *lastChunkIndex = iterator->chunkIndex;
+        *lastFileOffset = iterator->trackFileOffset;
+        found = true;
+    }
+    return found;
+}
+
+void CovStreamIterator_seek(CovStreamIterator *iterator, int chunkIndex, int blockIndex) {
+    stList *templateChunks = iterator->templateChunks;
+    int numberOfChunks = stList_length(templateChunks);
+    if (numberOfChunks <= chunkIndex) {
+        iterator->chunkIndex = numberOfChunks;
+        return;
+    }
+    Chunk *templateChunk = stList_get(templateChunks, chunkIndex);
+    if (0 <= blockIndex) {
+        CovStreamIterator_setFilePosition(iterator, chunkIndex, templateChunk->fileOffset);
+        char ctg[1000];
+        for (int i = 0; i < blockIndex; i++) {
+            if (CovStreamIterator_next(iterator, ctg) == NULL) return;
+        }
+        return;
+    }
+    int lastChunkIndex = -1;
+    int64_t lastFileOffset = -1;
+    // most of the times the first track after the offset of the next chunk starts in the given chunk
+    bool found = false;
+    if (chunkIndex + 1 < numberOfChunks) {
+        Chunk *nextTemplateChunk = stList_get(templateChunks, chunkIndex + 1);
+        found = strcmp(nextTemplateChunk->ctg, templateChunk->ctg) == 0 &&
+                CovStreamIterator_findLastTrack(iterator, chunkIndex, chunkIndex, nextTemplateChunk->fileOffset,
+                                                &lastChunkIndex, &lastFileOffset);
+    }
+    // otherwise read the chunks backward until finding a non-empty one
+    for (int i = chunkIndex; !found && 0 <= i; i--) {
+        Chunk *preTemplateChunk = stList_get(templateChunks, i);
+        if (strcmp(preTemplateChunk->ctg, templateChunk->ctg) != 0) break;
+        found = CovStreamIterator_findLastTrack(iterator, i, chunkIndex, preTemplateChunk->fileOffset,
+                                                &lastChunkIndex, &lastFileOffset);
+    }
+    if (found) {
+        CovStreamIterator_setFilePosition(iterator, lastChunkIndex, lastFileOffset);
+        // the last track may be split into multiple blocks; skip all of them except the last one
+        if (0 < iterator->numberOfPredictionSets && CovStreamIterator_readNextTrack(iterator)) {
+            iterator->trackBlock = ptBlock_constructFromTrackReader(iterator->trackReader, iterator->header);
+            iterator->subBlockStart = iterator->trackBlock->rfs;
+            int subBlockEnd;
+            while ((subBlockEnd = CovStreamIterator_setPredictionLabels(iterator)) < iterator->trackBlock->rfe) {
+                iterator->subBlockStart = subBlockEnd + 1;
+            }
+        }
+    } else {
+        CovStreamIterator_setFilePosition(iterator, chunkIndex, templateChunk->fileOffset);
+    }
+}
+
+ptBlock *CovStreamIterator_next(CovStreamIterator *iterator, char *ctg) {
+    // parse a new track if the last one is returned completely
+    if (iterator->trackBlock == NULL) {
+        if (!CovStreamIterator_readNextTrack(iterator)) {
+            ctg[0] = '\0';
+            return NULL;
+        }
+        iterator->trackBlock = ptBlock_constructFromTrackReader(iterator->trackReader, iterator->header);
+        iterator->subBlockStart = iterator->trackBlock->rfs;
+    }
+    ptBlock *block;
+    if (iterator->numberOfPredictionSets == 0) {
+        block = iterator->trackBlock;
+        iterator->trackBlock = NULL;
+    } else {
+        // return the part of the track until the next boundary of prediction blocks
+        int subBlockEnd = CovStreamIterator_setPredictionLabels(iterator);
+        block = ptBlock_copy(iterator->trackBlock);
+        block->rfs = iterator->subBlockStart;
+        block->rfe = subBlockEnd;
+        if (subBlockEnd == iterator->trackBlock->rfe) {
+            ptBlock_destruct(iterator->trackBlock);
+            iterator->trackBlock = NULL;
+        } else {
+            iterator->subBlockStart = subBlockEnd + 1;
+        }
+    }
+    // the block before the previous one is not needed anymore
+    if (iterator->preBlock != NULL) {
+        ptBlock_destruct(iterator->preBlock);
+    }
+    iterator->preBlock = iterator->block;
+    iterator->block = block;
+    strcpy(ctg, iterator->trackReader->ctg);
+    return iterator->block;
+}
+
+int CovStreamIterator_getChunkIndex(CovStreamIterator *iterator) {
+    return iterator->chunkIndex;
+}
+
+int *CovStreamIterator_getChunkLengths(CovStreamIterator *iterator, int *numberOfChunks) {
+    stList *templateChunks = iterator->templateChunks;
+    *numberOfChunks = stList_length(templateChunks);
+    int *chunkLengths = Int_construct1DArray(*numberOfChunks);
+    for (int chunkIndex = 0; chunkIndex < *numberOfChunks; chunkIndex++) {
+        Chunk *templateChunk = stList_get(templateChunks, chunkIndex);
+        chunkLengths[chunkIndex] = templateChunk->e - templateChunk->s + 1;
+    }
+    return chunkLengths;
+}
+
+void CovStreamIterator_destruct(CovStreamIterator *iterator) {
+    TrackReader_destruct(iterator->trackReader);
+    free(iterator->predictionBlockIndexPerSet);
+    free(iterator->predictionLabelPerSet);
+    if (iterator->trackBlock != NULL) {
+        ptBlock_destruct(iterator->trackBlock);
+    }
+    if (iterator->block != NULL) {
+        ptBlock_destruct(iterator->block);
+    }
+    if (iterator->preBlock != NULL) {
+        ptBlock_destruct(iterator->preBlock);
+    }
+    free(iterator);
+}
@@ -51,4 +51,60 @@ CovFastReaderPerThread *CovFastReaderPerThread_construct(CovFastReader *covFastR
 
 void CovFastReaderPerThread_destruct(CovFastReaderPerThread *covFastReaderPerThread);
 
+// iterates over the tracks of a cov file in file order and creates one block per track without keeping
+// the whole block table in memory. Template chunks of the cov index are used as units for seeking;
+// a track belongs to a chunk if it starts within the chunk and is not located before the file offset of the chunk
+typedef struct CovStreamIterator {
+    // the attributes below are not owned by the iterator
+    char *covPath;
+    stList *templateChunks; // made by ChunksCreator_constructTemplateChunks
+    CoverageHeader *header;
+    // optional prediction label tables (made by ptBlock_parse_inference_label_blocks) for evaluating multiple
+    // prediction sets in one pass. If there is at least one set the tracks are split at the boundaries of all
+    // prediction blocks and the prediction label of each set can be fetched for every returned block
+    stList *predictionBlockTables; // not owned by the iterator
+    int numberOfPredictionSets;
+    int *predictionBlockIndexPerSet; // index of the first prediction block not ended before the last returned block
+    int8_t *predictionLabelPerSet; // prediction labels of the last returned block
+    char predictionCtg[1000]; // contig of predictionBlockIndexPerSet; empty if the indices should be reset
+    // the attributes below are not shared between copies
+    TrackReader *trackReader;
+    int chunkIndex; // index of the chunk containing the last parsed track
+    int64_t trackFileOffset; // file offset of the last parsed track
+    ptBlock *trackBlock; // block of the last parsed track; NULL if it is returned completely
+    int subBlockStart; // start of the next block to return from trackBlock
+    ptBlock *block; // the last returned block
+    ptBlock *preBlock; // the block returned before the last one; kept since its data may still be in use
+} CovStreamIterator;
+
+CovStreamIterator *CovStreamIterator_construct(char *covPath, stList *templateChunks, CoverageHeader *header);
+
+CovStreamIterator *CovStreamIterator_copy(CovStreamIterator *src);
+
+void CovStreamIterator_reset(CovStreamIterator *iterator);
+
+// set the iterator to return the block with the given index in the given chunk as the next block.
+// If blockIndex is -1 the next block will be the last block of the given chunk (or the last block of the
+// closest non-empty chunk before it in the same contig); if there is no such block the next block
+// will be the first block after the given chunk
+void CovStreamIterator_seek(CovStreamIterator *iterator, int chunkIndex, int blockIndex);
+
+ptBlock *CovStreamIterator_next(CovStreamIterator *iterator, char *ctg);
+
+// returns the index of the chunk containing the last returned block
+int CovStreamIterator_getChunkIndex(CovStreamIterator *iterator);
+
+// set the list of prediction label tables (stHash of blocks per contig) for evaluating multiple prediction sets
+void CovStreamIterator_setPredictionSets(CovStreamIterator *iterator, stList *predictionBlockTables);
+
+int CovStreamIterator_getNumberOfPredictionSets(CovStreamIterator *iterator);
+
+// returns the prediction label of each set for the last returned block (-1 if not defined)
+int8_t *CovStreamIterator_getPredictionLabels(CovStreamIterator *iterator);
+
+// returns an array with the length of each chunk in bases
+int *CovStreamIterator_getChunkLengths(CovStreamIterator *iterator, int *numberOfChunks);
+
+void CovStreamIterator_destruct(CovStreamIterator *iterator);
+
 #endif //FLAGGER_COV_FAST_READER_H
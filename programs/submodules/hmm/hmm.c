@@ -109,6 +109,16 @@ HMM *HMM_copy(HMM* src){
     return dest;
 }
 
+void HMM_copyParameters(HMM *dest, HMM *src) {
+    assert(dest->numberOfRegions == src->numberOfRegions);
+    for (int region = 0; region < src->numberOfRegions; region++) {
+        EmissionDistSeries_copyParameterValues(dest->emissionDistSeriesPerRegion[region],
+                                               src->emissionDistSeriesPerRegion[region]);
+        Transition_copyParameterValues(dest->transitionPerRegion[region], src->transitionPerRegion[region]);
+    }
+    dest->loglikelihood = src->loglikelihood;
+}
+
 int HMM_getStartStateIndex(HMM *model) {
     return model->excludeMisjoin ? START_STATE_INDEX - 1 : START_STATE_INDEX;
 }
@@ -133,6 +143,35 @@ void HMM_resetEstimators(HMM *model) {
     }
 }
 
+void HMM_scaleEstimators(HMM *model, double factor) {
+    for (int region = 0; region < model->numberOfRegions; region++) {
+        EmissionDistSeries_scaleParameterEstimators(model->emissionDistSeriesPerRegion[region], factor);
+        Transition_scaleCountData(model->transitionPerRegion[region], factor);
+    }
+}
+
+void HMM_updateEstimatorsFromOtherModel(HMM *dest, HMM *src) {
+    for (int region = 0; region < dest->numberOfRegions; region++) {
+        EmissionDistSeries_updateEstimatorFromOtherEstimator(dest->emissionDistSeriesPerRegion[region],
+                                                             src->emissionDistSeriesPerRegion[region]);
+        TransitionCountData_incrementFromOtherCountData(dest->transitionPerRegion[region]->transitionCountData,
+                                                        src->transitionPerRegion[region]->transitionCountData);
+    }
+}
+
+// for negative binomial the emission counts are collected in count data
+// and they are converted into estimator values once per accumulator
+void HMM_updateEstimatorsUsingCountData(HMM *model) {
+    if (model->modelType != MODEL_NEGATIVE_BINOMIAL) return;
+    for (int region = 0; region < model->numberOfRegions; region++) {
+        EmissionDistSeries *emissionDistSeries = model->emissionDistSeriesPerRegion[region];
+        EmissionDistSeries_updateAllEstimatorsUsingCountData(emissionDistSeries);
+        for (int distIndex = 0; distIndex < emissionDistSeries->numberOfDists; distIndex++) {
+            CountData_reset(emissionDistSeries->countDataPerDist[distIndex]);
+        }
+    }
+}
+
 
 void HMM_printTransitionMatrixInTsvFormat(HMM *model, FILE *fout) {
     // 100 = maximum number of rows
@@ -238,6 +277,258 @@ void HMM_printEmissionParametersInTsvFormat(HMM *model, FILE *fout) {
     }
 }
 
+static void HMM_writeMatrixDoubleIntoBinaryFile(MatrixDouble *mat, FILE *fp) {
+    fwrite(&mat->dim1, sizeof(int32_t), 1, fp);
+    fwrite(&mat->dim2, sizeof(int32_t), 1, fp);
+    for (int i = 0; i < mat->dim1; i++) {
+        fwrite(mat->data[i], sizeof(double), mat->dim2, fp);
+    }
+}
+
+static void HMM_readFromBinaryFile(void *ptr, size_t size, size_t count, FILE *fp, char *binPath) {
+    if (fread(ptr, size, count, fp) != count) {
+        fprintf(stderr, "[%s] Error: The model file %s is truncated or corrupted.\n", get_timestamp(), binPath);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void HMM_readMatrixDoubleFromBinaryFile(MatrixDouble *mat, FILE *fp, char *binPath) {
+    int dim1 = 0;
+    int dim2 = 0;
+    HMM_readFromBinaryFile(&dim1, sizeof(int32_t), 1, fp, binPath);
+    HMM_readFromBinaryFile(&dim2, sizeof(int32_t), 1, fp, binPath);
+    if (dim1 != mat->dim1 || dim2 != mat->dim2) {
+        fprintf(stderr, "[%s] Error: Matrix dimensions in the model file %s (%d x %d) do not match (%d x %d).\n",
+                get_timestamp(), binPath, dim1, dim2, mat->dim1, mat->dim2);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < mat->dim1; i++) {
+        HMM_readFromBinaryFile(mat->data[i], sizeof(double), mat->dim2, fp, binPath);
+    }
+}
+
+static FILE *HMM_openBinaryFileForWriting(char *binPath) {
+    FILE *fp = fopen(binPath, "wb+");
+    if (fp == NULL) {
+        fprintf(stderr, "[%s] Error: %s cannot be opened.\n", get_timestamp(), binPath);
+        exit(EXIT_FAILURE);
+    }
+    return fp;
+}
+
+static void HMM_writeParametersIntoFile(HMM *model, FILE *fp) {
+    int version = HMM_BINARY_FORMAT_VERSION;
+    int modelType = model->modelType;
+    fwrite(HMM_BINARY_MAGIC, sizeof(char), strlen(HMM_BINARY_MAGIC), fp);
+    fwrite(&version, sizeof(int32_t), 1, fp);
+    // write dimensions and model type
+    fwrite(&modelType, sizeof(int32_t), 1, fp);
+    fwrite(&model->numberOfStates, sizeof(int32_t), 1, fp);
+    fwrite(&model->numberOfRegions, sizeof(int32_t), 1, fp);
+    fwrite(&model->excludeMisjoin, sizeof(bool), 1, fp);
+    // write number of components per state (same for all regions)
+    for (int state = 0; state < model->numberOfStates; state++) {
+        int numberOfComps = EmissionDistSeries_getNumberOfComps(model->emissionDistSeriesPerRegion[0], state);
+        fwrite(&numberOfComps, sizeof(int32_t), 1, fp);
+    }
+    // write requirements for restricting transitions (same for all regions)
+    TransitionRequirements *requirements = model->transitionPerRegion[0]->requirements;
+    fwrite(&requirements->minHighlyClippedRatio, sizeof(double), 1, fp);
+    fwrite(&requirements->maxHighMapqRatio, sizeof(double), 1, fp);
+    fwrite(&requirements->minHighMapqRatio, sizeof(double), 1, fp);
+    HMM_writeMatrixDoubleIntoBinaryFile(model->alpha, fp);
+    for (int region = 0; region < model->numberOfRegions; region++) {
+        // write emission parameters in the order of the parameter iterator
+        EmissionDistSeries *emissionDistSeries = model->emissionDistSeriesPerRegion[region];
+        EmissionDistSeriesParamIter *paramIter = EmissionDistSeriesParamIter_construct(emissionDistSeries);
+        void *parameterTypePtr;
+        int distIndex;
+        int compIndex;
+        double value;
+        while (EmissionDistSeriesParamIter_next(paramIter, &parameterTypePtr, &distIndex, &compIndex, &value)) {
+            fwrite(&value, sizeof(double), 1, fp);
+        }
+        EmissionDistSeriesParamIter_destruct(paramIter);
+        // truncation points are not iterated since they are not estimated
+        for (int state = 0; state < emissionDistSeries->numberOfDists; state++) {
+            EmissionDist *emissionDist = emissionDistSeries->emissionDists[state];
+            if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
+                fwrite(&((TruncExponential *) emissionDist->dist)->truncPoint, sizeof(double), 1, fp);
+            }
+        }
+        // write transition matrix and pseudo counts
+        Transition *transition = model->transitionPerRegion[region];
+        HMM_writeMatrixDoubleIntoBinaryFile(transition->matrix, fp);
+        HMM_writeMatrixDoubleIntoBinaryFile(transition->transitionCountData->pseudoCountMatrix, fp);
+        fwrite(&transition->terminationProb, sizeof(double), 1, fp);
+    }
+}
+
+void HMM_writeIntoBinaryFile(HMM *model, char *binPath) {
+    FILE *fp = HMM_openBinaryFileForWriting(binPath);
+    HMM_writeParametersIntoFile(model, fp);
+    fclose(fp);
+}
+
+static FILE *HMM_openBinaryFileForReading(char *binPath) {
+    if (!file_exists(binPath)) {
+        fprintf(stderr, "[%s] Error: The model file %s does not exist.\n", get_timestamp(), binPath);
+        exit(EXIT_FAILURE);
+    }
+    return fopen(binPath, "rb");
+}
+
+static HMM *HMM_constructFromParametersInFile(FILE *fp, char *binPath) {
+    char magic[sizeof(HMM_BINARY_MAGIC)] = {0};
+    int version = 0;
+    HMM_readFromBinaryFile(magic, sizeof(char), strlen(HMM_BINARY_MAGIC), fp, binPath);
+    HMM_readFromBinaryFile(&version, sizeof(int32_t), 1, fp, binPath);
+    if (strcmp(magic, HMM_BINARY_MAGIC) != 0 || version != HMM_BINARY_FORMAT_VERSION) {
+        fprintf(stderr, "[%s] Error: %s is not a model file saved by this version of hmm_flagger.\n",
+                get_timestamp(), binPath);
+        exit(EXIT_FAILURE);
+    }
+    // read dimensions and model type
+    int modelType = 0;
+    int numberOfStates = 0;
+    int numberOfRegions = 0;
+    bool excludeMisjoin = true;
+    HMM_readFromBinaryFile(&modelType, sizeof(int32_t), 1, fp, binPath);
+    HMM_readFromBinaryFile(&numberOfStates, sizeof(int32_t), 1, fp, binPath);
+    HMM_readFromBinaryFile(&numberOfRegions, sizeof(int32_t), 1, fp, binPath);
+    HMM_readFromBinaryFile(&excludeMisjoin, sizeof(bool), 1, fp, binPath);
+    int *numberOfCompsPerState = Int_construct1DArray(numberOfStates);
+    HMM_readFromBinaryFile(numberOfCompsPerState, sizeof(int32_t), numberOfStates, fp, binPath);
+    double minHighlyClippedRatio;
+    double maxHighMapqRatio;
+    double minHighMapqRatio;
+    HMM_readFromBinaryFile(&minHighlyClippedRatio, sizeof(double), 1, fp, binPath);
+    HMM_readFromBinaryFile(&maxHighMapqRatio, sizeof(double), 1, fp, binPath);
+    HMM_readFromBinaryFile(&minHighMapqRatio, sizeof(double), 1, fp, binPath);
+    int alphaDim1 = 0;
+    int alphaDim2 = 0;
+    HMM_readFromBinaryFile(&alphaDim1, sizeof(int32_t), 1, fp, binPath);
+    HMM_readFromBinaryFile(&alphaDim2, sizeof(int32_t), 1, fp, binPath);
+    MatrixDouble *alpha = MatrixDouble_construct0(alphaDim1, alphaDim2);
+    for (int i = 0; i < alphaDim1; i++) {
+        HMM_readFromBinaryFile(alpha->data[i], sizeof(double), alphaDim2, fp, binPath);
+    }
+
+    // construct a model with the same structure and placeholder means;
+    // all parameters are overwritten below with the saved values
+    int maxNumberOfComps = Int_getMaxValue1DArray(numberOfCompsPerState, numberOfStates);
+    double **means = Double_construct2DArray(numberOfStates, maxNumberOfComps);
+    for (int state = 0; state < numberOfStates; state++) {
+        for (int comp = 0; comp < maxNumberOfComps; comp++) {
+            means[state][comp] = 1.0;
+        }
+    }
+    double *meanScalePerRegion = Double_construct1DArray(numberOfRegions);
+    for (int region = 0; region < numberOfRegions; region++) {
+        meanScalePerRegion[region] = 1.0;
+    }
+    HMM *model = HMM_construct(numberOfStates,
+                               numberOfRegions,
+                               numberOfCompsPerState,
+                               means,
+                               meanScalePerRegion,
+                               maxHighMapqRatio,
+                               minHighMapqRatio,
+                               minHighlyClippedRatio,
+                               NULL,
+                               (ModelType) modelType,
+                               alpha,
+                               excludeMisjoin);
+    Double_destruct2DArray(means, numberOfStates);
+    Double_destruct1DArray(meanScalePerRegion);
+    free(numberOfCompsPerState);
+    MatrixDouble_destruct(alpha);
+
+    for (int region = 0; region < numberOfRegions; region++) {
+        // read emission parameters in the order of the parameter iterator
+        EmissionDistSeries *emissionDistSeries = model->emissionDistSeriesPerRegion[region];
+        EmissionDistSeriesParamIter *paramIter = EmissionDistSeriesParamIter_construct(emissionDistSeries);
+        void *parameterTypePtr;
+        int distIndex;
+        int compIndex;
+        double value;
+        while (EmissionDistSeriesParamIter_next(paramIter, &parameterTypePtr, &distIndex, &compIndex, &value)) {
+            HMM_readFromBinaryFile(&value, sizeof(double), 1, fp, binPath);
+            EmissionDistSeries_setParameterValue(emissionDistSeries, parameterTypePtr, distIndex, compIndex, value);
+        }
+        EmissionDistSeriesParamIter_destruct(paramIter);
+        for (int state = 0; state < emissionDistSeries->numberOfDists; state++) {
+            EmissionDist *emissionDist = emissionDistSeries->emissionDists[state];
+            if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
+                HMM_readFromBinaryFile(&((TruncExponential *) emissionDist->dist)->truncPoint, sizeof(double), 1, fp,
+                                       binPath);
+            } else if (emissionDist->distType == DIST_NEGATIVE_BINOMIAL) {
+                // digamma values depend on theta and lambda
+                NegativeBinomial_fillDigammaTable((NegativeBinomial *) emissionDist->dist);
+            }
+        }
+        // read transition matrix and pseudo counts
+        Transition *transition = model->transitionPerRegion[region];
+        HMM_readMatrixDoubleFromBinaryFile(transition->matrix, fp, binPath);
+        HMM_readMatrixDoubleFromBinaryFile(transition->transitionCountData->pseudoCountMatrix, fp, binPath);
+        HMM_readFromBinaryFile(&transition->terminationProb, sizeof(double), 1, fp, binPath);
+        Transition_updateConditionalMatrices(transition);
+    }
+    return model;
+}
+
+HMM *HMM_constructFromBinaryFile(char *binPath) {
+    FILE *fp = HMM_openBinaryFileForReading(binPath);
+    HMM *model = HMM_constructFromParametersInFile(fp, binPath);
+    fclose(fp);
+    return model;
+}
+
+void HMM_writeSufficientStatsIntoBinaryFile(HMM *model, char *binPath) {
+    FILE *fp = HMM_openBinaryFileForWriting(binPath);
+    // parameters are saved too so the reducer runs the M-step on the same model
+    HMM_writeParametersIntoFile(model, fp);
+    fwrite(&model->loglikelihood, sizeof(double), 1, fp);
+    for (int region = 0; region < model->numberOfRegions; region++) {
+        EmissionDistSeries_writeParameterEstimatorsIntoBinaryFile(model->emissionDistSeriesPerRegion[region], fp);
+        HMM_writeMatrixDoubleIntoBinaryFile(model->transitionPerRegion[region]->transitionCountData->countMatrix, fp);
+    }
+    fclose(fp);
+}
+
+HMM *HMM_constructFromSufficientStatsBinaryFile(char *binPath) {
+    FILE *fp = HMM_openBinaryFileForReading(binPath);
+    HMM *model = HMM_constructFromParametersInFile(fp, binPath);
+    HMM_readFromBinaryFile(&model->loglikelihood, sizeof(double), 1, fp, binPath);
+    for (int region = 0; region < model->numberOfRegions; region++) {
+        if (!EmissionDistSeries_readParameterEstimatorsFromBinaryFile(model->emissionDistSeriesPerRegion[region], fp)) {
+            fprintf(stderr, "[%s] Error: The sufficient statistics in %s are truncated or corrupted.\n",
+                    get_timestamp(), binPath);
+            exit(EXIT_FAILURE);
+        }
+        HMM_readMatrixDoubleFromBinaryFile(model->transitionPerRegion[region]->transitionCountData->countMatrix, fp,
+                                           binPath);
+    }
+    fclose(fp);
+    return model;
+}
+
+bool HMM_hasSameStructure(HMM *model1, HMM *model2) {
+    if (model1->modelType != model2->modelType ||
+        model1->numberOfStates != model2->numberOfStates ||
+        model1->numberOfRegions != model2->numberOfRegions ||
+        model1->excludeMisjoin != model2->excludeMisjoin) {
+        return false;
+    }
+    for (int state = 0; state < model1->numberOfStates; state++) {
+        if (EmissionDistSeries_getNumberOfComps(model1->emissionDistSeriesPerRegion[0], state) !=
+            EmissionDistSeries_getNumberOfComps(model2->emissionDistSeriesPerRegion[0], state)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void HMM_destruct(HMM *model) {
     for (int region = 0; region < model->numberOfRegions; region++) {
         EmissionDistSeries_destruct(model->emissionDistSeriesPerRegion[region]);
@@ -246,47 +537,254 @@ void HMM_destruct(HMM *model) {
     free(model->emissionDistSeriesPerRegion);
     free(model->transitionPerRegion);
     MatrixDouble_destruct(model->alpha);
+    free(model);
+}
+
+
+EMPrecision getEMPrecisionFromString(const char *precisionString) {
+    if (strcmp(precisionString, "double") == 0) {
+        return PRECISION_DOUBLE;
+    } else if (strcmp(precisionString, "float") == 0) {
+        return PRECISION_FLOAT;
+    }
+    return PRECISION_UNDEFINED;
+}
 
+bool EM_hasMatrices(EM *em) {
+    return em->scales != NULL;
 }
 
+void EM_allocateMatrices(EM *em) {
+    if (EM_hasMatrices(em)) return;
+    int numberOfStates = em->model->numberOfStates;
+    if (em->precision == PRECISION_FLOAT) {
+        em->fFloat = Float_construct2DArray(em->seqLen, numberOfStates);
+        em->bFloat = Float_construct2DArray(em->seqLen, numberOfStates);
+        em->bColumnScales = Double_construct1DArray(em->seqLen);
+    } else {
+        em->f = Double_construct2DArray(em->seqLen, numberOfStates);
+        em->b = Double_construct2DArray(em->seqLen, numberOfStates);
+    }
+    // Initialize scale to avoid underflow
+    em->scales = Double_construct1DArray(em->seqLen);
+}
 
-EM *EM_construct(CoverageInfo **coverageInfoSeq, int seqLen, HMM *model) {
+void EM_releaseMatrices(EM *em) {
+    if (EM_hasMatrices(em) == false) return;
+    if (em->precision == PRECISION_FLOAT) {
+        Float_destruct2DArray(em->fFloat);
+        Float_destruct2DArray(em->bFloat);
+        Double_destruct1DArray(em->bColumnScales);
+    } else {
+        Double_destruct2DArray(em->f, em->seqLen);
+        Double_destruct2DArray(em->b, em->seqLen);
+    }
+    Double_destruct1DArray(em->scales);
+    em->f = NULL;
+    em->b = NULL;
+    em->fFloat = NULL;
+    em->bFloat = NULL;
+    em->bColumnScales = NULL;
+    em->scales = NULL;
+}
+
+EM *EM_construct(CoverageInfo **coverageInfoSeq, int seqLen, HMM *model, EMPrecision precision) {
     assert(seqLen > 0);
+    assert(precision == PRECISION_DOUBLE || precision == PRECISION_FLOAT);
     EM *em = malloc(sizeof(EM));
     em->coverageInfoSeq = coverageInfoSeq;
     em->seqLen = seqLen;
     em->model = model;
     // Allocate and initialize forward and backward matrices
-    em->f = Double_construct2DArray(em->seqLen, model->numberOfStates);
-    em->b = Double_construct2DArray(em->seqLen, model->numberOfStates);
-    em->emissionDistSeriesPerRegion = EmissionDistSeries_copy1DArray(model->emissionDistSeriesPerRegion, model->numberOfRegions);
-    em->transitionPerRegion = Transition_copy1DArray(model->transitionPerRegion, model->numberOfRegions);
-    // Initialize scale to avoid underflow
-    em->scales = Double_construct1DArray(em->seqLen);
+    em->precision = precision;
+    em->f = NULL;
+    em->b = NULL;
+    em->fFloat = NULL;
+    em->bFloat = NULL;
+    em->bColumnScales = NULL;
+    em->scales = NULL;
+    EM_allocateMatrices(em);
+    em->preColumn = Double_construct1DArray(model->numberOfStates);
+    em->column = Double_construct1DArray(model->numberOfStates);
+    // parameters and estimators are borrowed from the model (or from an accumulator while running EM)
+    em->emissionDistSeriesPerRegion = model->emissionDistSeriesPerRegion;
+    em->transitionPerRegion = model->transitionPerRegion;
     em->px = -1.0;
     em->loglikelihood = 0.0;
     em->numberOfRegions = model->numberOfRegions;
+    em->coreStart = 0;
+    em->coreEnd = seqLen;
+    em->stepMatrix = Double_construct2DArray(model->numberOfStates, model->numberOfStates);
+    em->stepMatrixColumn = -1;
+    em->runCounts = Double_construct2DArray(model->numberOfStates, model->numberOfStates);
+    em->validityMasks = malloc(seqLen * sizeof(uint8_t));
+    for (int i = 0; i < seqLen; i++) {
+        uint8_t region = CoverageInfo_getRegionIndex(coverageInfoSeq[i]);
+        em->validityMasks[i] = Transition_getValidityMask(model->transitionPerRegion[region], coverageInfoSeq[i]);
+    }
+    em->updatePredictions = true;
+    em->freezingEnabled = false;
+    em->cachedStats = NULL;
+    em->previousPosteriors = NULL;
+    em->hasPreviousPosteriors = false;
+    em->frozenIterations = 0;
+    em->reusedCachedStats = false;
+    em->loglikelihoodChange = -1.0;
+    em->posteriorChange = -1.0;
     return em;
 }
 
+void EM_setCore(EM *em, int coreStart, int coreEnd) {
+    assert(0 <= coreStart && coreStart < coreEnd && coreEnd <= em->seqLen);
+    em->coreStart = coreStart;
+    em->coreEnd = coreEnd;
+}
+
+void EM_enableFreezing(EM *em) {
+    if (em->freezingEnabled) return;
+    em->freezingEnabled = true;
+    em->previousPosteriors = malloc((size_t) em->seqLen * em->model->numberOfStates * sizeof(float));
+}
+
+void EM_freeze(EM *em, int numberOfIterations) {
+    assert(em->freezingEnabled);
+    em->frozenIterations = numberOfIterations;
+}
+
+void EM_unfreeze(EM *em) {
+    em->frozenIterations = 0;
+}
+
 void EM_destruct(EM *em) {
-    Double_destruct2DArray(em->f, em->seqLen);
-    Double_destruct2DArray(em->b, em->seqLen);
-    Double_destruct1DArray(em->scales);
-    EmissionDistSeries_destruct1DArray(em->emissionDistSeriesPerRegion, em->numberOfRegions);
-    Transition_destruct1DArray(em->transitionPerRegion, em->numberOfRegions);
+    if (em->cachedStats != NULL) HMM_destruct(em->cachedStats);
+    if (em->previousPosteriors != NULL) free(em->previousPosteriors);
+    EM_releaseMatrices(em);
+    Double_destruct1DArray(em->preColumn);
+    Double_destruct1DArray(em->column);
+    Double_destruct2DArray(em->stepMatrix, em->model->numberOfStates);
+    Double_destruct2DArray(em->runCounts, em->model->numberOfStates);
+    free(em->validityMasks);
+    free(em);
 }
 
 void EM_renewParametersAndEstimatorsFromModel(EM *em, HMM *model){
-    if(em->emissionDistSeriesPerRegion != NULL) {
-        EmissionDistSeries_destruct1DArray(em->emissionDistSeriesPerRegion, em->numberOfRegions);
+    em->emissionDistSeriesPerRegion = model->emissionDistSeriesPerRegion;
+    em->transitionPerRegion = model->transitionPerRegion;
+    em->model = model;
+    em->stepMatrixColumn = -1;
+}
+
+void EM_setAccumulator(EM *em, HMM *accumulator){
+    em->emissionDistSeriesPerRegion = accumulator->emissionDistSeriesPerRegion;
+    em->transitionPerRegion = accumulator->transitionPerRegion;
+}
+
+
+///////////////////////////////////////
+// Step matrix for runs of windows   //
+//////////////////////////////////////
+
+// emission and transition probabilities only depend on the coverage values and the region
+static bool EM_areObservationsEqual(CoverageInfo *coverageInfo1, CoverageInfo *coverageInfo2) {
+    return coverageInfo1->coverage == coverageInfo2->coverage &&
+           coverageInfo1->coverage_high_mapq == coverageInfo2->coverage_high_mapq &&
+           coverageInfo1->coverage_high_clip == coverageInfo2->coverage_high_clip &&
+           CoverageInfo_getRegionIndex(coverageInfo1) == CoverageInfo_getRegionIndex(coverageInfo2);
+}
+
+// the step into a column depends on the observations of that column and the previous one
+static bool EM_areStepsEqual(EM *em, int columnIndex1, int columnIndex2) {
+    return EM_areObservationsEqual(em->coverageInfoSeq[columnIndex1], em->coverageInfoSeq[columnIndex2]) &&
+           EM_areObservationsEqual(em->coverageInfoSeq[columnIndex1 - 1], em->coverageInfoSeq[columnIndex2 - 1]);
+}
+
+// stepMatrix[preState][state] = P(state | preState) * P(x_i | state, x_(i-1)) under the given model
+static void EM_fillStepMatrix(EM *em, HMM *model, int columnIndex, double **stepMatrix) {
+    assert(0 < columnIndex && columnIndex < em->seqLen);
+    CoverageInfo *covInfo = em->coverageInfoSeq[columnIndex];
+    uint8_t region = CoverageInfo_getRegionIndex(covInfo);
+    uint8_t preRegion = CoverageInfo_getRegionIndex(em->coverageInfoSeq[columnIndex - 1]);
+    uint8_t x = covInfo->coverage;
+    uint8_t preX = em->coverageInfoSeq[columnIndex - 1]->coverage;
+    double *conditionalMatrix = Transition_getConditionalMatrix(model->transitionPerRegion[region],
+                                                                em->validityMasks[columnIndex]);
+    for (int state = 0; state < model->numberOfStates; state++) {
+        for (int preState = 0; preState < model->numberOfStates; preState++) {
+            // Emission probability
+            // Not that alpha can be zero and in that case emission probability is not
+            // dependent on the previous observation
+            double eProb = EmissionDistSeries_getProb(model->emissionDistSeriesPerRegion[region],
+                                                      state,
+                                                      x,
+                                                      preX,
+                                                      model->alpha->data[preState][state]);
+            double tProb;
+            if (region != preRegion) { // if the region class has changed
+                // Make the transition prob uniform
+                tProb = 1.0 / (model->numberOfStates + 1);
+            } else {
+                tProb = conditionalMatrix[preState * model->numberOfStates + state];
+            }
+            stepMatrix[preState][state] = tProb * eProb;
+        }
     }
-    if(em->transitionPerRegion != NULL) {
-        Transition_destruct1DArray(em->transitionPerRegion, em->numberOfRegions);
+}
+
+// the step matrix is computed once for each run of identical steps and reused for the other columns of the run
+static double **EM_getStepMatrix(EM *em, int columnIndex) {
+    assert(0 < columnIndex && columnIndex < em->seqLen);
+    if (em->stepMatrixColumn != -1 && EM_areStepsEqual(em, em->stepMatrixColumn, columnIndex)) {
+        return em->stepMatrix;
     }
-    em->emissionDistSeriesPerRegion = EmissionDistSeries_copy1DArray(model->emissionDistSeriesPerRegion, model->numberOfRegions);
-    em->transitionPerRegion = Transition_copy1DArray(model->transitionPerRegion, model->numberOfRegions);
-    em->model = model;
+    EM_fillStepMatrix(em, em->model, columnIndex, em->stepMatrix);
+    em->stepMatrixColumn = columnIndex;
+    return em->stepMatrix;
+}
+
+
+///////////////////////////////////////
+// Columns of forward and backward   //
+//////////////////////////////////////
+
+// returns the column of a forward or backward matrix in double; with PRECISION_FLOAT it is converted into buffer.
+// columnScales is NULL for the forward matrix since its columns are already normalized
+static inline double *EM_readColumn(EM *em, double **matrix, float **matrixFloat, double *columnScales,
+                                    int columnIndex, double *buffer) {
+    if (em->precision == PRECISION_DOUBLE) {
+        return matrix[columnIndex];
+    }
+    double columnScale = columnScales == NULL ? 1.0 : columnScales[columnIndex];
+    for (int s = 0; s < em->model->numberOfStates; s++) {
+        buffer[s] = matrixFloat[columnIndex][s] * columnScale;
+    }
+    return buffer;
+}
+
+// returns where a column should be computed; call EM_writeColumn after filling it
+static inline double *EM_getColumnForWriting(EM *em, double **matrix, int columnIndex) {
+    return em->precision == PRECISION_DOUBLE ? matrix[columnIndex] : em->column;
+}
+
+// backward values of different states can be many orders of magnitude apart (when some transitions
+// are not allowed) so each backward column is divided by its maximum to stay in the range of float
+static inline void EM_writeColumn(EM *em, float **matrixFloat, double *columnScales, int columnIndex, double *column) {
+    if (em->precision == PRECISION_DOUBLE) return;
+    double columnScale = 1.0;
+    if (columnScales != NULL) {
+        columnScale = Double_getMaxValue1DArray(column, em->model->numberOfStates);
+        columnScale = 0.0 < columnScale ? columnScale : 1.0;
+        columnScales[columnIndex] = columnScale;
+    }
+    for (int s = 0; s < em->model->numberOfStates; s++) {
+        matrixFloat[columnIndex][s] = (float) (column[s] / columnScale);
+    }
+}
+
+static inline double EM_getPosteriorNumerator(EM *em, int pos, int state) {
+    if (em->precision == PRECISION_FLOAT) {
+        return (double) em->fFloat[pos][state] * em->bFloat[pos][state] * em->bColumnScales[pos] * em->scales[pos];
+    }
+    return em->f[pos][state] * em->b[pos][state] * em->scales[pos];
 }
 
 
@@ -299,7 +797,11 @@ void EM_resetAllColumnsForward(EM *em) {
     // Initialize to zero
     for (int i = 0; i < em->seqLen; i++) {
         for (int s = 0; s < model->numberOfStates; s++) {
-            em->f[i][s] = 0.0;
+            if (em->precision == PRECISION_FLOAT) {
+                em->fFloat[i][s] = 0.0;
+            } else {
+                em->f[i][s] = 0.0;
+            }
         }
         em->scales[i] = 0.0;
     }
@@ -314,6 +816,7 @@ void EM_fillFirstColumnForward(EM *em) {
     uint8_t preX = 0;
     double alpha = 0.0; // for the first column alpha can not be greater than 0
     // Set the 0-th block of the forward matrix
+    double *f0 = EM_getColumnForWriting(em, em->f, 0);
     scale = 0.0;
     for (int state = 0; state < model->numberOfStates; state++) {
         uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[0]);
@@ -327,14 +830,15 @@ void EM_fillFirstColumnForward(EM *em) {
         // Transition probability
         tProb = Transition_getStartProb(model->transitionPerRegion[region], state);
         // Update forward
-        em->f[0][state] = eProb * tProb;
-        scale += em->f[0][state];
+        f0[state] = eProb * tProb;
+        scale += f0[state];
     }
     em->scales[0] = scale;
     // Scale f 0-th column
     for (int state = 0; state < model->numberOfStates; state++) {
-        em->f[0][state] /= scale;
+        f0[state] /= scale;
     }
+    EM_writeColumn(em, em->fFloat, NULL, 0, f0);
 }
 
 void EM_fillOneColumnForward(EM *em, int columnIndex) {
@@ -344,41 +848,16 @@ void EM_fillOneColumnForward(EM *em, int columnIndex) {
     }
     HMM *model = em->model;
     int i = columnIndex;
-    double eProb;
-    double tProb;
-    uint8_t region;
-    uint8_t preRegion;
-    uint8_t x;
-    uint8_t preX;
-    double alpha;
     double scale = 0.0;
-    region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i]);
-    preRegion = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i - 1]);
-    x = em->coverageInfoSeq[i]->coverage;
-    preX = em->coverageInfoSeq[i - 1]->coverage;
+    double **stepMatrix = EM_getStepMatrix(em, i);
+    double *preF = EM_readColumn(em, em->f, em->fFloat, NULL, i - 1, em->preColumn);
+    double *f = EM_getColumnForWriting(em, em->f, i);
     for (int state = 0; state < model->numberOfStates; state++) {
+        f[state] = 0.0;
         for (int preState = 0; preState < model->numberOfStates; preState++) { // Transition from c1 comp to c2 comp
-            alpha = model->alpha->data[preState][state];
-            // Emission probability
-            // Not that alpha can be zero and in that case emission probability is not
-            // dependent on the previous observation
-            eProb = EmissionDistSeries_getProb(model->emissionDistSeriesPerRegion[region],
-                                               state,
-                                               x,
-                                               preX,
-                                               model->alpha->data[preState][state]);
-            if (region != preRegion) { // if the region class has changed
-                // Make the transition prob uniform
-                tProb = 1.0 / (model->numberOfStates + 1);
-            } else {
-                tProb = Transition_getProbConditional(model->transitionPerRegion[region],
-                                                      preState,
-                                                      state,
-                                                      em->coverageInfoSeq[i]);
-            }
-            em->f[i][state] += (em->f[i - 1][preState] * tProb * eProb);
+            f[state] += preF[preState] * stepMatrix[preState][state];
         }
-        scale += em->f[i][state];
+        scale += f[state];
     }
     em->scales[i] = scale;
     if (em->scales[i] < 1e-50) {
@@ -387,16 +866,24 @@ void EM_fillOneColumnForward(EM *em, int columnIndex) {
     }
     // Scale f
     for (int state = 0; state < model->numberOfStates; state++) {
-        em->f[i][state] /= em->scales[i];
+        f[state] /= em->scales[i];
     }
+    EM_writeColumn(em, em->fFloat, NULL, i, f);
 }
 
 
 void EM_runForward(EM *em) {
+    // matrices may have been released after the previous run
+    EM_allocateMatrices(em);
     EM_resetAllColumnsForward(em);
+    // parameters may have changed since the last run
+    em->stepMatrixColumn = -1;
     // Fill columns of the forward matrix
     for (int columnIndex = 0; columnIndex < em->seqLen; columnIndex++) {
         EM_fillOneColumnForward(em, columnIndex);
+    }
+    // the scales of the flanking windows belong to the adjacent chunks
+    for (int columnIndex = em->coreStart; columnIndex < em->coreEnd; columnIndex++) {
         em->loglikelihood += log(em->scales[columnIndex]);
     }
     // Update P(x)
@@ -415,7 +902,11 @@ void EM_resetAllColumnsBackward(EM *em) {
     // Initialize to zero
     for (int i = 0; i < em->seqLen; i++) {
         for (int s = 0; s < model->numberOfStates; s++) {
-            em->b[i][s] = 0.0;
+            if (em->precision == PRECISION_FLOAT) {
+                em->bFloat[i][s] = 0.0;
+            } else {
+                em->b[i][s] = 0.0;
+            }
         }
     }
 }
@@ -424,18 +915,20 @@ void EM_resetAllColumnsBackward(EM *em) {
 void EM_fillLastColumnBackward(EM *em) {
     HMM *model = em->model;
     double tProb;
+    double *b = EM_getColumnForWriting(em, em->b, em->seqLen - 1);
     // Set the last block of the backward matrix
     for (int state = 0; state < model->numberOfStates; state++) {
         uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[em->seqLen - 1]);
         // Transition probability
         tProb = Transition_getTerminationProb(model->transitionPerRegion[region], state);
         // Update backward
-        em->b[em->seqLen - 1][state] = tProb;
+        b[state] = tProb;
     }
     // Scale last column of the backward matrix
     for (int state = 0; state < model->numberOfStates; state++) {
-        em->b[em->seqLen - 1][state] /= em->scales[em->seqLen - 1];
+        b[state] /= em->scales[em->seqLen - 1];
     }
+    EM_writeColumn(em, em->bFloat, em->bColumnScales, em->seqLen - 1, b);
 }
 
 
@@ -446,56 +939,26 @@ void EM_fillOneColumnBackward(EM *em, int columnIndex) {
     }
     HMM *model = em->model;
     int i = columnIndex;
-    double eProb;
-    double tProb;
-    uint8_t region;
-    uint8_t preRegion;
-    uint8_t x;
-    uint8_t preX;
-    CoverageInfo *covInfo;
-    CoverageInfo *preCovInfo;
-    double alpha;
-    region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i + 1]);
-    preRegion = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i]);
-    covInfo = em->coverageInfoSeq[i + 1];
-    preCovInfo = em->coverageInfoSeq[i];
-    x = covInfo->coverage;
-    preX = preCovInfo->coverage;
+    double **stepMatrix = EM_getStepMatrix(em, i + 1);
+    double *nextB = EM_readColumn(em, em->b, em->bFloat, em->bColumnScales, i + 1, em->preColumn);
+    double *b = EM_getColumnForWriting(em, em->b, i);
+    for (int preState = 0; preState < model->numberOfStates; preState++) {
+        b[preState] = 0.0;
+    }
     for (int state = 0; state < model->numberOfStates; state++) {
         for (int preState = 0; preState < model->numberOfStates; preState++) { // Transition from c1 comp to c2 comp
-            alpha = model->alpha->data[preState][state];
-            // Emission probability
-            // Not that alpha can be zero and in that case emission probability is not
-            // dependent on the previous observation
-            eProb = EmissionDistSeries_getProb(model->emissionDistSeriesPerRegion[region],
-                                               state,
-                                               x,
-                                               preX,
-                                               alpha);
-            if (region != preRegion) { // if the region class has changed
-                // Make the transition prob uniform
-                tProb = 1.0 / (model->numberOfStates + 1);
-            } else {
-                tProb = Transition_getProbConditional(model->transitionPerRegion[region],
-                                                      preState,
-                                                      state,
-                                                      covInfo);
-            }
-            em->b[i][preState] += tProb * eProb * em->b[i + 1][state];
-            //if (em->b[i][preState] == 0.0){
-            //fprintf(stdout, "i=%d, tProb =%.2e, eProb =%.2e,em->b[i + 1][state]=%.2e\n", i, tProb , eProb , em->b[i + 1][state]);
-            //	fprintf(stdout, "x = %d, state = %d, preState=%d, eProb=%.2e\n", x, state, preState, eProb);
-            //}
+            b[preState] += stepMatrix[preState][state] * nextB[state];
         }
     }
     if (em->scales[i] < 1e-50) {
         fprintf(stderr, "scale (= %.2e) is very low!\n", em->scales[i]);
         exit(EXIT_FAILURE);
     }
-    // Scale f
+    // Scale b
     for (int state = 0; state < model->numberOfStates; state++) {
-        em->b[i][state] /= em->scales[i];
+        b[state] /= em->scales[i];
     }
+    EM_writeColumn(em, em->bFloat, em->bColumnScales, i, b);
 }
 
 
@@ -504,6 +967,7 @@ void EM_fillOneColumnBackward(EM *em, int columnIndex) {
 // so they can be used in the backward algorithm
 void EM_runBackward(EM *em) {
     EM_resetAllColumnsBackward(em);
+    em->stepMatrixColumn = -1;
     // Fill columns of the backward matrix
     for (int columnIndex = em->seqLen - 1; columnIndex >= 0; columnIndex--) {
         EM_fillOneColumnBackward(em, columnIndex);
@@ -530,55 +994,23 @@ void EM_updateModelEstimators(EM *em) {
 }
 
 
-void EM_updateEstimatorsUsingOneColumn(EM *em, int columnIndex) {
-    if (columnIndex == em->seqLen - 1) {
-        return;
-    }
+// add the expected counts of one run of identical steps ending at the given column.
+// em->runCounts holds the sum of f[i][preState] * b[i + 1][state] over the run; since the step
+// matrix is the same for all columns of the run the counts are the sum times the step probability
+static void EM_updateEstimatorsUsingOneRun(EM *em, int columnIndex) {
     HMM *model = em->model;
-    int i = columnIndex;
-    double eProb;
-    double tProb;
-    uint8_t region;
-    uint8_t preRegion;
-    uint8_t x;
-    uint8_t preX;
-    double alpha;
-    EmissionDistSeries *emissionDistSeries;
-    Transition *transition;
-
+    double **stepMatrix = EM_getStepMatrix(em, columnIndex);
     // get observations
-    region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i + 1]);
-    preRegion = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i]);
-    x = em->coverageInfoSeq[i + 1]->coverage;
-    preX = em->coverageInfoSeq[i]->coverage;
+    uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[columnIndex]);
+    uint8_t x = em->coverageInfoSeq[columnIndex]->coverage;
+    uint8_t preX = em->coverageInfoSeq[columnIndex - 1]->coverage;
 
-    emissionDistSeries = em->emissionDistSeriesPerRegion[region];
-    transition = em->transitionPerRegion[region];
+    EmissionDistSeries *emissionDistSeries = em->emissionDistSeriesPerRegion[region];
+    Transition *transition = em->transitionPerRegion[region];
     for (int state = 0; state < model->numberOfStates; state++) {
         for (int preState = 0; preState < model->numberOfStates; preState++) { // Transition from c1 comp to c2 comp
-            // get model attributes
-            alpha = model->alpha->data[preState][state];
-	    // Emission probability
-            // Not that alpha can be zero and in that case emission probability is not
-            // dependent on the previous observation
-	    eProb = EmissionDistSeries_getProb(emissionDistSeries,
-                                               state,
-                                               x,
-                                               preX,
-                                               alpha);
-
-            if (region != preRegion) { // if the region class has changed
-                // Make the transition prob uniform
-                tProb = 1.0 / (model->numberOfStates + 1);
-            } else {
-                tProb = Transition_getProbConditional(transition,
-                                                      preState,
-                                                      state,
-                                                      em->coverageInfoSeq[i + 1]);
-            }
-
-            // P(s_i = preState, s_(i+1) = state|x)
-            double count = em->f[i][preState] * tProb * eProb * em->b[i + 1][state];
+            // sum of P(s_i = preState, s_(i+1) = state|x) over the run
+            double count = em->runCounts[preState][state] * stepMatrix[preState][state];
             double adjustedCount = count / transition->terminationProb;
             if (model->modelType == MODEL_NEGATIVE_BINOMIAL) {
                 EmissionDistSeries_incrementCountData(emissionDistSeries,state, x, adjustedCount);
@@ -587,13 +1019,9 @@ void EM_updateEstimatorsUsingOneColumn(EM *em, int columnIndex) {
                                                    state,
                                                    x,
                                                    preX,
-                                                   alpha,
+                                                   model->alpha->data[preState][state],
                                                    adjustedCount);
             }
-
-            /*if(count < 1e-3 && i % 50000  == 0){
-            fprintf(stdout, "i=%d, count=%.2e, em->f[%d][%d]=%.2e, tProb=%.2e, eProb=%.2e, em->b[%d][%d]=%.2e, scale=%.2e\n", i, count, i, preState, em->f[i][preState],tProb,eProb, i+1, state, em->b[i + 1][state], em->scales[i]);
-            }*/
             TransitionCountData_increment(transition->transitionCountData,
                                           adjustedCount,
                                           preState,
@@ -603,17 +1031,35 @@ void EM_updateEstimatorsUsingOneColumn(EM *em, int columnIndex) {
 }
 
 void EM_updateEstimators(EM *em) {
+    HMM *model = em->model;
+    em->stepMatrixColumn = -1;
+    // the column that the current run of identical steps started from
+    int runColumn = -1;
     // skip first column since alpha might be > 0
-    for (int columnIndex = 1; columnIndex < em->seqLen; columnIndex++) {
-        EM_updateEstimatorsUsingOneColumn(em, columnIndex);
-    }
-    // for accelerating EM for negative binomial
-    if (em->model->modelType == MODEL_NEGATIVE_BINOMIAL) {
-        for (int region = 0; region < em->numberOfRegions; region++) {
-            EmissionDistSeries *emissionDistSeries = em->emissionDistSeriesPerRegion[region];
-            EmissionDistSeries_updateAllEstimatorsUsingCountData(emissionDistSeries);
+    // with a left flank the transition into the first window of the core is counted
+    int firstColumn = em->coreStart == 0 ? 1 : em->coreStart - 1;
+    // each column adds the transition into the next window so the last window of the core is skipped
+    for (int columnIndex = firstColumn; columnIndex < em->coreEnd - 1; columnIndex++) {
+        if (runColumn == -1 || !EM_areStepsEqual(em, runColumn, columnIndex + 1)) {
+            if (runColumn != -1) {
+                EM_updateEstimatorsUsingOneRun(em, runColumn);
+            }
+            runColumn = columnIndex + 1;
+            Double_fill2DArray(em->runCounts, model->numberOfStates, model->numberOfStates, 0.0);
         }
+        double *f = EM_readColumn(em, em->f, em->fFloat, NULL, columnIndex, em->preColumn);
+        double *nextB = EM_readColumn(em, em->b, em->bFloat, em->bColumnScales, columnIndex + 1, em->column);
+        for (int state = 0; state < model->numberOfStates; state++) {
+            for (int preState = 0; preState < model->numberOfStates; preState++) {
+                em->runCounts[preState][state] += f[preState] * nextB[state];
+            }
+        }
+    }
+    if (runColumn != -1) {
+        EM_updateEstimatorsUsingOneRun(em, runColumn);
     }
+    // for negative binomial the counts are turned into estimator values
+    // later by HMM_updateEstimatorsUsingCountData
 }
 
 bool EM_estimateParameters(EM *em, double convergenceTol) {
@@ -635,12 +1081,164 @@ void EM_resetEstimators(EM *em) {
 }
 
 
+///////////////////////////////////////
+// Functions for Viterbi algorithm   //
+//////////////////////////////////////
+
+DecodeType getDecodeTypeFromString(const char *decodeString) {
+    if (strcmp(decodeString, "posterior") == 0) {
+        return DECODE_POSTERIOR;
+    } else if (strcmp(decodeString, "viterbi") == 0) {
+        return DECODE_VITERBI;
+    }
+    return DECODE_UNDEFINED;
+}
+
+// log(0) is -inf which is fine for max-product
+static inline double getLogProb(double prob) {
+    return 0.0 < prob ? log(prob) : -INFINITY;
+}
+
+void EM_fillFirstColumnViterbi(EM *em, double *v) {
+    HMM *model = em->model;
+    uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[0]);
+    uint8_t x = em->coverageInfoSeq[0]->coverage;
+    for (int state = 0; state < model->numberOfStates; state++) {
+        // for the first column alpha can not be greater than 0
+        double eProb = EmissionDistSeries_getProb(model->emissionDistSeriesPerRegion[region],
+                                                  state,
+                                                  x,
+                                                  0,
+                                                  0.0);
+        double tProb = Transition_getStartProb(model->transitionPerRegion[region], state);
+        v[state] = getLogProb(eProb) + getLogProb(tProb);
+    }
+}
+
+// fill column i of the log-space Viterbi matrix using column i-1 (preV)
+// and save the best previous state of each state in traceback
+void EM_fillOneColumnViterbi(EM *em, int columnIndex, double *preV, double *v, uint8_t *traceback) {
+    HMM *model = em->model;
+    int i = columnIndex;
+    double eProb;
+    double tProb;
+    uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i]);
+    uint8_t preRegion = CoverageInfo_getRegionIndex(em->coverageInfoSeq[i - 1]);
+    uint8_t x = em->coverageInfoSeq[i]->coverage;
+    uint8_t preX = em->coverageInfoSeq[i - 1]->coverage;
+    double *conditionalMatrix = Transition_getConditionalMatrix(model->transitionPerRegion[region],
+                                                                em->validityMasks[i]);
+    for (int state = 0; state < model->numberOfStates; state++) {
+        double maxLogProb = -INFINITY;
+        uint8_t bestPreState = 0;
+        for (int preState = 0; preState < model->numberOfStates; preState++) {
+            eProb = EmissionDistSeries_getProb(model->emissionDistSeriesPerRegion[region],
+                                               state,
+                                               x,
+                                               preX,
+                                               model->alpha->data[preState][state]);
+            if (region != preRegion) { // if the region class has changed
+                // Make the transition prob uniform
+                tProb = 1.0 / (model->numberOfStates + 1);
+            } else {
+                tProb = conditionalMatrix[preState * model->numberOfStates + state];
+            }
+            double logProb = preV[preState] + getLogProb(tProb) + getLogProb(eProb);
+            if (maxLogProb < logProb) {
+                maxLogProb = logProb;
+                bestPreState = preState;
+            }
+        }
+        v[state] = maxLogProb;
+        traceback[state] = bestPreState;
+    }
+}
+
+// Run Viterbi algorithm and return the most probable path of states.
+// Only two columns of log probabilities are kept in memory; the traceback
+// is one byte per state per position. Returned array should be freed by the caller.
+uint8_t *EM_runViterbi(EM *em, double *logProbPtr) {
+    HMM *model = em->model;
+    int numberOfStates = model->numberOfStates;
+    double *preV = Double_construct1DArray(numberOfStates);
+    double *v = Double_construct1DArray(numberOfStates);
+    uint8_t *traceback = malloc(em->seqLen * numberOfStates * sizeof(uint8_t));
+    uint8_t *path = malloc(em->seqLen * sizeof(uint8_t));
+
+    EM_fillFirstColumnViterbi(em, preV);
+    for (int i = 1; i < em->seqLen; i++) {
+        EM_fillOneColumnViterbi(em, i, preV, v, traceback + i * numberOfStates);
+        double *temp = preV;
+        preV = v;
+        v = temp;
+    }
+    // add termination probabilities and find the best last state
+    uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[em->seqLen - 1]);
+    double maxLogProb = -INFINITY;
+    uint8_t bestState = 0;
+    for (int state = 0; state < numberOfStates; state++) {
+        double logProb = preV[state] +
+                         getLogProb(Transition_getTerminationProb(model->transitionPerRegion[region], state));
+        if (maxLogProb < logProb) {
+            maxLogProb = logProb;
+            bestState = state;
+        }
+    }
+    // trace back the best path
+    path[em->seqLen - 1] = bestState;
+    for (int i = em->seqLen - 1; 0 < i; i--) {
+        path[i - 1] = traceback[i * numberOfStates + path[i]];
+    }
+    if (logProbPtr != NULL) {
+        *logProbPtr = maxLogProb;
+    }
+    free(traceback);
+    Double_destruct1DArray(preV);
+    Double_destruct1DArray(v);
+    return path;
+}
+
+void EM_runViterbiAndUpdatePredictions(EM *em) {
+    uint8_t *path = EM_runViterbi(em, NULL);
+    for (int pos = em->coreStart; pos < em->coreEnd; pos++) {
+        CoverageInfo *coverageInfo = em->coverageInfoSeq[pos];
+        if (coverageInfo->data != NULL) {
+            Inference *inference = coverageInfo->data;
+            inference->prediction = path[pos];
+        }
+    }
+    free(path);
+}
+
+void EM_runViterbiForThreadPool(void *arg_) {
+    work_arg_t *arg = arg_;
+    EM *em = arg->data;
+    EM_runViterbiAndUpdatePredictions(em);
+}
+
+void EM_runViterbiForList(stList *emList, HMM *model, wstpool_t *threadPool) {
+    stList *emListSorted = EM_getListSortedBySeqLenDecreasing(emList);
+    int numberOfEMs = stList_length(emListSorted);
+    work_arg_t *argWorks = malloc(numberOfEMs * sizeof(work_arg_t));
+    for (int i = 0; i < numberOfEMs; i++) {
+        EM *em = stList_get(emListSorted, i);
+        EM_renewParametersAndEstimatorsFromModel(em, model);
+        argWorks[i].data = (void *) em;
+        wstpool_add_work(threadPool, EM_runViterbiForThreadPool, &argWorks[i]);
+    }
+    wstpool_wait(threadPool);
+    free(argWorks);
+    stList_destruct(emListSorted);
+}
+
+
 double *EM_getPosterior(EM *em, int pos) {
+    assert(EM_hasMatrices(em));
     HMM *model = em->model;
     double *posterior = malloc(model->numberOfStates * sizeof(double));
     double total = 0.0;
     for (int s = 0; s < model->numberOfStates; s++) {
-        posterior[s] = em->f[pos][s] * em->b[pos][s] * em->scales[pos];
+        posterior[s] = EM_getPosteriorNumerator(em, pos, s);
         total += posterior[s];
         //fprintf(stdout, "s=%d, %.2e\t",s, posterior[s]);
     }
@@ -679,22 +1277,10 @@ void EM_printPosteriorInTsvFormat(EM *em, FILE *fout) {
     }
 }
 
-void EM_runOneIterationAndUpdateEstimatorsForThreadPool(void *arg_) {
-    work_arg_t *arg = arg_;
-    EM *em = arg->data;
-
-    EM_runForward(em);
-    EM_runBackward(em);
-    EM_updateEstimators(em);
-/*    fprintf(stderr, "em\n");
-    EmissionDistSeries_estimateParameters(em->emissionDistSeriesPerRegion[0], 1e-3);
-    Transition_estimateTransitionMatrix(em->transitionPerRegion[0], 1e-3);
-    fprintf(stderr, "em done\n");
-*/
-//    EM_updateModelEstimators(em);
-
+static void EM_updatePredictions(EM *em) {
+    if (em->updatePredictions == false) return;
     // update prediction labels
-    for (int pos = 0; pos < em->seqLen; pos++) {
+    for (int pos = em->coreStart; pos < em->coreEnd; pos++) {
         CoverageInfo *coverageInfo = em->coverageInfoSeq[pos];
         if (coverageInfo->data != NULL) {
             Inference *inference = coverageInfo->data;
@@ -703,31 +1289,213 @@ void EM_runOneIterationAndUpdateEstimatorsForThreadPool(void *arg_) {
     }
 }
 
-void EM_runOneIterationForList(stList *emList, HMM *model, int threads) {
-    model->loglikelihood = 0.0;
-    tpool_t *tm = tpool_create(threads);
-    for (int i = 0; i < stList_length(emList); i++) {
+void EM_runOneIterationAndUpdateEstimators(EM *em) {
+    EM_runForward(em);
+    EM_runBackward(em);
+    EM_updateEstimators(em);
+    EM_updatePredictions(em);
+}
 
-        // get EM struct for this chunk index
-        EM *em = stList_get(emList, i);
-        EM_renewParametersAndEstimatorsFromModel(em, model);
-        // add EM to the work struct
-        work_arg_t *argWork = malloc(sizeof(work_arg_t));
-        argWork->data = (void *) em;
+// compare the posteriors and the loglikelihood of the core windows with the ones from the previous E-step
+static void EM_updateChangesSincePreviousIteration(EM *em, double previousLoglikelihood) {
+    int numberOfStates = em->model->numberOfStates;
+    double sumOfDistances = 0.0;
+    for (int pos = em->coreStart; pos < em->coreEnd; pos++) {
+        float *previousPosterior = em->previousPosteriors + (size_t) pos * numberOfStates;
+        double total = 0.0;
+        for (int s = 0; s < numberOfStates; s++) {
+            total += EM_getPosteriorNumerator(em, pos, s);
+        }
+        double distance = 0.0;
+        for (int s = 0; s < numberOfStates; s++) {
+            double posterior = EM_getPosteriorNumerator(em, pos, s) / total;
+            distance += fabs(posterior - previousPosterior[s]);
+            previousPosterior[s] = (float) posterior;
+        }
+        // total variation distance
+        sumOfDistances += 0.5 * distance;
+    }
+    if (em->hasPreviousPosteriors) {
+        em->posteriorChange = sumOfDistances / (em->coreEnd - em->coreStart);
+        em->loglikelihoodChange = fabs(em->loglikelihood - previousLoglikelihood) /
+                                  (fabs(previousLoglikelihood) + 1.0e-9);
+    }
+    em->hasPreviousPosteriors = true;
+}
+
+// With freezing enabled the statistics of each EM are saved in its own cache so that a frozen EM can
+// reuse them; its loglikelihood, posteriors and prediction labels are the ones from the last E-step.
+// The cache is made once and it only takes the new parameters of the model in the next iterations
+static void EM_runOneIterationIntoCachedStats(EM *em, HMM *model) {
+    assert(em->freezingEnabled);
+    if (0 < em->frozenIterations) {
+        em->frozenIterations -= 1;
+        em->reusedCachedStats = true;
+        return;
+    }
+    if (em->cachedStats == NULL) {
+        em->cachedStats = HMM_copy(model);
+    } else {
+        HMM_copyParameters(em->cachedStats, model);
+    }
+    HMM_resetEstimators(em->cachedStats);
+    for (int region = 0; region < em->cachedStats->numberOfRegions; region++) {
+        EmissionDistSeries *emissionDistSeries = em->cachedStats->emissionDistSeriesPerRegion[region];
+        for (int distIndex = 0; distIndex < emissionDistSeries->numberOfDists; distIndex++) {
+            CountData_reset(emissionDistSeries->countDataPerDist[distIndex]);
+        }
+    }
+    double previousLoglikelihood = em->loglikelihood;
+    EM_setAccumulator(em, em->cachedStats);
+    EM_runOneIterationAndUpdateEstimators(em);
+    HMM_updateEstimatorsUsingCountData(em->cachedStats);
+    EM_updateChangesSincePreviousIteration(em, previousLoglikelihood);
+    em->reusedCachedStats = false;
+}
+
+void EM_runForwardBackwardAndUpdatePredictions(EM *em) {
+    double previousLoglikelihood = em->loglikelihood;
+    EM_runForward(em);
+    EM_runBackward(em);
+    if (em->freezingEnabled) {
+        EM_updateChangesSincePreviousIteration(em, previousLoglikelihood);
+        em->reusedCachedStats = false;
+    }
+    EM_updatePredictions(em);
+}
+
+void EM_runForwardBackwardAndUpdatePredictionsForThreadPool(void *arg_) {
+    work_arg_t *arg = arg_;
+    EM *em = arg->data;
+
+    EM_runForwardBackwardAndUpdatePredictions(em);
+}
+
+// The EMs of a lane run one after another and add their statistics directly into the accumulator
+// of the lane (EMs with freezing enabled add their cached statistics instead)
+void EM_runOneIterationAndUpdateEstimatorsForThreadPool(void *arg_) {
+    work_arg_t *arg = arg_;
+    EMLane *lane = arg->data;
+    for (int i = 0; i < stList_length(lane->emList); i++) {
+        EM *em = stList_get(lane->emList, i);
+        if (em->freezingEnabled) {
+            EM_runOneIterationIntoCachedStats(em, lane->accumulator);
+            HMM_updateEstimatorsFromOtherModel(lane->accumulator, em->cachedStats);
+        } else {
+            EM_setAccumulator(em, lane->accumulator);
+            EM_runOneIterationAndUpdateEstimators(em);
+        }
+    }
+    // negative binomial counts are converted once per lane
+    HMM_updateEstimatorsUsingCountData(lane->accumulator);
+}
+
+// used for sorting EMs by their sequence lengths in decreasing order
+int EM_cmpSeqLenDecreasing(const void *em_1_, const void *em_2_) {
+    const EM *em_1 = (EM *) em_1_;
+    const EM *em_2 = (EM *) em_2_;
+    return em_2->seqLen - em_1->seqLen;
+}
+
+stList *EM_getListSortedBySeqLenDecreasing(stList *emList) {
+    stList *emListSorted = stList_copy(emList, NULL);
+    stList_sort(emListSorted, EM_cmpSeqLenDecreasing);
+    return emListSorted;
+}
+
+EMLane *EMLane_construct(HMM *model) {
+    EMLane *lane = malloc(sizeof(EMLane));
+    lane->emList = stList_construct3(0, NULL);
+    lane->accumulator = HMM_copy(model);
+    HMM_resetEstimators(lane->accumulator);
+    return lane;
+}
+
+void EMLane_destruct(EMLane *lane) {
+    stList_destruct(lane->emList);
+    HMM_destruct(lane->accumulator);
+    free(lane);
+}
+
+// Chunks are dealt longest first and each one goes to the lane with the smallest total length so far
+// (the first one if there is a tie). The lanes only depend on the chunks and not on the number of threads
+stList *EMLane_constructLanes(stList *emList, HMM *model) {
+    int numberOfLanes = min(EM_MAX_NUMBER_OF_LANES, stList_length(emList));
+    stList *lanes = stList_construct3(0, EMLane_destruct);
+    for (int laneIndex = 0; laneIndex < numberOfLanes; laneIndex++) {
+        stList_append(lanes, EMLane_construct(model));
+    }
+    int64_t *lengthPerLane = calloc(numberOfLanes, sizeof(int64_t));
+    stList *emListSorted = EM_getListSortedBySeqLenDecreasing(emList);
+    for (int i = 0; i < stList_length(emListSorted); i++) {
+        EM *em = stList_get(emListSorted, i);
+        int shortestLaneIndex = 0;
+        for (int laneIndex = 1; laneIndex < numberOfLanes; laneIndex++) {
+            if (lengthPerLane[laneIndex] < lengthPerLane[shortestLaneIndex]) shortestLaneIndex = laneIndex;
+        }
+        lengthPerLane[shortestLaneIndex] += em->seqLen;
+        EMLane *lane = stList_get(lanes, shortestLaneIndex);
+        stList_append(lane->emList, em);
+    }
+    stList_destruct(emListSorted);
+    free(lengthPerLane);
+    return lanes;
+}
+
+void EMLane_mergeForThreadPool(void *arg_) {
+    work_arg_t *arg = arg_;
+    EMLane **lanePair = arg->data;
+    HMM_updateEstimatorsFromOtherModel(lanePair[0]->accumulator, lanePair[1]->accumulator);
+}
+
+// merge all accumulators into the accumulator of the first lane with a pairwise tree.
+// the order of additions only depends on the number of lanes
+void EMLane_reduceLanes(stList *lanes, wstpool_t *threadPool) {
+    int numberOfLanes = stList_length(lanes);
+    EMLane **lanePairs = malloc(numberOfLanes * sizeof(EMLane *));
+    work_arg_t *argWorks = malloc(numberOfLanes * sizeof(work_arg_t));
+    for (int step = 1; step < numberOfLanes; step *= 2) {
+        int numberOfPairs = 0;
+        for (int i = 0; i + step < numberOfLanes; i += 2 * step) {
+            lanePairs[2 * numberOfPairs] = stList_get(lanes, i);
+            lanePairs[2 * numberOfPairs + 1] = stList_get(lanes, i + step);
+            argWorks[numberOfPairs].data = (void *) &lanePairs[2 * numberOfPairs];
+            wstpool_add_work(threadPool, EMLane_mergeForThreadPool, &argWorks[numberOfPairs]);
+            numberOfPairs++;
+        }
+        wstpool_wait(threadPool);
+    }
+    free(argWorks);
+    free(lanePairs);
+}
+
+void EM_runOneIterationForList(stList *emList, HMM *model, wstpool_t *threadPool) {
+    model->loglikelihood = 0.0;
+    stList *lanes = EMLane_constructLanes(emList, model);
+    int numberOfLanes = stList_length(lanes);
+    work_arg_t *argWorks = malloc(numberOfLanes * sizeof(work_arg_t));
+    // the first lanes are the longest ones
+    for (int laneIndex = 0; laneIndex < numberOfLanes; laneIndex++) {
+        argWorks[laneIndex].data = stList_get(lanes, laneIndex);
         // queue job
-        tpool_add_work(tm, EM_runOneIterationAndUpdateEstimatorsForThreadPool, argWork);
+        wstpool_add_work(threadPool, EM_runOneIterationAndUpdateEstimatorsForThreadPool, &argWorks[laneIndex]);
     } // jobs for running EM on all chunks are queued
 
-    // wait until all jobs are finished for this iteration
-    tpool_wait(tm);
-    // destroy thread pool
-    tpool_destroy(tm);
+    // run jobs and wait until all of them are finished for this iteration
+    wstpool_wait(threadPool);
+    free(argWorks);
+
+    EMLane_reduceLanes(lanes, threadPool);
+    EMLane *firstLane = stList_get(lanes, 0);
+    HMM_updateEstimatorsFromOtherModel(model, firstLane->accumulator);
 
     for (int i = 0; i < stList_length(emList); i++) {
 	    EM *em = stList_get(emList, i);
         model->loglikelihood += em->loglikelihood;
-        EM_updateModelEstimators(em);
+        // accumulators are about to be destructed
+        EM_renewParametersAndEstimatorsFromModel(em, model);
     }
+    stList_destruct(lanes);
 
     /*double sum=0.0;
     for (int i = 0; i < stList_length(emList); i++) {
@@ -754,25 +1522,27 @@ void EM_runForwardForThreadPool(void *arg_) {
     EM_runForward(em);
 }
 
-void EM_runForwardForList(stList *emList, HMM *model, int threads) {
+void EM_runForwardForList(stList *emList, HMM *model, wstpool_t *threadPool) {
     model->loglikelihood = 0.0;
 
-    tpool_t *tm = tpool_create(threads);
-    for (int i = 0; i < stList_length(emList); i++) {
+    // queue the longest chunks first so that they do not become stragglers
+    stList *emListSorted = EM_getListSortedBySeqLenDecreasing(emList);
+    int numberOfEMs = stList_length(emListSorted);
+    work_arg_t *argWorks = malloc(numberOfEMs * sizeof(work_arg_t));
+    for (int i = 0; i < numberOfEMs; i++) {
         // get EM struct for this chunk index
-        EM *em = stList_get(emList, i);
+        EM *em = stList_get(emListSorted, i);
         EM_renewParametersAndEstimatorsFromModel(em, model);
         // add EM to the work struct
-        work_arg_t *argWork = malloc(sizeof(work_arg_t));
-        argWork->data = (void *) em;
+        argWorks[i].data = (void *) em;
         // queue job
-        tpool_add_work(tm, EM_runForwardForThreadPool, argWork);
+        wstpool_add_work(threadPool, EM_runForwardForThreadPool, &argWorks[i]);
     } // jobs for running EM on all chunks are queued
 
-    // wait until all jobs are finished for this iteration
-    tpool_wait(tm);
-    // destroy thread pool
-    tpool_destroy(tm);
+    // run jobs and wait until all of them are finished for this iteration
+    wstpool_wait(threadPool);
+    free(argWorks);
+    stList_destruct(emListSorted);
 
     for (int i = 0; i < stList_length(emList); i++) {
         EM *em = stList_get(emList, i);
@@ -784,6 +1554,54 @@ void EM_runForwardForList(stList *emList, HMM *model, int threads) {
 
 
 
+// forward algorithm that keeps only the last two columns; it does not touch the matrices of the EM
+// so several models can be evaluated on the same EM concurrently
+static double EM_computeLoglikelihoodForModel(EM *em, HMM *model, double *preColumn, double *column,
+                                              double **stepMatrix) {
+    double loglikelihood = 0.0;
+    // first column
+    uint8_t region = CoverageInfo_getRegionIndex(em->coverageInfoSeq[0]);
+    uint8_t x = em->coverageInfoSeq[0]->coverage;
+    double scale = 0.0;
+    for (int state = 0; state < model->numberOfStates; state++) {
+        column[state] = EmissionDistSeries_getProb(model->emissionDistSeriesPerRegion[region], state, x, 0, 0.0) *
+                        Transition_getStartProb(model->transitionPerRegion[region], state);
+        scale += column[state];
+    }
+    int stepMatrixColumn = -1;
+    for (int columnIndex = 0; columnIndex < em->seqLen; columnIndex++) {
+        if (0 < columnIndex) {
+            double *tmp = preColumn;
+            preColumn = column;
+            column = tmp;
+            if (stepMatrixColumn == -1 || !EM_areStepsEqual(em, stepMatrixColumn, columnIndex)) {
+                EM_fillStepMatrix(em, model, columnIndex, stepMatrix);
+                stepMatrixColumn = columnIndex;
+            }
+            scale = 0.0;
+            for (int state = 0; state < model->numberOfStates; state++) {
+                column[state] = 0.0;
+                for (int preState = 0; preState < model->numberOfStates; preState++) {
+                    column[state] += preColumn[preState] * stepMatrix[preState][state];
+                }
+                scale += column[state];
+            }
+        }
+        // a candidate model that can not explain the observations is rejected
+        if (scale < 1e-50) {
+            return -INFINITY;
+        }
+        for (int state = 0; state < model->numberOfStates; state++) {
+            column[state] /= scale;
+        }
+        // the scales of the flanking windows belong to the adjacent chunks
+        if (em->coreStart <= columnIndex && columnIndex < em->coreEnd) {
+            loglikelihood += log(scale);
+        }
+    }
+    return loglikelihood;
+}
+
 SquareAccelerator *SquareAccelerator_construct() {
     SquareAccelerator *accelerator = malloc(sizeof(SquareAccelerator));
     accelerator->model0 = NULL;
@@ -793,9 +1611,34 @@ SquareAccelerator *SquareAccelerator_construct() {
     accelerator->modelRatesR = NULL;
     accelerator->modelRatesV = NULL;
     accelerator->alphaRate = 0.0;
+    for (int i = 0; i < SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES; i++) {
+        accelerator->modelCandidates[i] = NULL;
+        accelerator->alphaRateCandidates[i] = 0.0;
+        accelerator->loglikelihoodCandidates[i] = 0.0;
+    }
+    accelerator->emList = NULL;
+    accelerator->jobs = NULL;
+    accelerator->jobArgs = NULL;
+    accelerator->numberOfJobs = 0;
     return accelerator;
 }
 
+static void SquareAccelerator_destructJobs(SquareAccelerator *accelerator) {
+    for (int i = 0; i < accelerator->numberOfJobs; i++) {
+        SquareAcceleratorJob *job = &accelerator->jobs[i];
+        int numberOfStates = job->em->model->numberOfStates;
+        free(job->preColumn);
+        free(job->column);
+        Double_destruct2DArray(job->stepMatrix, numberOfStates);
+    }
+    free(accelerator->jobs);
+    free(accelerator->jobArgs);
+    accelerator->jobs = NULL;
+    accelerator->jobArgs = NULL;
+    accelerator->numberOfJobs = 0;
+    accelerator->emList = NULL;
+}
+
 void SquareAccelerator_destruct(SquareAccelerator *accelerator) {
     if (accelerator->model0 != NULL) {
         HMM_destruct(accelerator->model0);
@@ -809,85 +1652,161 @@ void SquareAccelerator_destruct(SquareAccelerator *accelerator) {
     if (accelerator->modelRatesV != NULL) {
         HMM_destruct(accelerator->modelRatesV);
     }
-    if (accelerator->modelRatesR == NULL) {
+    if (accelerator->modelRatesR != NULL) {
         HMM_destruct(accelerator->modelRatesR);
     }
-    if (accelerator->modelPrime == NULL) {
-        HMM_destruct(accelerator->modelPrime);
+    // model prime is one of the candidates or model 0
+    for (int i = 0; i < SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES; i++) {
+        if (accelerator->modelCandidates[i] != NULL) {
+            HMM_destruct(accelerator->modelCandidates[i]);
+        }
     }
+    SquareAccelerator_destructJobs(accelerator);
     free(accelerator);
 }
 
+// the buffer is allocated the first time and only its parameter values are overwritten afterwards
+static void SquareAccelerator_copyIntoBuffer(HMM **bufferPtr, HMM *model) {
+    if (*bufferPtr == NULL) {
+        *bufferPtr = HMM_copy(model);
+    } else {
+        HMM_copyParameters(*bufferPtr, model);
+    }
+}
 
 void SquareAccelerator_setModel0(SquareAccelerator *accelerator, HMM *model0) {
-    accelerator->model0 = HMM_copy(model0);
-    accelerator->modelRatesR = HMM_copy(model0);
-    accelerator->modelRatesV = HMM_copy(model0);
-    accelerator->modelPrime = HMM_copy(model0);
+    SquareAccelerator_copyIntoBuffer(&accelerator->model0, model0);
+    SquareAccelerator_copyIntoBuffer(&accelerator->modelRatesR, model0);
+    SquareAccelerator_copyIntoBuffer(&accelerator->modelRatesV, model0);
+    for (int i = 0; i < SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES; i++) {
+        SquareAccelerator_copyIntoBuffer(&accelerator->modelCandidates[i], model0);
+    }
+    accelerator->modelPrime = NULL;
 }
 
 void SquareAccelerator_setModel1(SquareAccelerator *accelerator, HMM *model1) {
-    accelerator->model1 = HMM_copy(model1);
+    SquareAccelerator_copyIntoBuffer(&accelerator->model1, model1);
 }
 
 void SquareAccelerator_setModel2(SquareAccelerator *accelerator, HMM *model2) {
-    accelerator->model2 = HMM_copy(model2);
+    SquareAccelerator_copyIntoBuffer(&accelerator->model2, model2);
 }
 
-
-HMM *SquareAccelerator_shrinkAlphaAndRecomputeModelPrime(SquareAccelerator *accelerator, double alphaMargin){
-    // update alpha to make changes in parameter values smaller
-    accelerator->alphaRate = (accelerator->alphaRate - 1) / 2;
-    if ( accelerator->alphaRate > (-1 - alphaMargin)) {
-        accelerator->alphaRate = -1.0;
-        if(accelerator->modelPrime != NULL) {
-            HMM_destruct(accelerator->modelPrime);
+// one job per pair of candidate and EM; they are queued longest-chunk-first
+static void SquareAccelerator_constructJobs(SquareAccelerator *accelerator, stList *emList) {
+    if (accelerator->emList == emList && accelerator->numberOfJobs ==
+                                         stList_length(emList) * SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES) {
+        return;
+    }
+    SquareAccelerator_destructJobs(accelerator);
+    stList *emListSorted = EM_getListSortedBySeqLenDecreasing(emList);
+    int numberOfEMs = stList_length(emListSorted);
+    accelerator->numberOfJobs = numberOfEMs * SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES;
+    accelerator->jobs = malloc(accelerator->numberOfJobs * sizeof(SquareAcceleratorJob));
+    accelerator->jobArgs = malloc(accelerator->numberOfJobs * sizeof(work_arg_t));
+    for (int i = 0; i < numberOfEMs; i++) {
+        EM *em = stList_get(emListSorted, i);
+        int numberOfStates = em->model->numberOfStates;
+        for (int c = 0; c < SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES; c++) {
+            SquareAcceleratorJob *job = &accelerator->jobs[i * SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES + c];
+            job->em = em;
+            job->candidateIndex = c;
+            job->model = NULL;
+            job->loglikelihood = 0.0;
+            job->preColumn = Double_construct1DArray(numberOfStates);
+            job->column = Double_construct1DArray(numberOfStates);
+            job->stepMatrix = Double_construct2DArray(numberOfStates, numberOfStates);
         }
-        accelerator->modelPrime = HMM_copy(accelerator->model0);
-        return accelerator->modelPrime;
     }
-    // update parameters for modelPrime with the new alpha rate
-    return SquareAccelerator_computeValuesForModelPrime(accelerator);
+    stList_destruct(emListSorted);
+    accelerator->emList = emList;
 }
 
-HMM *SquareAccelerator_getModelPrime(SquareAccelerator *accelerator, stList *emList, int threads){
+void SquareAccelerator_runJobForThreadPool(void *arg_) {
+    work_arg_t *arg = arg_;
+    SquareAcceleratorJob *job = arg->data;
+    job->loglikelihood = EM_computeLoglikelihoodForModel(job->em, job->model, job->preColumn, job->column,
+                                                         job->stepMatrix);
+}
 
-    HMM *modelPrime = NULL;
+// compute the loglikelihoods of the first numberOfCandidates candidates in one round of jobs
+static void SquareAccelerator_evaluateCandidates(SquareAccelerator *accelerator,
+                                                 int numberOfCandidates,
+                                                 wstpool_t *threadPool) {
+    int numberOfQueuedJobs = 0;
+    for (int i = 0; i < accelerator->numberOfJobs; i++) {
+        SquareAcceleratorJob *job = &accelerator->jobs[i];
+        if (numberOfCandidates <= job->candidateIndex) continue;
+        job->model = accelerator->modelCandidates[job->candidateIndex];
+        accelerator->jobArgs[numberOfQueuedJobs].data = job;
+        wstpool_add_work(threadPool, SquareAccelerator_runJobForThreadPool, &accelerator->jobArgs[numberOfQueuedJobs]);
+        numberOfQueuedJobs++;
+    }
+    wstpool_wait(threadPool);
+    // sum in a fixed order so the result does not depend on the number of threads
+    for (int c = 0; c < numberOfCandidates; c++) {
+        accelerator->loglikelihoodCandidates[c] = 0.0;
+    }
+    for (int i = 0; i < accelerator->numberOfJobs; i++) {
+        SquareAcceleratorJob *job = &accelerator->jobs[i];
+        if (numberOfCandidates <= job->candidateIndex) continue;
+        accelerator->loglikelihoodCandidates[job->candidateIndex] += job->loglikelihood;
+    }
+}
+
+HMM *SquareAccelerator_getModelPrime(SquareAccelerator *accelerator, stList *emList, wstpool_t *threadPool){
     double loglikelihoodModel0 = accelerator->model0->loglikelihood;
-    double loglikelihoodModelPrime = 0.0;
 
     SquareAccelerator_computeRates(accelerator);
-    modelPrime = SquareAccelerator_computeValuesForModelPrime(accelerator);
-    while ((HMM_isFeasible(modelPrime) == false)){
-        // update parameters for modelPrime with the new alpha rate
-        modelPrime = SquareAccelerator_shrinkAlphaAndRecomputeModelPrime(accelerator, 1e-2);
-    }
-
-    // running forward will update loglikelihood
-    EM_runForwardForList(emList, modelPrime, threads);
-    loglikelihoodModelPrime = modelPrime->loglikelihood;
-    // update alpha and recompute model prime until the parameter values are feasible
-    // and the loglikelihood value is improved
-    while (loglikelihoodModelPrime < loglikelihoodModel0){
-	//fprintf(stderr, "old = %.4f, new = %.4f\n", loglikelihoodModel0, loglikelihoodModelPrime);
-        // if alpha rate is so close to -1 it means model prime will be very close to model 0
-        modelPrime = SquareAccelerator_shrinkAlphaAndRecomputeModelPrime(accelerator, 1e-2);
-        while ((HMM_isFeasible(modelPrime) == false)){
-            modelPrime = SquareAccelerator_shrinkAlphaAndRecomputeModelPrime(accelerator, 1e-2);
+    SquareAccelerator_constructJobs(accelerator, emList);
+
+    // alpha rates are shrunk toward -1 (that gives model 0) with (alpha - 1) / 2; in each round the next few
+    // feasible candidates are evaluated together and the best one improving the loglikelihood is selected
+    double alphaRate = accelerator->alphaRate;
+    bool reachedModel0 = false;
+    accelerator->modelPrime = NULL;
+    while (accelerator->modelPrime == NULL) {
+        int numberOfCandidates = 0;
+        while (numberOfCandidates < SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES && !reachedModel0) {
+            HMM *candidate = accelerator->modelCandidates[numberOfCandidates];
+            SquareAccelerator_computeValuesForModelPrime(accelerator, candidate, alphaRate);
+            if (HMM_isFeasible(candidate)) {
+                accelerator->alphaRateCandidates[numberOfCandidates] = alphaRate;
+                numberOfCandidates++;
+            }
+            // if alpha rate is so close to -1 it means model prime will be very close to model 0
+            alphaRate = (alphaRate - 1) / 2;
+            reachedModel0 = alphaRate > (-1 - SQUARE_ACCELERATOR_ALPHA_MARGIN);
+        }
+        if (0 < numberOfCandidates) {
+            SquareAccelerator_evaluateCandidates(accelerator, numberOfCandidates, threadPool);
+            int bestIndex = -1;
+            for (int c = 0; c < numberOfCandidates; c++) {
+                double loglikelihood = accelerator->loglikelihoodCandidates[c];
+                if (loglikelihoodModel0 <= loglikelihood &&
+                    (bestIndex == -1 || accelerator->loglikelihoodCandidates[bestIndex] < loglikelihood)) {
+                    bestIndex = c;
+                }
+            }
+            if (bestIndex != -1) {
+                accelerator->alphaRate = accelerator->alphaRateCandidates[bestIndex];
+                accelerator->modelPrime = accelerator->modelCandidates[bestIndex];
+                accelerator->modelPrime->loglikelihood = accelerator->loglikelihoodCandidates[bestIndex];
+                break;
+            }
+        }
+        if (reachedModel0) {
+            accelerator->alphaRate = -1.0;
+            accelerator->modelPrime = accelerator->model0;
         }
-        // running forward will update loglikelihood
-        EM_runForwardForList(emList, modelPrime, threads);
-        loglikelihoodModelPrime = modelPrime->loglikelihood;
     }
-    //fprintf(stderr, "old = %.4f, new = %.4f\n", loglikelihoodModel0, loglikelihoodModelPrime);
     fprintf(stderr, "[%s] Computed alpha rate for accelerating EM = %.4f\n", get_timestamp(), accelerator->alphaRate);
     return accelerator->modelPrime;
 }
 
 // run SquareAccelerator_computeRates before running this function
-HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator) {
+HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator, HMM *modelPrime, double alphaRate) {
     HMM *model0 = accelerator->model0;
-    HMM *modelPrime = accelerator->modelPrime;
     HMM *modelRatesV = accelerator->modelRatesV;
     HMM *modelRatesR = accelerator->modelRatesR;
 
@@ -924,7 +1843,7 @@ HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator
                                                             distIndex,
                                                             compIndex);
             // new value = value0 - 2 x r x alpha + v x alpha ^ 2
-            double newValue = valueForModel0 - 2 * r * accelerator->alphaRate + v * pow(accelerator->alphaRate, 2);
+            double newValue = valueForModel0 - 2 * r * alphaRate + v * pow(alphaRate, 2);
 
 	    //NegativeBinomialParameterType * xx = (NegativeBinomialParameterType *) parameterTypePtr;
 	    //fprintf(stderr, "param=%d,distIndex=%d,compIndex=%d, valueForModel0=%.2e, r=%.2e, v=%.2e, accelerator->alphaRate=%.2e, newValue=%.2e\n", xx[0], distIndex,compIndex,valueForModel0, r, v, accelerator->alphaRate, newValue);
@@ -935,6 +1854,7 @@ HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator
                                                  compIndex,
                                                  newValue);
         }
+        EmissionDistSeriesParamIter_destruct(paramIter);
 
         /////////////////////////////
         // For transition parameters
@@ -952,15 +1872,15 @@ HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator
                 double v = transitionModelRatesV->matrix->data[s1][s2];
 
                 // new value = value0 - 2 x r x alpha + v x alpha ^ 2
-                double newValue = valueForModel0 - 2 * r * accelerator->alphaRate + v * pow(accelerator->alphaRate, 2);
+                double newValue = valueForModel0 - 2 * r * alphaRate + v * pow(alphaRate, 2);
                 transitionModelPrime->matrix->data[s1][s2] = newValue;
 
             } // finished iterating s2
         } // finish iterating s1
 
     } // finished iterating over regions
-    HMM_normalizeWeightsAndTransitionRows(accelerator->modelPrime);
-    return accelerator->modelPrime;
+    HMM_normalizeWeightsAndTransitionRows(modelPrime);
+    return modelPrime;
 }
 
 void SquareAccelerator_computeRates(SquareAccelerator *accelerator) {
@@ -9,8 +9,25 @@
 #include "math.h"
 #include "digamma.h"
 #include "hmm_utils.h"
+#include "tpool.h"
 
 
+typedef enum DecodeType {
+    DECODE_POSTERIOR = 0, // argmax of posterior probabilities per window (needs forward-backward)
+    DECODE_VITERBI = 1, // most probable path of states
+    DECODE_UNDEFINED = 2
+} DecodeType;
+
+DecodeType getDecodeTypeFromString(const char *decodeString);
+
+typedef enum EMPrecision {
+    PRECISION_DOUBLE = 0, // forward and backward matrices are saved in double
+    PRECISION_FLOAT = 1, // forward and backward matrices are saved in float; computations and estimators stay in double
+    PRECISION_UNDEFINED = 2
+} EMPrecision;
+
+EMPrecision getEMPrecisionFromString(const char *precisionString);
+
 typedef struct HMM {
     EmissionDistSeries **emissionDistSeriesPerRegion;
     Transition **transitionPerRegion;
@@ -43,6 +60,10 @@ void HMM_normalizeWeightsAndTransitionRows(HMM *model);
 
 HMM *HMM_copy(HMM *src);
 
+// copy the parameter values and loglikelihood of src into dest (with the same structure) without allocating memory;
+// estimators of dest are not touched
+void HMM_copyParameters(HMM *dest, HMM *src);
+
 void HMM_destruct(HMM *model);
 
 int HMM_getStartStateIndex(HMM *model);
@@ -53,15 +74,47 @@ bool HMM_estimateParameters(HMM *model, double convergenceTol);
 
 void HMM_resetEstimators(HMM *model);
 
+// multiply the estimator values and transition counts by the given factor
+void HMM_scaleEstimators(HMM *model, double factor);
+
+// add the estimator values and transition counts of src into dest
+void HMM_updateEstimatorsFromOtherModel(HMM *dest, HMM *src);
+
+void HMM_updateEstimatorsUsingCountData(HMM *model);
+
 void HMM_printTransitionMatrixInTsvFormat(HMM *model, FILE *fout);
 
 void HMM_printEmissionParametersInTsvFormat(HMM *model, FILE *fout);
 
+#define HMM_BINARY_MAGIC "HMMFLAGGER"
+#define HMM_BINARY_FORMAT_VERSION 1
+
+// save all parameters (emissions and transitions per region, alpha and model type) for reusing the model
+void HMM_writeIntoBinaryFile(HMM *model, char *binPath);
+
+HMM *HMM_constructFromBinaryFile(char *binPath);
+
+// save parameters together with the accumulated estimators, transition counts and loglikelihood
+// (the sufficient statistics of one E-step) so they can be summed across processes
+void HMM_writeSufficientStatsIntoBinaryFile(HMM *model, char *binPath);
+
+HMM *HMM_constructFromSufficientStatsBinaryFile(char *binPath);
+
+bool HMM_hasSameStructure(HMM *model1, HMM *model2);
+
 typedef struct EM {
     CoverageInfo **coverageInfoSeq; // the sequence of emissions
     int seqLen;
-    double **f; // Forward matrix: #SEQ_LEN x #nComps
-    double **b; // Backward matrix: #SEQ_LEN x #nComps
+    double **f; // Forward matrix: #SEQ_LEN x #nComps (NULL with PRECISION_FLOAT)
+    double **b; // Backward matrix: #SEQ_LEN x #nComps (NULL with PRECISION_FLOAT)
+    // with PRECISION_FLOAT the matrices are saved in float to halve their memory traffic;
+    // each column is computed in double using the buffers below and then rounded
+    EMPrecision precision;
+    float **fFloat; // #SEQ_LEN x #nComps (NULL with PRECISION_DOUBLE)
+    float **bFloat; // #SEQ_LEN x #nComps (NULL with PRECISION_DOUBLE)
+    double *bColumnScales; // #SEQ_LEN; each column of bFloat is divided by its maximum (NULL with PRECISION_DOUBLE)
+    double *preColumn; // #nComps
+    double *column; // #nComps
     double px; // P(x)
     double *scales;
     HMM *model;
@@ -69,13 +122,61 @@ typedef struct EM {
     Transition **transitionPerRegion;
     int numberOfRegions;
     double loglikelihood;
+    // the sequence may be extended with flanking windows that belong to the adjacent chunks;
+    // only the windows in [coreStart, coreEnd) contribute to the statistics and get predictions
+    int coreStart;
+    int coreEnd;
+    // transition x emission probabilities of the step into column stepMatrixColumn;
+    // consecutive windows with identical observations reuse it instead of recomputing
+    double **stepMatrix;
+    int stepMatrixColumn;
+    double **runCounts; // expected counts summed over a run of identical steps
+    // validity mask of each window for the conditional transitions (see Transition_getValidityMask);
+    // computed once with the validity functions of the model given to EM_construct
+    uint8_t *validityMasks;
+    // prediction labels are saved in the (shared) coverage info data; it is disabled
+    // when several models are trained concurrently on the same chunks
+    bool updatePredictions;
+    // adaptive freezing: each EM keeps the sufficient statistics of its last E-step and
+    // reuses them instead of running forward-backward while frozenIterations > 0
+    bool freezingEnabled;
+    HMM *cachedStats;
+    float *previousPosteriors; // #SEQ_LEN x #nComps; posteriors of the last E-step
+    bool hasPreviousPosteriors;
+    int frozenIterations;
+    bool reusedCachedStats; // true if the last iteration reused the cached statistics
+    double loglikelihoodChange; // relative change since the previous E-step (-1 if not available)
+    double posteriorChange; // mean total variation distance of the core posteriors (-1 if not available)
 } EM;
 
 
-EM *EM_construct(CoverageInfo **coverageInfoSeq, int seqLen, HMM *model);
+EM *EM_construct(CoverageInfo **coverageInfoSeq, int seqLen, HMM *model, EMPrecision precision);
+
+// forward and backward matrices are allocated by EM_construct; they can be released once the
+// posteriors are not needed anymore and they are allocated again by the next EM_runForward
+bool EM_hasMatrices(EM *em);
 
+// does nothing if the matrices are already allocated
+void EM_allocateMatrices(EM *em);
+
+void EM_releaseMatrices(EM *em);
+
+// EM does not own the parameters; it reads them from the model
 void EM_renewParametersAndEstimatorsFromModel(EM *em, HMM *model);
 
+// read parameters from and add sufficient statistics into the given accumulator (a copy of em->model)
+void EM_setAccumulator(EM *em, HMM *accumulator);
+
+void EM_setCore(EM *em, int coreStart, int coreEnd);
+
+// enable caching the sufficient statistics of this EM so that it can be frozen later
+void EM_enableFreezing(EM *em);
+
+// reuse the cached sufficient statistics for the given number of iterations
+void EM_freeze(EM *em, int numberOfIterations);
+
+void EM_unfreeze(EM *em);
+
 void EM_destruct(EM *em);
 
 void EM_runForward(EM *em);
@@ -90,49 +191,121 @@ bool EM_estimateParameters(EM *em, double convergenceTol);
 
 void EM_resetEstimators(EM *em);
 
+uint8_t *EM_runViterbi(EM *em, double *logProbPtr);
+
+void EM_runViterbiAndUpdatePredictions(EM *em);
+
+void EM_runViterbiForThreadPool(void *arg_);
+
+// decode all EMs with Viterbi and save the paths as prediction labels
+void EM_runViterbiForList(stList *emList, HMM *model, wstpool_t *threadPool);
+
 double *EM_getPosterior(EM *em, int pos);
 
 int EM_getMostProbableState(EM *em, int pos);
 
 void EM_printPosteriorInTsvFormat(EM *em, FILE *fout);
 
+void EM_runOneIterationAndUpdateEstimators(EM *em);
+
+// run forward-backward and update the prediction labels without adding anything into the estimators;
+// with freezing enabled the per-chunk changes since the previous E-step are updated too
+void EM_runForwardBackwardAndUpdatePredictions(EM *em);
+
+void EM_runForwardBackwardAndUpdatePredictionsForThreadPool(void *arg_);
+
+int EM_cmpSeqLenDecreasing(const void *em_1_, const void *em_2_);
+
+stList *EM_getListSortedBySeqLenDecreasing(stList *emList);
+
+// Chunks are dealt into a fixed number of lanes with similar total lengths. Each lane runs as one job;
+// its EMs run one after another and add their statistics into the accumulator of the lane. The lanes
+// are merged with a pairwise tree, so the sufficient statistics are summed in an order that does not
+// depend on the number of threads or on the scheduling of the jobs and the merge cost only depends on
+// the number of lanes
+#define EM_MAX_NUMBER_OF_LANES 256
+
+typedef struct EMLane {
+    stList *emList; // not owned
+    HMM *accumulator;
+} EMLane;
+
+EMLane *EMLane_construct(HMM *model);
+
+void EMLane_destruct(EMLane *lane);
+
+stList *EMLane_constructLanes(stList *emList, HMM *model);
+
+void EMLane_reduceLanes(stList *lanes, wstpool_t *threadPool);
+
 void EM_runOneIterationAndUpdateEstimatorsForThreadPool(void *arg_);
 
-void EM_runOneIterationForList(stList *emList, HMM *model, int threads);
+// threadPool is reused across iterations; jobs are queued longest-chunk-first
+void EM_runOneIterationForList(stList *emList, HMM *model, wstpool_t *threadPool);
 
 void EM_runForwardForThreadPool(void *arg_);
 
-void EM_runForwardForList(stList *emList, HMM *model, int threads);
+void EM_runForwardForList(stList *emList, HMM *model, wstpool_t *threadPool);
+
+// number of shrunk alpha rates whose model primes are evaluated concurrently in one round
+#define SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES 4
+// alpha rates closer than this margin to -1 fall back to model 0
+#define SQUARE_ACCELERATOR_ALPHA_MARGIN 1e-2
+
+// forward pass of one candidate model on one chunk; only the last two columns are kept
+// so that several candidates can be evaluated on the same EM at the same time
+typedef struct SquareAcceleratorJob {
+    EM *em; // not owned
+    int candidateIndex;
+    HMM *model; // not owned
+    double loglikelihood;
+    double *preColumn;
+    double *column;
+    double **stepMatrix;
+} SquareAcceleratorJob;
 
 typedef struct SquareAccelerator {
     HMM *model0;
     HMM *model1;
     HMM *model2;
-    HMM *modelPrime;
+    HMM *modelPrime; // the selected candidate or model 0; not owned
     HMM *modelRatesV;
     HMM *modelRatesR;
     double alphaRate;
+    // model buffers are allocated by the first SquareAccelerator_setModel0 and reused in the next iterations
+    HMM *modelCandidates[SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES];
+    double alphaRateCandidates[SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES];
+    double loglikelihoodCandidates[SQUARE_ACCELERATOR_NUMBER_OF_CANDIDATES];
+    // jobs are built once for the chunks in emList
+    stList *emList; // not owned
+    SquareAcceleratorJob *jobs;
+    work_arg_t *jobArgs;
+    int numberOfJobs;
 } SquareAccelerator;
 
 // steps :
-// 1. run SquareAccelerator_construct to make an accelerator object
-// 2. set model 0 with SquareAccelerator_setModel0 (this function makes a copy of model 0)
+// 1. run SquareAccelerator_construct to make an accelerator object (it can be reused for all iterations)
+// 2. set model 0 with SquareAccelerator_setModel0 (this function copies model 0 into a buffer)
 // 3. run EM_runOneIterationForList on model 0 to get model 1
-// 4. set model 1 with SquareAccelerator_setModel1 (this function makes a copy of model 1)
+// 4. set model 1 with SquareAccelerator_setModel1 (this function copies model 1 into a buffer)
 // 5. run EM_runOneIterationForList on model 1 to get model 2
-// 6. set model 2 with SquareAccelerator_setModel2 (this function makes a copy of model 2)
+// 6. set model 2 with SquareAccelerator_setModel2 (this function copies model 2 into a buffer)
 // 7. call SquareAccelerator_getModelPrime to get model prime
-// 8. run EM_runOneIterationForList on model prime to get the final model after acceleration
+// 8. copy model prime into the model with HMM_copyParameters and run EM_runOneIterationForList on it
+//    to get the final model after acceleration
 
 SquareAccelerator *SquareAccelerator_construct();
 void SquareAccelerator_destruct(SquareAccelerator *accelerator);
 void SquareAccelerator_setModel0(SquareAccelerator *accelerator, HMM *model0);
 void SquareAccelerator_setModel1(SquareAccelerator *accelerator, HMM *model1);
 void SquareAccelerator_setModel2(SquareAccelerator *accelerator, HMM *model2);
-HMM *SquareAccelerator_getModelPrime(SquareAccelerator *accelerator, stList *emList, int threads);
+void SquareAccelerator_runJobForThreadPool(void *arg_);
+// the returned model is owned by the accelerator and is valid until the next SquareAccelerator_setModel0
+HMM *SquareAccelerator_getModelPrime(SquareAccelerator *accelerator, stList *emList, wstpool_t *threadPool);
 
 // run SquareAccelerator_computeRates before running this function
-HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator);
+// write the parameters for the given alpha rate into modelPrime
+HMM *SquareAccelerator_computeValuesForModelPrime(SquareAccelerator *accelerator, HMM *modelPrime, double alphaRate);
 void SquareAccelerator_computeRates(SquareAccelerator *accelerator);
 
 #endif
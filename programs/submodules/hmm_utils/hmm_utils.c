@@ -96,6 +96,28 @@ void ParameterEstimator_reset(ParameterEstimator *parameterEstimator) {
     Double_fill1DArray(parameterEstimator->denominatorPerComp, parameterEstimator->numberOfComps, 0.0);
 }
 
+void ParameterEstimator_scale(ParameterEstimator *parameterEstimator, double factor) {
+    Double_multiply1DArray(parameterEstimator->numeratorPerComp, parameterEstimator->numberOfComps, factor);
+    Double_multiply1DArray(parameterEstimator->denominatorPerComp, parameterEstimator->numberOfComps, factor);
+}
+
+void ParameterEstimator_writeIntoBinaryFile(ParameterEstimator *parameterEstimator, FILE *fp) {
+    fwrite(&parameterEstimator->numberOfComps, sizeof(int32_t), 1, fp);
+    fwrite(parameterEstimator->numeratorPerComp, sizeof(double), parameterEstimator->numberOfComps, fp);
+    fwrite(parameterEstimator->denominatorPerComp, sizeof(double), parameterEstimator->numberOfComps, fp);
+}
+
+bool ParameterEstimator_readFromBinaryFile(ParameterEstimator *parameterEstimator, FILE *fp) {
+    int numberOfComps = 0;
+    if (fread(&numberOfComps, sizeof(int32_t), 1, fp) != 1 ||
+        numberOfComps != parameterEstimator->numberOfComps) {
+        return false;
+    }
+    size_t n = parameterEstimator->numberOfComps;
+    return fread(parameterEstimator->numeratorPerComp, sizeof(double), n, fp) == n &&
+           fread(parameterEstimator->denominatorPerComp, sizeof(double), n, fp) == n;
+}
+
 
 void ParameterEstimator_destruct(ParameterEstimator *parameterEstimator) {
     Double_destruct1DArray(parameterEstimator->numeratorPerComp);
@@ -389,6 +411,15 @@ NegativeBinomial *NegativeBinomial_copy(NegativeBinomial *src, EmissionDist *emi
     return dest;
 }
 
+void NegativeBinomial_copyParameterValues(NegativeBinomial *dest, NegativeBinomial *src) {
+    assert(dest->numberOfComps == src->numberOfComps);
+    memcpy(dest->theta, src->theta, src->numberOfComps * sizeof(double));
+    memcpy(dest->lambda, src->lambda, src->numberOfComps * sizeof(double));
+    memcpy(dest->weights, src->weights, src->numberOfComps * sizeof(double));
+    // digamma values depend on theta and lambda
+    NegativeBinomial_fillDigammaTable(dest);
+}
+
 void NegativeBinomial_fillDigammaTable(NegativeBinomial *nb) {
     if (nb->digammaTable == NULL) {
         nb->digammaTable = Double_construct2DArray(nb->numberOfComps, MAX_COVERAGE_VALUE + 1);
@@ -706,6 +737,13 @@ Gaussian *Gaussian_copy(Gaussian *src, EmissionDist *emissionDistDest) {
     return dest;
 }
 
+void Gaussian_copyParameterValues(Gaussian *dest, Gaussian *src) {
+    assert(dest->numberOfComps == src->numberOfComps);
+    memcpy(dest->mean, src->mean, src->numberOfComps * sizeof(double));
+    memcpy(dest->var, src->var, src->numberOfComps * sizeof(double));
+    memcpy(dest->weights, src->weights, src->numberOfComps * sizeof(double));
+}
+
 /**
  * Destructs a Gaussian object
  *
@@ -928,6 +966,11 @@ TruncExponential *TruncExponential_copy(TruncExponential *src, EmissionDist *emi
     return dest;
 }
 
+void TruncExponential_copyParameterValues(TruncExponential *dest, TruncExponential *src) {
+    dest->lambda = src->lambda;
+    dest->truncPoint = src->truncPoint;
+}
+
 void TruncExponential_destruct(TruncExponential *truncExponential) {
     ParameterEstimator_destruct(truncExponential->lambdaEstimator);
     free(truncExponential);
@@ -1299,6 +1342,17 @@ EmissionDist *EmissionDist_copy(EmissionDist *src) {
     return dest;
 }
 
+void EmissionDist_copyParameterValues(EmissionDist *dest, EmissionDist *src) {
+    assert(dest->distType == src->distType);
+    if (src->distType == DIST_TRUNC_EXPONENTIAL) {
+        TruncExponential_copyParameterValues((TruncExponential *) dest->dist, (TruncExponential *) src->dist);
+    } else if (src->distType == DIST_GAUSSIAN) {
+        Gaussian_copyParameterValues((Gaussian *) dest->dist, (Gaussian *) src->dist);
+    } else if (src->distType == DIST_NEGATIVE_BINOMIAL) {
+        NegativeBinomial_copyParameterValues((NegativeBinomial *) dest->dist, (NegativeBinomial *) src->dist);
+    }
+}
+
 void EmissionDist_initParameterEstimators(EmissionDist *emissionDist) {
     if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
         TruncExponential *truncExponential = (TruncExponential *) emissionDist->dist;
@@ -1333,6 +1387,58 @@ void EmissionDist_resetParameterEstimators(EmissionDist *emissionDist) {
     }
 }
 
+void EmissionDist_scaleParameterEstimators(EmissionDist *emissionDist, double factor) {
+    if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
+        TruncExponential *truncExponential = (TruncExponential *) emissionDist->dist;
+        ParameterEstimator_scale(truncExponential->lambdaEstimator, factor);
+    } else if (emissionDist->distType == DIST_GAUSSIAN) {
+        Gaussian *gaussian = (Gaussian *) emissionDist->dist;
+        ParameterEstimator_scale(gaussian->meanEstimator, factor);
+        ParameterEstimator_scale(gaussian->varEstimator, factor);
+        ParameterEstimator_scale(gaussian->weightsEstimator, factor);
+    } else if (emissionDist->distType == DIST_NEGATIVE_BINOMIAL) {
+        NegativeBinomial *nb = (NegativeBinomial *) emissionDist->dist;
+        ParameterEstimator_scale(nb->thetaEstimator, factor);
+        ParameterEstimator_scale(nb->lambdaEstimator, factor);
+        ParameterEstimator_scale(nb->weightsEstimator, factor);
+    }
+}
+
+void EmissionDist_writeParameterEstimatorsIntoBinaryFile(EmissionDist *emissionDist, FILE *fp) {
+    if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
+        TruncExponential *truncExponential = (TruncExponential *) emissionDist->dist;
+        ParameterEstimator_writeIntoBinaryFile(truncExponential->lambdaEstimator, fp);
+    } else if (emissionDist->distType == DIST_GAUSSIAN) {
+        Gaussian *gaussian = (Gaussian *) emissionDist->dist;
+        ParameterEstimator_writeIntoBinaryFile(gaussian->meanEstimator, fp);
+        ParameterEstimator_writeIntoBinaryFile(gaussian->varEstimator, fp);
+        ParameterEstimator_writeIntoBinaryFile(gaussian->weightsEstimator, fp);
+    } else if (emissionDist->distType == DIST_NEGATIVE_BINOMIAL) {
+        NegativeBinomial *nb = (NegativeBinomial *) emissionDist->dist;
+        ParameterEstimator_writeIntoBinaryFile(nb->thetaEstimator, fp);
+        ParameterEstimator_writeIntoBinaryFile(nb->lambdaEstimator, fp);
+        ParameterEstimator_writeIntoBinaryFile(nb->weightsEstimator, fp);
+    }
+}
+
+bool EmissionDist_readParameterEstimatorsFromBinaryFile(EmissionDist *emissionDist, FILE *fp) {
+    if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
+        TruncExponential *truncExponential = (TruncExponential *) emissionDist->dist;
+        return ParameterEstimator_readFromBinaryFile(truncExponential->lambdaEstimator, fp);
+    } else if (emissionDist->distType == DIST_GAUSSIAN) {
+        Gaussian *gaussian = (Gaussian *) emissionDist->dist;
+        return ParameterEstimator_readFromBinaryFile(gaussian->meanEstimator, fp) &&
+               ParameterEstimator_readFromBinaryFile(gaussian->varEstimator, fp) &&
+               ParameterEstimator_readFromBinaryFile(gaussian->weightsEstimator, fp);
+    } else if (emissionDist->distType == DIST_NEGATIVE_BINOMIAL) {
+        NegativeBinomial *nb = (NegativeBinomial *) emissionDist->dist;
+        return ParameterEstimator_readFromBinaryFile(nb->thetaEstimator, fp) &&
+               ParameterEstimator_readFromBinaryFile(nb->lambdaEstimator, fp) &&
+               ParameterEstimator_readFromBinaryFile(nb->weightsEstimator, fp);
+    }
+    return false;
+}
+
 
 int EmissionDist_getNumberOfComps(EmissionDist *emissionDist) {
     if (emissionDist->distType == DIST_TRUNC_EXPONENTIAL) {
@@ -1709,6 +1815,13 @@ EmissionDistSeries **EmissionDistSeries_copy1DArray(EmissionDistSeries **srcArra
     return destArray;
 }
 
+void EmissionDistSeries_copyParameterValues(EmissionDistSeries *dest, EmissionDistSeries *src) {
+    assert(dest->numberOfDists == src->numberOfDists);
+    for (int s = 0; s < src->numberOfDists; s++) {
+        EmissionDist_copyParameterValues(dest->emissionDists[s], src->emissionDists[s]);
+    }
+}
+
 void EmissionDistSeries_destruct1DArray(EmissionDistSeries **array, int length) {
     for (int i = 0; i < length; i++) {
         EmissionDistSeries_destruct(array[i]);
@@ -1781,6 +1894,28 @@ void EmissionDistSeries_resetParameterEstimators(EmissionDistSeries *emissionDis
     }
 }
 
+void EmissionDistSeries_scaleParameterEstimators(EmissionDistSeries *emissionDistSeries, double factor) {
+    for (int distIndex = 0; distIndex < emissionDistSeries->numberOfDists; distIndex++) {
+        EmissionDist *emissionDist = emissionDistSeries->emissionDists[distIndex];
+        EmissionDist_scaleParameterEstimators(emissionDist, factor);
+    }
+}
+
+void EmissionDistSeries_writeParameterEstimatorsIntoBinaryFile(EmissionDistSeries *emissionDistSeries, FILE *fp) {
+    for (int distIndex = 0; distIndex < emissionDistSeries->numberOfDists; distIndex++) {
+        EmissionDist_writeParameterEstimatorsIntoBinaryFile(emissionDistSeries->emissionDists[distIndex], fp);
+    }
+}
+
+bool EmissionDistSeries_readParameterEstimatorsFromBinaryFile(EmissionDistSeries *emissionDistSeries, FILE *fp) {
+    for (int distIndex = 0; distIndex < emissionDistSeries->numberOfDists; distIndex++) {
+        if (!EmissionDist_readParameterEstimatorsFromBinaryFile(emissionDistSeries->emissionDists[distIndex], fp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 ParameterEstimator *
 EmissionDistSeries_getBoundParameterEstimator(EmissionDistSeries *emissionDistSeries, DistType distType,
                                               void *parameterTypePtr) {
@@ -2012,6 +2147,15 @@ void TransitionCountData_resetCountMatrix(TransitionCountData *transitionCountDa
     MatrixDouble_setValue(transitionCountData->countMatrix, 0.0);
 }
 
+void TransitionCountData_scaleCountMatrix(TransitionCountData *transitionCountData, double factor) {
+    MatrixDouble *countMatrix = transitionCountData->countMatrix;
+    for (int s1 = 0; s1 < countMatrix->dim1; s1++) {
+        for (int s2 = 0; s2 < countMatrix->dim2; s2++) {
+            countMatrix->data[s1][s2] *= factor;
+        }
+    }
+}
+
 void
 TransitionCountData_parsePseudoCountFromFile(TransitionCountData *transitionCountData, char *pathToMatrix, int dim) {
     assert(dim == (transitionCountData->numberOfStates + 1));
@@ -2047,6 +2191,24 @@ TransitionCountData *TransitionCountData_destruct(TransitionCountData *transitio
  * 		should be equal to the number of states + 1
  * @return trans The transition matrix
  */
+// one bit per state plus one for the end state
+static int Transition_getNumberOfValidityMasks(int numberOfStates) {
+    return 1 << (numberOfStates + 1);
+}
+
+static double *Transition_constructConditionalMatrices(int numberOfStates) {
+    assert(numberOfStates + 1 <= 8); // masks are saved in uint8_t
+    int numberOfMasks = Transition_getNumberOfValidityMasks(numberOfStates);
+    return malloc(numberOfMasks * numberOfStates * numberOfStates * sizeof(double));
+}
+
+static void Transition_copyConditionalMatrices(Transition *dest, Transition *src) {
+    int numberOfMasks = Transition_getNumberOfValidityMasks(src->numberOfStates);
+    memcpy(dest->conditionalMatrices,
+           src->conditionalMatrices,
+           numberOfMasks * src->numberOfStates * src->numberOfStates * sizeof(double));
+}
+
 Transition *Transition_constructUniform(int numberOfStates) {
     int dimension = numberOfStates + 1;
     Transition *transition = malloc(sizeof(Transition));
@@ -2056,6 +2218,10 @@ Transition *Transition_constructUniform(int numberOfStates) {
     transition->numberOfValidityFunctions = 0;
     transition->numberOfStates = numberOfStates;
     transition->terminationProb = 1e-4;
+    transition->requirements = NULL;
+    transition->validityFunctions = NULL;
+    transition->conditionalMatrices = Transition_constructConditionalMatrices(numberOfStates);
+    Transition_updateConditionalMatrices(transition);
     return transition;
 }
 
@@ -2071,6 +2237,8 @@ Transition *Transition_copy(Transition *src) {
     }
     dest->numberOfStates = src->numberOfStates;
     dest->terminationProb = src->terminationProb;
+    dest->conditionalMatrices = Transition_constructConditionalMatrices(src->numberOfStates);
+    Transition_copyConditionalMatrices(dest, src);
     return dest;
 }
 
@@ -2082,6 +2250,12 @@ Transition **Transition_copy1DArray(Transition **srcArray, int length) {
     return destArray;
 }
 
+void Transition_copyParameterValues(Transition *dest, Transition *src) {
+    MatrixDouble_copyInPlace(dest->matrix, src->matrix);
+    dest->terminationProb = src->terminationProb;
+    Transition_copyConditionalMatrices(dest, src);
+}
+
 void Transition_destruct1DArray(Transition **array, int length) {
     for (int i = 0; i < length; i++) {
         Transition_destruct(array[i]);
@@ -2117,6 +2291,8 @@ Transition *Transition_constructSymmetricBiased(int numberOfStates, double diago
     transition->numberOfStates = numberOfStates;
     transition->requirements = NULL;
     transition->validityFunctions = NULL;
+    transition->conditionalMatrices = Transition_constructConditionalMatrices(numberOfStates);
+    Transition_updateConditionalMatrices(transition);
     return transition;
 }
 
@@ -2135,12 +2311,17 @@ void Transition_resetCountData(Transition *transition) {
     TransitionCountData_resetCountMatrix(transition->transitionCountData);
 }
 
+void Transition_scaleCountData(Transition *transition, double factor) {
+    TransitionCountData_scaleCountMatrix(transition->transitionCountData, factor);
+}
+
 
 void Transition_destruct(Transition *transition) {
     MatrixDouble_destruct(transition->matrix);
     TransitionCountData_destruct(transition->transitionCountData);
     TransitionRequirements_destruct(transition->requirements);
     free(transition->validityFunctions);
+    free(transition->conditionalMatrices);
     free(transition);
 }
 
@@ -2173,6 +2354,7 @@ void Transition_normalizeTransitionRows(Transition *transition){
     }
     // the probability of empty sequence
     transition->matrix->data[transition->numberOfStates][transition->numberOfStates] = 0.0;
+    Transition_updateConditionalMatrices(transition);
 }
 
 bool Transition_estimateTransitionMatrix(Transition *transition, double convergenceTol) {
@@ -2208,6 +2390,7 @@ bool Transition_estimateTransitionMatrix(Transition *transition, double converge
     }
     // the probability of empty sequence
     transition->matrix->data[transition->numberOfStates][transition->numberOfStates] = 0.0;
+    Transition_updateConditionalMatrices(transition);
     return converged;
 }
 
@@ -2268,22 +2451,49 @@ double Transition_getStartProb(Transition *transition, StateType state) {
     return transition->matrix->data[transition->numberOfStates][state];
 }
 
-double
-Transition_getProbConditional(Transition *transition, StateType preState, StateType state, CoverageInfo *coverageInfo) {
-    double totProbValid = 0.0;
+uint8_t Transition_getValidityMask(Transition *transition, CoverageInfo *coverageInfo) {
+    uint8_t validityMask = 0;
     for (int s = 0; s < transition->numberOfStates + 1; s++) {
         if (Transition_isStateValid(transition, s, coverageInfo)) {
-            totProbValid += Transition_getProb(transition, preState, s);
+            validityMask |= 1 << s;
         }
     }
-    double prob = Transition_getProb(transition, preState, state);
-    if (Transition_isStateValid(transition, state, coverageInfo)) {
-        return prob / totProbValid;
-    } else {
-        return 0.0;
+    return validityMask;
+}
+
+void Transition_updateConditionalMatrices(Transition *transition) {
+    int numberOfStates = transition->numberOfStates;
+    int numberOfMasks = Transition_getNumberOfValidityMasks(numberOfStates);
+    for (int validityMask = 0; validityMask < numberOfMasks; validityMask++) {
+        double *conditionalMatrix = Transition_getConditionalMatrix(transition, validityMask);
+        for (int preState = 0; preState < numberOfStates; preState++) {
+            // normalize the row by the total probability of the valid states
+            double totProbValid = 0.0;
+            for (int s = 0; s < numberOfStates + 1; s++) {
+                if (validityMask & (1 << s)) {
+                    totProbValid += Transition_getProb(transition, preState, s);
+                }
+            }
+            for (int state = 0; state < numberOfStates; state++) {
+                double prob = Transition_getProb(transition, preState, state);
+                conditionalMatrix[preState * numberOfStates + state] =
+                        (validityMask & (1 << state)) ? prob / totProbValid : 0.0;
+            }
+        }
     }
 }
 
+double *Transition_getConditionalMatrix(Transition *transition, uint8_t validityMask) {
+    return transition->conditionalMatrices + validityMask * transition->numberOfStates * transition->numberOfStates;
+}
+
+double
+Transition_getProbConditional(Transition *transition, StateType preState, StateType state, CoverageInfo *coverageInfo) {
+    uint8_t validityMask = Transition_getValidityMask(transition, coverageInfo);
+    double *conditionalMatrix = Transition_getConditionalMatrix(transition, validityMask);
+    return conditionalMatrix[preState * transition->numberOfStates + state];
+}
+
 double Exponential_getPdf(double x, double lam) {
     if (x < 0.0) {
         return 0.0;
@@ -115,6 +115,22 @@ double ParameterEstimator_getEstimation(ParameterEstimator *parameterEstimator,
 
 void ParameterEstimator_reset(ParameterEstimator *parameterEstimator);
 
+/*
+ * Multiply all numerators and denominators by the given factor
+ */
+void ParameterEstimator_scale(ParameterEstimator *parameterEstimator, double factor);
+
+/*
+ * Write numerators and denominators into a binary file
+ */
+void ParameterEstimator_writeIntoBinaryFile(ParameterEstimator *parameterEstimator, FILE *fp);
+
+/*
+ * Overwrite numerators and denominators with the values read from a binary file.
+ * Returns false if the file ended before reading all values.
+ */
+bool ParameterEstimator_readFromBinaryFile(ParameterEstimator *parameterEstimator, FILE *fp);
+
 void ParameterEstimator_destruct(ParameterEstimator *parameterEstimator);
 
 ParameterEstimator *ParameterEstimator_copy(ParameterEstimator *src, EmissionDist *emissionDistDest);
@@ -234,6 +250,12 @@ bool NegativeBinomial_isFeasible(NegativeBinomial *nb);
 
 NegativeBinomial *NegativeBinomial_copy(NegativeBinomial *src, EmissionDist *emissionDistDest);
 
+/*
+ * Copy the parameter values of src into dest (with the same number of components) without allocating
+ * memory and refill the digamma table of dest. Estimators are not copied.
+ */
+void NegativeBinomial_copyParameterValues(NegativeBinomial *dest, NegativeBinomial *src);
+
 /*
  * Construct a Negative Binomial structure using an array of means and a factor to scale mean for getting variances
  */
@@ -335,6 +357,8 @@ bool Gaussian_isFeasible(Gaussian *gaussian);
 
 Gaussian *Gaussian_copy(Gaussian *src, EmissionDist *emissionDistDest);
 
+void Gaussian_copyParameterValues(Gaussian *dest, Gaussian *src);
+
 /*
  * Get the probability of observing x given the previous observation preX and alpha the factor for adjusting
  * mean of Gaussian with the previous observation
@@ -401,6 +425,8 @@ bool TruncExponential_isFeasible(TruncExponential *truncExponential);
  */
 TruncExponential *TruncExponential_copy(TruncExponential *src, EmissionDist *emissionDistDest);
 
+void TruncExponential_copyParameterValues(TruncExponential *dest, TruncExponential *src);
+
 /*
  * Get the probability of observing x
  */
@@ -471,6 +497,8 @@ bool EmissionDist_isFeasible(EmissionDist *emissionDist);
 
 EmissionDist *EmissionDist_copy(EmissionDist *src);
 
+void EmissionDist_copyParameterValues(EmissionDist *dest, EmissionDist *src);
+
 void EmissionDist_initParameterEstimators(EmissionDist *emissionDist);
 
 int EmissionDist_getNumberOfComps(EmissionDist *emissionDist);
@@ -515,6 +543,12 @@ const char *EmissionDist_getDistributionName(EmissionDist *emissionDist);
 
 void EmissionDist_resetParameterEstimators(EmissionDist *emissionDist);
 
+void EmissionDist_scaleParameterEstimators(EmissionDist *emissionDist, double factor);
+
+void EmissionDist_writeParameterEstimatorsIntoBinaryFile(EmissionDist *emissionDist, FILE *fp);
+
+bool EmissionDist_readParameterEstimatorsFromBinaryFile(EmissionDist *emissionDist, FILE *fp);
+
 /*
  * Destruct a EmissionDist structure
  */
@@ -570,6 +604,12 @@ EmissionDistSeries *EmissionDistSeries_copy(EmissionDistSeries *src);
 
 EmissionDistSeries **EmissionDistSeries_copy1DArray(EmissionDistSeries **srcArray, int length);
 
+/*
+ * Copy the parameter values of src into dest (both should have the same structure) without allocating memory.
+ * Estimators and count data of dest are not touched.
+ */
+void EmissionDistSeries_copyParameterValues(EmissionDistSeries *dest, EmissionDistSeries *src);
+
 void EmissionDistSeries_destruct1DArray(EmissionDistSeries **array, int length);
 
 /*
@@ -579,6 +619,12 @@ EmissionDist *EmissionDistSeries_getEmissionDist(EmissionDistSeries *emissionDis
 
 void EmissionDistSeries_resetParameterEstimators(EmissionDistSeries *emissionDistSeries);
 
+void EmissionDistSeries_scaleParameterEstimators(EmissionDistSeries *emissionDistSeries, double factor);
+
+void EmissionDistSeries_writeParameterEstimatorsIntoBinaryFile(EmissionDistSeries *emissionDistSeries, FILE *fp);
+
+bool EmissionDistSeries_readParameterEstimatorsFromBinaryFile(EmissionDistSeries *emissionDistSeries, FILE *fp);
+
 /*
  * Destruct an EmissionDistSeries structure
  */
@@ -791,6 +837,11 @@ void TransitionCountData_increment(TransitionCountData *transitionCountData, dou
  */
 void TransitionCountData_resetCountMatrix(TransitionCountData *transitionCountData);
 
+/*
+ * Multiply all elements in countMatrix by the given factor
+ */
+void TransitionCountData_scaleCountMatrix(TransitionCountData *transitionCountData, double factor);
+
 /*
  * Destruct a TransitionCountData structure
  */
@@ -807,6 +858,9 @@ TransitionCountData *TransitionCountData_destruct(TransitionCountData *transitio
  * @field numberOfValidityFunctions     Number of validity functions
  * @field requirements                  A TransitionRequirements structure which is necessary for calling
  *                                      validity functions
+ * @field conditionalMatrices           The transition probabilities conditioned on each validity mask (see
+ *                                      Transition_getValidityMask); it has one numberOfStates x numberOfStates
+ *                                      matrix per mask that is saved row by row
  */
 typedef struct Transition {
     MatrixDouble *matrix;
@@ -816,6 +870,7 @@ typedef struct Transition {
     int numberOfValidityFunctions;
     TransitionRequirements *requirements;
     double terminationProb;
+    double *conditionalMatrices;
 } Transition;
 
 /*
@@ -827,6 +882,11 @@ Transition *Transition_copy(Transition *src);
 
 Transition **Transition_copy1DArray(Transition **srcArray, int length);
 
+/*
+ * Copy the transition probabilities of src into dest without allocating memory. Count data are not copied.
+ */
+void Transition_copyParameterValues(Transition *dest, Transition *src);
+
 void Transition_destruct1DArray(Transition **array, int length);
 
 /*
@@ -853,6 +913,8 @@ bool Transition_isFeasible(Transition *transition);
 
 void Transition_resetCountData(Transition *transition);
 
+void Transition_scaleCountData(Transition *transition, double factor);
+
 /*
  * Destruct a Transition structure with uniform probabilities
  */
@@ -870,6 +932,27 @@ double Transition_getProb(Transition *transition, StateType preState, StateType
 double
 Transition_getProbConditional(Transition *transition, StateType preState, StateType state, CoverageInfo *coverageInfo);
 
+/*
+ * Get a bitmask whose s-th bit is set if it is valid to be in state s given a CoverageInfo based on the
+ * previously added validity functions. The end state (s = numberOfStates) is included.
+ * The mask of each window can be computed once and passed to Transition_getConditionalMatrix
+ */
+uint8_t Transition_getValidityMask(Transition *transition, CoverageInfo *coverageInfo);
+
+/*
+ * Recompute the conditional transition probabilities for all validity masks from the current transition matrix.
+ * Functions in this module that change the transition matrix call it; it has to be called after changing
+ * the matrix in any other way
+ */
+void Transition_updateConditionalMatrices(Transition *transition);
+
+/*
+ * Get the matrix of conditional transition probabilities for a validity mask; the probability of transitioning
+ * from preState to state is at [preState * numberOfStates + state]. It is the same as calling
+ * Transition_getProbConditional for a CoverageInfo with the given mask
+ */
+double *Transition_getConditionalMatrix(Transition *transition, uint8_t validityMask);
+
 /*
  * Get the probability of ending with state
  */
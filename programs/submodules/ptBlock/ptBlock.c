@@ -3,8 +3,9 @@
 #include "stdio.h"
 #include "track_reader.h"
 #include <zlib.h>
-
-#define MAX_NUMBER_OF_ANNOTATIONS 58
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 ptBlock *ptBlock_construct(int rfs, int rfe, int sqs, int sqe, int rds_f, int rde_f) {
     ptBlock *block = malloc(sizeof(ptBlock));
@@ -222,31 +223,176 @@ void CoverageInfo_destruct(CoverageInfo *coverageInfo) {
     destruct_cov_info_data((void *) coverageInfo);
 }
 
+// an interned annotation set that does not fit inline in the annotation flag
+typedef struct AnnotationSetEntry {
+    int64_t id;
+    int number_of_words;
+    uint64_t words[];
+} AnnotationSetEntry;
+
+// entries are kept in fixed-size blocks that never move so they can be read without locking
+#define ANNOTATION_SET_BLOCK_BITS 16
+#define ANNOTATION_SET_BLOCK_SIZE (1 << ANNOTATION_SET_BLOCK_BITS)
+static AnnotationSetEntry **annotation_set_blocks[1 << 16];
+static int64_t number_of_annotation_sets = 0;
+static stHash *annotation_set_table = NULL;
+static pthread_mutex_t annotation_set_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t AnnotationSetEntry_hashKey(const void *key) {
+    const AnnotationSetEntry *entry = key;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < entry->number_of_words; i++) {
+        hash ^= entry->words[i];
+        hash *= 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+int AnnotationSetEntry_equalKey(const void *key1, const void *key2) {
+    const AnnotationSetEntry *entry1 = key1;
+    const AnnotationSetEntry *entry2 = key2;
+    return entry1->number_of_words == entry2->number_of_words &&
+           memcmp(entry1->words, entry2->words, entry1->number_of_words * sizeof(uint64_t)) == 0;
+}
+
+bool AnnotationFlag_isSpilled(uint64_t annotation_flag) {
+    return (annotation_flag & ANNOTATION_FLAG_SPILL_BIT) != 0ULL;
+}
+
+uint64_t AnnotationFlag_constructFromWords(const uint64_t *words, int number_of_words) {
+    // trailing zero words are removed so each set has a unique representation
+    while (0 < number_of_words && words[number_of_words - 1] == 0ULL) number_of_words--;
+    if (number_of_words == 0) return 0ULL;
+    if (number_of_words == 1 && (words[0] & ~ANNOTATION_FLAG_INLINE_MASK) == 0ULL) return words[0];
+
+    AnnotationSetEntry *query = malloc(sizeof(AnnotationSetEntry) + number_of_words * sizeof(uint64_t));
+    query->number_of_words = number_of_words;
+    memcpy(query->words, words, number_of_words * sizeof(uint64_t));
+    pthread_mutex_lock(&annotation_set_mutex);
+    if (annotation_set_table == NULL) {
+        annotation_set_table = stHash_construct3(AnnotationSetEntry_hashKey, AnnotationSetEntry_equalKey, NULL, NULL);
+    }
+    AnnotationSetEntry *entry = stHash_search(annotation_set_table, query);
+    if (entry == NULL) {
+        entry = query;
+        entry->id = number_of_annotation_sets;
+        int64_t block_index = entry->id >> ANNOTATION_SET_BLOCK_BITS;
+        if (annotation_set_blocks[block_index] == NULL) {
+            annotation_set_blocks[block_index] = malloc(ANNOTATION_SET_BLOCK_SIZE * sizeof(AnnotationSetEntry *));
+        }
+        annotation_set_blocks[block_index][entry->id & (ANNOTATION_SET_BLOCK_SIZE - 1)] = entry;
+        stHash_insert(annotation_set_table, entry, entry);
+        number_of_annotation_sets++;
+    } else {
+        free(query);
+    }
+    pthread_mutex_unlock(&annotation_set_mutex);
+    return ANNOTATION_FLAG_SPILL_BIT | (uint64_t) entry->id;
+}
+
+const uint64_t *AnnotationFlag_getWords(uint64_t annotation_flag, uint64_t *buffer, int *number_of_words) {
+    if (!AnnotationFlag_isSpilled(annotation_flag)) {
+        buffer[0] = annotation_flag & ANNOTATION_FLAG_INLINE_MASK;
+        *number_of_words = 1;
+        return buffer;
+    }
+    int64_t id = annotation_flag & ANNOTATION_FLAG_INLINE_MASK;
+    AnnotationSetEntry *entry = annotation_set_blocks[id >> ANNOTATION_SET_BLOCK_BITS][id &
+                                                                                     (ANNOTATION_SET_BLOCK_SIZE - 1)];
+    *number_of_words = entry->number_of_words;
+    return entry->words;
+}
+
+uint64_t AnnotationFlag_or(uint64_t annotation_flag_1, uint64_t annotation_flag_2) {
+    if (!AnnotationFlag_isSpilled(annotation_flag_1 | annotation_flag_2)) {
+        return annotation_flag_1 | annotation_flag_2;
+    }
+    uint64_t region_bits = (annotation_flag_1 | annotation_flag_2) & ANNOTATION_FLAG_REGION_MASK;
+    uint64_t annotation_flag_no_region_1 = annotation_flag_1 & ~ANNOTATION_FLAG_REGION_MASK;
+    uint64_t annotation_flag_no_region_2 = annotation_flag_2 & ~ANNOTATION_FLAG_REGION_MASK;
+    // interned sets have unique flags
+    if (annotation_flag_no_region_1 == annotation_flag_no_region_2 || annotation_flag_no_region_2 == 0ULL) {
+        return region_bits | annotation_flag_no_region_1;
+    }
+    if (annotation_flag_no_region_1 == 0ULL) {
+        return region_bits | annotation_flag_no_region_2;
+    }
+    uint64_t buffer_1;
+    uint64_t buffer_2;
+    int number_of_words_1;
+    int number_of_words_2;
+    const uint64_t *words_1 = AnnotationFlag_getWords(annotation_flag_1, &buffer_1, &number_of_words_1);
+    const uint64_t *words_2 = AnnotationFlag_getWords(annotation_flag_2, &buffer_2, &number_of_words_2);
+    int number_of_words = max(number_of_words_1, number_of_words_2);
+    uint64_t *words = calloc(number_of_words, sizeof(uint64_t));
+    for (int i = 0; i < number_of_words_1; i++) words[i] |= words_1[i];
+    for (int i = 0; i < number_of_words_2; i++) words[i] |= words_2[i];
+    uint64_t annotation_flag = AnnotationFlag_constructFromWords(words, number_of_words);
+    free(words);
+    return region_bits | annotation_flag;
+}
+
+int64_t AnnotationFlag_getNumberOfInternedSets() {
+    pthread_mutex_lock(&annotation_set_mutex);
+    int64_t number = number_of_annotation_sets;
+    pthread_mutex_unlock(&annotation_set_mutex);
+    return number;
+}
+
 uint64_t CoverageInfo_getAnnotationFlag(int annotationIndex) {
-    uint64_t flag = 0 < annotationIndex ? 1ULL << (annotationIndex - 1) : 0ULL;
-    return flag;
+    if (annotationIndex <= 0) return 0ULL;
+    if (annotationIndex <= MAX_NUMBER_OF_INLINE_ANNOTATIONS) return 1ULL << (annotationIndex - 1);
+    return CoverageInfo_getAnnotationFlagFromArray(&annotationIndex, 1);
 }
 
 uint64_t CoverageInfo_getAnnotationFlagFromArray(int *annotationIndices, int len) {
     uint64_t annotationFlag = 0ULL;
+    int maxAnnotationIndex = 0;
     for (int i = 0; i < len; i++) {
-        annotationFlag |= CoverageInfo_getAnnotationFlag(annotationIndices[i]);
+        if (annotationIndices[i] <= 0) continue;
+        if (annotationIndices[i] <= MAX_NUMBER_OF_INLINE_ANNOTATIONS) {
+            annotationFlag |= 1ULL << (annotationIndices[i] - 1);
+        }
+        maxAnnotationIndex = max(maxAnnotationIndex, annotationIndices[i]);
     }
+    if (maxAnnotationIndex <= MAX_NUMBER_OF_INLINE_ANNOTATIONS) return annotationFlag;
+    // the set does not fit inline
+    int numberOfWords = (maxAnnotationIndex - 1) / 64 + 1;
+    uint64_t *words = calloc(numberOfWords, sizeof(uint64_t));
+    for (int i = 0; i < len; i++) {
+        if (annotationIndices[i] <= 0) continue;
+        words[(annotationIndices[i] - 1) / 64] |= 1ULL << ((annotationIndices[i] - 1) % 64);
+    }
+    annotationFlag = AnnotationFlag_constructFromWords(words, numberOfWords);
+    free(words);
     return annotationFlag;
 }
 
 
 int CoverageInfo_getFirstAnnotationIndex(CoverageInfo *coverageInfo) {
-    uint64_t annotationBits = CoverageInfo_getAnnotationBits(coverageInfo);
-    int annotationIndex = annotationBits == 0ULL ? 0 : getFirstIndexWithNonZeroBitFromRight(annotationBits) + 1;
-    return annotationIndex;
+    uint64_t buffer;
+    int numberOfWords = 0;
+    const uint64_t *words = AnnotationFlag_getWords(coverageInfo->annotation_flag, &buffer, &numberOfWords);
+    for (int w = 0; w < numberOfWords; w++) {
+        if (words[w] != 0ULL) return 64 * w + getFirstIndexWithNonZeroBitFromRight(words[w]) + 1;
+    }
+    return 0;
 }
 
 bool CoverageInfo_overlapAnnotationIndex(CoverageInfo *coverageInfo, int annotationIndex) {
-    if (coverageInfo == NULL || annotationIndex == -1) return false;
-    if (CoverageInfo_getAnnotationBits(coverageInfo) == 0ULL && annotationIndex == 0) return 1;
-    uint64_t annotationFlag = CoverageInfo_getAnnotationFlag(annotationIndex);
-    return (annotationFlag & coverageInfo->annotation_flag) ? 1 : 0;
+    if (coverageInfo == NULL || annotationIndex < 0) return false;
+    uint64_t annotationFlag = coverageInfo->annotation_flag & ~ANNOTATION_FLAG_REGION_MASK;
+    if (annotationIndex == 0) return annotationFlag == 0ULL;
+    if (!AnnotationFlag_isSpilled(annotationFlag)) {
+        return annotationIndex <= MAX_NUMBER_OF_INLINE_ANNOTATIONS &&
+               (annotationFlag & (1ULL << (annotationIndex - 1))) != 0ULL;
+    }
+    uint64_t buffer;
+    int numberOfWords = 0;
+    const uint64_t *words = AnnotationFlag_getWords(annotationFlag, &buffer, &numberOfWords);
+    int w = (annotationIndex - 1) / 64;
+    return w < numberOfWords && (words[w] & (1ULL << ((annotationIndex - 1) % 64))) != 0ULL;
 }
 
 bool CoverageInfo_overlapRegionIndex(CoverageInfo *coverageInfo, int regionIndex) {
@@ -280,9 +426,9 @@ void CoverageInfo_setRegionIndexByMapping(CoverageInfo *coverageInfo, int *annot
 
 
 uint64_t CoverageInfo_getAnnotationBits(CoverageInfo *coverageInfo) {
-    uint64_t regionDigitsMask = 0xFC00000000000000ULL; // only 6 high bits are 1
+    assert(!AnnotationFlag_isSpilled(coverageInfo->annotation_flag));
     // Note the negation symbol
-    uint64_t annotationBits = (coverageInfo->annotation_flag & ~regionDigitsMask);
+    uint64_t annotationBits = (coverageInfo->annotation_flag & ~ANNOTATION_FLAG_REGION_MASK);
     return annotationBits;
 }
 
@@ -292,8 +438,7 @@ uint64_t CoverageInfo_getAnnotationBits(CoverageInfo *coverageInfo) {
 // for hmm_flagger we barely expect to have more than 2^6 = 64
 // regions with different converage biases.
 int CoverageInfo_getRegionIndex(CoverageInfo *coverageInfo) {
-    uint64_t regionDigitsMask = 0xFC00000000000000ULL; // only 6 high bits are 1
-    int regionIndex = (coverageInfo->annotation_flag & regionDigitsMask) >> (64 - 6);
+    int regionIndex = (coverageInfo->annotation_flag & ANNOTATION_FLAG_REGION_MASK) >> (64 - 6);
     return regionIndex;
 }
 
@@ -305,13 +450,26 @@ void CoverageInfo_setRegionIndex(CoverageInfo *coverageInfo, int regionIndex) {
 
 
 int *CoverageInfo_getAnnotationIndices(CoverageInfo *coverageInfo, int *length) {
-    int *indices = NULL;
+    uint64_t buffer;
+    int numberOfWords = 0;
+    const uint64_t *words = AnnotationFlag_getWords(coverageInfo->annotation_flag, &buffer, &numberOfWords);
     int actualSize = 0;
-    for (int annotationIndex = 0; annotationIndex < MAX_NUMBER_OF_ANNOTATIONS; annotationIndex++) {
-        if (CoverageInfo_overlapAnnotationIndex(coverageInfo, annotationIndex)) {
-            indices = (int *) realloc(indices, (actualSize + 1) * sizeof(int));
-            indices[actualSize] = annotationIndex;
-            actualSize++;
+    for (int w = 0; w < numberOfWords; w++) {
+        actualSize += __builtin_popcountll(words[w]);
+    }
+    // index 0 is for the blocks with no annotation
+    int *indices = (int *) malloc(max(actualSize, 1) * sizeof(int));
+    if (actualSize == 0) {
+        indices[0] = 0;
+        *length = 1;
+        return indices;
+    }
+    actualSize = 0;
+    for (int w = 0; w < numberOfWords; w++) {
+        uint64_t bits = words[w];
+        while (bits != 0ULL) {
+            indices[actualSize++] = 64 * w + getFirstIndexWithNonZeroBitFromRight(bits) + 1;
+            bits &= bits - 1;
         }
     }
     *length = actualSize;
@@ -384,7 +542,7 @@ CoverageInfo *CoverageInfo_construct_from_alignment(ptAlignment *alignment, int
 void extend_cov_info_data(void *dest_, void *src_) {
     CoverageInfo *dest = dest_;
     CoverageInfo *src = src_;
-    dest->annotation_flag |= src->annotation_flag;
+    dest->annotation_flag = AnnotationFlag_or(dest->annotation_flag, src->annotation_flag);
     dest->coverage += src->coverage;
     dest->coverage_high_mapq += src->coverage_high_mapq;
     dest->coverage_high_clip += src->coverage_high_clip;
@@ -759,6 +917,25 @@ ptBlock *ptBlockItrPerContig_next(ptBlockItrPerContig *block_iter, char *ctg_nam
     return block;
 }
 
+void ptBlockItrPerContig_seek(ptBlockItrPerContig *block_iter, int ctg_index, int block_index) {
+    block_iter->ctg_index = ctg_index;
+    block_iter->block_index = block_index;
+}
+
+int ptBlockItrPerContig_get_ctg_index(ptBlockItrPerContig *block_iter) {
+    return block_iter->ctg_index;
+}
+
+int *ptBlockItrPerContig_get_number_of_blocks_per_contig(ptBlockItrPerContig *block_iter, int *number_of_ctgs) {
+    *number_of_ctgs = stList_length(block_iter->ctg_list);
+    int *num_blocks = malloc(*number_of_ctgs * sizeof(int));
+    for (int i = 0; i < *number_of_ctgs; i++) {
+        stList *blocks = stHash_search(block_iter->blocks_per_contig, stList_get(block_iter->ctg_list, i));
+        num_blocks[i] = stList_length(blocks);
+    }
+    return num_blocks;
+}
+
 void ptBlockItrPerContig_destruct(ptBlockItrPerContig *blockItr) {
     blockItr->blocks_per_contig = NULL;
     stList_destruct(blockItr->ctg_list);
@@ -823,104 +1000,276 @@ stList *ptBlock_split_into_batches(stHash *blocks_per_contig, int split_number)
 }
 
 
-stHash *ptBlock_parse_bed(char *bed_path) {
-    FILE *fp = fopen(bed_path, "r");
-    size_t read;
-    size_t len;
-    char *line = NULL;
-    char *contig_name;
-    int start;
-    int end;
-    char *token;
-    ptBlock *block = NULL;
-    stList *blocks = NULL;
-    stHash *blocks_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, NULL,
-                                                  (void (*)(void *)) stList_destruct);
-    while ((read = getline(&line, &len, fp)) != -1) {
-        // replace '\n' by '\0'
-        if (line[strlen(line) - 1] == '\n') {
-            line[strlen(line) - 1] = '\0';
+// read a bed file into memory; plain files are mapped and gzipped (or bgzipped) files are decompressed
+char *ptBlock_load_bed_file(char *bed_path, size_t *size, bool *is_mapped) {
+    *size = 0;
+    *is_mapped = false;
+    int bed_path_len = strlen(bed_path);
+    bool is_compressed = 3 <= bed_path_len && strcmp(bed_path + bed_path_len - 3, ".gz") == 0;
+    if (!is_compressed) {
+        int fd = open(bed_path, O_RDONLY);
+        struct stat file_stat;
+        if (fd < 0 || fstat(fd, &file_stat) != 0) {
+            fprintf(stderr, "[%s] Error: Couldn't open the bed file %s\n", get_timestamp(), bed_path);
+            exit(EXIT_FAILURE);
         }
-        token = strtok(line, "\t");
-        contig_name = copyString(token);
-        token = strtok(NULL, "\t");
-        start = atoi(token); // 0-based
-        token = strtok(NULL, "\t");
-        end = atoi(token) - 1; // 0-based
-        block = ptBlock_construct(start, end, -1, -1, -1, -1);
-        blocks = stHash_search(blocks_per_contig, contig_name);
-        // if contig does not exist as a key in the table
-        // add contig along with an empty list as its value
-        if (blocks == NULL) {
-            blocks = stList_construct3(0, ptBlock_destruct);
-            stHash_insert(blocks_per_contig, contig_name, blocks);
+        *size = file_stat.st_size;
+        char *data = NULL;
+        if (0 < *size) {
+            data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                fprintf(stderr, "[%s] Error: Couldn't map the bed file %s\n", get_timestamp(), bed_path);
+                exit(EXIT_FAILURE);
+            }
+            // lines are read once from start to end
+            madvise(data, *size, MADV_SEQUENTIAL);
+            *is_mapped = true;
         }
-        stList_append(blocks, block);
+        close(fd);
+        return data;
     }
-    // sort blocks per contig
-    stHashIterator *it = stHash_getIterator(blocks_per_contig);
-    while ((contig_name = stHash_getNext(it)) != NULL) {
-        blocks = stHash_search(blocks_per_contig, contig_name);
-        stList_sort(blocks, ptBlock_cmp_rfs);
+    gzFile gz_fp = gzopen(bed_path, "r");
+    if (gz_fp == NULL) {
+        fprintf(stderr, "[%s] Error: Couldn't open the bed file %s\n", get_timestamp(), bed_path);
+        exit(EXIT_FAILURE);
     }
-    stHash_destructIterator(it);
-    return blocks_per_contig;
+    size_t capacity = 1 << 20;
+    char *data = malloc(capacity);
+    int bytes_read;
+    while ((bytes_read = gzread(gz_fp, data + *size, capacity - *size)) > 0) {
+        *size += bytes_read;
+        if (*size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    if (bytes_read < 0) {
+        fprintf(stderr, "[%s] Error: Couldn't decompress the bed file %s\n", get_timestamp(), bed_path);
+        exit(EXIT_FAILURE);
+    }
+    gzclose(gz_fp);
+    return data;
 }
 
+// parse an integer and move the pointer to the first character after it
+int ptBlock_parse_bed_int(const char **ptr, const char *end) {
+    const char *p = *ptr;
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+    int value = 0;
+    while (p < end && '0' <= *p && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    *ptr = p;
+    return negative ? -value : value;
+}
 
-stHash *ptBlock_parse_bed_with_filtering_contigs(char *bed_path, stSet *contigs_to_include) {
-    FILE *fp = fopen(bed_path, "r");
-    size_t read;
-    size_t len;
-    char *line = NULL;
-    char *contig_name;
-    int start;
-    int end;
-    char *token;
-    ptBlock *block = NULL;
+// true if the line is a UCSC "track" or "browser" line (the keyword is followed by a space or the line end)
+bool ptBlock_is_bed_track_line(const char *line, const char *line_end) {
+    const char *keywords[2] = {"track", "browser"};
+    for (int i = 0; i < 2; i++) {
+        size_t len = strlen(keywords[i]);
+        if (line_end - line < len || memcmp(line, keywords[i], len) != 0) continue;
+        if (line + len == line_end || line[len] == ' ' || line[len] == '\r') return true;
+    }
+    return false;
+}
+
+typedef struct BedParsingArgs {
+    char *bed_path;
+    const char *start; // the first character of the first line in this batch
+    const char *end; // one character after the last line in this batch
+    stSet *contigs_to_include;
+    BedLabelType label_type;
+    stHash *blocks_per_contig; // output table of this batch
+} BedParsingArgs;
+
+void ptBlock_parse_bed_batch(void *argWork_) {
+    work_arg_t *argWork = argWork_;
+    BedParsingArgs *args = argWork->data;
+    const char *end = args->end;
+    // the list of the previous line is reused until the contig changes
+    int contig_name_capacity = 256;
+    char *contig_name = malloc(contig_name_capacity);
+    contig_name[0] = '\0';
+    int contig_name_len = -1;
     stList *blocks = NULL;
-    stHash *blocks_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, NULL,
-                                                  (void (*)(void *)) stList_destruct);
-    while ((read = getline(&line, &len, fp)) != -1) {
-        // replace '\n' by '\0'
-        if (line[strlen(line) - 1] == '\n') {
-            line[strlen(line) - 1] = '\0';
+    const char *p = args->start;
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (line_end == NULL) line_end = end;
+        // skip empty, header, track and browser lines
+        if (line_end == p || *p == '#' || (*p == '\r' && line_end == p + 1) ||
+            ptBlock_is_bed_track_line(p, line_end)) {
+            p = line_end + 1;
+            continue;
         }
-        token = strtok(line, "\t");
-        contig_name = copyString(token);
-        if (contigs_to_include != NULL) {
-            void *search_out = stSet_search(contigs_to_include, (void *) contig_name);
-            if (search_out == NULL) {
-                free(contig_name);
-                continue;
+        const char *tab = memchr(p, '\t', line_end - p);
+        if (tab == NULL) {
+            fprintf(stderr, "[%s] Error: Line \"%.*s\" in %s does not have three tab-delimited columns.\n",
+                    get_timestamp(), (int) (line_end - p), p, args->bed_path);
+            exit(EXIT_FAILURE);
+        }
+        if (tab - p != contig_name_len || memcmp(p, contig_name, contig_name_len) != 0) {
+            contig_name_len = tab - p;
+            if (contig_name_capacity <= contig_name_len) {
+                contig_name_capacity = 2 * contig_name_len + 1;
+                contig_name = realloc(contig_name, contig_name_capacity);
+            }
+            memcpy(contig_name, p, contig_name_len);
+            contig_name[contig_name_len] = '\0';
+            blocks = NULL;
+            if (args->contigs_to_include == NULL || stSet_search(args->contigs_to_include, contig_name) != NULL) {
+                blocks = stHash_search(args->blocks_per_contig, contig_name);
+                if (blocks == NULL) {
+                    blocks = stList_construct3(0, NULL);
+                    stHash_insert(args->blocks_per_contig, copyString(contig_name), blocks);
+                }
             }
         }
-        token = strtok(NULL, "\t");
-        start = atoi(token); // 0-based
-        token = strtok(NULL, "\t");
-        end = atoi(token) - 1; // 0-based
-        block = ptBlock_construct(start, end, -1, -1, -1, -1);
-        blocks = stHash_search(blocks_per_contig, contig_name);
-        // if contig does not exist as a key in the table
-        // add contig along with an empty list as its value
-        if (blocks == NULL) {
-            blocks = stList_construct3(0, ptBlock_destruct);
-            stHash_insert(blocks_per_contig, contig_name, blocks);
-        } else {
-            free(contig_name);
+        if (blocks == NULL) { // this contig is filtered
+            p = line_end + 1;
+            continue;
+        }
+        const char *q = tab + 1;
+        int start = ptBlock_parse_bed_int(&q, line_end); // 0-based
+        if (q == line_end || *q != '\t') {
+            fprintf(stderr, "[%s] Error: Line \"%.*s\" in %s does not have three tab-delimited columns.\n",
+                    get_timestamp(), (int) (line_end - p), p, args->bed_path);
+            exit(EXIT_FAILURE);
+        }
+        q++;
+        int end_pos = ptBlock_parse_bed_int(&q, line_end) - 1; // 0-based
+        ptBlock *block = ptBlock_construct(start, end_pos, -1, -1, -1, -1);
+        if (args->label_type != BED_LABEL_NONE) {
+            // 4th column (if exists) is the truth/prediction label
+            int8_t label = -1;
+            if (q < line_end && *q == '\t') {
+                q++;
+                label = ptBlock_parse_bed_int(&q, line_end);
+            }
+            CoverageInfo *cov_info_data = CoverageInfo_construct(0ULL, 0, 0, 0);
+            if (args->label_type == BED_LABEL_TRUTH) {
+                CoverageInfo_addInferenceData(cov_info_data, label, -1);
+            } else {
+                CoverageInfo_addInferenceData(cov_info_data, -1, label);
+            }
+            ptBlock_set_data(block, cov_info_data,
+                             destruct_cov_info_data,
+                             copy_cov_info_data,
+                             extend_cov_info_data);
         }
         stList_append(blocks, block);
+        p = line_end + 1;
+    }
+    free(contig_name);
+    free(argWork);
+}
+
+void ptBlock_sort_blocks_of_one_contig(void *argWork_) {
+    work_arg_t *argWork = argWork_;
+    stList_sort(argWork->data, ptBlock_cmp_rfs);
+    free(argWork);
+}
+
+stHash *ptBlock_parse_bed_multi_threaded(char *bed_path, stSet *contigs_to_include, BedLabelType label_type,
+                                         int threads) {
+    size_t size = 0;
+    bool is_mapped = false;
+    char *data = ptBlock_load_bed_file(bed_path, &size, &is_mapped);
+    threads = max(1, threads);
+    // small files are parsed with one thread
+    int number_of_batches = (int) min(threads, size / (1 << 20) + 1);
+
+    // the calling thread parses the last batch so the pool has one thread less; with one batch
+    // everything is parsed inline (tpool_wait and tpool_destroy do nothing with NULL)
+    tpool_t *tm = number_of_batches == 1 ? NULL : tpool_create(number_of_batches - 1);
+    BedParsingArgs *args_per_batch = malloc(number_of_batches * sizeof(BedParsingArgs));
+    const char *batch_start = data;
+    for (int i = 0; i < number_of_batches; i++) {
+        // each batch ends at a line boundary
+        const char *batch_end = data + size * (i + 1) / number_of_batches;
+        if (i < number_of_batches - 1) {
+            const char *new_line = memchr(batch_end, '\n', data + size - batch_end);
+            batch_end = new_line == NULL ? data + size : new_line + 1;
+        }
+        if (batch_end < batch_start) batch_end = batch_start;
+        BedParsingArgs *args = args_per_batch + i;
+        args->bed_path = bed_path;
+        args->start = batch_start;
+        args->end = batch_end;
+        args->contigs_to_include = contigs_to_include;
+        args->label_type = label_type;
+        args->blocks_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                    (void (*)(void *)) stList_destruct);
+        work_arg_t *argWork = malloc(sizeof(work_arg_t));
+        argWork->data = (void *) args;
+        // submit a job
+        if (tm == NULL || i == number_of_batches - 1) {
+            ptBlock_parse_bed_batch(argWork);
+        } else {
+            tpool_add_work(tm, ptBlock_parse_bed_batch, argWork);
+        }
+        batch_start = batch_end;
+    }
+    //wait for all threads
+    tpool_wait(tm);
+
+    // concatenate the batches in the order of the file
+    stHash *blocks_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, NULL,
+                                                  (void (*)(void *)) stList_destruct);
+    for (int i = 0; i < number_of_batches; i++) {
+        stHashIterator *it = stHash_getIterator(args_per_batch[i].blocks_per_contig);
+        char *contig_name;
+        while ((contig_name = stHash_getNext(it)) != NULL) {
+            stList *batch_blocks = stHash_search(args_per_batch[i].blocks_per_contig, contig_name);
+            stList *blocks = stHash_search(blocks_per_contig, contig_name);
+            if (blocks == NULL) {
+                blocks = stList_construct3(0, ptBlock_destruct);
+                stHash_insert(blocks_per_contig, copyString(contig_name), blocks);
+            }
+            for (int j = 0; j < stList_length(batch_blocks); j++) {
+                stList_append(blocks, stList_get(batch_blocks, j));
+            }
+        }
+        stHash_destructIterator(it);
+        stHash_destruct(args_per_batch[i].blocks_per_contig);
     }
+    free(args_per_batch);
+    if (is_mapped) {
+        munmap(data, size);
+    } else {
+        free(data);
+    }
+
     // sort blocks per contig
     stHashIterator *it = stHash_getIterator(blocks_per_contig);
+    char *contig_name;
     while ((contig_name = stHash_getNext(it)) != NULL) {
-        blocks = stHash_search(blocks_per_contig, contig_name);
-        stList_sort(blocks, ptBlock_cmp_rfs);
+        work_arg_t *argWork = malloc(sizeof(work_arg_t));
+        argWork->data = stHash_search(blocks_per_contig, contig_name);
+        if (tm == NULL) {
+            ptBlock_sort_blocks_of_one_contig(argWork);
+        } else {
+            tpool_add_work(tm, ptBlock_sort_blocks_of_one_contig, argWork);
+        }
     }
     stHash_destructIterator(it);
+    tpool_wait(tm);
+    tpool_destroy(tm);
     return blocks_per_contig;
 }
 
+stHash *ptBlock_parse_bed(char *bed_path) {
+    return ptBlock_parse_bed_multi_threaded(bed_path, NULL, BED_LABEL_NONE, 1);
+}
+
+
+stHash *ptBlock_parse_bed_with_filtering_contigs(char *bed_path, stSet *contigs_to_include) {
+    return ptBlock_parse_bed_multi_threaded(bed_path, contigs_to_include, BED_LABEL_NONE, 1);
+}
+
 void ptBlock_write_blocks_stHash_in_bed(stHash *blocks_per_contig,
                                         char *(*get_string_function)(void *),
                                         void *file_ptr,
@@ -1949,10 +2298,26 @@ stList *parse_annotation_paths_and_save_in_stList(const char *json_path, const c
     return annotation_paths;
 }
 
+typedef struct AnnotationParsingArgs {
+    char *bed_path;
+    stSet *contigs_to_include;
+    int threads;
+    stHash *annotation_block_table; // output
+} AnnotationParsingArgs;
+
+void parse_one_annotation(void *argWork_) {
+    work_arg_t *argWork = argWork_;
+    AnnotationParsingArgs *args = argWork->data;
+    args->annotation_block_table = ptBlock_parse_bed_multi_threaded(args->bed_path, args->contigs_to_include,
+                                                                    BED_LABEL_NONE, args->threads);
+    free(argWork);
+}
+
 // annotation_zero_block_table can be NULL
 stList *parse_all_annotations_and_save_in_stList(const char *json_path,
                                                  stHash *annotation_zero_block_table,
-                                                 stSet *contigs_to_include) {
+                                                 stSet *contigs_to_include,
+                                                 int threads) {
     stList *block_table_list = stList_construct3(0, stHash_destruct);
     // first add block table for annotation 0 (no_annotation)
     if (annotation_zero_block_table != NULL) {
@@ -1972,27 +2337,47 @@ stList *parse_all_annotations_and_save_in_stList(const char *json_path,
             return NULL;
         }
 
-        int annotation_count = cJSON_GetArraySize(annotation_json);
         // iterate over key-values in json
         // each key is an index
         // each value is a path to a bed file
+        stList *elements = stList_construct();
         cJSON *element = NULL;
         cJSON_ArrayForEach(element, annotation_json) {
             if (cJSON_IsString(element)) {
-                char *bed_path = cJSON_GetStringValue(element);
-                stHash *annotation_block_table = ptBlock_parse_bed_with_filtering_contigs(bed_path, contigs_to_include);
-                fprintf(stderr, "[%s] Parsed  annotation %s:%s\n", get_timestamp(), element->string,
-                        cJSON_GetStringValue(element));
-                stList_append(block_table_list, annotation_block_table);
+                stList_append(elements, element);
             }
         }
+        // bed files are parsed concurrently and the threads are shared between them;
+        // the remainder of the threads is given to the first beds (one extra thread each).
+        // each worker of this pool parses one batch of its bed and creates a pool for the other
+        // batches, so the total number of threads is at most the given number
+        int annotation_count = stList_length(elements);
+        tpool_t *tm = tpool_create(max(1, min(threads, annotation_count)));
+        AnnotationParsingArgs *args_per_annotation = malloc(max(annotation_count, 1) * sizeof(AnnotationParsingArgs));
+        for (int i = 0; i < annotation_count; i++) {
+            AnnotationParsingArgs *args = args_per_annotation + i;
+            args->bed_path = cJSON_GetStringValue(stList_get(elements, i));
+            args->contigs_to_include = contigs_to_include;
+            args->threads = max(1, threads / annotation_count + (i < threads % annotation_count ? 1 : 0));
+            args->annotation_block_table = NULL;
+            work_arg_t *argWork = malloc(sizeof(work_arg_t));
+            argWork->data = (void *) args;
+            tpool_add_work(tm, parse_one_annotation, argWork);
+        }
+        tpool_wait(tm);
+        tpool_destroy(tm);
+        for (int i = 0; i < annotation_count; i++) {
+            element = stList_get(elements, i);
+            fprintf(stderr, "[%s] Parsed  annotation %s:%s\n", get_timestamp(), element->string,
+                    cJSON_GetStringValue(element));
+            stList_append(block_table_list, args_per_annotation[i].annotation_block_table);
+        }
+        free(args_per_annotation);
+        stList_destruct(elements);
         cJSON_Delete(annotation_json);
     }
     fprintf(stderr, "[%s] Number of created annotation block tables = %d\n", get_timestamp(),
             stList_length(block_table_list));
-    //for(int i=0;i < stList_length(block_table_list);i++){
-    //    ptBlock_write_blocks_stHash_in_bed(stList_get(block_table_list, i), NULL, stderr, false);
-    //}
     return block_table_list;
 
 }
@@ -2000,47 +2385,9 @@ stList *parse_all_annotations_and_save_in_stList(const char *json_path,
 
 // parse a bed file with at least 4 columns. 4th column can be an integer
 // showing the truth/prediction label index
-stHash *ptBlock_parse_inference_label_blocks(char *bedPath, bool isLabelTruth) {
-    TrackReader *trackReader = TrackReader_construct(bedPath, NULL, true); //0-based coors = true
-    stHash *label_blocks_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, NULL,
-                                                        (void (*)(void *)) stList_destruct);
-    stList *blocks = NULL;
-    while (0 < TrackReader_next(trackReader)) {
-        // create a ptBlock based on the parsed track
-        ptBlock *block = ptBlock_construct(trackReader->s, trackReader->e,
-                                           -1, -1,
-                                           -1, -1);
-        CoverageInfo *cov_info_data = CoverageInfo_construct(0ULL, 0, 0, 0);
-        // read 4th column (first attribute after coordinates)
-        int8_t label = 1 <= trackReader->attrbsLen ? atoi(trackReader->attrbs[0]) : -1;
-        // add inference data to coverage info
-        if (isLabelTruth) {
-            int8_t truth = label;
-            CoverageInfo_addInferenceData(cov_info_data, truth, -1);
-        } else { // label is prediction
-            int8_t prediction = label;
-            CoverageInfo_addInferenceData(cov_info_data, -1, prediction);
-        }
-
-        // add coverage info data to block
-        ptBlock_set_data(block, cov_info_data,
-                         destruct_cov_info_data,
-                         copy_cov_info_data,
-                         extend_cov_info_data);
-
-        // add block to the block stHash table
-        blocks = stHash_search(label_blocks_per_contig, trackReader->ctg);
-        // add new contig key to the table if it does not exist
-        if (blocks == NULL) {
-            blocks = stList_construct3(0, ptBlock_destruct);
-            stHash_insert(label_blocks_per_contig, copyString(trackReader->ctg), blocks);
-        }
-        stList_append(blocks, block);
-    }
-    TrackReader_destruct(trackReader);
-    ptBlock_sort_stHash_by_rfs(label_blocks_per_contig);
-    return label_blocks_per_contig;
-
+stHash *ptBlock_parse_inference_label_blocks(char *bedPath, bool isLabelTruth, int threads) {
+    return ptBlock_parse_bed_multi_threaded(bedPath, NULL, isLabelTruth ? BED_LABEL_TRUTH : BED_LABEL_PREDICTION,
+                                            threads);
 }
 
 
@@ -2126,6 +2473,576 @@ void add_coverage_info_to_all_annotation_block_tables(stList *block_table_list)
     }
 }
 
+typedef struct AnnotationEvent {
+    int position;
+    int annotation_index;
+    int delta; // +1 for the start of an annotation block and -1 for the position after its end
+} AnnotationEvent;
+
+int AnnotationEvent_cmp(const void *a, const void *b) {
+    const AnnotationEvent *event_a = a;
+    const AnnotationEvent *event_b = b;
+    if (event_a->position != event_b->position) {
+        return event_a->position < event_b->position ? -1 : 1;
+    }
+    return 0;
+}
+
+// make a sorted list of the start/end events of all annotation blocks in one contig
+AnnotationEvent *get_sorted_annotation_events(stList *annotation_block_table_list, char *contig_name,
+                                              int *number_of_events) {
+    int len = 0;
+    for (int annotation_index = 1; annotation_index < stList_length(annotation_block_table_list); annotation_index++) {
+        stList *blocks = stHash_search(stList_get(annotation_block_table_list, annotation_index), contig_name);
+        len += blocks == NULL ? 0 : 2 * stList_length(blocks);
+    }
+    AnnotationEvent *events = malloc(max(len, 1) * sizeof(AnnotationEvent));
+    len = 0;
+    // annotation 0 (no_annotation) does not set any bit so it is skipped
+    for (int annotation_index = 1; annotation_index < stList_length(annotation_block_table_list); annotation_index++) {
+        stList *blocks = stHash_search(stList_get(annotation_block_table_list, annotation_index), contig_name);
+        if (blocks == NULL) continue;
+        for (int i = 0; i < stList_length(blocks); i++) {
+            ptBlock *block = stList_get(blocks, i);
+            if (block->rfe < block->rfs) continue; // empty bed interval
+            events[len].position = block->rfs;
+            events[len].annotation_index = annotation_index;
+            events[len].delta = 1;
+            len++;
+            events[len].position = block->rfe + 1;
+            events[len].annotation_index = annotation_index;
+            events[len].delta = -1;
+            len++;
+        }
+    }
+    qsort(events, len, sizeof(AnnotationEvent), AnnotationEvent_cmp);
+    *number_of_events = len;
+    return events;
+}
+
+void AnnotationSegmentList_destruct(AnnotationSegmentList *segment_list) {
+    free(segment_list->segments);
+    free(segment_list);
+}
+
+// walk the sorted events and make one segment between each pair of consecutive event positions
+// (if at least one annotation is active between them)
+AnnotationSegmentList *AnnotationSegmentList_constructFromEvents(AnnotationEvent *events, int number_of_events,
+                                                                 int number_of_annotations) {
+    AnnotationSegmentList *segment_list = malloc(sizeof(AnnotationSegmentList));
+    segment_list->segments = malloc(max(number_of_events, 1) * sizeof(AnnotationSegment));
+    segment_list->number_of_segments = 0;
+    // number of active blocks per annotation (blocks of one bed file may overlap)
+    int *active_count_per_annotation = Int_construct1DArray(number_of_annotations);
+    // bit (i - 1) is set if annotation i is active
+    int number_of_words = max(number_of_annotations - 2, 0) / 64 + 1;
+    uint64_t *active_words = calloc(number_of_words, sizeof(uint64_t));
+    int i = 0;
+    while (i < number_of_events) {
+        int position = events[i].position;
+        // apply all events at this position
+        while (i < number_of_events && events[i].position == position) {
+            int annotation_index = events[i].annotation_index;
+            active_count_per_annotation[annotation_index] += events[i].delta;
+            uint64_t bit = 1ULL << ((annotation_index - 1) % 64);
+            if (active_count_per_annotation[annotation_index] > 0) {
+                active_words[(annotation_index - 1) / 64] |= bit;
+            } else {
+                active_words[(annotation_index - 1) / 64] &= ~bit;
+            }
+            i++;
+        }
+        uint64_t annotation_flag = AnnotationFlag_constructFromWords(active_words, number_of_words);
+        if (i < number_of_events && annotation_flag != 0ULL) {
+            AnnotationSegment *segment = segment_list->segments + segment_list->number_of_segments;
+            segment->start = position;
+            segment->end = events[i].position - 1;
+            segment->annotation_flag = annotation_flag;
+            segment_list->number_of_segments++;
+        }
+    }
+    free(active_count_per_annotation);
+    free(active_words);
+    return segment_list;
+}
+
+AnnotationIndex *AnnotationIndex_constructFromBlockTables(stList *annotation_block_table_list) {
+    AnnotationIndex *annotation_index = malloc(sizeof(AnnotationIndex));
+    annotation_index->number_of_annotations = stList_length(annotation_block_table_list);
+    annotation_index->segments_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                              (void (*)(void *)) AnnotationSegmentList_destruct);
+    annotation_index->mapped_file = NULL;
+    annotation_index->mapped_size = 0;
+    for (int i = 1; i < stList_length(annotation_block_table_list); i++) {
+        stHashIterator *it = stHash_getIterator(stList_get(annotation_block_table_list, i));
+        char *contig_name;
+        while ((contig_name = stHash_getNext(it)) != NULL) {
+            // segments of each contig are made once using the events of all annotations
+            if (stHash_search(annotation_index->segments_per_contig, contig_name) != NULL) continue;
+            int number_of_events = 0;
+            AnnotationEvent *events = get_sorted_annotation_events(annotation_block_table_list, contig_name,
+                                                                   &number_of_events);
+            AnnotationSegmentList *segment_list = AnnotationSegmentList_constructFromEvents(events,
+                                                                                            number_of_events,
+                                                                                            annotation_index->number_of_annotations);
+            stHash_insert(annotation_index->segments_per_contig, copyString(contig_name), segment_list);
+            free(events);
+        }
+        stHash_destructIterator(it);
+    }
+    return annotation_index;
+}
+
+AnnotationIndex *AnnotationIndex_constructFromJson(char *json_path, int threads) {
+    // an empty table for annotation 0 to keep the indices of the other annotations
+    stHash *annotation_zero_block_table = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                            (void (*)(void *)) stList_destruct);
+    stList *annotation_block_table_list = parse_all_annotations_and_save_in_stList(json_path,
+                                                                                   annotation_zero_block_table,
+                                                                                   NULL,
+                                                                                   threads);
+    if (annotation_block_table_list == NULL) {
+        fprintf(stderr, "[%s] Error: Couldn't parse the annotation json file %s\n", get_timestamp(), json_path);
+        exit(EXIT_FAILURE);
+    }
+    AnnotationIndex *annotation_index = AnnotationIndex_constructFromBlockTables(annotation_block_table_list);
+    stList_destruct(annotation_block_table_list);
+    return annotation_index;
+}
+
+// size, modification time and content hash of one annotation file; saved in the index for checking
+// whether the index is still valid
+typedef struct AnnotationFileStamp {
+    int64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t content_hash;
+} AnnotationFileStamp;
+
+void set_annotation_file_stamp(AnnotationFileStamp *stamp, char *file_path) {
+    struct stat file_stat;
+    if (stat(file_path, &file_stat) != 0) {
+        fprintf(stderr, "[%s] Error: Couldn't open %s\n", get_timestamp(), file_path);
+        exit(EXIT_FAILURE);
+    }
+    stamp->size = file_stat.st_size;
+    stamp->mtime_sec = file_stat.st_mtim.tv_sec;
+    stamp->mtime_nsec = file_stat.st_mtim.tv_nsec;
+    stamp->content_hash = 0;
+}
+
+// stamps of the json file and the bed files in the same order as annotation indices
+// (the first one is for the json file). Content hashes are computed only if with_content_hashes is true
+AnnotationFileStamp *get_annotation_file_stamps(stList *annotation_paths, bool with_content_hashes) {
+    AnnotationFileStamp *stamps = malloc(stList_length(annotation_paths) * sizeof(AnnotationFileStamp));
+    for (int i = 0; i < stList_length(annotation_paths); i++) {
+        set_annotation_file_stamp(&stamps[i], stList_get(annotation_paths, i));
+        if (with_content_hashes) {
+            stamps[i].content_hash = get_file_content_hash(stList_get(annotation_paths, i));
+        }
+    }
+    return stamps;
+}
+
+stList *get_annotation_paths(char *json_path) {
+    stList *annotation_paths = parse_annotation_paths_and_save_in_stList(json_path, json_path);
+    if (annotation_paths == NULL) {
+        fprintf(stderr, "[%s] Error: Couldn't parse the annotation json file %s\n", get_timestamp(), json_path);
+        exit(EXIT_FAILURE);
+    }
+    return annotation_paths;
+}
+
+// A file is unchanged if its size and modification time are the same as the saved ones. Files are only
+// read for comparing their content hashes if their modification time has changed but not their size
+bool are_annotation_files_unchanged(stList *annotation_paths, AnnotationFileStamp *saved_stamps) {
+    AnnotationFileStamp *stamps = get_annotation_file_stamps(annotation_paths, false);
+    bool unchanged = true;
+    for (int i = 0; unchanged && i < stList_length(annotation_paths); i++) {
+        if (stamps[i].size != saved_stamps[i].size) {
+            unchanged = false;
+        } else if (stamps[i].mtime_sec != saved_stamps[i].mtime_sec ||
+                   stamps[i].mtime_nsec != saved_stamps[i].mtime_nsec) {
+            unchanged = get_file_content_hash(stList_get(annotation_paths, i)) == saved_stamps[i].content_hash;
+        }
+    }
+    free(stamps);
+    return unchanged;
+}
+
+/*
+ * Binary format of the annotation index (native byte order):
+ *
+ *  char[8]     ANNOTATION_INDEX_MAGIC
+ *  int32       number of annotations (+1 for 'no_annotation')
+ *  int32       number of contigs
+ *  AnnotationFileStamp[]   size (int64), modification time (int64 seconds, int64 nanoseconds) and
+ *                          content hash (uint64) of the json file and the bed files (one per annotation)
+ *  then for each contig (sorted by name):
+ *      int32               length of contig name + null character
+ *      char[]              contig name (+ null character), padded with zeros to a multiple of 8 bytes
+ *      int64               number of segments
+ *      AnnotationSegment[] segments
+ */
+#define ANNOTATION_INDEX_MAGIC "ANNIDX03"
+
+bool AnnotationIndex_write(AnnotationIndex *annotation_index, char *json_path, char *index_path) {
+    stList *annotation_paths = get_annotation_paths(json_path);
+    int number_of_stamps = stList_length(annotation_paths);
+    if (number_of_stamps != annotation_index->number_of_annotations) {
+        fprintf(stderr, "[%s] Warning: The number of annotations in %s has changed while making the index.\n",
+                get_timestamp(), json_path);
+        stList_destruct(annotation_paths);
+        return false;
+    }
+    AnnotationFileStamp *stamps = get_annotation_file_stamps(annotation_paths, true);
+    stList_destruct(annotation_paths);
+    // write into a temporary file first so other processes never see a partial index
+    char *tmp_path = malloc(strlen(index_path) + 50);
+    sprintf(tmp_path, "%s.%d.tmp", index_path, getpid());
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        free(stamps);
+        free(tmp_path);
+        return false;
+    }
+    stList *contig_names = ptBlock_get_sorted_contig_list(annotation_index->segments_per_contig);
+    int32_t number_of_annotations = annotation_index->number_of_annotations;
+    int32_t number_of_contigs = stList_length(contig_names);
+    char padding[8] = {0};
+    fwrite(ANNOTATION_INDEX_MAGIC, sizeof(char), 8, fp);
+    fwrite(&number_of_annotations, sizeof(int32_t), 1, fp);
+    fwrite(&number_of_contigs, sizeof(int32_t), 1, fp);
+    fwrite(stamps, sizeof(AnnotationFileStamp), number_of_stamps, fp);
+    // annotation sets that do not fit inline are saved in a table and segments refer to them by
+    // their index in this file, since the interned ids are only valid within one process
+    // interned ids are dense so the local ids can be kept in an array indexed by them
+    int64_t number_of_interned_sets = AnnotationFlag_getNumberOfInternedSets();
+    int64_t *local_id_per_interned_set = malloc(max(number_of_interned_sets, 1) * sizeof(int64_t));
+    for (int64_t i = 0; i < number_of_interned_sets; i++) local_id_per_interned_set[i] = -1;
+    stList *wide_sets = stList_construct();
+    int32_t number_of_words_per_set = 0;
+    for (int c = 0; c < number_of_contigs; c++) {
+        AnnotationSegmentList *segment_list = stHash_search(annotation_index->segments_per_contig,
+                                                            stList_get(contig_names, c));
+        for (int64_t i = 0; i < segment_list->number_of_segments; i++) {
+            uint64_t annotation_flag = segment_list->segments[i].annotation_flag;
+            if (!AnnotationFlag_isSpilled(annotation_flag)) continue;
+            int64_t interned_id = annotation_flag & ANNOTATION_FLAG_INLINE_MASK;
+            if (local_id_per_interned_set[interned_id] != -1) continue;
+            local_id_per_interned_set[interned_id] = stList_length(wide_sets);
+            stList_append(wide_sets, (void *) annotation_flag);
+            uint64_t buffer;
+            int number_of_words = 0;
+            AnnotationFlag_getWords(annotation_flag, &buffer, &number_of_words);
+            number_of_words_per_set = max(number_of_words_per_set, number_of_words);
+        }
+    }
+    int64_t number_of_wide_sets = stList_length(wide_sets);
+    fwrite(&number_of_wide_sets, sizeof(int64_t), 1, fp);
+    fwrite(&number_of_words_per_set, sizeof(int32_t), 1, fp);
+    fwrite(padding, sizeof(char), 4, fp);
+    uint64_t *set_words = malloc(max(number_of_words_per_set, 1) * sizeof(uint64_t));
+    for (int64_t i = 0; i < number_of_wide_sets; i++) {
+        uint64_t buffer;
+        int number_of_words = 0;
+        const uint64_t *words = AnnotationFlag_getWords((uint64_t) stList_get(wide_sets, i), &buffer,
+                                                        &number_of_words);
+        memset(set_words, 0, number_of_words_per_set * sizeof(uint64_t));
+        memcpy(set_words, words, number_of_words * sizeof(uint64_t));
+        fwrite(set_words, sizeof(uint64_t), number_of_words_per_set, fp);
+    }
+    free(set_words);
+    for (int c = 0; c < number_of_contigs; c++) {
+        char *contig_name = stList_get(contig_names, c);
+        AnnotationSegmentList *segment_list = stHash_search(annotation_index->segments_per_contig, contig_name);
+        int32_t ctg_name_len = strlen(contig_name) + 1;
+        fwrite(&ctg_name_len, sizeof(int32_t), 1, fp);
+        fwrite(contig_name, sizeof(char), ctg_name_len, fp);
+        // keep the segments 8-byte aligned for reading them directly from the mapped file
+        int padding_len = (8 - (sizeof(int32_t) + ctg_name_len) % 8) % 8;
+        fwrite(padding, sizeof(char), padding_len, fp);
+        fwrite(&segment_list->number_of_segments, sizeof(int64_t), 1, fp);
+        if (number_of_wide_sets == 0) {
+            fwrite(segment_list->segments, sizeof(AnnotationSegment), segment_list->number_of_segments, fp);
+            continue;
+        }
+        for (int64_t i = 0; i < segment_list->number_of_segments; i++) {
+            AnnotationSegment segment = segment_list->segments[i];
+            if (AnnotationFlag_isSpilled(segment.annotation_flag)) {
+                int64_t interned_id = segment.annotation_flag & ANNOTATION_FLAG_INLINE_MASK;
+                segment.annotation_flag = ANNOTATION_FLAG_SPILL_BIT | (uint64_t) local_id_per_interned_set[interned_id];
+            }
+            fwrite(&segment, sizeof(AnnotationSegment), 1, fp);
+        }
+    }
+    free(local_id_per_interned_set);
+    stList_destruct(wide_sets);
+    bool success = ferror(fp) == 0;
+    success &= fclose(fp) == 0;
+    success &= success && rename(tmp_path, index_path) == 0;
+    if (!success) {
+        remove(tmp_path);
+    }
+    stList_destruct(contig_names);
+    free(stamps);
+    free(tmp_path);
+    return success;
+}
+
+AnnotationIndex *AnnotationIndex_load(char *index_path, char *json_path) {
+    if (!file_exists(index_path)) {
+        return NULL;
+    }
+    int fd = open(index_path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat file_stat;
+    size_t header_size = 8 + 2 * sizeof(int32_t);
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < header_size) {
+        close(fd);
+        fprintf(stderr, "[%s] Warning: Annotation index %s is malformed.\n", get_timestamp(), index_path);
+        return NULL;
+    }
+    size_t mapped_size = file_stat.st_size;
+    // private writable mapping; only the pages with segments of wide annotation sets are copied
+    char *mapped_file = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped_file == MAP_FAILED) {
+        return NULL;
+    }
+    int32_t number_of_annotations = *(int32_t *) (mapped_file + 8);
+    int32_t number_of_contigs = *(int32_t *) (mapped_file + 12);
+    size_t offset = header_size;
+    if (memcmp(mapped_file, ANNOTATION_INDEX_MAGIC, 8) != 0 ||
+        number_of_annotations < 1 ||
+        mapped_size < offset + number_of_annotations * sizeof(AnnotationFileStamp)) {
+        fprintf(stderr, "[%s] Warning: Annotation index %s is malformed.\n", get_timestamp(), index_path);
+        munmap(mapped_file, mapped_size);
+        return NULL;
+    }
+    // compare the saved stamps with the current json and bed files
+    stList *annotation_paths = get_annotation_paths(json_path);
+    bool up_to_date = stList_length(annotation_paths) == number_of_annotations &&
+                      are_annotation_files_unchanged(annotation_paths,
+                                                     (AnnotationFileStamp *) (mapped_file + offset));
+    stList_destruct(annotation_paths);
+    if (!up_to_date) {
+        fprintf(stderr, "[%s] Annotation index %s is outdated (json or bed files have changed).\n",
+                get_timestamp(), index_path);
+        munmap(mapped_file, mapped_size);
+        return NULL;
+    }
+    offset += number_of_annotations * sizeof(AnnotationFileStamp);
+
+    // intern the wide annotation sets of this file
+    int64_t number_of_wide_sets = 0;
+    int32_t number_of_words_per_set = 0;
+    if (offset + sizeof(int64_t) + 2 * sizeof(int32_t) <= mapped_size) {
+        number_of_wide_sets = *(int64_t *) (mapped_file + offset);
+        number_of_words_per_set = *(int32_t *) (mapped_file + offset + sizeof(int64_t));
+    }
+    offset += sizeof(int64_t) + 2 * sizeof(int32_t);
+    if (mapped_size < offset || number_of_wide_sets < 0 || number_of_words_per_set < 0 ||
+        (0 < number_of_wide_sets && (number_of_words_per_set == 0 ||
+                                     (mapped_size - offset) / sizeof(uint64_t) / number_of_words_per_set <
+                                     number_of_wide_sets))) {
+        fprintf(stderr, "[%s] Warning: Annotation index %s is malformed.\n", get_timestamp(), index_path);
+        munmap(mapped_file, mapped_size);
+        return NULL;
+    }
+    uint64_t *flag_per_wide_set = malloc(max(number_of_wide_sets, 1) * sizeof(uint64_t));
+    for (int64_t i = 0; i < number_of_wide_sets; i++) {
+        uint64_t *words = (uint64_t *) (mapped_file + offset);
+        flag_per_wide_set[i] = AnnotationFlag_constructFromWords(words, number_of_words_per_set);
+        offset += number_of_words_per_set * sizeof(uint64_t);
+    }
+
+    AnnotationIndex *annotation_index = malloc(sizeof(AnnotationIndex));
+    annotation_index->number_of_annotations = number_of_annotations;
+    // contig names and segments point to the mapped file
+    annotation_index->segments_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, NULL, free);
+    annotation_index->mapped_file = mapped_file;
+    annotation_index->mapped_size = mapped_size;
+    for (int c = 0; c < number_of_contigs; c++) {
+        bool malformed = mapped_size < offset + sizeof(int32_t);
+        int32_t ctg_name_len = malformed ? 0 : *(int32_t *) (mapped_file + offset);
+        char *contig_name = mapped_file + offset + sizeof(int32_t);
+        offset += sizeof(int32_t) + ctg_name_len;
+        offset += (8 - offset % 8) % 8;
+        malformed |= ctg_name_len < 1 || mapped_size < offset + sizeof(int64_t) ||
+                     contig_name[ctg_name_len - 1] != '\0';
+        int64_t number_of_segments = malformed ? 0 : *(int64_t *) (mapped_file + offset);
+        offset += sizeof(int64_t);
+        malformed |= number_of_segments < 0 ||
+                     (mapped_size - offset) / sizeof(AnnotationSegment) < number_of_segments;
+        AnnotationSegment *segments = (AnnotationSegment *) (mapped_file + offset);
+        // replace the file-local ids of the wide sets with the interned ones
+        for (int64_t i = 0; !malformed && 0 < number_of_wide_sets && i < number_of_segments; i++) {
+            if (!AnnotationFlag_isSpilled(segments[i].annotation_flag)) continue;
+            int64_t local_id = segments[i].annotation_flag & ANNOTATION_FLAG_INLINE_MASK;
+            malformed |= number_of_wide_sets <= local_id;
+            if (!malformed) segments[i].annotation_flag = flag_per_wide_set[local_id];
+        }
+        if (malformed) {
+            fprintf(stderr, "[%s] Warning: Annotation index %s is malformed.\n", get_timestamp(), index_path);
+            free(flag_per_wide_set);
+            AnnotationIndex_destruct(annotation_index);
+            return NULL;
+        }
+        AnnotationSegmentList *segment_list = malloc(sizeof(AnnotationSegmentList));
+        segment_list->segments = segments;
+        segment_list->number_of_segments = number_of_segments;
+        stHash_insert(annotation_index->segments_per_contig, contig_name, segment_list);
+        offset += number_of_segments * sizeof(AnnotationSegment);
+    }
+    free(flag_per_wide_set);
+    return annotation_index;
+}
+
+AnnotationIndex *AnnotationIndex_constructWithCache(char *json_path, char *index_path, int threads) {
+    AnnotationIndex *annotation_index = AnnotationIndex_load(index_path, json_path);
+    if (annotation_index != NULL) {
+        fprintf(stderr, "[%s] Annotation index is loaded from %s\n", get_timestamp(), index_path);
+        return annotation_index;
+    }
+    fprintf(stderr, "[%s] Constructing annotation index from the bed files in %s ...\n", get_timestamp(),
+            json_path);
+    annotation_index = AnnotationIndex_constructFromJson(json_path, threads);
+    if (AnnotationIndex_write(annotation_index, json_path, index_path)) {
+        fprintf(stderr, "[%s] Annotation index is saved into %s (It will skip parsing bed files for next runs).\n",
+                get_timestamp(), index_path);
+    } else {
+        fprintf(stderr, "[%s] Warning: Couldn't save annotation index into %s\n", get_timestamp(), index_path);
+    }
+    return annotation_index;
+}
+
+AnnotationSegmentList *AnnotationIndex_getSegments(AnnotationIndex *annotation_index, char *contig_name) {
+    return stHash_search(annotation_index->segments_per_contig, contig_name);
+}
+
+void AnnotationIndex_destruct(AnnotationIndex *annotation_index) {
+    stHash_destruct(annotation_index->segments_per_contig);
+    if (annotation_index->mapped_file != NULL) {
+        munmap(annotation_index->mapped_file, annotation_index->mapped_size);
+    }
+    free(annotation_index);
+}
+
+typedef struct OverlayAnnotationsArgs {
+    stHash *coverage_blocks_per_contig;
+    stHash *whole_genome_blocks_per_contig;
+    AnnotationIndex *annotation_index;
+    char *contig_name;
+    stList *overlaid_blocks;
+} OverlayAnnotationsArgs;
+
+void ptBlock_overlay_annotations_one_contig(void *argWork_) {
+    work_arg_t *argWork = argWork_;
+    OverlayAnnotationsArgs *args = argWork->data;
+    char *contig_name = args->contig_name;
+    stList *overlaid_blocks = args->overlaid_blocks;
+
+    stList *whole_genome_blocks = stHash_search(args->whole_genome_blocks_per_contig, contig_name);
+    stList *coverage_blocks = stHash_search(args->coverage_blocks_per_contig, contig_name);
+    int number_of_coverage_blocks = coverage_blocks == NULL ? 0 : stList_length(coverage_blocks);
+    AnnotationSegmentList *segment_list = AnnotationIndex_getSegments(args->annotation_index, contig_name);
+    AnnotationSegment *segments = segment_list == NULL ? NULL : segment_list->segments;
+    int64_t number_of_segments = segment_list == NULL ? 0 : segment_list->number_of_segments;
+
+    int64_t segment_index = 0;
+    int coverage_block_index = 0;
+    for (int w = 0; w < stList_length(whole_genome_blocks); w++) {
+        ptBlock *whole_genome_block = stList_get(whole_genome_blocks, w);
+        int pos = whole_genome_block->rfs;
+        while (pos <= whole_genome_block->rfe) {
+            int end = whole_genome_block->rfe;
+            // find the annotation segment containing the current position
+            while (segment_index < number_of_segments && segments[segment_index].end < pos) {
+                segment_index++;
+            }
+            uint64_t annotation_flag = 0ULL;
+            if (segment_index < number_of_segments) {
+                if (segments[segment_index].start <= pos) {
+                    annotation_flag = segments[segment_index].annotation_flag;
+                    end = min(end, segments[segment_index].end);
+                } else { // no annotation up to the next segment
+                    end = min(end, segments[segment_index].start - 1);
+                }
+            }
+            // find the coverage run containing the current position
+            while (coverage_block_index < number_of_coverage_blocks &&
+                   ((ptBlock *) stList_get(coverage_blocks, coverage_block_index))->rfe < pos) {
+                coverage_block_index++;
+            }
+            ptBlock *coverage_block = NULL;
+            if (coverage_block_index < number_of_coverage_blocks) {
+                ptBlock *next_coverage_block = stList_get(coverage_blocks, coverage_block_index);
+                if (next_coverage_block->rfs <= pos) {
+                    coverage_block = next_coverage_block;
+                    end = min(end, coverage_block->rfe);
+                } else { // zero coverage up to the next coverage block
+                    end = min(end, next_coverage_block->rfs - 1);
+                }
+            }
+            CoverageInfo *cov_info = coverage_block == NULL ? CoverageInfo_construct(0ULL, 0, 0, 0)
+                                                            : CoverageInfo_copy(coverage_block->data);
+            cov_info->annotation_flag = AnnotationFlag_or(cov_info->annotation_flag, annotation_flag);
+            ptBlock *block = ptBlock_construct(pos, end,
+                                               -1, -1,
+                                               -1, -1);
+            ptBlock_set_data(block, cov_info,
+                             destruct_cov_info_data,
+                             copy_cov_info_data,
+                             extend_cov_info_data);
+            stList_append(overlaid_blocks, block);
+            pos = end + 1;
+        }
+    }
+}
+
+stHash *ptBlock_overlay_annotations_per_contig(stHash *coverage_blocks_per_contig,
+                                               stHash *whole_genome_blocks_per_contig,
+                                               AnnotationIndex *annotation_index,
+                                               int threads) {
+    stHash *overlaid_blocks_per_contig = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                           (void (*)(void *)) stList_destruct);
+    // create a thread pool
+    tpool_t *tm = tpool_create(threads);
+
+    stList *argsList = stList_construct3(0, free);
+    stHashIterator *it = stHash_getIterator(whole_genome_blocks_per_contig);
+    char *contig_name;
+    while ((contig_name = stHash_getNext(it)) != NULL) {
+        // each job fills its own list so no locking is needed
+        stList *overlaid_blocks = stList_construct3(0, ptBlock_destruct);
+        stHash_insert(overlaid_blocks_per_contig, copyString(contig_name), overlaid_blocks);
+        OverlayAnnotationsArgs *args = malloc(sizeof(OverlayAnnotationsArgs));
+        args->coverage_blocks_per_contig = coverage_blocks_per_contig;
+        args->whole_genome_blocks_per_contig = whole_genome_blocks_per_contig;
+        args->annotation_index = annotation_index;
+        args->contig_name = contig_name;
+        args->overlaid_blocks = overlaid_blocks;
+        work_arg_t *argWork = malloc(sizeof(work_arg_t));
+        argWork->data = (void *) args;
+        // submit a job
+        tpool_add_work(tm, ptBlock_overlay_annotations_one_contig, argWork);
+        stList_append(argsList, args);
+    }
+    //wait for all threads
+    tpool_wait(tm);
+
+    // free thread pool
+    tpool_destroy(tm);
+
+    stList_destruct(argsList);
+    stHash_destructIterator(it);
+
+    return overlaid_blocks_per_contig;
+}
+
 stHash *ptBlock_multi_threaded_coverage_extraction_with_zero_coverage_and_annotation(char *bam_path,
                                                                                      char *contigs_path,
                                                                                      double downsample_rate,
@@ -2164,62 +3081,40 @@ stHash *ptBlock_multi_threaded_coverage_extraction_with_zero_coverage_and_annota
     // this is useful to save the blocks with no coverage
     stHash *whole_genome_block_table = ptBlock_get_whole_genome_blocks_per_contig(bam_path, contigs_to_include);
 
-    CoverageInfo *cov_info = CoverageInfo_construct(CoverageInfo_getAnnotationFlag(0), 0, 0, 0);
-    // The cov_info object created above will be copied and added as "data" to all whole genome blocks
-    // This process is happening in place.
-    ptBlock_add_data_to_all_blocks_stHash(whole_genome_block_table,
-                                          cov_info,
-                                          destruct_cov_info_data,
-                                          copy_cov_info_data,
-                                          extend_cov_info_data);
-
     // print len/number stats for the whole genome block table
     fprintf(stderr, "[%s] Created block table for whole genome  : tot_len=%ld, number=%ld\n", get_timestamp(),
             ptBlock_get_total_length_by_rf(whole_genome_block_table),
             ptBlock_get_total_number(whole_genome_block_table));
 
 
-    // parse annotation bed files
-    stList *annotation_block_table_list = parse_all_annotations_and_save_in_stList(json_path,
-                                                                                   whole_genome_block_table,
-                                                                                   contigs_to_include);
-
-    if (MAX_NUMBER_OF_ANNOTATIONS < stList_length(annotation_block_table_list)) {
-        fprintf(stderr,
-                "[%s] Warning: %d annotation bed files are given, which is more than maximum number (%d). In the current implementation it may interfere with digits dedicated for coverage bias detection.\n",
-                get_timestamp(), stList_length(annotation_block_table_list), MAX_NUMBER_OF_ANNOTATIONS);
+    // load the annotation index saved next to the json file or make it from the bed files
+    AnnotationIndex *annotation_index = NULL;
+    if (json_path != NULL) {
+        char *index_path = malloc(strlen(json_path) + 10);
+        sprintf(index_path, "%s.index", json_path);
+        annotation_index = AnnotationIndex_constructWithCache(json_path, index_path, threads);
+        free(index_path);
+    } else {
+        annotation_index = AnnotationIndex_constructFromJson(NULL, threads);
     }
-    // add coverage info objects as data to all annotation blocks
-    // each coverage info will contain only the related annotation flag with 0 coverage
-    add_coverage_info_to_all_annotation_block_tables(annotation_block_table_list);
 
+    fprintf(stderr, "[%s] Started overlaying annotation blocks on coverage blocks\n", get_timestamp());
 
-    for (int i = 0; i < stList_length(annotation_block_table_list); i++) {
-        ptBlock_extend_block_tables(coverage_block_table, stList_get(annotation_block_table_list, i));
-    }
-    fprintf(stderr, "[%s] Added annotation blocks to coverage block tables: tot_len=%ld, number=%ld\n", get_timestamp(),
-            ptBlock_get_total_length_by_rf(coverage_block_table),
-            ptBlock_get_total_number(coverage_block_table));
-
-    fprintf(stderr, "[%s] Started sorting and merging blocks\n", get_timestamp());
-    //sort
-    ptBlock_sort_stHash_by_rfs(coverage_block_table);
-
-    fprintf(stderr, "[%s] Blocks before merging : tot_len=%ld, number=%ld\n", get_timestamp(),
-            ptBlock_get_total_length_by_rf(coverage_block_table),
-            ptBlock_get_total_number(coverage_block_table));
-
-    //merge and create the final block table
-    stHash *final_block_table = ptBlock_merge_blocks_per_contig_by_rf_v2_multithreaded(coverage_block_table, threads);
+    // walk the annotation segments and the coverage blocks together to create the final block table
+    stHash *final_block_table = ptBlock_overlay_annotations_per_contig(coverage_block_table,
+                                                                       whole_genome_block_table,
+                                                                       annotation_index,
+                                                                       threads);
 
     fprintf(stderr, "[%s] Created final block table : tot_len=%ld, number=%ld\n", get_timestamp(),
             ptBlock_get_total_length_by_rf(final_block_table),
             ptBlock_get_total_number(final_block_table));
 
 
-    // free unmerged blocks
+    // free coverage blocks and annotations
     stHash_destruct(coverage_block_table);
-    stList_destruct(annotation_block_table_list);
+    stHash_destruct(whole_genome_block_table);
+    AnnotationIndex_destruct(annotation_index);
 
     return final_block_table;
 }
@@ -68,10 +68,12 @@ int get_inference_prediction_label(Inference *src);
 
 /*! @typedef
  * @abstract Structure for keeping useful information about a block with the same coverage/annotation
- * @field annotation_flag     a 64-bit flag where each bit represents a single annotation. Therefore it can only
- *                           keep track of 64 distinct annotations. For example "0...00000100" means the 3rd annotation
- *                           or "0...00011100" means that this block is completely within three different annotations;
- *                           3rd, 4th and 5th
+ * @field annotation_flag     a 64-bit flag where each bit represents a single annotation. For example "0...00000100"
+ *                           means the 3rd annotation or "0...00011100" means that this block is completely within
+ *                           three different annotations; 3rd, 4th and 5th. Bits 0-56 can keep the annotations 1-57
+ *                           inline. Bit 57 is set for the sets with larger annotation indices and then bits 0-56
+ *                           keep the id of the set in a shared table of interned wider masks (see AnnotationFlag_*).
+ *                           The 6 high bits (58-63) keep the region index.
  * @field coverage              The total read depth of coverage in this block
  * @field coverage_high_mapq    The read depth of coverage for only the alignments with high mapqs (for example >20)
  * @field coverage_high_clip    The read depth of coverage for only the alignments that are highly clipped (for example >10%)
@@ -155,7 +157,7 @@ char *get_string_count_data(void *src_);
 /**
  * Creates an instance of CoverageInfo given the required attributes
  *
- * @param annotation_flag       64-bit flag for representing at most 64 different annotations
+ * @param annotation_flag       64-bit flag for representing annotations (see CoverageInfo)
  * @param coverage              coverage value for the related block
  * @param coverage_high_mapq    coverage of the alignments with high mapq for the related block
  * @param coverage_high_clip    coverage of the highly clipped alignments for the related block
@@ -177,6 +179,32 @@ void CoverageInfo_destruct1DArray(CoverageInfo **coverageInfo1DArray, int len);
 
 void CoverageInfo_destruct(CoverageInfo *coverageInfo);
 
+#define MAX_NUMBER_OF_INLINE_ANNOTATIONS 57
+#define ANNOTATION_FLAG_SPILL_BIT 0x0200000000000000ULL
+#define ANNOTATION_FLAG_INLINE_MASK 0x01FFFFFFFFFFFFFFULL
+#define ANNOTATION_FLAG_REGION_MASK 0xFC00000000000000ULL
+
+// true if the annotation set does not fit inline and the flag keeps the id of an interned wide mask
+bool AnnotationFlag_isSpilled(uint64_t annotation_flag);
+
+/**
+ * Makes the flag of an annotation set given as 64-bit words; bit i of word w is for the annotation
+ * index 64 * w + i + 1. Sets that do not fit inline are interned in a shared thread-safe table, so
+ * equal sets always get equal flags and flags can still be compared with ==.
+ */
+uint64_t AnnotationFlag_constructFromWords(const uint64_t *words, int number_of_words);
+
+/**
+ * Returns the annotation bits of the flag (without region bits) as 64-bit words. For inline flags the
+ * only word is written into the given buffer and for spilled flags the interned words are returned.
+ */
+const uint64_t *AnnotationFlag_getWords(uint64_t annotation_flag, uint64_t *buffer, int *number_of_words);
+
+// union of the annotations in two flags (region bits are also ORed)
+uint64_t AnnotationFlag_or(uint64_t annotation_flag_1, uint64_t annotation_flag_2);
+
+int64_t AnnotationFlag_getNumberOfInternedSets();
+
 int CoverageInfo_getFirstAnnotationIndex(CoverageInfo *coverageInfo);
 
 uint64_t CoverageInfo_getAnnotationFlag(int annotationIndex);
@@ -185,6 +213,7 @@ uint64_t CoverageInfo_getAnnotationFlagFromArray(int *annotationIndices, int len
 
 bool CoverageInfo_overlapAnnotationIndex(CoverageInfo *coverageInfo, int annotationIndex);
 
+// only for the flags that are not spilled; use AnnotationFlag_getWords() for iterating over annotations
 uint64_t CoverageInfo_getAnnotationBits(CoverageInfo *coverageInfo);
 
 int CoverageInfo_getRegionIndex(CoverageInfo *coverageInfo);
@@ -213,7 +242,7 @@ void CoverageInfo_addInferenceData(CoverageInfo *cov_info,
                                    int8_t truth,
                                    int8_t prediction);
 
-stHash *ptBlock_parse_inference_label_blocks(char *bedPath, bool isLabelTruth);
+stHash *ptBlock_parse_inference_label_blocks(char *bedPath, bool isLabelTruth, int threads);
 
 /**
  * Receives the path to a cov or bed file (could be gz-compressed) that was created with bam2cov
@@ -257,6 +286,11 @@ char *get_string_cov_info_data_format_1(void *src_);
 // format 2 is compatible for HMM-Flagger
 char *get_string_cov_info_data_format_default(void *src_);
 
+// format 2 with the additional columns for truth labels (and prediction labels)
+char *get_string_cov_info_data_format_with_truth(void *src_);
+
+char *get_string_cov_info_data_format_with_truth_and_prediction(void *src_);
+
 // these formats can be used for the original implementation of Flagger
 char *get_string_cov_info_data_format_only_total(void *src_);
 
@@ -328,6 +362,26 @@ void ptBlock_sort_stHash_by_rfs(stHash *blocks_per_contig);
  */
 stHash *ptBlock_parse_bed(char *bed_path);
 
+typedef enum BedLabelType {
+    BED_LABEL_NONE = 0, // only the coordinates are parsed
+    BED_LABEL_TRUTH = 1, // 4th column is saved as the truth label in CoverageInfo
+    BED_LABEL_PREDICTION = 2 // 4th column is saved as the prediction label in CoverageInfo
+} BedLabelType;
+
+/**
+ * Parse a bed file (plain or gzipped) with multiple threads. Plain files are mapped into memory and
+ * the content is split at line boundaries into one batch per thread. The batches are concatenated in
+ * the order of the file and then the blocks of each contig are sorted by start.
+ *
+ * @param bed_path              Path to a BED file
+ * @param contigs_to_include    Only the blocks of these contigs are kept (NULL for keeping all)
+ * @param label_type            Whether the 4th column should be parsed as a truth/prediction label
+ * @param threads               Number of threads
+ * @return  stHash table with contigs as keys and sorted lists of blocks as values
+ */
+stHash *ptBlock_parse_bed_multi_threaded(char *bed_path, stSet *contigs_to_include, BedLabelType label_type,
+                                         int threads);
+
 stHash *ptBlock_parse_bed_with_filtering_contigs(char *bed_path, stSet *contigs_to_include);
 
 
@@ -398,6 +452,35 @@ void ptBlockItrPerContig_reset(ptBlockItrPerContig *block_iter);
 ptBlock *ptBlockItrPerContig_next(ptBlockItrPerContig *block_iter, char *ctg_name);
 
 
+/**
+ * Set the iterator to return the block with the given index in the given contig as the next block
+ *
+ * @param block_iter        the block iterator
+ * @param ctg_index         index of the contig (contigs are sorted by name)
+ * @param block_index       index of the block in the list of blocks related to the contig
+ */
+void ptBlockItrPerContig_seek(ptBlockItrPerContig *block_iter, int ctg_index, int block_index);
+
+
+/**
+ * Return the index of the contig containing the last returned block
+ *
+ * @param block_iter        the block iterator
+ * @return ctg_index        index of the contig (contigs are sorted by name)
+ */
+int ptBlockItrPerContig_get_ctg_index(ptBlockItrPerContig *block_iter);
+
+
+/**
+ * Return the number of blocks saved for each contig
+ *
+ * @param block_iter        the block iterator
+ * @param number_of_ctgs    the number of contigs (to be able to update in place)
+ * @return num_blocks       array of the number of blocks per contig (in the same order as ctg_list)
+ */
+int *ptBlockItrPerContig_get_number_of_blocks_per_contig(ptBlockItrPerContig *block_iter, int *number_of_ctgs);
+
+
 /**
  * Destruct a ptBlockItrPerContig structure
  *
@@ -722,9 +805,11 @@ stList *parse_annotation_paths_and_save_in_stList(const char *json_path, const c
 
 void add_coverage_info_to_all_annotation_block_tables(stList *block_table_list);
 
+// the bed files are parsed concurrently with the given number of threads
 stList *parse_all_annotations_and_save_in_stList(const char *json_path,
                                                  stHash *annotation_zero_block_table,
-                                                 stSet *contigs_to_include);
+                                                 stSet *contigs_to_include,
+                                                 int threads);
 
 
 // parse bam file and create a stHash table of blocks
@@ -742,6 +827,105 @@ stHash *ptBlock_multi_threaded_coverage_extraction_with_zero_coverage_and_annota
                                                                                      bool start_only_mode,
                                                                                      int *average_alignment_length_ptr);
 
+/*! @typedef
+ * @abstract Structure for keeping an interval over which the set of overlapping annotations does not change
+ * @field start                 0-based start coordinate
+ * @field end                   0-based end coordinate (inclusive)
+ * @field annotation_flag       bits of all annotations overlapping this interval
+ */
+typedef struct AnnotationSegment {
+    int32_t start;
+    int32_t end;
+    uint64_t annotation_flag;
+} AnnotationSegment;
+
+/*! @typedef
+ * @abstract Structure for keeping the annotation segments of one contig
+ * @field segments              sorted and non-overlapping segments (only the ones with at least one annotation)
+ * @field number_of_segments    number of segments
+ */
+typedef struct AnnotationSegmentList {
+    AnnotationSegment *segments;
+    int64_t number_of_segments;
+} AnnotationSegmentList;
+
+/*! @typedef
+ * @abstract Index of the annotation bed files given in a json file. For each contig it keeps the sorted
+ * annotation segments, which are split at every start/end position of the annotation blocks. The index
+ * can be saved in a binary file along with the content hashes of the json and bed files and it can be
+ * loaded later with mmap, which skips parsing, sorting and merging the bed files.
+ * @field number_of_annotations     number of annotations (+1 for 'no_annotation' with index 0)
+ * @field segments_per_contig       contig name -> AnnotationSegmentList
+ * @field mapped_file               start of the memory-mapped index file (NULL if the index is made in memory)
+ * @field mapped_size               size of the memory-mapped index file
+ */
+typedef struct AnnotationIndex {
+    int number_of_annotations;
+    stHash *segments_per_contig;
+    void *mapped_file;
+    size_t mapped_size;
+} AnnotationIndex;
+
+/**
+ * Make an index from annotation block tables. The i-th table is for annotation index i and
+ * the table with index 0 ('no_annotation') is skipped since it does not set any bit.
+ */
+AnnotationIndex *AnnotationIndex_constructFromBlockTables(stList *annotation_block_table_list);
+
+/**
+ * Parse all bed files in the json file (without filtering contigs) and make an index.
+ * If json_path is NULL the index will only have 'no_annotation'.
+ */
+AnnotationIndex *AnnotationIndex_constructFromJson(char *json_path, int threads);
+
+/**
+ * Write the index in binary format along with the sizes, modification times and content hashes of the json
+ * file and its bed files.
+ *
+ * @return  true if the index was written successfully
+ */
+bool AnnotationIndex_write(AnnotationIndex *annotation_index, char *json_path, char *index_path);
+
+/**
+ * Load a binary index with mmap. The segments are not copied and they point to the mapped file.
+ *
+ * @return  the index or NULL if the file is missing, malformed or it was made with a json/bed file
+ *          whose content is different from the current one. Content hashes are only computed for files
+ *          whose modification time has changed but not their size
+ */
+AnnotationIndex *AnnotationIndex_load(char *index_path, char *json_path);
+
+/**
+ * Load the index if it is valid otherwise make it from the bed files and save it in index_path
+ * for the next runs (a warning is printed if it cannot be saved)
+ */
+AnnotationIndex *AnnotationIndex_constructWithCache(char *json_path, char *index_path, int threads);
+
+// returns NULL if there is no annotation in the given contig
+AnnotationSegmentList *AnnotationIndex_getSegments(AnnotationIndex *annotation_index, char *contig_name);
+
+void AnnotationIndex_destruct(AnnotationIndex *annotation_index);
+
+/**
+ * Overlays the annotation segments on the coverage blocks and creates a table that covers the whole
+ * genome. For each contig the annotation segments are walked in lockstep with the coverage blocks and
+ * each output block gets the annotation flag of the segment overlapping it, so no extra blocks are added
+ * and no merging is needed. Output blocks are split at every boundary of the coverage and annotation
+ * blocks, exactly like extending the tables and merging them with ptBlock_merge_blocks_v2().
+ *
+ * @param coverage_blocks_per_contig        sorted and non-overlapping coverage blocks with CoverageInfo data
+ * @param whole_genome_blocks_per_contig    one block per contig covering the whole contig
+ * @param annotation_index                  index of the annotation segments
+ * @param threads                           number of threads (one job per contig)
+ * @return                                  the overlaid block table; annotations outside the contigs
+ *                                          of whole_genome_blocks_per_contig are ignored
+ *
+ */
+stHash *ptBlock_overlay_annotations_per_contig(stHash *coverage_blocks_per_contig,
+                                               stHash *whole_genome_blocks_per_contig,
+                                               AnnotationIndex *annotation_index,
+                                               int threads);
+
 void ptBlock_set_region_indices_by_mapping(stHash *blocks_per_contig,
                                            int *annotation_to_region_map,
                                            int annotation_to_region_map_length);
@@ -88,6 +88,48 @@ void SummaryTable_increment(SummaryTable *summaryTable, int rowIndex, int column
     }
 }
 
+// recompute all percentages from the values (rows and the whole table with no value are left untouched)
+static void SummaryTable_updateAllPercentages(SummaryTable *summaryTable) {
+    for (int i = 0; i < summaryTable->numberOfRows; i++) {
+        if (summaryTable->totalPerRow[i] <= 0) continue;
+        for (int j = 0; j < summaryTable->numberOfColumns; j++) {
+            summaryTable->tablePercentage[i][j] = summaryTable->table[i][j] / summaryTable->totalPerRow[i] * 100.0;
+        }
+    }
+    if (0 < summaryTable->totalSum) {
+        for (int i = 0; i < summaryTable->numberOfRows; i++) {
+            summaryTable->totalPerRowPercentage[i] = summaryTable->totalPerRow[i] / summaryTable->totalSum * 100.0;
+        }
+    }
+}
+
+void SummaryTable_divideRow(SummaryTable *summaryTable, int rowIndex, double denominator) {
+    for (int j = 0; j < summaryTable->numberOfColumns; j++) {
+        summaryTable->table[rowIndex][j] /= denominator;
+    }
+    summaryTable->totalPerRow[rowIndex] /= denominator;
+    summaryTable->totalSum = 0.0;
+    for (int i = 0; i < summaryTable->numberOfRows; i++) {
+        summaryTable->totalSum += summaryTable->totalPerRow[i];
+    }
+    SummaryTable_updateAllPercentages(summaryTable);
+}
+
+void SummaryTable_add(SummaryTable *dest, SummaryTable *src) {
+    if (dest->numberOfRows != src->numberOfRows || dest->numberOfColumns != src->numberOfColumns) {
+        fprintf(stderr, "[%s] Error: summary tables with different dimensions cannot be added.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < dest->numberOfRows; i++) {
+        for (int j = 0; j < dest->numberOfColumns; j++) {
+            dest->table[i][j] += src->table[i][j];
+        }
+        dest->totalPerRow[i] += src->totalPerRow[i];
+    }
+    dest->totalSum += src->totalSum;
+    SummaryTable_updateAllPercentages(dest);
+}
+
 double SummaryTable_getValue(SummaryTable *summaryTable, int rowIndex, int columnIndex) {
     return summaryTable->table[rowIndex][columnIndex];
 }
@@ -812,6 +854,107 @@ void SummaryTableList_writeFinalAunStatisticsIntoFile(SummaryTableList *numerato
     }
 }
 
+int SummaryTableList_getCategoryIndex1(SummaryTableList *summaryTableList, const char *categoryName1) {
+    for (int c1 = 0; c1 < summaryTableList->numberOfCategories1; c1++) {
+        if (strcmp(stList_get(summaryTableList->categoryNames1, c1), categoryName1) == 0) return c1;
+    }
+    return -1;
+}
+
+int SummaryTableList_getCategoryIndex2(SummaryTableList *summaryTableList, const char *categoryName2) {
+    for (int c2 = 0; c2 < summaryTableList->numberOfCategories2; c2++) {
+        if (strcmp(stList_get(summaryTableList->categoryNames2, c2), categoryName2) == 0) return c2;
+    }
+    return -1;
+}
+
+double SummaryTableList_getHarmonicMeanF1Score(SummaryTableList *recallTableList,
+                                               SummaryTableList *precisionTableList,
+                                               int catIndex1,
+                                               int catIndex2,
+                                               bool excludeHap) {
+    // last row is reserved for unknown labels
+    int numberOfLabels = recallTableList->numberOfRows - 1;
+    SummaryTable *recallTable = SummaryTableList_getTable(recallTableList, catIndex1, catIndex2);
+    SummaryTable *precisionTable = SummaryTableList_getTable(precisionTableList, catIndex1, catIndex2);
+    double sumOfReciprocalRecall = 0.0;
+    double sumOfReciprocalPrecision = 0.0;
+    int numberOfNonZeroDenomRecall = 0;
+    int numberOfNonZeroDenomPrecision = 0;
+    // same as SummaryTableList_writeFinalStatisticsIntoFile
+    for (int rowIndex = 0; rowIndex < numberOfLabels; rowIndex++) {
+        if (excludeHap && rowIndex == HAP_INDEX) continue;
+        double tpRecall = SummaryTable_getTPCountInRow(recallTable, rowIndex);
+        double tpPrecision = SummaryTable_getTPCountInRow(precisionTable, rowIndex);
+        double fn = SummaryTable_getAllCountInRow(recallTable, rowIndex) - tpRecall;
+        double fp = SummaryTable_getAllCountInRow(precisionTable, rowIndex) - tpPrecision;
+        double recallPercent = tpRecall / (tpRecall + fn + 1.0e-9) * 100.0;
+        double precisionPercent = tpPrecision / (tpPrecision + fp + 1.0e-9) * 100.0;
+        // 1.0e9 is sufficiently large
+        if (1e-9 < (tpRecall + fn)) {
+            numberOfNonZeroDenomRecall += 1;
+            sumOfReciprocalRecall += 0.0 < recallPercent ? 1.0 / recallPercent : 1.0e9;
+        }
+        if (1e-9 < (tpPrecision + fp)) {
+            numberOfNonZeroDenomPrecision += 1;
+            sumOfReciprocalPrecision += 0.0 < precisionPercent ? 1.0 / precisionPercent : 1.0e9;
+        }
+    }
+    if (numberOfNonZeroDenomRecall == 0 || numberOfNonZeroDenomPrecision == 0) return -1.0;
+    double harmonicMeanRecall = (double) numberOfNonZeroDenomRecall / sumOfReciprocalRecall;
+    double harmonicMeanPrecision = (double) numberOfNonZeroDenomPrecision / sumOfReciprocalPrecision;
+    return 2 * harmonicMeanRecall * harmonicMeanPrecision / (harmonicMeanRecall + harmonicMeanPrecision + 1.0e-9);
+}
+
+double SummaryTableList_getAunRatioHarmonicMean(SummaryTableList *numeratorTableList,
+                                                SummaryTableList *denominatorTableList,
+                                                int catIndex1,
+                                                int catIndex2) {
+    // last row is reserved for unknown labels
+    int numberOfLabels = numeratorTableList->numberOfRows - 1;
+    SummaryTable *numeratorTable = SummaryTableList_getTable(numeratorTableList, catIndex1, catIndex2);
+    SummaryTable *denominatorTable = SummaryTableList_getTable(denominatorTableList, catIndex1, catIndex2);
+    double aunSumReciprocal = 0.0;
+    int numberOfNonZeroDenom = 0;
+    // same as SummaryTableList_writeFinalAunStatisticsIntoFile
+    for (int rowIndex = 0; rowIndex < numberOfLabels; rowIndex++) {
+        double aunDenom = SummaryTable_getValue(denominatorTable, rowIndex, rowIndex);
+        double aunNum = SummaryTable_getValue(numeratorTable, rowIndex, rowIndex);
+        double aun = aunNum / (aunDenom + 1e-9);
+        if (0 < aunDenom) {
+            numberOfNonZeroDenom += 1;
+            //1.0e9 is sufficiently large
+            aunSumReciprocal += 0.0 < aun ? 1.0 / aun : 1.0e9;
+        }
+    }
+    if (numberOfNonZeroDenom == 0) return -1.0;
+    return (double) numberOfNonZeroDenom / aunSumReciprocal;
+}
+
+void SummaryTableList_add(SummaryTableList *dest, SummaryTableList *src) {
+    if (dest->totalNumberOfTables != src->totalNumberOfTables) {
+        fprintf(stderr, "[%s] Error: summary table lists with different numbers of tables cannot be added.\n",
+                get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    for (int tableIndex = 0; tableIndex < dest->totalNumberOfTables; tableIndex++) {
+        SummaryTable_add(stList_get(dest->summaryTables, tableIndex), stList_get(src->summaryTables, tableIndex));
+    }
+}
+
+void SummaryTableList_normalizeAunByTotalLengths(SummaryTableList *aunTableList, SummaryTableList *auxTableList) {
+    for (int c1 = 0; c1 < aunTableList->numberOfCategories1; c1++) {
+        for (int c2 = 0; c2 < aunTableList->numberOfCategories2; c2++) {
+            SummaryTable *aunTable = SummaryTableList_getTable(aunTableList, c1, c2);
+            for (int rowIndex = 0; rowIndex < aunTable->numberOfRows; rowIndex++) {
+                double totalSizeOfRefLabel = SummaryTableList_getValue(auxTableList, c1, c2, rowIndex, rowIndex);
+                // rows with no ref label block have no value to normalize
+                if (totalSizeOfRefLabel <= 0) continue;
+                SummaryTable_divideRow(aunTable, rowIndex, totalSizeOfRefLabel);
+            }
+        }
+    }
+}
 
 void SummaryTableList_destruct(SummaryTableList *summaryTableList) {
     if (summaryTableList->summaryTables != NULL) stList_destruct(summaryTableList->summaryTables);
@@ -840,121 +983,30 @@ void convertBaseLevelToOverlapBased(double *refLabelConfusionRow,
     }
 }
 
-SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_construct(void *blockIterator,
-                                                           void *(*copyBlockIterator)(void *),
-                                                           void *(*resetBlockIterator)(void *),
-                                                           void (*destructBlockIterator)(void *),
-                                                           ptBlock *(*getNextBlock)(void *, char *),
-                                                           SummaryTableList *summaryTableList,
-                                                           IntBinArray *sizeBinArray,
-                                                           int (*overlapFuncCategoryIndex1)(CoverageInfo *, int),
-                                                           int categoryIndex1,
-                                                           int8_t (*getRefLabelFunction)(Inference *),
-                                                           int8_t (*getQueryLabelFunction)(Inference *),
-                                                           MetricType metricType,
-                                                           double overlapThreshold,
-                                                           SummaryTableList *auxiliarySummaryTableList) {
-    SummaryTableUpdaterArgs *args = (SummaryTableUpdaterArgs *) malloc(1 * sizeof(SummaryTableUpdaterArgs));
-    args->blockIterator = blockIterator;
-    args->copyBlockIterator = copyBlockIterator;
-    args->resetBlockIterator = resetBlockIterator;
-    args->destructBlockIterator = destructBlockIterator;
-    args->getNextBlock = getNextBlock;
-    args->summaryTableList = summaryTableList;
-    args->sizeBinArray = sizeBinArray;
-    args->overlapFuncCategoryIndex1 = overlapFuncCategoryIndex1;
-    args->categoryIndex1 = categoryIndex1;
-    args->getRefLabelFunction = getRefLabelFunction;
-    args->getQueryLabelFunction = getQueryLabelFunction;
-    args->metricType = metricType;
-    args->overlapThreshold = overlapThreshold;
-    args->auxiliarySummaryTableList = auxiliarySummaryTableList;
-    return args;
-}
-
-SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_copy(SummaryTableUpdaterArgs *src) {
-    SummaryTableUpdaterArgs *dest = (SummaryTableUpdaterArgs *) malloc(1 * sizeof(SummaryTableUpdaterArgs));
-    dest->blockIterator = src->blockIterator;
-    dest->copyBlockIterator = src->copyBlockIterator;
-    dest->resetBlockIterator = src->resetBlockIterator;
-    dest->destructBlockIterator = src->destructBlockIterator;
-    dest->getNextBlock = src->getNextBlock;
-    dest->summaryTableList = src->summaryTableList;
-    dest->sizeBinArray = src->sizeBinArray;
-    dest->overlapFuncCategoryIndex1 = src->overlapFuncCategoryIndex1;
-    dest->categoryIndex1 = src->categoryIndex1;
-    dest->getRefLabelFunction = src->getRefLabelFunction;
-    dest->getQueryLabelFunction = src->getQueryLabelFunction;
-    dest->metricType = src->metricType;
-    dest->overlapThreshold = src->overlapThreshold;
-    dest->auxiliarySummaryTableList = src->auxiliarySummaryTableList;
-    return dest;
-}
-
-void SummaryTableUpdaterArgs_destruct(SummaryTableUpdaterArgs *args) {
-    free(args);
+void SummaryTableBlockContext_reset(SummaryTableBlockContext *context) {
+    context->start = -1;
+    context->end = -1;
+    context->refLabel = -1;
+    context->queryLabel = -1;
+    context->contigChanged = false;
+    context->preRefLabel = -1;
+    context->preQueryLabel = -1;
+    context->preBlockEnd = -1;
 }
 
-
-void
-SummaryTableList_addCreationJobsForAllCategory1(SummaryTableUpdaterArgs *argsTemplate, int sizeOfCategory1,
-                                                tpool_t *threadPool) {
-    for (int categoryIndex1 = 0; categoryIndex1 < sizeOfCategory1; categoryIndex1++) {
-        // make a copy of args
-        SummaryTableUpdaterArgs *argsToRun = SummaryTableUpdaterArgs_copy(argsTemplate);
-        // set the category index 1 whose related summary table is going to be updated
-        argsToRun->categoryIndex1 = categoryIndex1;
-        // create arg struct for tpool
-        work_arg_t *argWork = malloc(sizeof(work_arg_t));
-        argWork->data = (void *) argsToRun;
-        // Add a new job to the thread pool
-        tpool_add_work(threadPool,
-                       SummaryTableList_updateByUpdaterArgsForThreadPool,
-                       (void *) argWork);
-        //fprintf(stderr, "[%s] Created thread for updating summary table for category1 index %d (out of range [0-%d])\n",
-        //        get_timestamp(), categoryIndex1, sizeOfCategory1 - 1);
-    }
+void SummaryTableBlockContext_moveToNextBlock(SummaryTableBlockContext *context) {
+    context->preRefLabel = context->refLabel;
+    context->preQueryLabel = context->queryLabel;
+    context->preBlockEnd = context->end;
 }
 
-void SummaryTableList_updateByUpdaterArgsForThreadPool(void *argWork_) {
-    // get the arguments
-    work_arg_t *argWork = argWork_;
-    SummaryTableUpdaterArgs *args = argWork->data;
-    SummaryTableList_updateByUpdaterArgs(args);
-    SummaryTableUpdaterArgs_destruct(args);
-}
-
-
-// blockIterator can be created by either
-// ChunkIterator_construct or ptBlockItrPerContig_construct
-void SummaryTableList_updateByUpdaterArgs(SummaryTableUpdaterArgs *args) {
-    // fetch the arguments
-    void *(*copyBlockIterator)(void *) = args->copyBlockIterator;
-    void (*resetBlockIterator)(void *) = args->resetBlockIterator;
-    void (*destructBlockIterator)(void *) = args->destructBlockIterator;
-    ptBlock *(*getNextBlock)(void *, char *) = args->getNextBlock;
-    SummaryTableList *summaryTableList = args->summaryTableList;
-    // in the current implementation aux table can only be the table that contains total lengths
-    // of truth labels. It is required for computing AuN ratio values.
-    SummaryTableList *auxTableList = args->auxiliarySummaryTableList;
-    IntBinArray *sizeBinArray = args->sizeBinArray;
-    int (*overlapFuncCategoryIndex1)(CoverageInfo *, int) = args->overlapFuncCategoryIndex1;
-    int categoryIndex1 = args->categoryIndex1;
-    int8_t(*getRefLabelFunction)(Inference * ) = args->getRefLabelFunction;
-    int8_t(*getQueryLabelFunction)(Inference * ) = args->getQueryLabelFunction;
-    MetricType metricType = args->metricType;
-    double overlapThreshold = args->overlapThreshold;
-
-    // will be used only for computing AuN metric
-    stList **queryLengthsPerLabel = (stList **) malloc(summaryTableList->numberOfColumns * sizeof(stList * ));
-    for (int labelIndex = 0; labelIndex < summaryTableList->numberOfColumns; labelIndex++) {
-        queryLengthsPerLabel[labelIndex] = stList_construct3(0, free);
-    }
-
-    // make a copy of iterator and reset it
-    void *blockIterator = copyBlockIterator(args->blockIterator);
-    resetBlockIterator(blockIterator);
-
+SummaryTableUpdater *SummaryTableUpdater_construct(SummaryTableList *summaryTableList,
+                                                   IntBinArray *sizeBinArray,
+                                                   int categoryIndex1,
+                                                   MetricType metricType,
+                                                   double overlapThreshold,
+                                                   SummaryTableList *auxiliarySummaryTableList,
+                                                   SummaryTableBlockContext *context) {
     if (summaryTableList->numberOfCategories1 <= categoryIndex1) {
         fprintf(stderr,
                 "[%s] Error: annotation index (%d) for updating category 1 is greater than or equal to the size of the category (%d).",
@@ -963,369 +1015,222 @@ void SummaryTableList_updateByUpdaterArgs(SummaryTableUpdaterArgs *args) {
                 summaryTableList->numberOfCategories1);
         exit(EXIT_FAILURE);
     }
-
+    SummaryTableUpdater *updater = (SummaryTableUpdater *) malloc(sizeof(SummaryTableUpdater));
+    updater->summaryTableList = summaryTableList;
+    updater->sizeBinArray = sizeBinArray;
+    updater->categoryIndex1 = categoryIndex1;
+    updater->metricType = metricType;
+    updater->overlapThreshold = overlapThreshold;
+    updater->auxiliarySummaryTableList = auxiliarySummaryTableList;
+    updater->context = context;
+    updater->isRefLabelBlockInherited = false;
+    updater->refLabelStart = -1;
+    updater->queryLabelStart = -1;
     // +1 for undefined query labels
-    double *refLabelConfusionRow = Double_construct1DArray(summaryTableList->numberOfColumns);
-    Double_fill1DArray(refLabelConfusionRow, summaryTableList->numberOfColumns, 0.0);
-
-    int refLabelStart = -1;
-    int queryLabelStart = -1;
-    int preRefLabel = -1;
-    int preQueryLabel = -1;
-    int preBlockEnd = -1;
-    CoverageInfo *preCoverageInfo = NULL;
-
-    char ctg[200];
-    char preCtg[200];
-    preCtg[0] = '\0';
-
-    ptBlock *block = NULL;
-    int *queryLabelBlockLenPtr = NULL;
-    int queryLabelBlockLen = 0;
-
-    while ((block = getNextBlock(blockIterator, ctg)) != NULL) {
-
-        // get coverage info for this block
-        CoverageInfo *coverageInfo = (CoverageInfo *) block->data;
-        int start = block->rfs;
-        int end = block->rfe;
+    updater->refLabelConfusionRow = Double_construct1DArray(summaryTableList->numberOfColumns);
+    Double_fill1DArray(updater->refLabelConfusionRow, summaryTableList->numberOfColumns, 0.0);
+    updater->queryLengthsPerLabel = NULL;
+    if (metricType == METRIC_AUN) {
+        updater->queryLengthsPerLabel = (stList **) malloc(summaryTableList->numberOfColumns * sizeof(stList *));
+        for (int labelIndex = 0; labelIndex < summaryTableList->numberOfColumns; labelIndex++) {
+            updater->queryLengthsPerLabel[labelIndex] = stList_construct3(0, free);
+        }
+    }
+    return updater;
+}
 
-        // get labels
-        if (coverageInfo->data == NULL) {
-            fprintf(stderr, "[%s] Warning: inference data does not exist for updating summary tables.\n",
-                    get_timestamp());
+void SummaryTableUpdater_destruct(SummaryTableUpdater *updater) {
+    Double_destruct1DArray(updater->refLabelConfusionRow);
+    if (updater->queryLengthsPerLabel != NULL) {
+        for (int labelIndex = 0; labelIndex < updater->summaryTableList->numberOfColumns; labelIndex++) {
+            stList_destruct(updater->queryLengthsPerLabel[labelIndex]);
         }
-        Inference *inference = coverageInfo->data;
-        int refLabel = getRefLabelFunction(inference);
-        // if refLabel is -1 change it to numberOfRows - 1 since last row is for "Unk"
-        refLabel = refLabel == -1 ? summaryTableList->numberOfRows - 1 : refLabel;
-        int queryLabel = getQueryLabelFunction(inference);
-        // if queryLabel is -1 change it to numberOfColumns - 1 since last column is for "Unk"
-        queryLabel = queryLabel == -1 ? summaryTableList->numberOfColumns - 1 : queryLabel;
-
-        // set event flags
-        bool contigChanged = (preCtg[0] != '\0') && (strcmp(preCtg, ctg) != 0);
-        bool refLabelChanged = refLabel != preRefLabel;
-        bool queryLabelChanged = queryLabel != preQueryLabel;
-
-        bool annotationInCurrent = overlapFuncCategoryIndex1(coverageInfo, categoryIndex1);
-        bool annotationInPrevious = overlapFuncCategoryIndex1(preCoverageInfo, categoryIndex1);
-        bool annotationContinued = annotationInCurrent && annotationInPrevious;
-        bool annotationStarted = annotationInCurrent && !annotationInPrevious;
-        bool annotationEnded = !annotationInCurrent && annotationInPrevious;
-
-        bool preRefLabelIsValid = preRefLabel != -1;
-        bool preQueryLabelIsValid = preQueryLabel != -1;
-        /*
-        fprintf(stderr, "%s %d-%d annot = %d \n", ctg, start, end, categoryIndex1);
-        fprintf(stderr, "\t rlabel = %d\n", refLabel);
-        fprintf(stderr, "\t qlabel = %d\n", queryLabel);
-        fprintf(stderr, "\t contigChanged = %d\n", contigChanged);
-        fprintf(stderr, "\t refLabelChanged = %d\n", refLabelChanged);
-        fprintf(stderr, "\t annotationInCurrent = %d\n", annotationInCurrent);
-        fprintf(stderr, "\t annotationInPrevious = %d\n", annotationInPrevious);
-        fprintf(stderr, "\t annotationContinued = %d\n", annotationContinued);
-        fprintf(stderr, "\t annotationStarted = %d\n", annotationStarted);
-        fprintf(stderr, "\t annotationEnded = %d\n", annotationEnded);
-        fprintf(stderr, "\t preRefLabelIsValid = %d\n", preRefLabelIsValid);
-         */
-
-        // one annotation-ref-label block has ended
-        // update summary table
-        if (preRefLabelIsValid && (
-                (annotationContinued && refLabelChanged) ||
-                (annotationInPrevious && contigChanged) ||
-                annotationEnded)
-                ) {
-            int refLabelBlockLen = preBlockEnd - refLabelStart + 1;
-            int binIndicesLength = 0;
-            int *binIndices = IntBinArray_getBinIndices(sizeBinArray, refLabelBlockLen, &binIndicesLength);
-            if (metricType == METRIC_OVERLAP_BASED) {
-                convertBaseLevelToOverlapBased(refLabelConfusionRow,
-                                               summaryTableList->numberOfColumns,
-                                               refLabelBlockLen,
-                                               overlapThreshold);
-            }
+        free(updater->queryLengthsPerLabel);
+    }
+    free(updater);
+}
 
-            if (metricType == METRIC_AUN) {
-                if (preQueryLabelIsValid) {
-                    // add last block (with a contiguous ref and query label)
-                    queryLabelBlockLenPtr = (int *) malloc(sizeof(int));
-                    *queryLabelBlockLenPtr = preBlockEnd - queryLabelStart + 1;
-                    stList_append(queryLengthsPerLabel[preQueryLabel], queryLabelBlockLenPtr);
-                }
-                //fprintf(stderr, "new ref block\n");
-                // iterating over query labels
-                for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
-                    for (int queryBlockIndex = 0;
-                         queryBlockIndex < stList_length(queryLengthsPerLabel[q]);
-                         queryBlockIndex++) {
-                        queryLabelBlockLenPtr = (int *) stList_get(queryLengthsPerLabel[q], queryBlockIndex);
-                        queryLabelBlockLen = (int) *queryLabelBlockLenPtr;
-                        //fprintf(stderr, "annot_idx=%d\tref=%d\tquery=%d\trefBlockLen=%d\tqueryBlockLen=%d\n", categoryIndex1, preRefLabel, q, refLabelBlockLen, queryLabelBlockLen);
-                        // update ref label confusion row for computing AuN ratio values
-                        refLabelConfusionRow[q] += (double) queryLabelBlockLen * queryLabelBlockLen;
-                    }
-                }
-            }
+static void SummaryTableUpdater_addQueryLabelBlock(SummaryTableUpdater *updater) {
+    SummaryTableBlockContext *context = updater->context;
+    int *queryLabelBlockLenPtr = (int *) malloc(sizeof(int));
+    *queryLabelBlockLenPtr = context->preBlockEnd - updater->queryLabelStart + 1;
+    stList_append(updater->queryLengthsPerLabel[context->preQueryLabel], queryLabelBlockLenPtr);
+}
 
+// one annotation-ref-label block has ended (the previous block was its last block)
+// update summary tables with its confusion row
+static void SummaryTableUpdater_updateTablesWithRefLabelBlock(SummaryTableUpdater *updater) {
+    SummaryTableBlockContext *context = updater->context;
+    SummaryTableList *summaryTableList = updater->summaryTableList;
+    double *refLabelConfusionRow = updater->refLabelConfusionRow;
+    int preRefLabel = context->preRefLabel;
+    bool preQueryLabelIsValid = context->preQueryLabel != -1;
+
+    int refLabelBlockLen = context->preBlockEnd - updater->refLabelStart + 1;
+    int binIndicesLength = 0;
+    int *binIndices = IntBinArray_getBinIndices(updater->sizeBinArray, refLabelBlockLen, &binIndicesLength);
+    if (updater->metricType == METRIC_OVERLAP_BASED) {
+        convertBaseLevelToOverlapBased(refLabelConfusionRow,
+                                       summaryTableList->numberOfColumns,
+                                       refLabelBlockLen,
+                                       updater->overlapThreshold);
+    }
 
-            // iterating over size bin indices
-            for (int bi = 0; bi < binIndicesLength; bi++) {
-                int binIndex = binIndices[bi];
-                // each bin index as its own total ref length
-                double totalSizeOfPreRefLabel = metricType == METRIC_AUN ? SummaryTableList_getValue(auxTableList,
-                                                                                                     categoryIndex1,
-                                                                                                     binIndex,
-                                                                                                     preRefLabel,
-                                                                                                     preRefLabel) : 1.0;
-                // iterating over query labels
-                for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
-                    int catIndex1 = categoryIndex1;
-                    int catIndex2 = binIndex;
-                    int rowIndex = preRefLabel;
-                    int columnIndex = q;
-                    //fprintf(stderr, "block len = %d, [%d][%d] [%d][%d] += %d\n", blockLen, catIndex1, catIndex2, rowIndex, columnIndex, refLabelConfusionRow[q]);
-                    SummaryTableList_increment(summaryTableList,
-                                               catIndex1,
-                                               catIndex2,
-                                               rowIndex,
-                                               columnIndex,
-                                               refLabelConfusionRow[q] / totalSizeOfPreRefLabel);
-                }
+    if (updater->metricType == METRIC_AUN) {
+        if (preQueryLabelIsValid) {
+            // add last block (with a contiguous ref and query label)
+            SummaryTableUpdater_addQueryLabelBlock(updater);
+        }
+        // iterating over query labels
+        for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
+            for (int queryBlockIndex = 0;
+                 queryBlockIndex < stList_length(updater->queryLengthsPerLabel[q]);
+                 queryBlockIndex++) {
+                int queryLabelBlockLen = *((int *) stList_get(updater->queryLengthsPerLabel[q], queryBlockIndex));
+                // update ref label confusion row for computing AuN ratio values
+                refLabelConfusionRow[q] += (double) queryLabelBlockLen * queryLabelBlockLen;
             }
-            free(binIndices);
         }
+    }
 
-        // query label changed within a ref block
-        if (annotationInCurrent &&
-            metricType == METRIC_AUN &&
-            preQueryLabelIsValid &&
-            queryLabelChanged &&
-            (annotationContinued && !refLabelChanged) &&
-            !contigChanged) {
-            queryLabelBlockLenPtr = (int *) malloc(sizeof(int));
-            *queryLabelBlockLenPtr = preBlockEnd - queryLabelStart + 1;
-            stList_append(queryLengthsPerLabel[preQueryLabel], queryLabelBlockLenPtr);
+    // iterating over size bin indices
+    for (int bi = 0; bi < binIndicesLength; bi++) {
+        int binIndex = binIndices[bi];
+        // each bin index as its own total ref length
+        double totalSizeOfPreRefLabel = 1.0;
+        if (updater->metricType == METRIC_AUN && updater->auxiliarySummaryTableList != NULL) {
+            totalSizeOfPreRefLabel = SummaryTableList_getValue(updater->auxiliarySummaryTableList,
+                                                               updater->categoryIndex1,
+                                                               binIndex,
+                                                               preRefLabel,
+                                                               preRefLabel);
         }
-
-
-        // reset confusion row and update start location
-        if ((!annotationInCurrent && contigChanged) ||
-            annotationEnded) {
-            refLabelStart = -1;
-            queryLabelStart = -1;
-            Double_fill1DArray(refLabelConfusionRow, summaryTableList->numberOfColumns, 0);
+        // iterating over query labels
+        for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
+            SummaryTableList_increment(summaryTableList,
+                                       updater->categoryIndex1,
+                                       binIndex,
+                                       preRefLabel,
+                                       q,
+                                       refLabelConfusionRow[q] / totalSizeOfPreRefLabel);
         }
+    }
+    free(binIndices);
+}
 
-        // reset confusion row and update start location
-        if ((annotationContinued && refLabelChanged) ||
-            (annotationInCurrent && contigChanged) ||
-            annotationStarted) {
-            refLabelStart = start;
-            Double_fill1DArray(refLabelConfusionRow, summaryTableList->numberOfColumns, 0);
-            for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
-                // reset the list of query block lengths
-                stList_destruct(queryLengthsPerLabel[q]);
-                queryLengthsPerLabel[q] = stList_construct3(0, free);
-            }
-        }
+bool SummaryTableUpdater_isRefLabelBlockEnded(SummaryTableUpdater *updater,
+                                              bool annotationInCurrent,
+                                              bool annotationInPrevious) {
+    SummaryTableBlockContext *context = updater->context;
+    bool refLabelChanged = context->refLabel != context->preRefLabel;
+    bool annotationContinued = annotationInCurrent && annotationInPrevious;
+    bool annotationEnded = !annotationInCurrent && annotationInPrevious;
+    bool preRefLabelIsValid = context->preRefLabel != -1;
+    return preRefLabelIsValid && (
+            (annotationContinued && refLabelChanged) ||
+            (annotationInPrevious && context->contigChanged) ||
+            annotationEnded);
+}
 
-        // update start location for query label
-        if ((annotationContinued && refLabelChanged) ||
-            (annotationContinued && queryLabelChanged) ||
-            (annotationInCurrent && contigChanged) ||
-            annotationStarted) {
-            queryLabelStart = start;
-        }
+bool SummaryTableUpdater_extendRefLabelBlock(SummaryTableUpdater *updater,
+                                             bool annotationInCurrent,
+                                             bool annotationInPrevious) {
+    if (SummaryTableUpdater_isRefLabelBlockEnded(updater, annotationInCurrent, annotationInPrevious)) {
+        SummaryTableUpdater_updateTablesWithRefLabelBlock(updater);
+        return true;
+    }
+    // the current block is continuing the ref label block
+    SummaryTableUpdater_updateByBlock(updater, annotationInCurrent, annotationInPrevious);
+    return false;
+}
 
-        // update confusion row
-        if (annotationInCurrent && metricType != METRIC_AUN) {
-            refLabelConfusionRow[queryLabel] += end - start + 1;
+void SummaryTableUpdater_updateByBlock(SummaryTableUpdater *updater,
+                                       bool annotationInCurrent,
+                                       bool annotationInPrevious) {
+    SummaryTableBlockContext *context = updater->context;
+    int numberOfColumns = updater->summaryTableList->numberOfColumns;
+    MetricType metricType = updater->metricType;
+
+    // set event flags
+    bool contigChanged = context->contigChanged;
+    bool refLabelChanged = context->refLabel != context->preRefLabel;
+    bool queryLabelChanged = context->queryLabel != context->preQueryLabel;
+
+    bool annotationContinued = annotationInCurrent && annotationInPrevious;
+    bool annotationStarted = annotationInCurrent && !annotationInPrevious;
+    bool annotationEnded = !annotationInCurrent && annotationInPrevious;
+
+    bool preQueryLabelIsValid = context->preQueryLabel != -1;
+
+    // one annotation-ref-label block has ended
+    // update summary table
+    if (SummaryTableUpdater_isRefLabelBlockEnded(updater, annotationInCurrent, annotationInPrevious)) {
+        if (updater->isRefLabelBlockInherited) {
+            // it is counted by the partition where it started
+            updater->isRefLabelBlockInherited = false;
+        } else {
+            SummaryTableUpdater_updateTablesWithRefLabelBlock(updater);
         }
+    }
+    // the blocks of an inherited ref label block are counted by the partition where it started
+    if (updater->isRefLabelBlockInherited) return;
+
+    // query label changed within a ref block
+    if (annotationInCurrent &&
+        metricType == METRIC_AUN &&
+        preQueryLabelIsValid &&
+        queryLabelChanged &&
+        (annotationContinued && !refLabelChanged) &&
+        !contigChanged) {
+        SummaryTableUpdater_addQueryLabelBlock(updater);
+    }
 
 
-        preCoverageInfo = coverageInfo;
-        preRefLabel = refLabel;
-        preQueryLabel = queryLabel;
-        strcpy(preCtg, ctg);
-        preBlockEnd = end;
+    // reset confusion row and update start location
+    if ((!annotationInCurrent && contigChanged) ||
+        annotationEnded) {
+        updater->refLabelStart = -1;
+        updater->queryLabelStart = -1;
+        Double_fill1DArray(updater->refLabelConfusionRow, numberOfColumns, 0);
     }
 
-    bool preRefLabelIsValid = preRefLabel != -1;
-    bool preQueryLabelIsValid = preQueryLabel != -1;
-    // check last window and update summary tables if it had overlap with annotation
-    bool annotationInLastWindow = overlapFuncCategoryIndex1(preCoverageInfo, categoryIndex1);
-    if (annotationInLastWindow && preRefLabelIsValid) {
-        int refLabelBlockLen = preBlockEnd - refLabelStart + 1;
-        int binIndicesLength = 0;
-        int *binIndices = IntBinArray_getBinIndices(sizeBinArray, refLabelBlockLen, &binIndicesLength);
-        if (metricType == METRIC_OVERLAP_BASED) {
-            convertBaseLevelToOverlapBased(refLabelConfusionRow,
-                                           summaryTableList->numberOfColumns,
-                                           refLabelBlockLen,
-                                           overlapThreshold);
-        }
+    // reset confusion row and update start location
+    if ((annotationContinued && refLabelChanged) ||
+        (annotationInCurrent && contigChanged) ||
+        annotationStarted) {
+        updater->refLabelStart = context->start;
+        Double_fill1DArray(updater->refLabelConfusionRow, numberOfColumns, 0);
         if (metricType == METRIC_AUN) {
-            if (preQueryLabelIsValid) {
-                // add last block (with a contiguous ref and query label)
-                queryLabelBlockLenPtr = (int *) malloc(sizeof(int));
-                *queryLabelBlockLenPtr = preBlockEnd - queryLabelStart + 1;
-                stList_append(queryLengthsPerLabel[preQueryLabel], queryLabelBlockLenPtr);
-            }
-            //fprintf(stderr, "new ref block final\n");
-            // iterating over query labels
-            for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
-                for (int queryBlockIndex = 0;
-                     queryBlockIndex < stList_length(queryLengthsPerLabel[q]);
-                     queryBlockIndex++) {
-                    queryLabelBlockLenPtr = (int *) stList_get(queryLengthsPerLabel[q], queryBlockIndex);
-                    queryLabelBlockLen = (int) *queryLabelBlockLenPtr;
-                    //fprintf(stderr, "annot_idx=%d\tref=%d\tquery=%d\trefBlockLen=%d\tqueryBlockLen=%d\n", categoryIndex1, preRefLabel, q, refLabelBlockLen, queryLabelBlockLen);
-                    // update ref label confusion row for computing AuN ratio values
-                    refLabelConfusionRow[q] += (double) queryLabelBlockLen * queryLabelBlockLen;
-                }
-            }
-        }
-        // iterating over size bin indices
-        for (int bi = 0; bi < binIndicesLength; bi++) {
-            int binIndex = binIndices[bi];
-            // each bin index as its own total ref length
-            double totalSizeOfPreRefLabel = metricType == METRIC_AUN ? SummaryTableList_getValue(auxTableList,
-                                                                                                 categoryIndex1,
-                                                                                                 binIndex,
-                                                                                                 preRefLabel,
-                                                                                                 preRefLabel) : 1.0;
-
-            // iterating over query labels
-            for (int q = 0; q < summaryTableList->numberOfColumns; q++) {
-                int catIndex1 = categoryIndex1;
-                int catIndex2 = binIndex;
-                int rowIndex = preRefLabel;
-                int columnIndex = q;
-                //fprintf(stderr, "[%d][%d] [%d][%d] += %d\n", catIndex1, catIndex2, rowIndex, columnIndex, refLabelConfusionRow[q]);
-                SummaryTableList_increment(summaryTableList,
-                                           catIndex1,
-                                           catIndex2,
-                                           rowIndex,
-                                           columnIndex,
-                                           refLabelConfusionRow[q] / totalSizeOfPreRefLabel);
+            for (int q = 0; q < numberOfColumns; q++) {
+                // reset the list of query block lengths
+                stList_destruct(updater->queryLengthsPerLabel[q]);
+                updater->queryLengthsPerLabel[q] = stList_construct3(0, free);
             }
         }
-        free(binIndices);
     }
 
-    Double_destruct1DArray(refLabelConfusionRow);
-    destructBlockIterator(blockIterator);
-    for (int labelIndex = 0; labelIndex < summaryTableList->numberOfColumns; labelIndex++) {
-        stList_destruct(queryLengthsPerLabel[labelIndex]);
-    }
-    free(queryLengthsPerLabel);
-}
-
-void SummaryTableList_constructAndFillByIterator(void *blockIterator,
-                                                 BlockIteratorType blockIteratorType,
-                                                 stList *categoryNames,
-                                                 CategoryType categoryType,
-                                                 IntBinArray *sizeBinArray,
-                                                 MetricType metricType,
-                                                 double overlapRatioThreshold,
-                                                 int numberOfLabelsWithUnknown,
-                                                 stList *labelNamesWithUnknown,
-                                                 ComparisonType comparisonType,
-                                                 SummaryTableList *auxiliarySummaryTableList,
-                                                 SummaryTableListFullCatalog *catalog,
-                                                 tpool_t *threadPool) {
-
-    ptBlock *(*getNextBlock)(void *, char *);
-    void *(*copyIterator)(void *);
-    void (*destructIterator)(void *);
-    void (*resetIterator)(void *);
-    if (blockIteratorType == ITERATOR_BY_CHUNK) {
-        copyIterator = ChunkIterator_copy;
-        destructIterator = ChunkIterator_destruct;
-        resetIterator = ChunkIterator_reset;
-        getNextBlock = ChunkIterator_getNextPtBlock;
-    } else if (blockIteratorType == ITERATOR_BY_COV_BLOCK) {
-        copyIterator = ptBlockItrPerContig_copy;
-        destructIterator = ptBlockItrPerContig_destruct;
-        resetIterator = ptBlockItrPerContig_reset;
-        getNextBlock = ptBlockItrPerContig_next;
-    } else {
-        fprintf(stderr, "[%s] block iterator type is not valid.\n", get_timestamp());
-        exit(EXIT_FAILURE);
+    // update start location for query label
+    if ((annotationContinued && refLabelChanged) ||
+        (annotationContinued && queryLabelChanged) ||
+        (annotationInCurrent && contigChanged) ||
+        annotationStarted) {
+        updater->queryLabelStart = context->start;
     }
 
-
-    bool (*overlapFuncCategoryIndex1)(CoverageInfo *, int);
-    if (categoryType == CATEGORY_ANNOTATION) {
-        overlapFuncCategoryIndex1 = CoverageInfo_overlapAnnotationIndex;
-    } else if (categoryType == CATEGORY_REGION) {
-        overlapFuncCategoryIndex1 = CoverageInfo_overlapRegionIndex;
-    } else {
-        fprintf(stderr, "[%s] category type is not valid.\n", get_timestamp());
-        exit(EXIT_FAILURE);
+    // update confusion row
+    if (annotationInCurrent && metricType != METRIC_AUN) {
+        updater->refLabelConfusionRow[context->queryLabel] += context->end - context->start + 1;
     }
+}
 
-    int8_t(*getRefLabelFunction)(Inference * );
-    if (comparisonType == COMPARISON_TRUTH_VS_PREDICTION || comparisonType == COMPARISON_TRUTH_VS_TRUTH) {
-        getRefLabelFunction = get_inference_truth_label;
-    } else {
-        getRefLabelFunction = get_inference_prediction_label;
+void SummaryTableUpdater_finish(SummaryTableUpdater *updater, bool annotationInLastWindow) {
+    bool preRefLabelIsValid = updater->context->preRefLabel != -1;
+    // check last window and update summary tables if it had overlap with annotation
+    if (annotationInLastWindow && preRefLabelIsValid && !updater->isRefLabelBlockInherited) {
+        SummaryTableUpdater_updateTablesWithRefLabelBlock(updater);
     }
-
-
-    int8_t(*getQueryLabelFunction)(Inference * );
-    if (comparisonType == COMPARISON_TRUTH_VS_PREDICTION || comparisonType == COMPARISON_PREDICTION_VS_PREDICTION) {
-        getQueryLabelFunction = get_inference_prediction_label;
-    } else {
-        getQueryLabelFunction = get_inference_truth_label;
-    }
-
-    // create summary table list
-    stList *categoryNames1 = categoryNames;
-    stList *categoryNames2 = sizeBinArray->names;
-
-    int sizeOfCategory1 = stList_length(categoryNames1);
-    int numberOfRows = numberOfLabelsWithUnknown;
-    int numberOfColumns = numberOfLabelsWithUnknown;
-    SummaryTableList *summaryTableList;
-    if (labelNamesWithUnknown == NULL) {
-        summaryTableList = SummaryTableList_construct(categoryNames1,
-                                                      categoryNames2,
-                                                      numberOfRows,
-                                                      numberOfColumns);
-    } else {
-        summaryTableList = SummaryTableList_constructByNames(categoryNames1,
-                                                             categoryNames2,
-                                                             labelNamesWithUnknown,
-                                                             labelNamesWithUnknown);
-    }
-    // insert summary table list to the catalog
-    SummaryTableListFullCatalog_update(catalog, summaryTableList, categoryType, metricType, comparisonType);
-
-    // create a template of update args with category 1 index set to -1
-    SummaryTableUpdaterArgs *argsTemplate = SummaryTableUpdaterArgs_construct((void *) blockIterator,
-                                                                              copyIterator,
-                                                                              resetIterator,
-                                                                              destructIterator,
-                                                                              getNextBlock,
-                                                                              summaryTableList,
-                                                                              sizeBinArray,
-                                                                              overlapFuncCategoryIndex1,
-                                                                              -1,
-                                                                              getRefLabelFunction,
-                                                                              getQueryLabelFunction,
-                                                                              metricType,
-                                                                              overlapRatioThreshold,
-                                                                              auxiliarySummaryTableList);
-    // update all tables with multi-threading
-    SummaryTableList_addCreationJobsForAllCategory1(argsTemplate, sizeOfCategory1, threadPool);
-
-    SummaryTableUpdaterArgs_destruct(argsTemplate);
 }
 
-
 SummaryTableListFullCatalog *
 SummaryTableListFullCatalog_constructNull(int dimCategoryType, int dimMetricType, int dimComparisonType) {
     SummaryTableListFullCatalog *catalog = malloc(sizeof(SummaryTableListFullCatalog));
@@ -1369,6 +1274,59 @@ SummaryTableList *SummaryTableListFullCatalog_get(SummaryTableListFullCatalog *c
     return catalog->array[categoryType][metricType][comparisonType];
 }
 
+void SummaryTableListFullCatalog_add(SummaryTableListFullCatalog *dest, SummaryTableListFullCatalog *src) {
+    for (int categoryType = 0; categoryType < dest->dimCategoryType; categoryType++) {
+        for (int metricType = 0; metricType < dest->dimMetricType; metricType++) {
+            for (int comparisonType = 0; comparisonType < dest->dimComparisonType; comparisonType++) {
+                SummaryTableList *destList = dest->array[categoryType][metricType][comparisonType];
+                SummaryTableList *srcList = src->array[categoryType][metricType][comparisonType];
+                if (destList == NULL || srcList == NULL) continue;
+                SummaryTableList_add(destList, srcList);
+            }
+        }
+    }
+}
+
+double SummaryTableListFullCatalog_getHarmonicMeanF1Score(SummaryTableListFullCatalog *catalog,
+                                                          CategoryType categoryType,
+                                                          MetricType metricType,
+                                                          const char *categoryName1,
+                                                          const char *categoryName2,
+                                                          bool excludeHap) {
+    SummaryTableList *recallTables = SummaryTableListFullCatalog_get(catalog,
+                                                                    categoryType,
+                                                                    metricType,
+                                                                    COMPARISON_TRUTH_VS_PREDICTION);
+    SummaryTableList *precisionTables = SummaryTableListFullCatalog_get(catalog,
+                                                                       categoryType,
+                                                                       metricType,
+                                                                       COMPARISON_PREDICTION_VS_TRUTH);
+    if (recallTables == NULL || precisionTables == NULL) return -1.0;
+    int c1 = SummaryTableList_getCategoryIndex1(recallTables, categoryName1);
+    int c2 = SummaryTableList_getCategoryIndex2(recallTables, categoryName2);
+    if (c1 == -1 || c2 == -1) return -1.0;
+    return SummaryTableList_getHarmonicMeanF1Score(recallTables, precisionTables, c1, c2, excludeHap);
+}
+
+double SummaryTableListFullCatalog_getAunRatioHarmonicMean(SummaryTableListFullCatalog *catalog,
+                                                           CategoryType categoryType,
+                                                           const char *categoryName1,
+                                                           const char *categoryName2) {
+    SummaryTableList *numeratorTables = SummaryTableListFullCatalog_get(catalog,
+                                                                       categoryType,
+                                                                       METRIC_AUN,
+                                                                       COMPARISON_TRUTH_VS_PREDICTION);
+    SummaryTableList *denominatorTables = SummaryTableListFullCatalog_get(catalog,
+                                                                         categoryType,
+                                                                         METRIC_AUN,
+                                                                         COMPARISON_TRUTH_VS_TRUTH);
+    if (numeratorTables == NULL || denominatorTables == NULL) return -1.0;
+    int c1 = SummaryTableList_getCategoryIndex1(numeratorTables, categoryName1);
+    int c2 = SummaryTableList_getCategoryIndex2(numeratorTables, categoryName2);
+    if (c1 == -1 || c2 == -1) return -1.0;
+    return SummaryTableList_getAunRatioHarmonicMean(numeratorTables, denominatorTables, c1, c2);
+}
+
 void SummaryTableListFullCatalog_destruct(SummaryTableListFullCatalog *catalog) {
     for (int metricType = 0; metricType < catalog->dimMetricType; metricType++) {
         for (int comparisonType = 0; comparisonType < catalog->dimComparisonType; comparisonType++) {
@@ -1379,6 +1337,14 @@ void SummaryTableListFullCatalog_destruct(SummaryTableListFullCatalog *catalog)
             } // end loop for category type
         }// end loop for comparison type
     }// end loop for metric type
+    // free the 3D array
+    for (int categoryType = 0; categoryType < catalog->dimCategoryType; categoryType++) {
+        for (int metricType = 0; metricType < catalog->dimMetricType; metricType++) {
+            free(catalog->array[categoryType][metricType]);
+        }
+        free(catalog->array[categoryType]);
+    }
+    free(catalog->array);
     free(catalog);
 }
 
@@ -1587,97 +1553,454 @@ void SummaryTableListFullCatalog_write(SummaryTableListFullCatalog *catalog,
 }
 
 
-void SummaryTableList_addCreationJobsForOneMetricType(CoverageHeader *header,
-                                                      void *blockIterator,
-                                                      BlockIteratorType blockIteratorType,
-                                                      IntBinArray *sizeBinArray,
-                                                      MetricType metricType,
-                                                      double overlapRatioThreshold,
-                                                      int numberOfLabelsWithUnknown,
-                                                      stList *labelNamesWithUnknown,
-                                                      SummaryTableListFullCatalog *catalog,
-                                                      tpool_t *threadPool) {
-    SummaryTableList *auxiliarySummaryTableList = NULL;
+// truth/prediction labels are available for the comparison types that need them
+// and auN ratio stats are not defined for prediction as reference
+bool SummaryTableList_isTableListNeeded(CoverageHeader *header, MetricType metricType, ComparisonType comparisonType) {
+    bool truthLabelIsNeeded = comparisonType == COMPARISON_TRUTH_VS_PREDICTION ||
+                              comparisonType == COMPARISON_PREDICTION_VS_TRUTH ||
+                              comparisonType == COMPARISON_TRUTH_VS_TRUTH;
+    bool predictionLabelIsNeeded = comparisonType == COMPARISON_TRUTH_VS_PREDICTION ||
+                                   comparisonType == COMPARISON_PREDICTION_VS_TRUTH ||
+                                   comparisonType == COMPARISON_PREDICTION_VS_PREDICTION;
+    if (header->isTruthAvailable == false && truthLabelIsNeeded) return false;
+    if (header->isPredictionAvailable == false && predictionLabelIsNeeded) return false;
+    if (metricType == METRIC_AUN &&
+        (comparisonType == COMPARISON_PREDICTION_VS_PREDICTION ||
+         comparisonType == COMPARISON_PREDICTION_VS_TRUTH)) {
+        return false;
+    }
+    return true;
+}
 
-    // iterating over category types; annotation and region
-    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
-        stList *categoryNames =
-                categoryType == CATEGORY_REGION ? header->regionNames : header->annotationNames;
-        // iterate over comparison types such as precision and recall
-        for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
-            bool truthLabelIsNeeded = comparisonType == COMPARISON_TRUTH_VS_PREDICTION ||
-                                      comparisonType == COMPARISON_PREDICTION_VS_TRUTH ||
-                                      comparisonType == COMPARISON_TRUTH_VS_TRUTH;
-            bool predictionLabelIsNeeded = comparisonType == COMPARISON_TRUTH_VS_PREDICTION ||
-                                           comparisonType == COMPARISON_PREDICTION_VS_TRUTH ||
-                                           comparisonType == COMPARISON_PREDICTION_VS_PREDICTION;
-            if (header->isTruthAvailable == false && truthLabelIsNeeded) continue;
-            if (header->isPredictionAvailable == false && predictionLabelIsNeeded) continue;
-
-            // auN ratio stats are not defined for prediction as reference
-            // so skip these comparisons
-            if (metricType == METRIC_AUN &&
-                (comparisonType == COMPARISON_PREDICTION_VS_PREDICTION ||
-                 comparisonType == COMPARISON_PREDICTION_VS_TRUTH)) {
-                continue;
-            }
+void SummaryTableListFullCatalog_updateByOnePassForThreadPool(void *argWork_) {
+    // get the arguments
+    work_arg_t *argWork = argWork_;
+    SummaryTableCatalogUpdaterArgs *args = argWork->data;
+    SummaryTableListFullCatalog_updateByOnePass(args);
+    free(args);
+    free(argWork);
+}
 
-	    // now create jobs for METRIC_AUN
-            // get auxiliary table necessary for getting auN metric values
-            auxiliarySummaryTableList = metricType == METRIC_AUN ? SummaryTableListFullCatalog_get(catalog,
-                                                                    categoryType,
-                                                                    METRIC_BASE_LEVEL,
-                                                                    COMPARISON_TRUTH_VS_TRUTH) : NULL;
-        if (metricType == METRIC_AUN && auxiliarySummaryTableList == NULL) {
-            fprintf(stderr,
-                    "[%s] Error: For creating summary tables for the metric type of %s it is required to have the tables for the metric type of %s constructed and accessible beforehand.\n ",
-                    get_timestamp(),
-                    MetricTypeToString[METRIC_AUN],
-                    MetricTypeToString[METRIC_BASE_LEVEL]);
-            exit(EXIT_FAILURE);
+// set the labels of the given block for all comparison types of all catalogs.
+// predictionLabelPerCatalog is NULL if the prediction label should be taken from the block
+static void setBlockContextPerComparisonType(SummaryTableBlockContext *contextPerComparisonType,
+                                             int numberOfCatalogs,
+                                             ptBlock *block,
+                                             int8_t *predictionLabelPerCatalog,
+                                             bool contigChanged,
+                                             int numberOfLabelsWithUnknown) {
+    CoverageInfo *coverageInfo = (CoverageInfo *) block->data;
+    // get labels
+    if (coverageInfo->data == NULL) {
+        fprintf(stderr, "[%s] Warning: inference data does not exist for updating summary tables.\n",
+                get_timestamp());
+    }
+    Inference *inference = coverageInfo->data;
+    // if a label is -1 change it to numberOfLabelsWithUnknown - 1 since last row/column is for "Unk"
+    int truthLabel = get_inference_truth_label(inference);
+    truthLabel = truthLabel == -1 ? numberOfLabelsWithUnknown - 1 : truthLabel;
+    for (int catalogIndex = 0; catalogIndex < numberOfCatalogs; catalogIndex++) {
+        int predictionLabel = predictionLabelPerCatalog == NULL ? get_inference_prediction_label(inference) :
+                              predictionLabelPerCatalog[catalogIndex];
+        predictionLabel = predictionLabel == -1 ? numberOfLabelsWithUnknown - 1 : predictionLabel;
+        for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+            SummaryTableBlockContext *context =
+                    &contextPerComparisonType[catalogIndex * NUMBER_OF_COMPARISON_TYPES + comparisonType];
+            bool refIsTruth = comparisonType == COMPARISON_TRUTH_VS_PREDICTION ||
+                              comparisonType == COMPARISON_TRUTH_VS_TRUTH;
+            bool queryIsTruth = comparisonType == COMPARISON_PREDICTION_VS_TRUTH ||
+                                comparisonType == COMPARISON_TRUTH_VS_TRUTH;
+            context->refLabel = refIsTruth ? truthLabel : predictionLabel;
+            context->queryLabel = queryIsTruth ? truthLabel : predictionLabel;
+            context->start = block->rfs;
+            context->end = block->rfe;
+            context->contigChanged = contigChanged;
         }
+    }
+}
 
-            fprintf(stderr,
-                    "[%s] Initiating jobs for creating summary tables for categoryType = %s, metricType = %s, comparisonType = %s .\n",
-                    get_timestamp(),
-                    CategoryTypeToString[categoryType],
-                    MetricTypeToString[metricType],
-                    ComparisonTypeToString[comparisonType]);
-            SummaryTableList_constructAndFillByIterator(blockIterator,
-                                                        blockIteratorType,
-                                                        categoryNames,
-                                                        categoryType,
-                                                        sizeBinArray,
-                                                        metricType,
-                                                        overlapRatioThreshold,
-                                                        numberOfLabelsWithUnknown,
-                                                        labelNamesWithUnknown,
-                                                        comparisonType,
-                                                        auxiliarySummaryTableList,
-                                                        catalog,
-                                                        threadPool);
+// get the indices of the categories overlapping at least one of the two given coverage infos.
+// for annotations only the set bits are visited and for regions only the region indices of the two
+// coverage infos are checked. Returns the number of indices saved in categoryIndices
+static int getCategoryIndicesOverlappingEither(CategoryType categoryType,
+                                               CoverageInfo *coverageInfo1,
+                                               CoverageInfo *coverageInfo2,
+                                               int numberOfCategories,
+                                               int *categoryIndices) {
+    int length = 0;
+    if (categoryType == CATEGORY_REGION) {
+        int regionIndex1 = coverageInfo1 == NULL ? -1 : CoverageInfo_getRegionIndex(coverageInfo1);
+        int regionIndex2 = coverageInfo2 == NULL ? -1 : CoverageInfo_getRegionIndex(coverageInfo2);
+        if (0 <= regionIndex1 && regionIndex1 < numberOfCategories) {
+            categoryIndices[length++] = regionIndex1;
+        }
+        if (0 <= regionIndex2 && regionIndex2 < numberOfCategories && regionIndex2 != regionIndex1) {
+            categoryIndices[length++] = regionIndex2;
+        }
+        return length;
+    }
+    uint64_t buffer1 = 0ULL;
+    uint64_t buffer2 = 0ULL;
+    int numberOfWords1 = 0;
+    int numberOfWords2 = 0;
+    const uint64_t *words1 = coverageInfo1 == NULL ? &buffer1 : AnnotationFlag_getWords(coverageInfo1->annotation_flag,
+                                                                                        &buffer1,
+                                                                                        &numberOfWords1);
+    const uint64_t *words2 = coverageInfo2 == NULL ? &buffer2 : AnnotationFlag_getWords(coverageInfo2->annotation_flag,
+                                                                                        &buffer2,
+                                                                                        &numberOfWords2);
+    // annotation index 0 is for the blocks with no annotation
+    bool noAnnotation = (coverageInfo1 != NULL && CoverageInfo_getFirstAnnotationIndex(coverageInfo1) == 0) ||
+                        (coverageInfo2 != NULL && CoverageInfo_getFirstAnnotationIndex(coverageInfo2) == 0);
+    if (noAnnotation && 0 < numberOfCategories) {
+        categoryIndices[length++] = 0;
+    }
+    // wide annotation sets are visited 64 bits at a time
+    for (int w = 0; w < max(numberOfWords1, numberOfWords2); w++) {
+        uint64_t annotationBits = (w < numberOfWords1 ? words1[w] : 0ULL) | (w < numberOfWords2 ? words2[w] : 0ULL);
+        while (annotationBits != 0ULL) {
+            int annotationIndex = 64 * w + getFirstIndexWithNonZeroBitFromRight(annotationBits) + 1;
+            // bits are visited in increasing order
+            if (numberOfCategories <= annotationIndex) return length;
+            categoryIndices[length++] = annotationIndex;
+            // clear the lowest set bit
+            annotationBits &= annotationBits - 1;
         }
     }
+    return length;
 }
 
-void SummaryTableList_createAndWriteAllTables(void *iterator,
-                                              BlockIteratorType blockIteratorType,
-                                              CoverageHeader *header,
-                                              const char *outputPath,
-                                              const char *binArrayFilePath,
-                                              stList *labelNamesWithUnknown,
-                                              double overlapRatioThreshold,
-                                              int threads) {
+void SummaryTableListFullCatalog_updateByOnePass(SummaryTableCatalogUpdaterArgs *args) {
+    SummaryTableListFullCatalog **catalogs = args->catalogs;
+    int numberOfCatalogs = args->numberOfCatalogs;
 
-    IntBinArray *binArray;
-    if (binArrayFilePath != NULL) {
-        // parse bin intervals
-        binArray = IntBinArray_constructFromFile(binArrayFilePath);
+    void *(*copyBlockIterator)(void *);
+    void (*resetBlockIterator)(void *);
+    void (*seekBlockIterator)(void *, int, int);
+    void (*destructBlockIterator)(void *);
+    ptBlock *(*getNextBlock)(void *, char *);
+    int (*getUnitIndex)(void *);
+    if (args->blockIteratorType == ITERATOR_BY_CHUNK) {
+        copyBlockIterator = ChunkIterator_copy;
+        destructBlockIterator = ChunkIterator_destruct;
+        resetBlockIterator = ChunkIterator_reset;
+        seekBlockIterator = ChunkIterator_seek;
+        getNextBlock = ChunkIterator_getNextPtBlock;
+        getUnitIndex = ChunkIterator_getChunkIndex;
+    } else if (args->blockIteratorType == ITERATOR_BY_COV_BLOCK) {
+        copyBlockIterator = ptBlockItrPerContig_copy;
+        destructBlockIterator = ptBlockItrPerContig_destruct;
+        resetBlockIterator = ptBlockItrPerContig_reset;
+        seekBlockIterator = ptBlockItrPerContig_seek;
+        getNextBlock = ptBlockItrPerContig_next;
+        getUnitIndex = ptBlockItrPerContig_get_ctg_index;
+    } else if (args->blockIteratorType == ITERATOR_BY_COV_STREAM) {
+        copyBlockIterator = CovStreamIterator_copy;
+        destructBlockIterator = CovStreamIterator_destruct;
+        resetBlockIterator = CovStreamIterator_reset;
+        seekBlockIterator = CovStreamIterator_seek;
+        getNextBlock = CovStreamIterator_next;
+        getUnitIndex = CovStreamIterator_getChunkIndex;
     } else {
-        binArray = IntBinArray_constructSingleBin(0, 1e9, "ALL_SIZES");
+        fprintf(stderr, "[%s] block iterator type is not valid.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+
+    bool (*overlapFuncPerCategoryType[NUMBER_OF_CATEGORY_TYPES])(CoverageInfo *, int);
+    overlapFuncPerCategoryType[CATEGORY_REGION] = CoverageInfo_overlapRegionIndex;
+    overlapFuncPerCategoryType[CATEGORY_ANNOTATION] = CoverageInfo_overlapAnnotationIndex;
+
+    // block labels depend only on the catalog and the comparison type so one context is shared
+    // between all updaters with the same catalog and comparison type
+    int numberOfContexts = numberOfCatalogs * NUMBER_OF_COMPARISON_TYPES;
+    SummaryTableBlockContext *contextPerComparisonType = malloc(numberOfContexts * sizeof(SummaryTableBlockContext));
+    for (int contextIndex = 0; contextIndex < numberOfContexts; contextIndex++) {
+        SummaryTableBlockContext_reset(&contextPerComparisonType[contextIndex]);
+    }
+
+    // updatersPerCategory[categoryType][categoryIndex1] is the list of updaters (one per table list in the catalogs)
+    // for that category; it is NULL if the category is assigned to other category groups for all catalogs
+    stList **updatersPerCategory[NUMBER_OF_CATEGORY_TYPES];
+    int numberOfCategories[NUMBER_OF_CATEGORY_TYPES];
+    int numberOfLabelsWithUnknown = 0;
+    int slot = 0;
+    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+        numberOfCategories[categoryType] = 0;
+        for (int metricType = 0; metricType < NUMBER_OF_METRIC_TYPES; metricType++) {
+            for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+                SummaryTableList *summaryTableList = SummaryTableListFullCatalog_get(catalogs[0], categoryType,
+                                                                                     metricType, comparisonType);
+                if (summaryTableList == NULL) continue;
+                numberOfCategories[categoryType] = summaryTableList->numberOfCategories1;
+                numberOfLabelsWithUnknown = summaryTableList->numberOfRows;
+            }
+        }
+        updatersPerCategory[categoryType] = (stList **) malloc(numberOfCategories[categoryType] * sizeof(stList *));
+        for (int categoryIndex1 = 0; categoryIndex1 < numberOfCategories[categoryType]; categoryIndex1++) {
+            updatersPerCategory[categoryType][categoryIndex1] = NULL;
+            // the pairs of catalog and category are distributed between the category groups
+            for (int catalogIndex = 0; catalogIndex < numberOfCatalogs; catalogIndex++) {
+                if (slot++ % args->numberOfCategoryGroups != args->categoryGroupIndex) continue;
+                if (updatersPerCategory[categoryType][categoryIndex1] == NULL) {
+                    updatersPerCategory[categoryType][categoryIndex1] =
+                            stList_construct3(0, (void (*)(void *)) SummaryTableUpdater_destruct);
+                }
+                stList *updaters = updatersPerCategory[categoryType][categoryIndex1];
+                SummaryTableBlockContext *contextPerComparisonTypeOfCatalog =
+                        &contextPerComparisonType[catalogIndex * NUMBER_OF_COMPARISON_TYPES];
+                for (int metricType = 0; metricType < NUMBER_OF_METRIC_TYPES; metricType++) {
+                    for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+                        SummaryTableList *summaryTableList = SummaryTableListFullCatalog_get(catalogs[catalogIndex],
+                                                                                             categoryType,
+                                                                                             metricType,
+                                                                                             comparisonType);
+                        if (summaryTableList == NULL) continue;
+                        // auN tables will be normalized after all jobs are done since the
+                        // base-level tables are being filled in the same pass
+                        stList_append(updaters,
+                                      SummaryTableUpdater_construct(summaryTableList,
+                                                                    args->sizeBinArray,
+                                                                    categoryIndex1,
+                                                                    metricType,
+                                                                    args->overlapThreshold,
+                                                                    NULL,
+                                                                    &contextPerComparisonTypeOfCatalog[comparisonType]));
+                    }
+                }
+            }
+        }
+    }
+
+    // a buffer for the indices of the categories overlapping the current or the previous block
+    int maxNumberOfCategories = numberOfCategories[CATEGORY_REGION] < numberOfCategories[CATEGORY_ANNOTATION] ?
+                                numberOfCategories[CATEGORY_ANNOTATION] : numberOfCategories[CATEGORY_REGION];
+    int *overlappingCategoryIndices = Int_construct1DArray(maxNumberOfCategories + 1);
+
+    // make a copy of iterator and reset it
+    void *blockIterator = copyBlockIterator(args->blockIterator);
+    resetBlockIterator(blockIterator);
+
+    // the prediction labels of the separate prediction sets are updated by the iterator for each block
+    int8_t *predictionLabelPerCatalog = NULL;
+    if (args->blockIteratorType == ITERATOR_BY_COV_STREAM &&
+        0 < CovStreamIterator_getNumberOfPredictionSets(blockIterator)) {
+        predictionLabelPerCatalog = CovStreamIterator_getPredictionLabels(blockIterator);
+    }
+
+    CoverageInfo *preCoverageInfo = NULL;
+
+    char ctg[200];
+    char preCtg[200];
+    preCtg[0] = '\0';
+
+    ptBlock *block = NULL;
+
+    // read the last block of the previous partition to find the ref label blocks
+    // that were started in the previous partition
+    if (args->preUnitIndex != -1) {
+        seekBlockIterator(blockIterator, args->preUnitIndex, args->preBlockIndex);
+        block = getNextBlock(blockIterator, preCtg);
+    }
+    // the block before the partition may not exist for CovStreamIterator if the previous units are empty
+    if (block != NULL && getUnitIndex(blockIterator) < args->startUnitIndex) {
+        setBlockContextPerComparisonType(contextPerComparisonType, numberOfCatalogs, block, predictionLabelPerCatalog,
+                                         false, numberOfLabelsWithUnknown);
+        for (int contextIndex = 0; contextIndex < numberOfContexts; contextIndex++) {
+            SummaryTableBlockContext_moveToNextBlock(&contextPerComparisonType[contextIndex]);
+        }
+        preCoverageInfo = (CoverageInfo *) block->data;
+        for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+            for (int categoryIndex1 = 0; categoryIndex1 < numberOfCategories[categoryType]; categoryIndex1++) {
+                stList *updaters = updatersPerCategory[categoryType][categoryIndex1];
+                if (updaters == NULL) continue;
+                bool annotationInPrevious = overlapFuncPerCategoryType[categoryType](preCoverageInfo, categoryIndex1);
+                for (int i = 0; i < stList_length(updaters); i++) {
+                    SummaryTableUpdater *updater = stList_get(updaters, i);
+                    updater->isRefLabelBlockInherited = annotationInPrevious;
+                }
+            }
+        }
+    } else {
+        preCtg[0] = '\0';
+        seekBlockIterator(blockIterator, args->startUnitIndex, 0);
+    }
+
+    block = getNextBlock(blockIterator, ctg);
+    while (block != NULL && getUnitIndex(blockIterator) < args->endUnitIndex) {
+
+        // get coverage info for this block
+        CoverageInfo *coverageInfo = (CoverageInfo *) block->data;
+        bool contigChanged = (preCtg[0] != '\0') && (strcmp(preCtg, ctg) != 0);
+        setBlockContextPerComparisonType(contextPerComparisonType, numberOfCatalogs, block, predictionLabelPerCatalog,
+                                         contigChanged, numberOfLabelsWithUnknown);
+
+        for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+            // the state of an updater can only change when its category is in one of the two blocks;
+            // the resets outside of the category are overwritten once the category starts again
+            int numberOfOverlappingCategories = getCategoryIndicesOverlappingEither(categoryType,
+                                                                                    coverageInfo,
+                                                                                    preCoverageInfo,
+                                                                                    numberOfCategories[categoryType],
+                                                                                    overlappingCategoryIndices);
+            for (int k = 0; k < numberOfOverlappingCategories; k++) {
+                int categoryIndex1 = overlappingCategoryIndices[k];
+                stList *updaters = updatersPerCategory[categoryType][categoryIndex1];
+                if (updaters == NULL) continue;
+                bool annotationInCurrent = overlapFuncPerCategoryType[categoryType](coverageInfo, categoryIndex1);
+                bool annotationInPrevious = overlapFuncPerCategoryType[categoryType](preCoverageInfo, categoryIndex1);
+                for (int i = 0; i < stList_length(updaters); i++) {
+                    SummaryTableUpdater_updateByBlock(stList_get(updaters, i),
+                                                      annotationInCurrent,
+                                                      annotationInPrevious);
+                }
+            }
+        }
+
+        preCoverageInfo = coverageInfo;
+        strcpy(preCtg, ctg);
+        for (int contextIndex = 0; contextIndex < numberOfContexts; contextIndex++) {
+            SummaryTableBlockContext_moveToNextBlock(&contextPerComparisonType[contextIndex]);
+        }
+        block = getNextBlock(blockIterator, ctg);
+    }
+
+    // collect the updaters whose ref label blocks are still open at the end of the partition
+    stList *openUpdatersPerCategoryType[NUMBER_OF_CATEGORY_TYPES];
+    int numberOfOpenUpdaters = 0;
+    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+        openUpdatersPerCategoryType[categoryType] = stList_construct();
+        for (int categoryIndex1 = 0; categoryIndex1 < numberOfCategories[categoryType]; categoryIndex1++) {
+            stList *updaters = updatersPerCategory[categoryType][categoryIndex1];
+            if (updaters == NULL) continue;
+            if (!overlapFuncPerCategoryType[categoryType](preCoverageInfo, categoryIndex1)) continue;
+            for (int i = 0; i < stList_length(updaters); i++) {
+                SummaryTableUpdater *updater = stList_get(updaters, i);
+                if (updater->isRefLabelBlockInherited) continue;
+                stList_append(openUpdatersPerCategoryType[categoryType], updater);
+                numberOfOpenUpdaters++;
+            }
+        }
+    }
+
+    // iterate over the blocks of the next partitions until all open ref label blocks are ended;
+    // the first block after the partition is already fetched
+    while (0 < numberOfOpenUpdaters && block != NULL) {
+        CoverageInfo *coverageInfo = (CoverageInfo *) block->data;
+        bool contigChanged = (preCtg[0] != '\0') && (strcmp(preCtg, ctg) != 0);
+        setBlockContextPerComparisonType(contextPerComparisonType, numberOfCatalogs, block, predictionLabelPerCatalog,
+                                         contigChanged, numberOfLabelsWithUnknown);
+        for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+            stList *openUpdaters = openUpdatersPerCategoryType[categoryType];
+            for (int i = stList_length(openUpdaters) - 1; 0 <= i; i--) {
+                SummaryTableUpdater *updater = stList_get(openUpdaters, i);
+                int categoryIndex1 = updater->categoryIndex1;
+                bool annotationInCurrent = overlapFuncPerCategoryType[categoryType](coverageInfo, categoryIndex1);
+                bool annotationInPrevious = overlapFuncPerCategoryType[categoryType](preCoverageInfo, categoryIndex1);
+                if (SummaryTableUpdater_extendRefLabelBlock(updater, annotationInCurrent, annotationInPrevious)) {
+                    stList_remove(openUpdaters, i);
+                    numberOfOpenUpdaters--;
+                }
+            }
+        }
+        preCoverageInfo = coverageInfo;
+        strcpy(preCtg, ctg);
+        for (int contextIndex = 0; contextIndex < numberOfContexts; contextIndex++) {
+            SummaryTableBlockContext_moveToNextBlock(&contextPerComparisonType[contextIndex]);
+        }
+        block = getNextBlock(blockIterator, ctg);
+    }
+
+    // the ref label blocks that are still open have reached the last block
+    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+        stList *openUpdaters = openUpdatersPerCategoryType[categoryType];
+        for (int i = 0; i < stList_length(openUpdaters); i++) {
+            SummaryTableUpdater_finish(stList_get(openUpdaters, i), true);
+        }
+        stList_destruct(openUpdaters);
+        for (int categoryIndex1 = 0; categoryIndex1 < numberOfCategories[categoryType]; categoryIndex1++) {
+            if (updatersPerCategory[categoryType][categoryIndex1] != NULL) {
+                stList_destruct(updatersPerCategory[categoryType][categoryIndex1]);
+            }
+        }
+        free(updatersPerCategory[categoryType]);
+    }
+    free(contextPerComparisonType);
+    free(overlappingCategoryIndices);
+    destructBlockIterator(blockIterator);
+}
+
+// construct a catalog with empty table lists for all the metric and comparison types that can be computed
+static SummaryTableListFullCatalog *SummaryTableListFullCatalog_constructEmptyTables(CoverageHeader *header,
+                                                                                     IntBinArray *binArray,
+                                                                                     stList *labelNamesWithUnknown) {
+    int numberOfLabelsWithUnknown = header->numberOfLabels + 1;
+    // make a 3D array of summary table list with the dimension of
+    // NUMBER_OF_METRIC_TYPES x NUMBER_OF_COMPARISON_TYPES x NUMBER_OF_CATEGORY_TYPES
+    SummaryTableListFullCatalog *catalog = SummaryTableListFullCatalog_constructNull(NUMBER_OF_CATEGORY_TYPES,
+                                                                                     NUMBER_OF_METRIC_TYPES,
+                                                                                     NUMBER_OF_COMPARISON_TYPES);
+    if (header->isTruthAvailable == false && header->isPredictionAvailable == false) {
+        return catalog;
+    }
+    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+        stList *categoryNames = categoryType == CATEGORY_REGION ? header->regionNames : header->annotationNames;
+        for (int metricType = 0; metricType < NUMBER_OF_METRIC_TYPES; metricType++) {
+            for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+                if (!SummaryTableList_isTableListNeeded(header, metricType, comparisonType)) continue;
+                SummaryTableList *summaryTableList;
+                if (labelNamesWithUnknown == NULL) {
+                    summaryTableList = SummaryTableList_construct(categoryNames,
+                                                                  binArray->names,
+                                                                  numberOfLabelsWithUnknown,
+                                                                  numberOfLabelsWithUnknown);
+                } else {
+                    summaryTableList = SummaryTableList_constructByNames(categoryNames,
+                                                                         binArray->names,
+                                                                         labelNamesWithUnknown,
+                                                                         labelNamesWithUnknown);
+                }
+                SummaryTableListFullCatalog_update(catalog, summaryTableList, categoryType, metricType,
+                                                   comparisonType);
+            }
+        }
     }
+    return catalog;
+}
 
+// auN tables contain the sums of squared query block lengths
+// normalize them with the total lengths of truth labels
+static void SummaryTableListFullCatalog_normalizeAun(SummaryTableListFullCatalog *catalog) {
+    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+        SummaryTableList *auxiliarySummaryTableList = SummaryTableListFullCatalog_get(catalog,
+                                                                                      categoryType,
+                                                                                      METRIC_BASE_LEVEL,
+                                                                                      COMPARISON_TRUTH_VS_TRUTH);
+        for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+            SummaryTableList *aunTableList = SummaryTableListFullCatalog_get(catalog,
+                                                                             categoryType,
+                                                                             METRIC_AUN,
+                                                                             comparisonType);
+            if (aunTableList == NULL) continue;
+            if (auxiliarySummaryTableList == NULL) {
+                fprintf(stderr,
+                        "[%s] Error: For creating summary tables for the metric type of %s it is required to have the tables for the metric type of %s constructed and accessible beforehand.\n ",
+                        get_timestamp(),
+                        MetricTypeToString[METRIC_AUN],
+                        MetricTypeToString[METRIC_BASE_LEVEL]);
+                exit(EXIT_FAILURE);
+            }
+            SummaryTableList_normalizeAunByTotalLengths(aunTableList, auxiliarySummaryTableList);
+        }
+    }
+}
 
+stList *SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(void *iterator,
+                                                                              BlockIteratorType blockIteratorType,
+                                                                              CoverageHeader *header,
+                                                                              IntBinArray *binArray,
+                                                                              stList *labelNamesWithUnknown,
+                                                                              double overlapRatioThreshold,
+                                                                              int threads) {
     // The list of label names has an additional name "Unk" for handling labels with the value of -1
     if (labelNamesWithUnknown != NULL && stList_length(labelNamesWithUnknown) - 1 != header->numberOfLabels) {
         fprintf(stderr,
@@ -1688,55 +2011,196 @@ void SummaryTableList_createAndWriteAllTables(void *iterator,
         exit(EXIT_FAILURE);
     }
 
+    // one catalog per prediction set
+    int numberOfCatalogs = 1;
+    if (blockIteratorType == ITERATOR_BY_COV_STREAM &&
+        0 < CovStreamIterator_getNumberOfPredictionSets((CovStreamIterator *) iterator)) {
+        numberOfCatalogs = CovStreamIterator_getNumberOfPredictionSets((CovStreamIterator *) iterator);
+    }
+    stList *catalogs = stList_construct3(0, (void (*)(void *)) SummaryTableListFullCatalog_destruct);
+    for (int catalogIndex = 0; catalogIndex < numberOfCatalogs; catalogIndex++) {
+        stList_append(catalogs, SummaryTableListFullCatalog_constructEmptyTables(header,
+                                                                                binArray,
+                                                                                labelNamesWithUnknown));
+    }
+    if (header->isTruthAvailable == false && header->isPredictionAvailable == false) {
+        return catalogs;
+    }
 
-    int numberOfLabelsWithUnknown = header->numberOfLabels + 1;
-
-
-    // make a 3D array of summary table list with the dimension of
-    // NUMBER_OF_METRIC_TYPES x NUMBER_OF_COMPARISON_TYPES x NUMBER_OF_CATEGORY_TYPES
-    SummaryTableListFullCatalog *catalog = SummaryTableListFullCatalog_constructNull(NUMBER_OF_CATEGORY_TYPES,
-                                                                                     NUMBER_OF_METRIC_TYPES,
-                                                                                     NUMBER_OF_COMPARISON_TYPES);
+    // partition the blocks into contiguous ranges of units with almost the same number of blocks;
+    // a unit is a chunk for ChunkIterator and a contig for ptBlockItrPerContig.
+    // for CovStreamIterator a unit is a template chunk and the chunk lengths are used instead of
+    // the numbers of blocks since blocks are not parsed before iteration
+    int numberOfUnits = 0;
+    int *numberOfBlocksPerUnit;
+    if (blockIteratorType == ITERATOR_BY_CHUNK) {
+        numberOfBlocksPerUnit = ChunkIterator_getNumberOfBlocksPerChunk((ChunkIterator *) iterator, &numberOfUnits);
+    } else if (blockIteratorType == ITERATOR_BY_COV_BLOCK) {
+        numberOfBlocksPerUnit = ptBlockItrPerContig_get_number_of_blocks_per_contig((ptBlockItrPerContig *) iterator,
+                                                                                    &numberOfUnits);
+    } else if (blockIteratorType == ITERATOR_BY_COV_STREAM) {
+        numberOfBlocksPerUnit = CovStreamIterator_getChunkLengths((CovStreamIterator *) iterator, &numberOfUnits);
+    } else {
+        fprintf(stderr, "[%s] block iterator type is not valid.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    int64_t totalNumberOfBlocks = 0;
+    int numberOfNonEmptyUnits = 0;
+    for (int unitIndex = 0; unitIndex < numberOfUnits; unitIndex++) {
+        totalNumberOfBlocks += numberOfBlocksPerUnit[unitIndex];
+        if (0 < numberOfBlocksPerUnit[unitIndex]) numberOfNonEmptyUnits++;
+    }
+    int numberOfPartitions = threads < numberOfNonEmptyUnits ? threads : numberOfNonEmptyUnits;
+    numberOfPartitions = numberOfPartitions < 1 ? 1 : numberOfPartitions;
+    // the remaining threads will be used for splitting categories (of all catalogs) in each partition
+    int numberOfCategoryGroups = threads / numberOfPartitions;
+    int numberOfCategories = (stList_length(header->regionNames) + stList_length(header->annotationNames)) *
+                             numberOfCatalogs;
+    numberOfCategoryGroups = numberOfCategories < numberOfCategoryGroups ? numberOfCategories : numberOfCategoryGroups;
+    numberOfCategoryGroups = numberOfCategoryGroups < 1 ? 1 : numberOfCategoryGroups;
 
+    fprintf(stderr,
+            "[%s] Filling summary tables in %d partitions of blocks (each with %d category groups).\n",
+            get_timestamp(),
+            numberOfPartitions,
+            numberOfCategoryGroups);
+
+    // each partition has its own tables and they will be added after all jobs are done
+    SummaryTableListFullCatalog ***catalogsPerPartition = (SummaryTableListFullCatalog ***) malloc(
+            numberOfPartitions * sizeof(SummaryTableListFullCatalog **));
     // create a thread pool to parallelize table list creation
     tpool_t *threadPool = tpool_create(threads);
-    if (header->isTruthAvailable || header->isPredictionAvailable) {
-        // first add jobs are submitted except the ones for METRIC_AUN since
-        // this metric is dependent on METRIC_BASE_LEVEL
-        for (int metricType = 0; metricType < NUMBER_OF_METRIC_TYPES; metricType++) {
-            if (metricType == METRIC_AUN) continue;
-            // submit table creation jobs
-            SummaryTableList_addCreationJobsForOneMetricType(header,
-                                                             iterator,
-                                                             blockIteratorType,
-                                                             binArray,
-                                                             metricType,
-                                                             overlapRatioThreshold,
-                                                             numberOfLabelsWithUnknown,
-                                                             labelNamesWithUnknown,
-                                                             catalog,
-                                                             threadPool);
-        } // end loop over metric types
-	
-	// wait until all jobs are done
-        tpool_wait(threadPool);
-
-        //submit table creation jobs for METRIC_AUN
-        SummaryTableList_addCreationJobsForOneMetricType(header,
-                                                         iterator,
-                                                         blockIteratorType,
-                                                         binArray,
-                                                         METRIC_AUN,
-                                                         overlapRatioThreshold,
-                                                         numberOfLabelsWithUnknown,
-                                                         labelNamesWithUnknown,
-                                                         catalog,
-                                                         threadPool);
+    // numberOfNonEmptyUnits will be the number of non-empty units not assigned to any partition yet
+    int unitIndex = 0;
+    int lastNonEmptyUnitIndex = -1;
+    int64_t numberOfBlocksSoFar = 0;
+    for (int partitionIndex = 0; partitionIndex < numberOfPartitions; partitionIndex++) {
+        catalogsPerPartition[partitionIndex] = (SummaryTableListFullCatalog **) malloc(
+                numberOfCatalogs * sizeof(SummaryTableListFullCatalog *));
+        for (int catalogIndex = 0; catalogIndex < numberOfCatalogs; catalogIndex++) {
+            catalogsPerPartition[partitionIndex][catalogIndex] = SummaryTableListFullCatalog_constructEmptyTables(
+                    header,
+                    binArray,
+                    labelNamesWithUnknown);
+        }
+        // skip empty units
+        while (unitIndex < numberOfUnits && numberOfBlocksPerUnit[unitIndex] == 0) unitIndex++;
+        int startUnitIndex = unitIndex;
+        int preUnitIndex = lastNonEmptyUnitIndex;
+        int preBlockIndex = preUnitIndex == -1 || blockIteratorType == ITERATOR_BY_COV_STREAM ? -1 :
+                            numberOfBlocksPerUnit[preUnitIndex] - 1;
+        // the last partition takes all remaining blocks
+        int64_t endBlockIndex = partitionIndex == numberOfPartitions - 1 ? totalNumberOfBlocks :
+                                totalNumberOfBlocks * (partitionIndex + 1) / numberOfPartitions;
+        int64_t numberOfBlocks = 0;
+        // each partition has at least one non-empty unit
+        do {
+            numberOfBlocks += numberOfBlocksPerUnit[unitIndex];
+            if (0 < numberOfBlocksPerUnit[unitIndex]) {
+                lastNonEmptyUnitIndex = unitIndex;
+                numberOfNonEmptyUnits--;
+            }
+            unitIndex++;
+        } while (unitIndex < numberOfUnits &&
+                 numberOfBlocksSoFar + numberOfBlocks < endBlockIndex &&
+                 numberOfPartitions - partitionIndex - 1 < numberOfNonEmptyUnits);
+        numberOfBlocksSoFar += numberOfBlocks;
+
+        for (int categoryGroupIndex = 0; categoryGroupIndex < numberOfCategoryGroups; categoryGroupIndex++) {
+            SummaryTableCatalogUpdaterArgs *args = malloc(sizeof(SummaryTableCatalogUpdaterArgs));
+            args->blockIterator = iterator;
+            args->blockIteratorType = blockIteratorType;
+            args->catalogs = catalogsPerPartition[partitionIndex];
+            args->numberOfCatalogs = numberOfCatalogs;
+            args->sizeBinArray = binArray;
+            args->overlapThreshold = overlapRatioThreshold;
+            args->startUnitIndex = startUnitIndex;
+            args->endUnitIndex = partitionIndex == numberOfPartitions - 1 ? numberOfUnits : unitIndex;
+            args->preUnitIndex = preUnitIndex;
+            args->preBlockIndex = preBlockIndex;
+            args->categoryGroupIndex = categoryGroupIndex;
+            args->numberOfCategoryGroups = numberOfCategoryGroups;
+            // create arg struct for tpool
+            work_arg_t *argWork = malloc(sizeof(work_arg_t));
+            argWork->data = (void *) args;
+            tpool_add_work(threadPool,
+                           SummaryTableListFullCatalog_updateByOnePassForThreadPool,
+                           (void *) argWork);
+        }
     }
     // wait until all jobs are done
     tpool_wait(threadPool);
     tpool_destroy(threadPool);
+    free(numberOfBlocksPerUnit);
+
+    // merge the tables of all partitions
+    for (int partitionIndex = 0; partitionIndex < numberOfPartitions; partitionIndex++) {
+        for (int catalogIndex = 0; catalogIndex < numberOfCatalogs; catalogIndex++) {
+            SummaryTableListFullCatalog_add(stList_get(catalogs, catalogIndex),
+                                            catalogsPerPartition[partitionIndex][catalogIndex]);
+            SummaryTableListFullCatalog_destruct(catalogsPerPartition[partitionIndex][catalogIndex]);
+        }
+        free(catalogsPerPartition[partitionIndex]);
+    }
+    free(catalogsPerPartition);
 
+    for (int catalogIndex = 0; catalogIndex < numberOfCatalogs; catalogIndex++) {
+        SummaryTableListFullCatalog_normalizeAun(stList_get(catalogs, catalogIndex));
+    }
+
+    return catalogs;
+}
+
+SummaryTableListFullCatalog *SummaryTableListFullCatalog_constructAndFillAllTables(void *iterator,
+                                                                                  BlockIteratorType blockIteratorType,
+                                                                                  CoverageHeader *header,
+                                                                                  IntBinArray *binArray,
+                                                                                  stList *labelNamesWithUnknown,
+                                                                                  double overlapRatioThreshold,
+                                                                                  int threads) {
+    stList *catalogs = SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(iterator,
+                                                                                            blockIteratorType,
+                                                                                            header,
+                                                                                            binArray,
+                                                                                            labelNamesWithUnknown,
+                                                                                            overlapRatioThreshold,
+                                                                                            threads);
+    if (stList_length(catalogs) != 1) {
+        fprintf(stderr,
+                "[%s] Error: The block iterator has %d prediction sets so a single catalog cannot be filled.\n",
+                get_timestamp(),
+                stList_length(catalogs));
+        exit(EXIT_FAILURE);
+    }
+    SummaryTableListFullCatalog *catalog = stList_remove(catalogs, 0);
+    stList_destruct(catalogs);
+    return catalog;
+}
+
+void SummaryTableList_createAndWriteAllTables(void *iterator,
+                                              BlockIteratorType blockIteratorType,
+                                              CoverageHeader *header,
+                                              const char *outputPath,
+                                              const char *binArrayFilePath,
+                                              stList *labelNamesWithUnknown,
+                                              double overlapRatioThreshold,
+                                              int threads) {
+
+    IntBinArray *binArray;
+    if (binArrayFilePath != NULL) {
+        // parse bin intervals
+        binArray = IntBinArray_constructFromFile(binArrayFilePath);
+    } else {
+        binArray = IntBinArray_constructSingleBin(0, 1e9, "ALL_SIZES");
+    }
+
+    SummaryTableListFullCatalog *catalog = SummaryTableListFullCatalog_constructAndFillAllTables(iterator,
+                                                                                               blockIteratorType,
+                                                                                               header,
+                                                                                               binArray,
+                                                                                               labelNamesWithUnknown,
+                                                                                               overlapRatioThreshold,
+                                                                                               threads);
 
     SummaryTableListFullCatalog_write(catalog, header, labelNamesWithUnknown, outputPath);
 
@@ -1745,3 +2209,47 @@ void SummaryTableList_createAndWriteAllTables(void *iterator,
     // free full catalog
     SummaryTableListFullCatalog_destruct(catalog);
 }
+
+void SummaryTableList_createAndWriteAllTablesPerPredictionSet(void *iterator,
+                                                              BlockIteratorType blockIteratorType,
+                                                              CoverageHeader *header,
+                                                              stList *outputPathPerPredictionSet,
+                                                              const char *binArrayFilePath,
+                                                              stList *labelNamesWithUnknown,
+                                                              double overlapRatioThreshold,
+                                                              int threads) {
+
+    IntBinArray *binArray;
+    if (binArrayFilePath != NULL) {
+        // parse bin intervals
+        binArray = IntBinArray_constructFromFile(binArrayFilePath);
+    } else {
+        binArray = IntBinArray_constructSingleBin(0, 1e9, "ALL_SIZES");
+    }
+
+    stList *catalogs = SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(iterator,
+                                                                                            blockIteratorType,
+                                                                                            header,
+                                                                                            binArray,
+                                                                                            labelNamesWithUnknown,
+                                                                                            overlapRatioThreshold,
+                                                                                            threads);
+    if (stList_length(catalogs) != stList_length(outputPathPerPredictionSet)) {
+        fprintf(stderr, "[%s] Error: Number of output paths %d does not match the number of prediction sets %d.\n",
+                get_timestamp(),
+                stList_length(outputPathPerPredictionSet),
+                stList_length(catalogs));
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < stList_length(catalogs); i++) {
+        SummaryTableListFullCatalog_write(stList_get(catalogs, i),
+                                          header,
+                                          labelNamesWithUnknown,
+                                          stList_get(outputPathPerPredictionSet, i));
+    }
+
+    // destruct bin array
+    IntBinArray_destruct(binArray);
+    // free full catalogs
+    stList_destruct(catalogs);
+}
@@ -13,10 +13,12 @@
 #include "common.h"
 #include "chunk.h"
 #include "ptBlock.h"
+#include "cov_fast_reader.h"
 
 typedef enum BlockIteratorType {
     ITERATOR_BY_CHUNK = 0,
-    ITERATOR_BY_COV_BLOCK = 1
+    ITERATOR_BY_COV_BLOCK = 1,
+    ITERATOR_BY_COV_STREAM = 2
 } BlockIteratorType;
 
 typedef enum MetricType {
@@ -71,6 +73,12 @@ void SummaryTable_destruct(SummaryTable *summaryTable);
 
 void SummaryTable_increment(SummaryTable *summaryTable, int rowIndex, int columnIndex, double value);
 
+// divide all the values in one row by the given denominator and update the percentages
+void SummaryTable_divideRow(SummaryTable *summaryTable, int rowIndex, double denominator);
+
+// element-wise addition of the values in src to dest (for merging the tables filled by different threads)
+void SummaryTable_add(SummaryTable *dest, SummaryTable *src);
+
 double SummaryTable_getValue(SummaryTable *summaryTable, int rowIndex, int columnIndex);
 
 double SummaryTable_getTPCountInRow(SummaryTable *summaryTable, int rowIndex);
@@ -180,6 +188,34 @@ void SummaryTableList_writeFinalStatisticsIntoFile(SummaryTableList *recallTable
                                                    FILE *fout,
                                                    const char *linePrefix);
 
+// returns -1 if there is no category with the given name
+int SummaryTableList_getCategoryIndex1(SummaryTableList *summaryTableList, const char *categoryName1);
+
+int SummaryTableList_getCategoryIndex2(SummaryTableList *summaryTableList, const char *categoryName2);
+
+// F1 score of the harmonic means of recall and precision across labels (the value reported as HARMONIC_MEAN
+// or HARMONIC_MEAN_NO_HAP in the benchmarking tsv file). Returns -1 if it is not defined (NA)
+double SummaryTableList_getHarmonicMeanF1Score(SummaryTableList *recallTableList,
+                                               SummaryTableList *precisionTableList,
+                                               int catIndex1,
+                                               int catIndex2,
+                                               bool excludeHap);
+
+// harmonic mean of auN ratios across labels (the value reported as HARMONIC_MEAN in the auN ratio tsv file).
+// Returns -1 if it is not defined (NA)
+double SummaryTableList_getAunRatioHarmonicMean(SummaryTableList *numeratorTableList,
+                                                SummaryTableList *denominatorTableList,
+                                                int catIndex1,
+                                                int catIndex2);
+
+// add all tables in src to the tables in dest; both lists should have the same categories and dimensions
+void SummaryTableList_add(SummaryTableList *dest, SummaryTableList *src);
+
+// divide each row of the auN tables by the total length of the related ref label, which is taken from
+// the diagonal of the base-level table of the same ref label (auxTableList). It is used when the auN tables
+// are filled with the raw sums of squared query block lengths
+void SummaryTableList_normalizeAunByTotalLengths(SummaryTableList *aunTableList, SummaryTableList *auxTableList);
+
 void SummaryTableList_destruct(SummaryTableList *summaryTableList);
 
 
@@ -204,134 +240,167 @@ SummaryTableList *SummaryTableListFullCatalog_get(SummaryTableListFullCatalog *c
                                                   MetricType metricType,
                                                   ComparisonType comparisonType);
 
+// add all tables in src to the tables in dest (only the table lists that exist in both catalogs)
+void SummaryTableListFullCatalog_add(SummaryTableListFullCatalog *dest, SummaryTableListFullCatalog *src);
+
 void SummaryTableListFullCatalog_write(SummaryTableListFullCatalog *catalog,
                                        CoverageHeader *header,
                                        stList *labelNamesWithUnknown,
                                        char *outputPath);
 
-void SummaryTableListFullCatalog_destruct(SummaryTableListFullCatalog *catalog);
+// the scores below are computed from the tables in memory; they return -1 if the tables or the
+// categories are not available or the score is not defined
+double SummaryTableListFullCatalog_getHarmonicMeanF1Score(SummaryTableListFullCatalog *catalog,
+                                                          CategoryType categoryType,
+                                                          MetricType metricType,
+                                                          const char *categoryName1,
+                                                          const char *categoryName2,
+                                                          bool excludeHap);
 
+double SummaryTableListFullCatalog_getAunRatioHarmonicMean(SummaryTableListFullCatalog *catalog,
+                                                           CategoryType categoryType,
+                                                           const char *categoryName1,
+                                                           const char *categoryName2);
 
-typedef struct SummaryTableUpdaterArgs {
-    // a ptBlock iterator
-    // can be either ChunkIterator or ptBlockItrPerContig
-    void *blockIterator;
-
-    // a function for making a copy of the iterator
-    void *(*copyBlockIterator)(void *);
+void SummaryTableListFullCatalog_destruct(SummaryTableListFullCatalog *catalog);
 
-    // a function for resetting the iterator to start from the first block
-    void (*resetBlockIterator)(void *);
 
-    // a function for freeing iterator memory
-    void (*destructBlockIterator)(void *);
+void convertBaseLevelToOverlapBased(double *refLabelConfusionRow,
+                                    int columnSize,
+                                    int refLabelBlockLength,
+                                    double overlapThreshold);
 
-    // a function for fetching the next ptBlock from iterator
-    // can be either ChunkIterator_getNextPtBlock or ptBlockItrPerContig_next
-    ptBlock *(*getNextBlock)(void *, char *);
+/*! @typedef
+ * @abstract Structure for keeping the labels of the current and previous blocks while iterating over blocks.
+ * It can be shared between all updaters with the same comparison type since it does not depend on the category
+ */
+typedef struct SummaryTableBlockContext {
+    int start;
+    int end;
+    int refLabel;
+    int queryLabel;
+    bool contigChanged;
+    // -1 if there is no previous block
+    int preRefLabel;
+    int preQueryLabel;
+    int preBlockEnd;
+} SummaryTableBlockContext;
+
+void SummaryTableBlockContext_reset(SummaryTableBlockContext *context);
+
+// labels of the current block become the labels of the previous block
+void SummaryTableBlockContext_moveToNextBlock(SummaryTableBlockContext *context);
 
-    // a struct containing a list of summary tables
+/*! @typedef
+ * @abstract Structure for keeping the state of updating the summary tables of one category 1 index
+ * (a single table list, metric and comparison) while the blocks are being iterated
+ */
+typedef struct SummaryTableUpdater {
     SummaryTableList *summaryTableList;
-    // a struct containing the size bin intervals to stratify events based on their sizes
     IntBinArray *sizeBinArray;
-
-    // a function to check if a coverage info has overlap with a category index
-    // can be either CoverageInfo_overlapRegionIndex or CoverageInfo_overlapAnnotationIndex
-    int (*overlapFuncCategoryIndex1)(CoverageInfo *, int);
-
-    // index of category 1 to update its related sumary table. It can be either region index or annotation index
     int categoryIndex1;
-
-    // a function for getting the reference label (rows in summary table) from the
-    // Inference data embedded inside a CoverageInfo struct
-    // (it can be either get_inference_prediction_label or get_inference_truth_label)
-    // for calculating recall ref should be truth and for precision it should be prediction
-    int8_t (*getRefLabelFunction)(Inference *);
-
-    // a function for getting the query label (columns in summary table) from the
-    // Inference data embedded inside a CoverageInfo struct
-    // (it can be either get_inference_prediction_label or get_inference_truth_label)
-    // for calculating recall query should be prediction and for precision it should be truth
-    int8_t (*getQueryLabelFunction)(Inference *);
-
-    // There are two types of metric for recall and precision
-    // The default metric is base-level which is calculated by just counting the number of bases
-    // fall into each entry of the confusion matrix (represented in summary table)
-    // For example for entry[0][3] if isMetricOverlapBases=false it counts the number of bases/windows
-    // that has ref label of 0 and prediction label of 3
-    // However if this attribute is true (overlap-based metric) it counts the number of hits based on overlap threshold.
-    // For example if there is a contiguous block with a ref label of 0 and its length is 20 then if at least
-    // (overlapThreshold * 20) bases/windows in this contiguous block has the query label of 3
-    // then entry[0][3] will be incremented by one.
     MetricType metricType;
-    // the overlap ratio threshold for considering an overlap as a hit in calculating overlap-based metrics
     double overlapThreshold;
-
-    // auxiliary summary table list
-    // it can be useful when for creating one summary table we need to get some information from another table
-    // for example for METRIC_AUN, which is defined only for TRUTH_VS_PREDICTION or PREDICTION_VS_TRUTH,
-    // we need the summary table of METRIC_BASE_LEVEL for TRUTH_VS_TRUTH and PREDICTION_VS_PREDICTION respectively
-    // to compute what ratio of whole bases with a specific truth label (or prediction label) is covered by
-    // each truth label (prediction label).
+    // total lengths of ref labels for normalizing auN values (the base-level table of TRUTH_VS_TRUTH for
+    // TRUTH_VS_PREDICTION and the one of PREDICTION_VS_PREDICTION for PREDICTION_VS_TRUTH);
+    // if it is NULL the raw sums of squared query block lengths are added to the auN tables and they
+    // have to be normalized afterwards with SummaryTableList_normalizeAunByTotalLengths
     SummaryTableList *auxiliarySummaryTableList;
-} SummaryTableUpdaterArgs;
-
-SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_construct(void *blockIterator,
-                                                           void *(*copyBlockIterator)(void *),
-                                                           void *(*resetBlockIterator)(void *),
-                                                           void (*destructBlockIterator)(void *),
-                                                           ptBlock *(*getNextBlock)(void *, char *),
-                                                           SummaryTableList *summaryTableList,
-                                                           IntBinArray *sizeBinArray,
-                                                           int (*overlapFuncCategoryIndex1)(CoverageInfo *, int),
-                                                           int categoryIndex1,
-                                                           int8_t (*getRefLabelFunction)(Inference *),
-                                                           int8_t (*getQueryLabelFunction)(Inference *),
-                                                           MetricType metricType,
-                                                           double overlapThreshold,
-                                                           SummaryTableList *auxiliarySummaryTableList);
-
-SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_copy(SummaryTableUpdaterArgs *src);
-
-void SummaryTableUpdaterArgs_destruct(SummaryTableUpdaterArgs *args);
-
-void convertBaseLevelToOverlapBased(double *refLabelConfusionRow,
-                                    int columnSize,
-                                    int refLabelBlockLength,
-                                    double overlapThreshold);
-
-void SummaryTableList_addCreationJobsForAllCategory1(SummaryTableUpdaterArgs *argsTemplate, int sizeOfCategory1, tpool_t *threadPool);
-
-void SummaryTableList_updateByUpdaterArgsForThreadPool(void *argWork_);
-
-void SummaryTableList_updateByUpdaterArgs(SummaryTableUpdaterArgs *args);
-
-
-void SummaryTableList_addCreationJobsForOneMetricType(CoverageHeader *header,
-                                                      void *blockIterator,
-                                                      BlockIteratorType blockIteratorType,
-                                                      IntBinArray *sizeBinArray,
-                                                      MetricType metricType,
-                                                      double overlapRatioThreshold,
-                                                      int numberOfLabelsWithUnknown,
-                                                      stList *labelNamesWithUnknown,
-                                                      SummaryTableListFullCatalog *catalog,
-                                                      tpool_t *threadPool);
-
-
-void SummaryTableList_constructAndFillByIterator(void *blockIterator,
-                                                 BlockIteratorType blockIteratorType,
-                                                 stList *categoryNames,
-                                                 CategoryType categoryType,
-                                                 IntBinArray *sizeBinArray,
-                                                 MetricType metricType,
-                                                 double overlapRatioThreshold,
-                                                 int numberOfLabelsWithUnknown,
-                                                 stList *labelNamesWithUnknown,
-                                                 ComparisonType comparisonType,
-                                                 SummaryTableList *auxiliarySummaryTableList,
-                                                 SummaryTableListFullCatalog *catalog,
-                                                 tpool_t *threadPool);
+    // labels of the current and previous blocks
+    SummaryTableBlockContext *context;
+    // true if the blocks are partitioned and the current ref label block has started
+    // in the previous partition; such a block is counted only by the previous partition
+    bool isRefLabelBlockInherited;
+    int refLabelStart;
+    int queryLabelStart;
+    double *refLabelConfusionRow;
+    // will be used only for computing auN metric
+    stList **queryLengthsPerLabel;
+} SummaryTableUpdater;
+
+SummaryTableUpdater *SummaryTableUpdater_construct(SummaryTableList *summaryTableList,
+                                                   IntBinArray *sizeBinArray,
+                                                   int categoryIndex1,
+                                                   MetricType metricType,
+                                                   double overlapThreshold,
+                                                   SummaryTableList *auxiliarySummaryTableList,
+                                                   SummaryTableBlockContext *context);
+
+// update the state (and the tables if a ref label block has ended) with the current block in the context
+void SummaryTableUpdater_updateByBlock(SummaryTableUpdater *updater,
+                                       bool annotationInCurrent,
+                                       bool annotationInPrevious);
+
+// returns true if the ref label block that contained the previous block ends before the current block
+bool SummaryTableUpdater_isRefLabelBlockEnded(SummaryTableUpdater *updater,
+                                              bool annotationInCurrent,
+                                              bool annotationInPrevious);
+
+// used after the last block of a partition for completing the ref label block that is still open.
+// Returns true once that block has ended and the tables are updated
+bool SummaryTableUpdater_extendRefLabelBlock(SummaryTableUpdater *updater,
+                                             bool annotationInCurrent,
+                                             bool annotationInPrevious);
+
+// update the tables with the last ref label block; the context should contain the last block as the previous one
+void SummaryTableUpdater_finish(SummaryTableUpdater *updater, bool annotationInLastWindow);
+
+void SummaryTableUpdater_destruct(SummaryTableUpdater *updater);
+
+typedef struct SummaryTableCatalogUpdaterArgs {
+    // a ptBlock iterator; ChunkIterator, ptBlockItrPerContig or CovStreamIterator
+    void *blockIterator;
+    BlockIteratorType blockIteratorType;
+    // the tables of this partition; all table lists in the catalogs will be updated.
+    // there is one catalog per prediction set of the iterator (or a single catalog if the iterator
+    // has no separate prediction sets and the predictions are taken from the blocks)
+    SummaryTableListFullCatalog **catalogs;
+    int numberOfCatalogs;
+    IntBinArray *sizeBinArray;
+    double overlapThreshold;
+    // the partition contains the blocks of the units with indices in [startUnitIndex, endUnitIndex).
+    // a unit is a chunk for ChunkIterator, a contig for ptBlockItrPerContig and a template chunk for CovStreamIterator
+    int startUnitIndex;
+    int endUnitIndex;
+    // location of the last block before the partition (both -1 for the first partition).
+    // preBlockIndex is -1 for CovStreamIterator since the number of blocks per unit is not known in advance
+    int preUnitIndex;
+    int preBlockIndex;
+    // category indices (of both category types) are distributed between the category groups
+    // of a partition in a round-robin fashion and each job updates only the tables of its own categories
+    int categoryGroupIndex;
+    int numberOfCategoryGroups;
+} SummaryTableCatalogUpdaterArgs;
+
+bool SummaryTableList_isTableListNeeded(CoverageHeader *header, MetricType metricType, ComparisonType comparisonType);
+
+// iterate over the blocks of one partition and update the tables of all metric and comparison types
+// for the categories assigned to this job. A ref label block that starts in a partition is counted completely
+// by that partition even if it ends in the next partitions. auN tables are left unnormalized.
+void SummaryTableListFullCatalog_updateByOnePass(SummaryTableCatalogUpdaterArgs *args);
+
+void SummaryTableListFullCatalog_updateByOnePassForThreadPool(void *argWork_);
+
+// create all summary tables (without writing them) for each prediction set of a CovStreamIterator
+// by iterating over the blocks only once with multiple threads. Returns a list of catalogs, one per prediction set.
+// If the iterator has no prediction sets (or it is not a CovStreamIterator) the list has a single catalog
+// filled with the predictions embedded in the blocks
+stList *SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(void *iterator,
+                                                                              BlockIteratorType blockIteratorType,
+                                                                              CoverageHeader *header,
+                                                                              IntBinArray *binArray,
+                                                                              stList *labelNamesWithUnknown,
+                                                                              double overlapRatioThreshold,
+                                                                              int threads);
+
+// create all summary tables (without writing them) by iterating over the blocks with multiple threads
+SummaryTableListFullCatalog *SummaryTableListFullCatalog_constructAndFillAllTables(void *iterator,
+                                                                                  BlockIteratorType blockIteratorType,
+                                                                                  CoverageHeader *header,
+                                                                                  IntBinArray *binArray,
+                                                                                  stList *labelNamesWithUnknown,
+                                                                                  double overlapRatioThreshold,
+                                                                                  int threads);
 
 void SummaryTableList_createAndWriteAllTables(void *iterator,
                                               BlockIteratorType blockIteratorType,
@@ -342,4 +411,15 @@ void SummaryTableList_createAndWriteAllTables(void *iterator,
                                               double overlapRatioThreshold,
                                               int threads);
 
+// create and write all summary tables for each prediction set of a CovStreamIterator
+// (one output path per prediction set) by iterating over the blocks only once
+void SummaryTableList_createAndWriteAllTablesPerPredictionSet(void *iterator,
+                                                              BlockIteratorType blockIteratorType,
+                                                              CoverageHeader *header,
+                                                              stList *outputPathPerPredictionSet,
+                                                              const char *binArrayFilePath,
+                                                              stList *labelNamesWithUnknown,
+                                                              double overlapRatioThreshold,
+                                                              int threads);
+
 #endif //FLAGGER_SUMMARY_TABLE_H
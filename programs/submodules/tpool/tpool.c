@@ -175,3 +175,187 @@ void tpool_wait(tpool_t *tm)
 }
 
 
+
+
+static void wstpool_deque_push(wstpool_deque_t *deque, thread_func_t func, void *arg) {
+    pthread_mutex_lock(&(deque->mutex));
+    if (deque->head == deque->tail) {
+        deque->head = 0;
+        deque->tail = 0;
+    }
+    if (deque->tail == deque->capacity) {
+        deque->capacity = deque->capacity == 0 ? 16 : 2 * deque->capacity;
+        deque->works = realloc(deque->works, deque->capacity * sizeof(tpool_work_t));
+    }
+    deque->works[deque->tail].func = func;
+    deque->works[deque->tail].arg = arg;
+    deque->works[deque->tail].next = NULL;
+    deque->tail++;
+    pthread_mutex_unlock(&(deque->mutex));
+}
+
+// the owner takes the oldest job (the most expensive one if jobs were added longest-first).
+// running is checked under the deque lock: jobs of the next batch are pushed only after running
+// is cleared so a worker that is late from the previous batch cannot take them before wstpool_wait
+static bool wstpool_deque_pop_front(wstpool_deque_t *deque, atomic_bool *running, tpool_work_t *work) {
+    bool found = false;
+    pthread_mutex_lock(&(deque->mutex));
+    if (atomic_load(running) && deque->head < deque->tail) {
+        *work = deque->works[deque->head];
+        deque->head++;
+        found = true;
+    }
+    pthread_mutex_unlock(&(deque->mutex));
+    return found;
+}
+
+// thieves take the newest job to keep away from the owner
+static bool wstpool_deque_pop_back(wstpool_deque_t *deque, atomic_bool *running, tpool_work_t *work) {
+    bool found = false;
+    pthread_mutex_lock(&(deque->mutex));
+    if (atomic_load(running) && deque->head < deque->tail) {
+        deque->tail--;
+        *work = deque->works[deque->tail];
+        found = true;
+    }
+    pthread_mutex_unlock(&(deque->mutex));
+    return found;
+}
+
+static bool wstpool_get_work(wstpool_t *pool, size_t idx, tpool_work_t *work) {
+    if (wstpool_deque_pop_front(&(pool->deques[idx]), &(pool->running), work))
+        return true;
+    for (size_t i = 1; i < pool->thread_cnt; i++) {
+        if (wstpool_deque_pop_back(&(pool->deques[(idx + i) % pool->thread_cnt]), &(pool->running), work))
+            return true;
+    }
+    return false;
+}
+
+typedef struct wstpool_worker_arg {
+    wstpool_t *pool;
+    size_t     idx;
+} wstpool_worker_arg_t;
+
+static void *wstpool_worker(void *arg) {
+    wstpool_worker_arg_t *worker_arg = arg;
+    wstpool_t *pool = worker_arg->pool;
+    size_t idx = worker_arg->idx;
+    size_t generation = 0;
+    tpool_work_t work;
+    free(worker_arg);
+
+    while (1) {
+        pthread_mutex_lock(&(pool->mutex));
+        while (pool->generation == generation && !pool->stop)
+            pthread_cond_wait(&(pool->work_cond), &(pool->mutex));
+        if (pool->stop) {
+            pthread_mutex_unlock(&(pool->mutex));
+            break;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&(pool->mutex));
+
+        while (wstpool_get_work(pool, idx, &work)) {
+            work.func(work.arg);
+            // the last job of the batch clears running and wakes up wstpool_wait
+            if (atomic_fetch_sub(&(pool->pending_cnt), 1) == 1) {
+                pthread_mutex_lock(&(pool->mutex));
+                atomic_store(&(pool->running), false);
+                pthread_cond_broadcast(&(pool->done_cond));
+                pthread_mutex_unlock(&(pool->mutex));
+            }
+        }
+    }
+    return NULL;
+}
+
+wstpool_t *wstpool_create(size_t num) {
+    wstpool_t *pool;
+
+    if (num == 0)
+        num = 2;
+
+    pool = calloc(1, sizeof(*pool));
+    pool->thread_cnt = num;
+    pool->deques = calloc(num, sizeof(wstpool_deque_t));
+    pool->threads = malloc(num * sizeof(pthread_t));
+    atomic_init(&(pool->pending_cnt), 0);
+    atomic_init(&(pool->running), false);
+
+    pthread_mutex_init(&(pool->mutex), NULL);
+    pthread_cond_init(&(pool->work_cond), NULL);
+    pthread_cond_init(&(pool->done_cond), NULL);
+
+    for (size_t i = 0; i < num; i++) {
+        pthread_mutex_init(&(pool->deques[i].mutex), NULL);
+    }
+    for (size_t i = 0; i < num; i++) {
+        wstpool_worker_arg_t *worker_arg = malloc(sizeof(wstpool_worker_arg_t));
+        worker_arg->pool = pool;
+        worker_arg->idx = i;
+        pthread_create(&(pool->threads[i]), NULL, wstpool_worker, worker_arg);
+    }
+    return pool;
+}
+
+void wstpool_destroy(wstpool_t *pool) {
+    if (pool == NULL)
+        return;
+
+    // finish whatever is still queued
+    wstpool_wait(pool);
+
+    pthread_mutex_lock(&(pool->mutex));
+    pool->stop = true;
+    pthread_cond_broadcast(&(pool->work_cond));
+    pthread_mutex_unlock(&(pool->mutex));
+
+    for (size_t i = 0; i < pool->thread_cnt; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (size_t i = 0; i < pool->thread_cnt; i++) {
+        pthread_mutex_destroy(&(pool->deques[i].mutex));
+        free(pool->deques[i].works);
+    }
+    pthread_mutex_destroy(&(pool->mutex));
+    pthread_cond_destroy(&(pool->work_cond));
+    pthread_cond_destroy(&(pool->done_cond));
+
+    free(pool->deques);
+    free(pool->threads);
+    free(pool);
+}
+
+bool wstpool_add_work(wstpool_t *pool, thread_func_t func, void *arg) {
+    if (pool == NULL || func == NULL)
+        return false;
+
+    pthread_mutex_lock(&(pool->mutex));
+    size_t idx = pool->next_deque;
+    pool->next_deque = (pool->next_deque + 1) % pool->thread_cnt;
+    atomic_fetch_add(&(pool->pending_cnt), 1);
+    pthread_mutex_unlock(&(pool->mutex));
+
+    wstpool_deque_push(&(pool->deques[idx]), func, arg);
+    return true;
+}
+
+void wstpool_wait(wstpool_t *pool) {
+    if (pool == NULL)
+        return;
+
+    pthread_mutex_lock(&(pool->mutex));
+    if (atomic_load(&(pool->pending_cnt)) > 0) {
+        // wake up the workers for the new batch
+        pool->generation++;
+        atomic_store(&(pool->running), true);
+        pthread_cond_broadcast(&(pool->work_cond));
+    }
+    // running (not pending_cnt) is waited for so no job of the next batch is pushed before it is cleared
+    while (atomic_load(&(pool->running)))
+        pthread_cond_wait(&(pool->done_cond), &(pool->mutex));
+    // next batch starts dealing from the first worker
+    pool->next_deque = 0;
+    pthread_mutex_unlock(&(pool->mutex));
+}
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <pthread.h>
 
@@ -39,4 +40,43 @@ void tpool_destroy(tpool_t *tm);
 bool tpool_add_work(tpool_t *tm, thread_func_t func, void *arg);
 void tpool_wait(tpool_t *tm);
 
+/*
+ * Work-stealing thread pool
+ *
+ * Unlike tpool_t this pool is meant to be created once and reused for many batches of jobs.
+ * Each worker owns a deque; jobs added by wstpool_add_work are dealt to the deques in a
+ * round-robin fashion so if the jobs are added in the order of decreasing cost, every worker
+ * starts with its most expensive job. A worker pops jobs from the front of its own deque and
+ * once it is empty it steals from the back of the other deques.
+ */
+typedef struct wstpool_deque {
+    tpool_work_t    *works;
+    size_t           head;
+    size_t           tail;
+    size_t           capacity;
+    pthread_mutex_t  mutex;
+} wstpool_deque_t;
+
+typedef struct wstpool {
+    wstpool_deque_t *deques;
+    pthread_t       *threads;
+    size_t           thread_cnt;
+    size_t           next_deque;
+    atomic_size_t    pending_cnt;
+    size_t           generation;
+    atomic_bool      running; // true from releasing a batch in wstpool_wait until its last job is finished
+    pthread_mutex_t  mutex;
+    pthread_cond_t   work_cond;
+    pthread_cond_t   done_cond;
+    bool             stop;
+} wstpool_t;
+
+wstpool_t *wstpool_create(size_t num);
+void wstpool_destroy(wstpool_t *pool);
+
+// jobs are not started before calling wstpool_wait
+bool wstpool_add_work(wstpool_t *pool, thread_func_t func, void *arg);
+// start the queued jobs and block until all of them are finished
+void wstpool_wait(wstpool_t *pool);
+
 #endif /* __THREAD_POOL_H__ */
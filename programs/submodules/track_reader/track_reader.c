@@ -5,6 +5,8 @@
 #include "sonLib.h"
 #include "common.h"
 #include "track_reader.h"
+#include "hmm_utils.h"
+#include "bgzf.h"
 #include <zlib.h>
 
 # define LINE_MAX_SIZE 8192   /* line length maximum */
@@ -42,6 +44,7 @@ stList *TrackReader_parseHeaderLines(TrackReader *trackReader) {
             stList_append(headerLines, copyString(line));
         }
     }
+    free(line);
     return headerLines;
 }
 
@@ -269,6 +272,7 @@ void CoverageHeader_updateAnnotationNames(CoverageHeader *header) {
             token = Splitter_getToken(splitter); // index
             int annotationIndex = atoi(token);
             token = Splitter_getToken(splitter); //name
+            free(stList_get(header->annotationNames, annotationIndex));
             stList_set(header->annotationNames, annotationIndex, copyString(token));
             numberOfParsedNames += 1;
             Splitter_destruct(splitter);
@@ -482,7 +486,9 @@ void *TrackReader_openFile(char *filePath, TrackFileFormat format) {
 }
 
 int TrackReader_readLine(TrackReader *trackReader, char **linePtr, int maxSize) {
-    size_t len = 0;
+    // the line buffer is allocated with maxSize bytes; getline would allocate
+    // a new buffer (and leak the old one) if len was zero
+    size_t len = maxSize;
     ssize_t read = 0;
     // file can be either gz-compressed or not
     if (trackReader->trackFileFormat == TRACK_FILE_FORMAT_BED ||
@@ -816,3 +822,448 @@ int TrackReader_readNextTrackCov(TrackReader *trackReader) {
 	return read;
     }
 }
+
+
+// read the next track of an input and replace its current block
+// the block is set to NULL if there is no track left
+static void CovMerger_advanceInput(CovMerger *merger, int inputIndex) {
+    TrackReader *trackReader = merger->trackReaders[inputIndex];
+    ptBlock *preBlock = stList_get(merger->blocks, inputIndex);
+    stList_set(merger->blocks, inputIndex, NULL);
+    if (TrackReader_next(trackReader) <= 0) {
+        if (preBlock != NULL) ptBlock_destruct(preBlock);
+        return;
+    }
+    char *inputPath = stList_get(merger->inputPaths, inputIndex);
+    if (preBlock != NULL) {
+        int cmp = strcmp(trackReader->ctg, merger->contigs[inputIndex]);
+        // contigs should be sorted and tracks should be sorted and disjoint within each contig
+        if (cmp < 0 || (cmp == 0 && trackReader->s <= preBlock->rfe)) {
+            fprintf(stderr, "[%s] Error: %s is not sorted at %s:%d (contigs should be sorted by name and tracks by position).\n",
+                    get_timestamp(), inputPath, trackReader->ctg, trackReader->s + 1);
+            exit(EXIT_FAILURE);
+        }
+        ptBlock_destruct(preBlock);
+    }
+    if (trackReader->attrbsLen < 5) {
+        fprintf(stderr, "[%s] Error: %s should have coverage, annotation and region columns (%s:%d).\n",
+                get_timestamp(), inputPath, trackReader->ctg, trackReader->s + 1);
+        exit(EXIT_FAILURE);
+    }
+    strcpy(merger->contigs[inputIndex], trackReader->ctg);
+    merger->contigLengths[inputIndex] = trackReader->ctgLen;
+    ptBlock *block = ptBlock_constructFromTrackReader(trackReader, merger->headers[inputIndex]);
+    CoverageInfo *coverageInfo = block->data;
+    merger->coverageSumPerInput[inputIndex] += (double) coverageInfo->coverage * (block->rfe - block->rfs + 1);
+    stList_set(merger->blocks, inputIndex, block);
+}
+
+CovMerger *CovMerger_construct(stList *inputPaths, CovMergeMode mode) {
+    if (stList_length(inputPaths) == 0) {
+        fprintf(stderr, "[%s] Error: At least one input file should be given for merging.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+    CovMerger *merger = malloc(sizeof(CovMerger));
+    merger->mode = mode;
+    merger->numberOfInputs = stList_length(inputPaths);
+    merger->inputPaths = stList_construct3(0, free);
+    merger->trackReaders = malloc(merger->numberOfInputs * sizeof(TrackReader *));
+    merger->headers = malloc(merger->numberOfInputs * sizeof(CoverageHeader *));
+    merger->blocks = stList_construct3(merger->numberOfInputs, NULL);
+    merger->contigs = malloc(merger->numberOfInputs * sizeof(char *));
+    merger->contigLengths = Int_construct1DArray(merger->numberOfInputs);
+    merger->coverageSumPerInput = Double_construct1DArray(merger->numberOfInputs);
+    merger->numberOfRegions = 1;
+    merger->header = NULL;
+
+    for (int i = 0; i < merger->numberOfInputs; i++) {
+        char *inputPath = stList_get(inputPaths, i);
+        stList_append(merger->inputPaths, copyString(inputPath));
+        merger->headers[i] = CoverageHeader_construct(inputPath);
+        merger->trackReaders[i] = TrackReader_construct(inputPath, NULL, true);
+        merger->contigs[i] = malloc(sizeof(merger->trackReaders[i]->ctg));
+        merger->contigs[i][0] = '\0';
+        merger->contigLengths[i] = 0;
+        merger->coverageSumPerInput[i] = 0.0;
+        merger->numberOfRegions = max(merger->numberOfRegions, merger->headers[i]->numberOfRegions);
+
+        // all inputs should be made with the same annotations and in the same mode
+        CoverageHeader *firstHeader = merger->headers[0];
+        CoverageHeader *header = merger->headers[i];
+        bool isCompatible = header->numberOfAnnotations == firstHeader->numberOfAnnotations &&
+                            header->startOnlyMode == firstHeader->startOnlyMode;
+        for (int j = 0; isCompatible && j < header->numberOfAnnotations; j++) {
+            isCompatible &= strcmp(stList_get(header->annotationNames, j),
+                                   stList_get(firstHeader->annotationNames, j)) == 0;
+        }
+        if (!isCompatible) {
+            fprintf(stderr, "[%s] Error: Annotation names or start-only mode of %s do not match the ones of %s.\n",
+                    get_timestamp(), inputPath, (char *) stList_get(inputPaths, 0));
+            exit(EXIT_FAILURE);
+        }
+        // load the first track
+        CovMerger_advanceInput(merger, i);
+    }
+    merger->countDataPerRegion = CountData_construct1DArray(MAX_COVERAGE_VALUE, merger->numberOfRegions);
+    return merger;
+}
+
+void CovMerger_destruct(CovMerger *merger) {
+    for (int i = 0; i < merger->numberOfInputs; i++) {
+        if (stList_get(merger->blocks, i) != NULL) ptBlock_destruct(stList_get(merger->blocks, i));
+        TrackReader_destruct(merger->trackReaders[i]);
+        CoverageHeader_destruct(merger->headers[i]);
+        free(merger->contigs[i]);
+    }
+    free(merger->trackReaders);
+    free(merger->headers);
+    stList_destruct(merger->blocks);
+    free(merger->contigs);
+    free(merger->contigLengths);
+    free(merger->coverageSumPerInput);
+    CountData_destruct1DArray(merger->countDataPerRegion, merger->numberOfRegions);
+    if (merger->header != NULL) CoverageHeader_destruct(merger->header);
+    stList_destruct(merger->inputPaths);
+    free(merger);
+}
+
+// the smallest contig name among the current blocks of the inputs (NULL if all inputs are finished)
+static char *CovMerger_getNextContig(CovMerger *merger) {
+    char *nextContig = NULL;
+    for (int i = 0; i < merger->numberOfInputs; i++) {
+        if (stList_get(merger->blocks, i) == NULL) continue;
+        if (nextContig == NULL || strcmp(merger->contigs[i], nextContig) < 0) {
+            nextContig = merger->contigs[i];
+        }
+    }
+    return nextContig;
+}
+
+static void CovMerger_incrementRegionCounts(CovMerger *merger, int regionIndex, int value, double count) {
+    // region 0 is the whole genome baseline
+    CountData_increment(merger->countDataPerRegion[0], value, count);
+    if (0 < regionIndex && regionIndex < merger->numberOfRegions) {
+        CountData_increment(merger->countDataPerRegion[regionIndex], value, count);
+    }
+}
+
+// merge the tracks of one contig from the inputs that are currently on this contig
+// one output track is written per interval between two consecutive breakpoints of the inputs
+static void CovMerger_writeContig(CovMerger *merger,
+                                  char *contig,
+                                  FILE *fp,
+                                  CoverageInfo *mergedCoverageInfo,
+                                  char *(*get_string_function)(void *)) {
+    int contigLength = -1;
+    int numberOfInputsOnContig = 0;
+    for (int i = 0; i < merger->numberOfInputs; i++) {
+        if (stList_get(merger->blocks, i) == NULL || strcmp(merger->contigs[i], contig) != 0) continue;
+        numberOfInputsOnContig += 1;
+        if (contigLength != -1 && contigLength != merger->contigLengths[i]) {
+            fprintf(stderr, "[%s] Error: Contig %s has different lengths in the input files (%d != %d).\n",
+                    get_timestamp(), contig, contigLength, merger->contigLengths[i]);
+            exit(EXIT_FAILURE);
+        }
+        contigLength = merger->contigLengths[i];
+    }
+    if (merger->mode == COV_MERGE_UNION && 1 < numberOfInputsOnContig) {
+        fprintf(stderr, "[%s] Error: Contig %s exists in more than one input file. Use the sum mode for merging shards that are not split by contig.\n",
+                get_timestamp(), contig);
+        exit(EXIT_FAILURE);
+    }
+    // contig name is copied since the current block of the input it was taken from will be replaced
+    char *ctg = copyString(contig);
+    fprintf(fp, ">%s %d\n", ctg, contigLength);
+
+    Inference *mergedInference = mergedCoverageInfo->data;
+    int pos = -1;
+    while (true) {
+        // find the end of the next output track
+        // it is either the end of a block overlapping pos or one base before the start of the next block
+        int s = -1;
+        int e = -1;
+        int firstStart = -1;
+        for (int i = 0; i < merger->numberOfInputs; i++) {
+            ptBlock *block = stList_get(merger->blocks, i);
+            if (block == NULL || strcmp(merger->contigs[i], ctg) != 0) continue;
+            if (firstStart == -1 || block->rfs < firstStart) firstStart = block->rfs;
+        }
+        // all inputs passed this contig
+        if (firstStart == -1) break;
+        // skip the gap that is not covered by any input
+        pos = max(pos, firstStart);
+        s = pos;
+        for (int i = 0; i < merger->numberOfInputs; i++) {
+            ptBlock *block = stList_get(merger->blocks, i);
+            if (block == NULL || strcmp(merger->contigs[i], ctg) != 0) continue;
+            int end = block->rfs <= pos ? block->rfe : block->rfs - 1;
+            if (e == -1 || end < e) e = end;
+        }
+
+        // merge the blocks overlapping [s, e]
+        uint64_t annotationFlag = 0ULL;
+        int coverage = 0;
+        int coverageHighMapq = 0;
+        int coverageHighClip = 0;
+        int regionIndex = -1;
+        int8_t truth = -1;
+        int8_t prediction = -1;
+        for (int i = 0; i < merger->numberOfInputs; i++) {
+            ptBlock *block = stList_get(merger->blocks, i);
+            if (block == NULL || strcmp(merger->contigs[i], ctg) != 0 || s < block->rfs) continue;
+            CoverageInfo *coverageInfo = block->data;
+            Inference *inference = coverageInfo->data;
+            annotationFlag = AnnotationFlag_or(annotationFlag,
+                                               coverageInfo->annotation_flag & ~ANNOTATION_FLAG_REGION_MASK);
+            coverage += coverageInfo->coverage;
+            coverageHighMapq += coverageInfo->coverage_high_mapq;
+            coverageHighClip += coverageInfo->coverage_high_clip;
+            // region index and labels are taken from the first input that has them
+            if (regionIndex == -1) regionIndex = CoverageInfo_getRegionIndex(coverageInfo);
+            if (truth == -1 && inference != NULL) truth = inference->truth;
+            if (prediction == -1 && inference != NULL) prediction = inference->prediction;
+            // go to the next block of this input if this one is finished
+            if (block->rfe == e) CovMerger_advanceInput(merger, i);
+        }
+        mergedCoverageInfo->annotation_flag = annotationFlag;
+        mergedCoverageInfo->coverage = min(coverage, UINT16_MAX);
+        mergedCoverageInfo->coverage_high_mapq = min(coverageHighMapq, UINT16_MAX);
+        mergedCoverageInfo->coverage_high_clip = min(coverageHighClip, UINT16_MAX);
+        CoverageInfo_setRegionIndex(mergedCoverageInfo, regionIndex);
+        if (mergedInference != NULL) {
+            mergedInference->truth = truth;
+            mergedInference->prediction = prediction;
+        }
+        char *str = get_string_function(mergedCoverageInfo);
+        fprintf(fp, "%d\t%d\t%s\n", s + 1, e + 1, str); // 1-based in cov format
+        free(str);
+        // windows are needed for counting coverage values in the start-only mode
+        // so they are counted later from the merged tracks
+        if (!merger->headers[0]->startOnlyMode) {
+            CovMerger_incrementRegionCounts(merger, regionIndex, coverage, (double) (e - s + 1));
+        }
+        pos = e + 1;
+    }
+    free(ctg);
+}
+
+// In the start-only mode the coverage values are the number of read starts so they are summed over
+// windows of the average alignment length (similar to making chunks for the bias detector in this mode)
+static void CovMerger_countWindowsForStartOnlyMode(CovMerger *merger, char *covPath, int windowLen) {
+    TrackReader *trackReader = TrackReader_construct(covPath, NULL, true);
+    char ctg[1000];
+    ctg[0] = '\0';
+    int ctgLen = 0;
+    int windowStart = 0;
+    int windowItr = 0; // number of bases added to the current window
+    double windowSumCoverage = 0.0;
+    double *basesPerRegion = Double_construct1DArray(merger->numberOfRegions);
+    memset(basesPerRegion, 0, merger->numberOfRegions * sizeof(double));
+    bool isFinished = false;
+    while (!isFinished) {
+        isFinished = TrackReader_next(trackReader) <= 0;
+        // flush the last window of the previous contig
+        if ((isFinished || strcmp(ctg, trackReader->ctg) != 0) && 0 < windowItr) {
+            int regionIndex = Double_getArgMaxIndex1DArray(basesPerRegion, merger->numberOfRegions);
+            CovMerger_incrementRegionCounts(merger, regionIndex, (int) (windowSumCoverage * windowLen / windowItr),
+                                            (double) windowItr);
+            windowItr = 0;
+            windowSumCoverage = 0.0;
+            memset(basesPerRegion, 0, merger->numberOfRegions * sizeof(double));
+        }
+        if (isFinished) break;
+        if (strcmp(ctg, trackReader->ctg) != 0) {
+            strcpy(ctg, trackReader->ctg);
+            ctgLen = trackReader->ctgLen;
+            windowStart = 0;
+        }
+        int coverage = atoi(trackReader->attrbs[0]);
+        int regionIndex = min(atoi(trackReader->attrbs[4]), merger->numberOfRegions - 1);
+        int s = trackReader->s;
+        while (s <= trackReader->e) {
+            // skip the windows that are not covered by any track
+            if (windowStart + windowLen <= s) {
+                windowStart = s - s % windowLen;
+                if (0 < windowItr) {
+                    fprintf(stderr, "[%s] Error: Tracks in the start-only mode should cover contigs without gaps (%s:%d).\n",
+                            get_timestamp(), ctg, s + 1);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            int windowEnd = min(windowStart + windowLen, ctgLen) - 1;
+            int e = min(trackReader->e, windowEnd);
+            windowSumCoverage += (double) coverage * (e - s + 1);
+            basesPerRegion[regionIndex] += e - s + 1;
+            windowItr += e - s + 1;
+            if (e == windowEnd) {
+                int windowRegionIndex = Double_getArgMaxIndex1DArray(basesPerRegion, merger->numberOfRegions);
+                CovMerger_incrementRegionCounts(merger, windowRegionIndex,
+                                                (int) (windowSumCoverage * windowLen / windowItr),
+                                                (double) windowItr);
+                windowStart += windowLen;
+                windowItr = 0;
+                windowSumCoverage = 0.0;
+                memset(basesPerRegion, 0, merger->numberOfRegions * sizeof(double));
+            }
+            s = e + 1;
+        }
+    }
+    free(basesPerRegion);
+    TrackReader_destruct(trackReader);
+}
+
+// Average alignment length of the merged file is the total aligned bases divided by the total number of reads.
+// In the normal mode the coverage sum of each input is its number of aligned bases and in the start-only mode
+// it is its number of reads.
+static int CovMerger_getAverageAlignmentLength(CovMerger *merger) {
+    double totalBases = 0.0;
+    double totalReads = 0.0;
+    for (int i = 0; i < merger->numberOfInputs; i++) {
+        int averageAlignmentLength = merger->headers[i]->averageAlignmentLength;
+        if (averageAlignmentLength <= 0) continue;
+        if (merger->headers[i]->startOnlyMode) {
+            totalBases += merger->coverageSumPerInput[i] * averageAlignmentLength;
+            totalReads += merger->coverageSumPerInput[i];
+        } else {
+            totalBases += merger->coverageSumPerInput[i];
+            totalReads += merger->coverageSumPerInput[i] / averageAlignmentLength;
+        }
+    }
+    if (totalReads == 0.0) {
+        // inputs with no coverage
+        int averageAlignmentLength = 0;
+        for (int i = 0; i < merger->numberOfInputs; i++) {
+            averageAlignmentLength = max(averageAlignmentLength, merger->headers[i]->averageAlignmentLength);
+        }
+        return averageAlignmentLength;
+    }
+    return (int) round(totalBases / totalReads);
+}
+
+static void CovMerger_writeBuffer(void *filePtr, bool isCompressed, char *buffer, size_t len, char *outputPath) {
+    bool failed = isCompressed ? bgzf_write((BGZF *) filePtr, buffer, len) < 0 :
+                  fwrite(buffer, 1, len, (FILE *) filePtr) != len;
+    if (failed) {
+        fprintf(stderr, "[%s] Error: Failed to write into %s.\n", get_timestamp(), outputPath);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void CovMerger_write(CovMerger *merger, char *outputPath, int threads) {
+    char *extension = extractFileExtension(outputPath);
+    bool isCompressed = strcmp(extension, "cov.gz") == 0;
+    if (!isCompressed && strcmp(extension, "cov") != 0) {
+        fprintf(stderr, "[%s] Error: The output file (%s) should have one of these formats cov or cov.gz\n",
+                get_timestamp(), outputPath);
+        exit(EXIT_FAILURE);
+    }
+    free(extension);
+
+    // labels are written if at least one input has them
+    int numberOfLabels = 0;
+    bool isTruthAvailable = false;
+    bool isPredictionAvailable = false;
+    for (int i = 0; i < merger->numberOfInputs; i++) {
+        numberOfLabels = max(numberOfLabels, merger->headers[i]->numberOfLabels);
+        isTruthAvailable |= merger->headers[i]->isTruthAvailable;
+        isPredictionAvailable |= merger->headers[i]->isPredictionAvailable;
+    }
+    char *(*get_string_function)(void *);
+    if (isPredictionAvailable) {
+        get_string_function = get_string_cov_info_data_format_with_truth_and_prediction;
+    } else if (isTruthAvailable) {
+        get_string_function = get_string_cov_info_data_format_with_truth;
+    } else {
+        get_string_function = get_string_cov_info_data_format_default;
+    }
+    CoverageInfo *mergedCoverageInfo = CoverageInfo_construct(0ULL, 0, 0, 0);
+    if (isTruthAvailable || isPredictionAvailable) {
+        CoverageInfo_addInferenceData(mergedCoverageInfo, -1, -1);
+    }
+
+    // stream the merged tracks into a temporary file since the header needs the statistics of all tracks
+    char *tmpPath = malloc(strlen(outputPath) + 10);
+    sprintf(tmpPath, "%s.tmp.cov", outputPath);
+    FILE *tmpFp = fopen(tmpPath, "w");
+    if (tmpFp == NULL) {
+        fprintf(stderr, "[%s] Error: Failed to open file %s.\n", get_timestamp(), tmpPath);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "[%s] Started merging %d files (%s mode).\n", get_timestamp(), merger->numberOfInputs,
+            merger->mode == COV_MERGE_SUM ? "sum" : "union");
+    char *contig;
+    while ((contig = CovMerger_getNextContig(merger)) != NULL) {
+        CovMerger_writeContig(merger, contig, tmpFp, mergedCoverageInfo, get_string_function);
+    }
+    fclose(tmpFp);
+    CoverageInfo_destruct(mergedCoverageInfo);
+
+    // recompute header statistics
+    bool startOnlyMode = merger->headers[0]->startOnlyMode;
+    int averageAlignmentLength = CovMerger_getAverageAlignmentLength(merger);
+    if (startOnlyMode) {
+        if (averageAlignmentLength <= 0) {
+            fprintf(stderr, "[%s] Error: Average alignment length is needed for merging files in the start-only mode.\n",
+                    get_timestamp());
+            exit(EXIT_FAILURE);
+        }
+        CovMerger_countWindowsForStartOnlyMode(merger, tmpPath, averageAlignmentLength);
+    }
+    // region coverages are the most frequent coverage values of the merged tracks per region
+    // (the statistic bam2cov takes from the bias detector)
+    int *regionCoverages = Int_construct1DArray(merger->numberOfRegions);
+    for (int r = 0; r < merger->numberOfRegions; r++) {
+        regionCoverages[r] = CountData_getMostFrequentValue(merger->countDataPerRegion[r], 1, MAX_COVERAGE_VALUE);
+        // regions with no coverage
+        if (regionCoverages[r] == -1) regionCoverages[r] = 0;
+    }
+    merger->header = CoverageHeader_constructByAttributes(merger->headers[0]->annotationNames,
+                                                          regionCoverages,
+                                                          merger->numberOfRegions,
+                                                          numberOfLabels,
+                                                          isTruthAvailable,
+                                                          isPredictionAvailable,
+                                                          startOnlyMode,
+                                                          averageAlignmentLength);
+    free(regionCoverages);
+
+    // write header and then copy tracks from the temporary file
+    void *filePtr;
+    if (isCompressed) {
+        BGZF *bgzfPtr = bgzf_open(outputPath, "w");
+        if (bgzfPtr != NULL && 1 < threads) bgzf_mt(bgzfPtr, threads, 256);
+        filePtr = bgzfPtr;
+    } else {
+        filePtr = fopen(outputPath, "w");
+    }
+    if (filePtr == NULL) {
+        fprintf(stderr, "[%s] Error: Failed to open file %s.\n", get_timestamp(), outputPath);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < stList_length(merger->header->headerLines); i++) {
+        char *line = stList_get(merger->header->headerLines, i);
+        CovMerger_writeBuffer(filePtr, isCompressed, line, strlen(line), outputPath);
+        CovMerger_writeBuffer(filePtr, isCompressed, "\n", 1, outputPath);
+    }
+    tmpFp = fopen(tmpPath, "r");
+    if (tmpFp == NULL) {
+        fprintf(stderr, "[%s] Error: Failed to open file %s.\n", get_timestamp(), tmpPath);
+        exit(EXIT_FAILURE);
+    }
+    size_t bufferSize = 1 << 20;
+    char *buffer = malloc(bufferSize);
+    size_t len;
+    while ((len = fread(buffer, 1, bufferSize, tmpFp)) > 0) {
+        CovMerger_writeBuffer(filePtr, isCompressed, buffer, len, outputPath);
+    }
+    free(buffer);
+    fclose(tmpFp);
+    remove(tmpPath);
+    free(tmpPath);
+    bool failed = isCompressed ? bgzf_close((BGZF *) filePtr) != 0 : fclose((FILE *) filePtr) != 0;
+    if (failed) {
+        fprintf(stderr, "[%s] Error: Failed to close file %s.\n", get_timestamp(), outputPath);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "[%s] Merged tracks are written into %s.\n", get_timestamp(), outputPath);
+}
@@ -6,6 +6,7 @@
 #include "stdlib.h"
 #include "stdbool.h"
 #include "ptBlock.h"
+#include "count_data.h"
 
 #ifndef PT_TRACK_H
 #define PT_TRACK_H
@@ -115,4 +116,69 @@ int TrackReader_readNextTrackBed(TrackReader *trackReader);
 
 int TrackReader_readNextTrackCov(TrackReader *trackReader);
 
+
+typedef enum CovMergeMode {
+    COV_MERGE_UNION, // each contig comes from exactly one input (for example per-contig shards)
+    COV_MERGE_SUM // coverage values of all inputs are added up (for example per-read-subset shards)
+} CovMergeMode;
+
+/*! @typedef
+ * @abstract Structure for merging multiple cov/cov.gz files into one cov file. All inputs are streamed
+ *           at the same time and only the current track of each input is kept in memory so the inputs
+ *           have to be sorted by contig name (bam2cov writes contigs in this order).
+ * @field mode                      Merging mode (union or sum)
+ * @field numberOfInputs            Number of input files
+ * @field inputPaths                Paths to the input files
+ * @field trackReaders              One track reader per input (with 0-based coordinates)
+ * @field headers                   Parsed header of each input
+ * @field blocks                    Current ptBlock of each input with a CoverageInfo object as its data
+ *                                  (NULL if the input is finished)
+ * @field contigs                   Contig name of the current block of each input
+ * @field contigLengths             Contig length of the current block of each input
+ * @field coverageSumPerInput       Sum of coverage values multiplied by track lengths for each input
+ *                                  (total aligned bases or total reads in the start-only mode)
+ * @field numberOfRegions           Maximum number of regions among inputs
+ * @field countDataPerRegion        Histogram of coverage values per region in the merged tracks. Region 0
+ *                                  counts all bases (like the whole genome baseline of the bias detector)
+ * @field header                    Header of the merged file with recomputed region coverages and average
+ *                                  alignment length (NULL before CovMerger_write is called)
+ */
+typedef struct CovMerger {
+    CovMergeMode mode;
+    int numberOfInputs;
+    stList *inputPaths;
+    TrackReader **trackReaders;
+    CoverageHeader **headers;
+    stList *blocks;
+    char **contigs;
+    int *contigLengths;
+    double *coverageSumPerInput;
+    int numberOfRegions;
+    CountData **countDataPerRegion;
+    CoverageHeader *header;
+} CovMerger;
+
+/**
+ * Opens all inputs and checks that their headers are compatible (same annotation names and same start-only mode)
+ *
+ * @param inputPaths    List of cov/cov.gz paths
+ * @param mode          COV_MERGE_UNION or COV_MERGE_SUM
+ * @return merger
+ */
+CovMerger *CovMerger_construct(stList *inputPaths, CovMergeMode mode);
+
+/**
+ * Writes the merged tracks into a cov or cov.gz file. Tracks are first streamed into a temporary plain file
+ * (<outputPath>.tmp.cov) while the region coverages and the average alignment length are being recomputed and
+ * then the new header and the tracks are written into the output. The cov.gz output is written in the BGZF
+ * format with the given number of compression threads.
+ *
+ * @param merger        Merger object which is not used before
+ * @param outputPath    Path to the output file (cov or cov.gz)
+ * @param threads       Number of threads for BGZF compression
+ */
+void CovMerger_write(CovMerger *merger, char *outputPath, int threads);
+
+void CovMerger_destruct(CovMerger *merger);
+
 #endif
@@ -39,7 +39,7 @@ bool test_BiasDetector_getAnnotationToRegionMap(char *bamPath, char *jsonPath) {
 							startOnlyMode,
 							NULL);
 
-    BiasDetector_setStatisticsPerAnnotation(biasDetector, blockTable);
+    BiasDetector_setStatisticsPerAnnotation(biasDetector, blockTable, threads);
     /*for(int i=0; i < 7; i++){
         fprintf(stderr, "%s %d mod=%d tot=%d max=%d\n", stList_get(annotationNames,i), i, biasDetector->mostFrequentCoveragePerAnnotation[i], biasDetector->totalCountPerAnnotation[i], biasDetector->maxCountPerAnnotation[i]);
     }*/
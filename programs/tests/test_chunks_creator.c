@@ -229,6 +229,107 @@ bool testCreatingChunksWithLabels(char *covPath, bool doWriteAndRead) {
     return correct;
 }
 
+bool testCreatingFlankedSeqs(char *covPath, int flankLen, int expectedFlankWindows) {
+    bool correct = true;
+    int windowLen = 20;
+    int chunkCanonicalLen = 40;
+    int nThreads = 2;
+    ChunksCreator *chunksCreator = ChunksCreator_constructFromCov(covPath, NULL, chunkCanonicalLen, nThreads,
+                                                                  windowLen);
+    if (ChunksCreator_parseChunks(chunksCreator) != 0) {
+        return false;
+    }
+    stList *chunks = chunksCreator->chunks;
+    int numberOfChunks = stList_length(chunks);
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, flankLen);
+    if (stList_length(flankedSeqs) != numberOfChunks) return false;
+    for (int chunkIndex = 0; chunkIndex < numberOfChunks; chunkIndex++) {
+        Chunk *chunk = stList_get(chunks, chunkIndex);
+        ChunkFlankedSeq *flankedSeq = stList_get(flankedSeqs, chunkIndex);
+        // the core is the chunk itself
+        correct &= (flankedSeq->coreEnd - flankedSeq->coreStart == chunk->coverageInfoSeqLen);
+        for (int i = 0; i < chunk->coverageInfoSeqLen; i++) {
+            correct &= (flankedSeq->coverageInfoSeq[flankedSeq->coreStart + i] == chunk->coverageInfoSeq[i]);
+        }
+        // the flanks are the windows of the adjacent chunks of the same contig (if there is any)
+        int expectedLeftFlank = 0;
+        for (int j = chunkIndex - 1; 0 <= j && expectedLeftFlank < expectedFlankWindows; j--) {
+            Chunk *prevChunk = stList_get(chunks, j);
+            if (strcmp(prevChunk->ctg, chunk->ctg) != 0 || prevChunk->e + 1 != chunk->s) break;
+            expectedLeftFlank = min(expectedFlankWindows, prevChunk->coverageInfoSeqLen);
+            for (int i = 0; i < expectedLeftFlank; i++) {
+                correct &= (flankedSeq->coverageInfoSeq[flankedSeq->coreStart - 1 - i] ==
+                            prevChunk->coverageInfoSeq[prevChunk->coverageInfoSeqLen - 1 - i]);
+            }
+            break;
+        }
+        int expectedRightFlank = 0;
+        if (chunkIndex + 1 < numberOfChunks) {
+            Chunk *nextChunk = stList_get(chunks, chunkIndex + 1);
+            if (strcmp(nextChunk->ctg, chunk->ctg) == 0 && chunk->e + 1 == nextChunk->s) {
+                expectedRightFlank = min(expectedFlankWindows, nextChunk->coverageInfoSeqLen);
+                for (int i = 0; i < expectedRightFlank; i++) {
+                    correct &= (flankedSeq->coverageInfoSeq[flankedSeq->coreEnd + i] == nextChunk->coverageInfoSeq[i]);
+                }
+            }
+        }
+        correct &= (flankedSeq->coreStart == expectedLeftFlank);
+        correct &= (flankedSeq->coverageInfoSeqLen == flankedSeq->coreEnd + expectedRightFlank);
+    }
+    stList_destruct(flankedSeqs);
+    ChunksCreator_destruct(chunksCreator);
+    return correct;
+}
+
+
+bool testWritingAndReadingWideAnnotations(char *covPath) {
+    bool correct = true;
+    // annotation indices per window of 20 bases (-1 means no more indices)
+    int truthAnnotations[5][5] = {{3, 70, -1, -1, -1},
+                                  {99, -1, -1, -1, -1},
+                                  {2, 57, 58, -1, -1},
+                                  {1, 64, 65, 70, -1},
+                                  {70, 99, -1, -1, -1}};
+    int windowLen = 20;
+    int chunkCanonicalLen = 40;
+    ChunksCreator *chunksCreator = ChunksCreator_constructFromCov(covPath, NULL, chunkCanonicalLen, 2, windowLen);
+    if (ChunksCreator_parseChunks(chunksCreator) != 0) {
+        return false;
+    }
+    ChunksCreator_writeChunksIntoBinaryFile(chunksCreator, "tests/test_files/chunks_creator/tmp_wide.bin");
+    ChunksCreator *chunksCreatorFromBin = ChunksCreator_constructEmpty();
+    ChunksCreator_parseChunksFromBinaryFile(chunksCreatorFromBin, "tests/test_files/chunks_creator/tmp_wide.bin");
+    remove("tests/test_files/chunks_creator/tmp_wide.bin");
+
+    correct &= chunksCreatorFromBin->header->numberOfAnnotations == 100;
+    correct &= stList_length(chunksCreator->chunks) == stList_length(chunksCreatorFromBin->chunks);
+    if (!correct) return false;
+    int windowIndexInContig = 0;
+    for (int chunkIndex = 0; chunkIndex < stList_length(chunksCreator->chunks); chunkIndex++) {
+        Chunk *chunk = stList_get(chunksCreator->chunks, chunkIndex);
+        Chunk *chunkFromBin = stList_get(chunksCreatorFromBin->chunks, chunkIndex);
+        correct &= chunk->coverageInfoSeqLen == chunkFromBin->coverageInfoSeqLen;
+        if (!correct) return false;
+        for (int windowIndex = 0; windowIndex < chunk->coverageInfoSeqLen; windowIndex++) {
+            CoverageInfo *coverageInfo = chunk->coverageInfoSeq[windowIndex];
+            CoverageInfo *coverageInfoFromBin = chunkFromBin->coverageInfoSeq[windowIndex];
+            // wide annotation sets are interned again after reading so the flags should be equal
+            correct &= coverageInfo->annotation_flag == coverageInfoFromBin->annotation_flag;
+            correct &= CoverageInfo_getRegionIndex(coverageInfoFromBin) == CoverageInfo_getRegionIndex(coverageInfo);
+            int len = 0;
+            int *annotationIndices = CoverageInfo_getAnnotationIndices(coverageInfoFromBin, &len);
+            int *truth = truthAnnotations[windowIndexInContig];
+            for (int i = 0; i < 5; i++) {
+                correct &= i < len ? annotationIndices[i] == truth[i] : truth[i] == -1;
+            }
+            free(annotationIndices);
+            windowIndexInContig++;
+        }
+    }
+    ChunksCreator_destruct(chunksCreator);
+    ChunksCreator_destruct(chunksCreatorFromBin);
+    return correct;
+}
 
 int main(int argc, char *argv[]) {
 
@@ -258,6 +359,20 @@ int main(int argc, char *argv[]) {
     printf(test4Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
     allTestsPassed &= test4Passed;
 
+    // test 5
+    bool test5Passed = testCreatingFlankedSeqs("tests/test_files/chunks_creator/test_1.cov", 0, 0) &&
+                       testCreatingFlankedSeqs("tests/test_files/chunks_creator/test_1.cov", 20, 1) &&
+                       testCreatingFlankedSeqs("tests/test_files/chunks_creator/test_1.cov", 30, 2);
+    printf("[chunks_creator] Test creating chunks with flanking windows:");
+    printf(test5Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test5Passed;
+
+    // test 6
+    bool test6Passed = testWritingAndReadingWideAnnotations("tests/test_files/chunks_creator/test_wide_annotations.cov");
+    printf("[chunks_creator] Test writing and reading chunks with more than 57 annotations:");
+    printf(test6Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test6Passed;
+
 
     if (allTestsPassed)
         return 0;
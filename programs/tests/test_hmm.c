@@ -0,0 +1,199 @@
+#include "hmm.h"
+#include "chunk.h"
+#include "track_reader.h"
+#include "sonLib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+HMM *createTestModel(ModelType modelType, CoverageHeader *header) {
+    int numberOfStates = 4; // Err, Dup, Hap, and Col
+    int numberOfCompsPerState[4] = {1, 1, 1, 2};
+    double medianCoverage = header->regionCoverages[0];
+    double *regionScales = Double_construct1DArray(header->numberOfRegions);
+    for (int i = 0; i < header->numberOfRegions; i++) {
+        regionScales[i] = (double) header->regionCoverages[i] / medianCoverage;
+    }
+    double **means = Double_construct2DArray(numberOfStates, 2);
+    means[STATE_ERR][0] = medianCoverage * ERR_COMP_BINDING_COEF;
+    means[STATE_DUP][0] = medianCoverage * 0.5;
+    means[STATE_HAP][0] = medianCoverage;
+    means[STATE_COL][0] = medianCoverage * 2;
+    means[STATE_COL][1] = medianCoverage * 3;
+    MatrixDouble *alpha = MatrixDouble_construct0(numberOfStates, numberOfStates);
+    MatrixDouble_setValue(alpha, 0.0);
+    HMM *model = HMM_construct(numberOfStates,
+                               header->numberOfRegions,
+                               numberOfCompsPerState,
+                               means,
+                               regionScales,
+                               0.25,
+                               0.75,
+                               1.0,
+                               NULL,
+                               modelType,
+                               alpha,
+                               true);
+    Double_destruct2DArray(means, numberOfStates);
+    Double_destruct1DArray(regionScales);
+    return model;
+}
+
+// train a model for a few iterations and keep the EMs of the last E-step for reading posteriors
+stList *runEM(stList *flankedSeqs, HMM *model, EMPrecision precision, int numberOfIterations, wstpool_t *threadPool) {
+    stList *emPerChunk = stList_construct3(0, EM_destruct);
+    for (int chunkIndex = 0; chunkIndex < stList_length(flankedSeqs); chunkIndex++) {
+        ChunkFlankedSeq *flankedSeq = stList_get(flankedSeqs, chunkIndex);
+        EM *em = EM_construct(flankedSeq->coverageInfoSeq, flankedSeq->coverageInfoSeqLen, model, precision);
+        EM_setCore(em, flankedSeq->coreStart, flankedSeq->coreEnd);
+        em->updatePredictions = false;
+        stList_append(emPerChunk, em);
+    }
+    for (int iter = 0; iter < numberOfIterations; iter++) {
+        HMM_resetEstimators(model);
+        EM_runOneIterationForList(emPerChunk, model, threadPool);
+        HMM_estimateParameters(model, 1e-3);
+    }
+    HMM_resetEstimators(model);
+    EM_runOneIterationForList(emPerChunk, model, threadPool);
+    return emPerChunk;
+}
+
+bool testFloatPrecisionMatchesDouble(char *covPath, ModelType modelType) {
+    bool correct = true;
+    int windowLen = 100;
+    int chunkCanonicalLen = 40000;
+    int nThreads = 2;
+    int numberOfIterations = 5;
+    ChunksCreator *chunksCreator = ChunksCreator_constructFromCov(covPath, NULL, chunkCanonicalLen, nThreads,
+                                                                  windowLen);
+    if (ChunksCreator_parseChunks(chunksCreator) != 0) {
+        return false;
+    }
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, 2 * windowLen);
+    wstpool_t *threadPool = wstpool_create(nThreads);
+
+    HMM *modelDouble = createTestModel(modelType, chunksCreator->header);
+    HMM *modelFloat = createTestModel(modelType, chunksCreator->header);
+    stList *emsDouble = runEM(flankedSeqs, modelDouble, PRECISION_DOUBLE, numberOfIterations, threadPool);
+    stList *emsFloat = runEM(flankedSeqs, modelFloat, PRECISION_FLOAT, numberOfIterations, threadPool);
+
+    // loglikelihoods should be the same up to the float rounding of the matrices
+    double relativeDiff = fabs(modelDouble->loglikelihood - modelFloat->loglikelihood) /
+                          fabs(modelDouble->loglikelihood);
+    correct &= !isnan(modelFloat->loglikelihood);
+    correct &= relativeDiff < 1e-5;
+
+    // predictions should be identical and posteriors very close
+    for (int chunkIndex = 0; chunkIndex < stList_length(emsDouble); chunkIndex++) {
+        EM *emDouble = stList_get(emsDouble, chunkIndex);
+        EM *emFloat = stList_get(emsFloat, chunkIndex);
+        for (int pos = emDouble->coreStart; pos < emDouble->coreEnd; pos++) {
+            correct &= EM_getMostProbableState(emDouble, pos) == EM_getMostProbableState(emFloat, pos);
+            double *posteriorDouble = EM_getPosterior(emDouble, pos);
+            double *posteriorFloat = EM_getPosterior(emFloat, pos);
+            for (int s = 0; s < modelDouble->numberOfStates; s++) {
+                correct &= fabs(posteriorDouble[s] - posteriorFloat[s]) < 1e-3;
+            }
+            free(posteriorDouble);
+            free(posteriorFloat);
+        }
+    }
+
+    stList_destruct(emsDouble);
+    stList_destruct(emsFloat);
+    HMM_destruct(modelDouble);
+    HMM_destruct(modelFloat);
+    wstpool_destroy(threadPool);
+    stList_destruct(flankedSeqs);
+    ChunksCreator_destruct(chunksCreator);
+    return correct;
+}
+
+// conditional transition probabilities computed directly with the validity functions
+double getProbConditionalByValidityFunctions(Transition *transition, StateType preState, StateType state,
+                                             CoverageInfo *coverageInfo) {
+    double totProbValid = 0.0;
+    for (int s = 0; s < transition->numberOfStates + 1; s++) {
+        if (Transition_isStateValid(transition, s, coverageInfo)) {
+            totProbValid += Transition_getProb(transition, preState, s);
+        }
+    }
+    if (Transition_isStateValid(transition, state, coverageInfo)) {
+        return Transition_getProb(transition, preState, state) / totProbValid;
+    } else {
+        return 0.0;
+    }
+}
+
+bool testConditionalTransitionsByValidityMask(char *covPath) {
+    bool correct = true;
+    int windowLen = 100;
+    ChunksCreator *chunksCreator = ChunksCreator_constructFromCov(covPath, NULL, 40000, 2, windowLen);
+    if (ChunksCreator_parseChunks(chunksCreator) != 0) {
+        return false;
+    }
+    stList *flankedSeqs = ChunksCreator_constructFlankedSeqs(chunksCreator, 0);
+    wstpool_t *threadPool = wstpool_create(2);
+    HMM *model = createTestModel(MODEL_GAUSSIAN, chunksCreator->header);
+    // a few iterations so the transition matrices are not symmetric anymore
+    stList *emPerChunk = runEM(flankedSeqs, model, PRECISION_DOUBLE, 3, threadPool);
+    HMM_estimateParameters(model, 1e-3);
+    for (int chunkIndex = 0; chunkIndex < stList_length(emPerChunk); chunkIndex++) {
+        EM *em = stList_get(emPerChunk, chunkIndex);
+        for (int pos = 0; pos < em->seqLen; pos++) {
+            CoverageInfo *coverageInfo = em->coverageInfoSeq[pos];
+            Transition *transition = model->transitionPerRegion[CoverageInfo_getRegionIndex(coverageInfo)];
+            correct &= em->validityMasks[pos] == Transition_getValidityMask(transition, coverageInfo);
+            double *conditionalMatrix = Transition_getConditionalMatrix(transition, em->validityMasks[pos]);
+            for (int preState = 0; preState < model->numberOfStates; preState++) {
+                for (int state = 0; state < model->numberOfStates; state++) {
+                    double expected = getProbConditionalByValidityFunctions(transition, preState, state,
+                                                                            coverageInfo);
+                    correct &= conditionalMatrix[preState * model->numberOfStates + state] == expected;
+                }
+            }
+        }
+    }
+    stList_destruct(emPerChunk);
+    HMM_destruct(model);
+    wstpool_destroy(threadPool);
+    stList_destruct(flankedSeqs);
+    ChunksCreator_destruct(chunksCreator);
+    return correct;
+}
+
+int main(int argc, char *argv[]) {
+
+    bool allTestsPassed = true;
+
+    // test 1
+    bool test1Passed = testFloatPrecisionMatchesDouble("tests/test_files/hmm/test_1.cov", MODEL_GAUSSIAN);
+    printf("[hmm] Test float precision against double precision (gaussian):");
+    printf(test1Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test1Passed;
+
+    // test 2
+    bool test2Passed = testFloatPrecisionMatchesDouble("tests/test_files/hmm/test_1.cov", MODEL_TRUNC_EXP_GAUSSIAN);
+    printf("[hmm] Test float precision against double precision (trunc_exp_gaussian):");
+    printf(test2Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test2Passed;
+
+    // test 3
+    bool test3Passed = testFloatPrecisionMatchesDouble("tests/test_files/hmm/test_1.cov", MODEL_NEGATIVE_BINOMIAL);
+    printf("[hmm] Test float precision against double precision (negative_binomial):");
+    printf(test3Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test3Passed;
+
+    // test 4
+    bool test4Passed = testConditionalTransitionsByValidityMask("tests/test_files/hmm/test_1.cov");
+    printf("[hmm] Test conditional transitions by validity masks:");
+    printf(test4Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test4Passed;
+
+    if (allTestsPassed)
+        return 0;
+    else
+        return 1;
+}
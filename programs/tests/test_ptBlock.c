@@ -10,6 +10,8 @@
 #include "ptAlignment.h"
 #include "common.h"
 #include "hmm.h"
+#include <zlib.h>
+#include <utime.h>
 
 bool Test_parse_bed(char *bed_path) {
     stHash *blocks_per_contig_truth = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, NULL,
@@ -254,6 +256,390 @@ bool test_CoverageInfo_getEndingAnnotationIndices() {
 
 
 
+// make random non-overlapping coverage blocks and random (possibly overlapping) annotation blocks
+// then compare overlaying the annotation index with extending the block tables and merging them
+bool test_ptBlock_overlay_annotations_per_contig() {
+    srand(7);
+    int number_of_contigs = 3;
+    char *contig_names[3] = {"ctg1", "ctg2", "ctg3"};
+    int contig_lengths[3] = {1000, 500, 37};
+    int number_of_annotations = 12;
+
+    stHash *whole_genome_block_table = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                         (void (*)(void *)) stList_destruct);
+    stHash *coverage_block_table = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                     (void (*)(void *)) stList_destruct);
+    stList *annotation_block_table_list = stList_construct3(0, (void (*)(void *)) stHash_destruct);
+    stList_append(annotation_block_table_list, whole_genome_block_table);
+    for (int i = 1; i < number_of_annotations; i++) {
+        stList_append(annotation_block_table_list,
+                      stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                        (void (*)(void *)) stList_destruct));
+    }
+    for (int c = 0; c < number_of_contigs; c++) {
+        int len = contig_lengths[c];
+        ptBlock_add_block_to_stList_table(whole_genome_block_table, ptBlock_construct(0, len - 1, -1, -1, -1, -1),
+                                          contig_names[c]);
+        // coverage blocks with gaps of zero coverage
+        int pos = rand() % 5;
+        while (pos < len) {
+            int end = min(len - 1, pos + rand() % 20);
+            ptBlock *block = ptBlock_construct(pos, end, -1, -1, -1, -1);
+            ptBlock_set_data(block, CoverageInfo_construct(0ULL, 1 + rand() % 30, rand() % 30, rand() % 5),
+                             destruct_cov_info_data,
+                             copy_cov_info_data,
+                             extend_cov_info_data);
+            ptBlock_add_block_to_stList_table(coverage_block_table, block, contig_names[c]);
+            pos = end + 1 + (rand() % 3 == 0 ? rand() % 10 : 0);
+        }
+        // annotation blocks; one annotation has no block in the last contig
+        for (int i = 1; i < number_of_annotations; i++) {
+            if (c == number_of_contigs - 1 && i == 5) continue;
+            int number_of_blocks = 1 + rand() % 6;
+            for (int j = 0; j < number_of_blocks; j++) {
+                int start = rand() % len;
+                int end = min(len - 1, start + rand() % 200);
+                ptBlock_add_block_to_stList_table(stList_get(annotation_block_table_list, i),
+                                                  ptBlock_construct(start, end, -1, -1, -1, -1),
+                                                  contig_names[c]);
+            }
+        }
+    }
+    for (int i = 0; i < number_of_annotations; i++) {
+        ptBlock_sort_stHash_by_rfs(stList_get(annotation_block_table_list, i));
+    }
+
+    AnnotationIndex *annotation_index = AnnotationIndex_constructFromBlockTables(annotation_block_table_list);
+    stHash *overlaid_block_table = ptBlock_overlay_annotations_per_contig(coverage_block_table,
+                                                                          whole_genome_block_table,
+                                                                          annotation_index,
+                                                                          2);
+
+    // extend the coverage block table with all annotation blocks and merge them
+    add_coverage_info_to_all_annotation_block_tables(annotation_block_table_list);
+    stHash *unmerged_block_table = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                     (void (*)(void *)) stList_destruct);
+    ptBlock_extend_block_tables(unmerged_block_table, coverage_block_table);
+    for (int i = 0; i < number_of_annotations; i++) {
+        ptBlock_extend_block_tables(unmerged_block_table, stList_get(annotation_block_table_list, i));
+    }
+    ptBlock_sort_stHash_by_rfs(unmerged_block_table);
+    stHash *merged_block_table = ptBlock_merge_blocks_per_contig_by_rf_v2(unmerged_block_table);
+
+    bool correct = ptBlock_is_equal_stHash(overlaid_block_table, merged_block_table);
+    for (int c = 0; c < number_of_contigs && correct; c++) {
+        stList *overlaid_blocks = stHash_search(overlaid_block_table, contig_names[c]);
+        stList *merged_blocks = stHash_search(merged_block_table, contig_names[c]);
+        for (int i = 0; i < stList_length(overlaid_blocks); i++) {
+            CoverageInfo *cov_info_1 = ((ptBlock *) stList_get(overlaid_blocks, i))->data;
+            CoverageInfo *cov_info_2 = ((ptBlock *) stList_get(merged_blocks, i))->data;
+            correct &= cov_info_1->annotation_flag == cov_info_2->annotation_flag;
+            correct &= cov_info_1->coverage == cov_info_2->coverage;
+            correct &= cov_info_1->coverage_high_mapq == cov_info_2->coverage_high_mapq;
+            correct &= cov_info_1->coverage_high_clip == cov_info_2->coverage_high_clip;
+        }
+    }
+
+    AnnotationIndex_destruct(annotation_index);
+    stHash_destruct(overlaid_block_table);
+    stHash_destruct(merged_block_table);
+    stHash_destruct(unmerged_block_table);
+    stHash_destruct(coverage_block_table);
+    stList_destruct(annotation_block_table_list);
+    return correct;
+}
+
+
+bool is_equal_annotation_index(AnnotationIndex *annotation_index_1, AnnotationIndex *annotation_index_2) {
+    if (annotation_index_1->number_of_annotations != annotation_index_2->number_of_annotations) return false;
+    if (stHash_size(annotation_index_1->segments_per_contig) !=
+        stHash_size(annotation_index_2->segments_per_contig)) return false;
+    bool is_equal = true;
+    stHashIterator *it = stHash_getIterator(annotation_index_1->segments_per_contig);
+    char *contig_name;
+    while ((contig_name = stHash_getNext(it)) != NULL) {
+        AnnotationSegmentList *segment_list_1 = AnnotationIndex_getSegments(annotation_index_1, contig_name);
+        AnnotationSegmentList *segment_list_2 = AnnotationIndex_getSegments(annotation_index_2, contig_name);
+        is_equal &= segment_list_2 != NULL &&
+                    segment_list_1->number_of_segments == segment_list_2->number_of_segments &&
+                    memcmp(segment_list_1->segments, segment_list_2->segments,
+                           segment_list_1->number_of_segments * sizeof(AnnotationSegment)) == 0;
+    }
+    stHash_destructIterator(it);
+    return is_equal;
+}
+
+// write an annotation index, load it with mmap and check that it is invalidated after changing a bed file
+bool test_AnnotationIndex_writeAndLoad() {
+    char *bed_path = "tests/test_files/ptBlock/tmp_annotation.bed";
+    char *json_path = "tests/test_files/ptBlock/tmp_annotations.json";
+    char *index_path = "tests/test_files/ptBlock/tmp_annotations.json.index";
+    FILE *fp = fopen(bed_path, "w");
+    fprintf(fp, "ctg1\t20\t120\nctg1\t120\t130\nctg3\t5\t50\nctg4\t0\t7\n");
+    fclose(fp);
+    fp = fopen(json_path, "w");
+    fprintf(fp, "{\"annot_1\": \"tests/test_files/ptBlock/test.bed\", \"annot_2\": \"%s\"}\n", bed_path);
+    fclose(fp);
+
+    bool correct = true;
+    AnnotationIndex *annotation_index = AnnotationIndex_constructFromJson(json_path, 2);
+    correct &= annotation_index->number_of_annotations == 3;
+    correct &= AnnotationIndex_write(annotation_index, json_path, index_path);
+    AnnotationIndex *loaded_annotation_index = AnnotationIndex_load(index_path, json_path);
+    correct &= loaded_annotation_index != NULL &&
+               loaded_annotation_index->mapped_file != NULL &&
+               is_equal_annotation_index(annotation_index, loaded_annotation_index);
+    // ctg1 has both annotations in [20,49] and it is split at 120 where two blocks of annot_2 meet
+    AnnotationSegmentList *segment_list = AnnotationIndex_getSegments(annotation_index, "ctg1");
+    correct &= segment_list != NULL && segment_list->number_of_segments == 6;
+    if (correct) {
+        int expected[6][3] = {{10, 19, 1}, {20, 49, 3}, {50, 99, 2}, {100, 119, 3}, {120, 129, 3}, {130, 149, 1}};
+        for (int i = 0; i < 6; i++) {
+            correct &= segment_list->segments[i].start == expected[i][0];
+            correct &= segment_list->segments[i].end == expected[i][1];
+            correct &= segment_list->segments[i].annotation_flag == expected[i][2];
+        }
+    }
+    if (loaded_annotation_index != NULL) AnnotationIndex_destruct(loaded_annotation_index);
+    AnnotationIndex_destruct(annotation_index);
+
+    // changing a bed file should invalidate the saved index
+    fp = fopen(bed_path, "a");
+    fprintf(fp, "ctg2\t0\t5\n");
+    fclose(fp);
+    loaded_annotation_index = AnnotationIndex_load(index_path, json_path);
+    correct &= loaded_annotation_index == NULL;
+    // the index should be reconstructed and saved again
+    annotation_index = AnnotationIndex_constructWithCache(json_path, index_path, 2);
+    loaded_annotation_index = AnnotationIndex_load(index_path, json_path);
+    correct &= loaded_annotation_index != NULL &&
+               is_equal_annotation_index(annotation_index, loaded_annotation_index);
+    if (loaded_annotation_index != NULL) AnnotationIndex_destruct(loaded_annotation_index);
+    AnnotationIndex_destruct(annotation_index);
+
+    // a new modification time with the same content should keep the index valid
+    struct utimbuf times = {1000, 1000};
+    utime(bed_path, &times);
+    loaded_annotation_index = AnnotationIndex_load(index_path, json_path);
+    correct &= loaded_annotation_index != NULL;
+    if (loaded_annotation_index != NULL) AnnotationIndex_destruct(loaded_annotation_index);
+    // a different content with the same size should invalidate it
+    fp = fopen(bed_path, "w");
+    fprintf(fp, "ctg1\t20\t120\nctg1\t120\t130\nctg3\t6\t50\nctg4\t0\t7\nctg2\t0\t5\n");
+    fclose(fp);
+    times.actime = times.modtime = 2000;
+    utime(bed_path, &times);
+    loaded_annotation_index = AnnotationIndex_load(index_path, json_path);
+    correct &= loaded_annotation_index == NULL;
+
+    remove(bed_path);
+    remove(json_path);
+    remove(index_path);
+    return correct;
+}
+
+
+bool test_AnnotationFlag_wideSets() {
+    bool correct = true;
+    int x[3] = {3, 70, 130};
+    uint64_t flag = CoverageInfo_getAnnotationFlagFromArray(x, 3);
+    correct &= AnnotationFlag_isSpilled(flag);
+    // equal sets should have equal flags
+    correct &= flag == CoverageInfo_getAnnotationFlagFromArray(x, 3);
+    uint64_t flag_3 = CoverageInfo_getAnnotationFlag(3);
+    uint64_t flag_70_130 = CoverageInfo_getAnnotationFlagFromArray(x + 1, 2);
+    correct &= flag_3 == 0x4ULL;
+    correct &= AnnotationFlag_or(flag_3, flag_70_130) == flag;
+    correct &= AnnotationFlag_or(flag, flag_3) == flag;
+    correct &= AnnotationFlag_or(flag_3, CoverageInfo_getAnnotationFlag(57)) == (0x4ULL | (1ULL << 56));
+    correct &= AnnotationFlag_isSpilled(CoverageInfo_getAnnotationFlag(58));
+
+    uint64_t buffer;
+    int number_of_words = 0;
+    const uint64_t *words = AnnotationFlag_getWords(flag, &buffer, &number_of_words);
+    correct &= number_of_words == 3 && words[0] == 0x4ULL && words[1] == (1ULL << 5) && words[2] == (1ULL << 1);
+
+    // region index should be kept next to a wide set
+    CoverageInfo *covInfo = CoverageInfo_construct(flag_70_130, 0, 0, 0);
+    CoverageInfo_setRegionIndex(covInfo, 5);
+    covInfo->annotation_flag = AnnotationFlag_or(covInfo->annotation_flag, flag_3);
+    correct &= CoverageInfo_getRegionIndex(covInfo) == 5;
+    correct &= CoverageInfo_getFirstAnnotationIndex(covInfo) == 3;
+    correct &= CoverageInfo_overlapAnnotationIndex(covInfo, 70);
+    correct &= CoverageInfo_overlapAnnotationIndex(covInfo, 130);
+    correct &= !CoverageInfo_overlapAnnotationIndex(covInfo, 71);
+    correct &= !CoverageInfo_overlapAnnotationIndex(covInfo, 200);
+    correct &= !CoverageInfo_overlapAnnotationIndex(covInfo, 0);
+    int len = 0;
+    int *y = CoverageInfo_getAnnotationIndices(covInfo, &len);
+    correct &= len == 3 && y[0] == 3 && y[1] == 70 && y[2] == 130;
+    free(y);
+
+    // 70 starts and 3 ends
+    CoverageInfo *prev = CoverageInfo_construct(CoverageInfo_getAnnotationFlagFromArray(x, 1), 0, 0, 0);
+    CoverageInfo *curr = CoverageInfo_construct(CoverageInfo_getAnnotationFlag(70), 0, 0, 0);
+    y = CoverageInfo_getStartingAnnotationIndices(prev, curr, &len);
+    correct &= len == 1 && y[0] == 70;
+    free(y);
+    y = CoverageInfo_getEndingAnnotationIndices(prev, curr, &len);
+    correct &= len == 1 && y[0] == 3;
+    free(y);
+
+    CoverageInfo_destruct(prev);
+    CoverageInfo_destruct(curr);
+    CoverageInfo_destruct(covInfo);
+    return correct;
+}
+
+bool test_AnnotationIndex_writeAndLoadWideSets() {
+    char *bed_path = "tests/test_files/ptBlock/tmp_annotation_wide.bed";
+    char *json_path = "tests/test_files/ptBlock/tmp_annotations_wide.json";
+    char *index_path = "tests/test_files/ptBlock/tmp_annotations_wide.json.index";
+    FILE *fp = fopen(bed_path, "w");
+    fprintf(fp, "ctg1\t20\t120\nctg3\t5\t50\n");
+    fclose(fp);
+    // 69 annotations from test.bed and the last one from the temporary bed file
+    int number_of_beds = 70;
+    fp = fopen(json_path, "w");
+    fprintf(fp, "{");
+    for (int i = 1; i < number_of_beds; i++) {
+        fprintf(fp, "\"annot_%d\": \"tests/test_files/ptBlock/test.bed\", ", i);
+    }
+    fprintf(fp, "\"annot_%d\": \"%s\"}\n", number_of_beds, bed_path);
+    fclose(fp);
+
+    bool correct = true;
+    AnnotationIndex *annotation_index = AnnotationIndex_constructFromJson(json_path, 2);
+    correct &= annotation_index->number_of_annotations == number_of_beds + 1;
+    correct &= AnnotationIndex_write(annotation_index, json_path, index_path);
+    AnnotationIndex *loaded_annotation_index = AnnotationIndex_load(index_path, json_path);
+    correct &= loaded_annotation_index != NULL &&
+               is_equal_annotation_index(annotation_index, loaded_annotation_index);
+    // ctg1 segments: [10,19] 1-69, [20,49] 1-70, [50,99] 70, [100,119] 1-70, [120,149] 1-69
+    AnnotationSegmentList *segment_list = loaded_annotation_index == NULL ? NULL :
+                                          AnnotationIndex_getSegments(loaded_annotation_index, "ctg1");
+    correct &= segment_list != NULL && segment_list->number_of_segments == 5;
+    if (correct) {
+        int expected[5][4] = {{10, 19, 69, 0}, {20, 49, 69, 1}, {50, 99, 0, 1}, {100, 119, 69, 1},
+                              {120, 149, 69, 0}};
+        for (int i = 0; i < 5; i++) {
+            CoverageInfo *cov_info = CoverageInfo_construct(segment_list->segments[i].annotation_flag, 0, 0, 0);
+            int len = 0;
+            int *indices = CoverageInfo_getAnnotationIndices(cov_info, &len);
+            correct &= segment_list->segments[i].start == expected[i][0];
+            correct &= segment_list->segments[i].end == expected[i][1];
+            correct &= len == expected[i][2] + expected[i][3];
+            correct &= CoverageInfo_overlapAnnotationIndex(cov_info, 69) == (expected[i][2] != 0);
+            correct &= CoverageInfo_overlapAnnotationIndex(cov_info, 70) == (expected[i][3] != 0);
+            free(indices);
+            CoverageInfo_destruct(cov_info);
+        }
+    }
+    if (loaded_annotation_index != NULL) AnnotationIndex_destruct(loaded_annotation_index);
+    AnnotationIndex_destruct(annotation_index);
+
+    remove(bed_path);
+    remove(json_path);
+    remove(index_path);
+    return correct;
+}
+
+// label of the blocks in the test bed file is derived from the start so it does not depend on the order
+int get_test_bed_label(int start) {
+    return start % 3 == 0 ? -1 : start % 7 - 1;
+}
+
+bool test_ptBlock_parse_bed_multi_threaded() {
+    char *bed_path = "tests/test_files/ptBlock/tmp_large.bed";
+    char *bed_gz_path = "tests/test_files/ptBlock/tmp_large.bed.gz";
+    srand(11);
+    int number_of_lines = 200000;
+    // make the expected table in the order of lines and sort it like the single-threaded parser
+    stHash *blocks_per_contig_truth = stHash_construct3(stHash_stringKey, stHash_stringEqualKey, free,
+                                                        (void (*)(void *)) stList_destruct);
+    FILE *fp = fopen(bed_path, "w");
+    gzFile gz_fp = gzopen(bed_gz_path, "w");
+    fprintf(fp, "#header\nbrowser position ctg_0:1-1000\ntrack name=test description=\"test bed\"\n");
+    gzprintf(gz_fp, "#header\nbrowser position ctg_0:1-1000\ntrack name=test description=\"test bed\"\n");
+    char contig_name[20];
+    for (int i = 0; i < number_of_lines; i++) {
+        // track lines can also be in the middle of the file
+        if (i == number_of_lines / 2) {
+            fprintf(fp, "track name=second\n");
+            gzprintf(gz_fp, "track name=second\n");
+        }
+        sprintf(contig_name, "ctg_%d", rand() % 5);
+        int start = rand() % 1000000;
+        int end = start + 1 + rand() % 1000;
+        stList *blocks = stHash_search(blocks_per_contig_truth, contig_name);
+        if (blocks == NULL) {
+            blocks = stList_construct3(0, ptBlock_destruct);
+            stHash_insert(blocks_per_contig_truth, copyString(contig_name), blocks);
+        }
+        stList_append(blocks, ptBlock_construct(start, end - 1, -1, -1, -1, -1));
+        // no new line after the last line
+        char *new_line = i < number_of_lines - 1 ? "\n" : "";
+        if (start % 3 == 0) {
+            fprintf(fp, "%s\t%d\t%d%s", contig_name, start, end, new_line);
+            gzprintf(gz_fp, "%s\t%d\t%d%s", contig_name, start, end, new_line);
+        } else {
+            fprintf(fp, "%s\t%d\t%d\t%d\tname%s", contig_name, start, end, get_test_bed_label(start), new_line);
+            gzprintf(gz_fp, "%s\t%d\t%d\t%d\tname%s", contig_name, start, end, get_test_bed_label(start), new_line);
+        }
+    }
+    fclose(fp);
+    gzclose(gz_fp);
+    ptBlock_sort_stHash_by_rfs(blocks_per_contig_truth);
+
+    bool correct = true;
+    stHash *blocks_per_contig = ptBlock_parse_bed(bed_path);
+    correct &= ptBlock_is_equal_stHash(blocks_per_contig_truth, blocks_per_contig);
+    stHash_destruct(blocks_per_contig);
+
+    blocks_per_contig = ptBlock_parse_bed_multi_threaded(bed_path, NULL, BED_LABEL_NONE, 4);
+    correct &= ptBlock_is_equal_stHash(blocks_per_contig_truth, blocks_per_contig);
+    stHash_destruct(blocks_per_contig);
+
+    blocks_per_contig = ptBlock_parse_bed_multi_threaded(bed_gz_path, NULL, BED_LABEL_NONE, 4);
+    correct &= ptBlock_is_equal_stHash(blocks_per_contig_truth, blocks_per_contig);
+    stHash_destruct(blocks_per_contig);
+
+    // only two contigs should be parsed
+    stSet *contigs_to_include = stSet_construct3(stHash_stringKey, stHash_stringEqualKey, NULL);
+    stSet_insert(contigs_to_include, "ctg_0");
+    stSet_insert(contigs_to_include, "ctg_2");
+    blocks_per_contig = ptBlock_parse_bed_multi_threaded(bed_path, contigs_to_include, BED_LABEL_NONE, 3);
+    correct &= stHash_size(blocks_per_contig) == 2;
+    correct &= ptBlock_is_equal_stList(stHash_search(blocks_per_contig_truth, "ctg_0"),
+                                       stHash_search(blocks_per_contig, "ctg_0"));
+    correct &= ptBlock_is_equal_stList(stHash_search(blocks_per_contig_truth, "ctg_2"),
+                                       stHash_search(blocks_per_contig, "ctg_2"));
+    stHash_destruct(blocks_per_contig);
+    stSet_destruct(contigs_to_include);
+
+    // 4th column as truth labels (-1 if missing)
+    blocks_per_contig = ptBlock_parse_inference_label_blocks(bed_path, true, 4);
+    correct &= ptBlock_is_equal_stHash(blocks_per_contig_truth, blocks_per_contig);
+    stHashIterator *it = stHash_getIterator(blocks_per_contig);
+    char *contig;
+    while ((contig = stHash_getNext(it)) != NULL) {
+        stList *blocks = stHash_search(blocks_per_contig, contig);
+        for (int i = 0; i < stList_length(blocks); i++) {
+            ptBlock *block = stList_get(blocks, i);
+            CoverageInfo *cov_info = block->data;
+            correct &= get_inference_truth_label(cov_info->data) == get_test_bed_label(block->rfs);
+            correct &= get_inference_prediction_label(cov_info->data) == -1;
+        }
+    }
+    stHash_destructIterator(it);
+    stHash_destruct(blocks_per_contig);
+
+    stHash_destruct(blocks_per_contig_truth);
+    remove(bed_path);
+    remove(bed_gz_path);
+    return correct;
+}
+
 int main(int argc, char *argv[]) {
     char bed_path[200] = "tests/test_files/ptBlock/test.bed";
 
@@ -303,6 +689,36 @@ int main(int argc, char *argv[]) {
     printf("Test CoverageInfo_getEndingAnnotationIndices:");
     printf(test_CoverageInfo_getEndingAnnotationIndices_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
 
+    // test 8
+    bool test_ptBlock_overlay_annotations_per_contig_passed = test_ptBlock_overlay_annotations_per_contig();
+    all_tests_passed &= test_ptBlock_overlay_annotations_per_contig_passed;
+    printf("Test ptBlock_overlay_annotations_per_contig:");
+    printf(test_ptBlock_overlay_annotations_per_contig_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
+    // test 9
+    bool test_AnnotationIndex_writeAndLoad_passed = test_AnnotationIndex_writeAndLoad();
+    all_tests_passed &= test_AnnotationIndex_writeAndLoad_passed;
+    printf("Test AnnotationIndex_writeAndLoad:");
+    printf(test_AnnotationIndex_writeAndLoad_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
+    // test 10
+    bool test_AnnotationFlag_wideSets_passed = test_AnnotationFlag_wideSets();
+    all_tests_passed &= test_AnnotationFlag_wideSets_passed;
+    printf("Test AnnotationFlag_wideSets:");
+    printf(test_AnnotationFlag_wideSets_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
+    // test 11
+    bool test_AnnotationIndex_writeAndLoadWideSets_passed = test_AnnotationIndex_writeAndLoadWideSets();
+    all_tests_passed &= test_AnnotationIndex_writeAndLoadWideSets_passed;
+    printf("Test AnnotationIndex_writeAndLoadWideSets:");
+    printf(test_AnnotationIndex_writeAndLoadWideSets_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
+    // test 12
+    bool test_ptBlock_parse_bed_multi_threaded_passed = test_ptBlock_parse_bed_multi_threaded();
+    all_tests_passed &= test_ptBlock_parse_bed_multi_threaded_passed;
+    printf("Test ptBlock_parse_bed_multi_threaded:");
+    printf(test_ptBlock_parse_bed_multi_threaded_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
     if (all_tests_passed)
         return 0;
     else
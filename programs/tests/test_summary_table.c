@@ -6,9 +6,369 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 #include "sonLib.h"
 
 
+// Reference implementation used as an oracle: it fills the tables of one category type, metric type and
+// comparison type with one job per category that iterates over all blocks. The one-pass catalog updater of
+// summary_table.c is compared against it
+
+typedef struct SummaryTableUpdaterArgs {
+    // a ptBlock iterator
+    // can be either ChunkIterator or ptBlockItrPerContig
+    void *blockIterator;
+
+    // a function for making a copy of the iterator
+    void *(*copyBlockIterator)(void *);
+
+    // a function for resetting the iterator to start from the first block
+    void (*resetBlockIterator)(void *);
+
+    // a function for freeing iterator memory
+    void (*destructBlockIterator)(void *);
+
+    // a function for fetching the next ptBlock from iterator
+    // can be either ChunkIterator_getNextPtBlock or ptBlockItrPerContig_next
+    ptBlock *(*getNextBlock)(void *, char *);
+
+    // a struct containing a list of summary tables
+    SummaryTableList *summaryTableList;
+    // a struct containing the size bin intervals to stratify events based on their sizes
+    IntBinArray *sizeBinArray;
+
+    // a function to check if a coverage info has overlap with a category index
+    // can be either CoverageInfo_overlapRegionIndex or CoverageInfo_overlapAnnotationIndex
+    bool (*overlapFuncCategoryIndex1)(CoverageInfo *, int);
+
+    // index of category 1 to update its related sumary table. It can be either region index or annotation index
+    int categoryIndex1;
+
+    // a function for getting the reference label (rows in summary table) from the
+    // Inference data embedded inside a CoverageInfo struct
+    // (it can be either get_inference_prediction_label or get_inference_truth_label)
+    // for calculating recall ref should be truth and for precision it should be prediction
+    int8_t (*getRefLabelFunction)(Inference *);
+
+    // a function for getting the query label (columns in summary table) from the
+    // Inference data embedded inside a CoverageInfo struct
+    // (it can be either get_inference_prediction_label or get_inference_truth_label)
+    // for calculating recall query should be prediction and for precision it should be truth
+    int8_t (*getQueryLabelFunction)(Inference *);
+
+    // There are two types of metric for recall and precision
+    // The default metric is base-level which is calculated by just counting the number of bases
+    // fall into each entry of the confusion matrix (represented in summary table)
+    // For example for entry[0][3] if isMetricOverlapBases=false it counts the number of bases/windows
+    // that has ref label of 0 and prediction label of 3
+    // However if this attribute is true (overlap-based metric) it counts the number of hits based on overlap threshold.
+    // For example if there is a contiguous block with a ref label of 0 and its length is 20 then if at least
+    // (overlapThreshold * 20) bases/windows in this contiguous block has the query label of 3
+    // then entry[0][3] will be incremented by one.
+    MetricType metricType;
+    // the overlap ratio threshold for considering an overlap as a hit in calculating overlap-based metrics
+    double overlapThreshold;
+
+    // auxiliary summary table list
+    // it can be useful when for creating one summary table we need to get some information from another table
+    // for example for METRIC_AUN, which is defined only for TRUTH_VS_PREDICTION or PREDICTION_VS_TRUTH,
+    // we need the summary table of METRIC_BASE_LEVEL for TRUTH_VS_TRUTH and PREDICTION_VS_PREDICTION respectively
+    // to compute what ratio of whole bases with a specific truth label (or prediction label) is covered by
+    // each truth label (prediction label).
+    SummaryTableList *auxiliarySummaryTableList;
+} SummaryTableUpdaterArgs;
+
+SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_construct(void *blockIterator,
+                                                           void *(*copyBlockIterator)(void *),
+                                                           void *(*resetBlockIterator)(void *),
+                                                           void (*destructBlockIterator)(void *),
+                                                           ptBlock *(*getNextBlock)(void *, char *),
+                                                           SummaryTableList *summaryTableList,
+                                                           IntBinArray *sizeBinArray,
+                                                           bool (*overlapFuncCategoryIndex1)(CoverageInfo *, int),
+                                                           int categoryIndex1,
+                                                           int8_t (*getRefLabelFunction)(Inference *),
+                                                           int8_t (*getQueryLabelFunction)(Inference *),
+                                                           MetricType metricType,
+                                                           double overlapThreshold,
+                                                           SummaryTableList *auxiliarySummaryTableList);
+
+SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_copy(SummaryTableUpdaterArgs *src);
+
+void SummaryTableUpdaterArgs_destruct(SummaryTableUpdaterArgs *args);
+
+void SummaryTableList_addCreationJobsForAllCategory1(SummaryTableUpdaterArgs *argsTemplate, int sizeOfCategory1, tpool_t *threadPool);
+
+void SummaryTableList_updateByUpdaterArgsForThreadPool(void *argWork_);
+
+void SummaryTableList_updateByUpdaterArgs(SummaryTableUpdaterArgs *args);
+
+SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_construct(void *blockIterator,
+                                                           void *(*copyBlockIterator)(void *),
+                                                           void *(*resetBlockIterator)(void *),
+                                                           void (*destructBlockIterator)(void *),
+                                                           ptBlock *(*getNextBlock)(void *, char *),
+                                                           SummaryTableList *summaryTableList,
+                                                           IntBinArray *sizeBinArray,
+                                                           bool (*overlapFuncCategoryIndex1)(CoverageInfo *, int),
+                                                           int categoryIndex1,
+                                                           int8_t (*getRefLabelFunction)(Inference *),
+                                                           int8_t (*getQueryLabelFunction)(Inference *),
+                                                           MetricType metricType,
+                                                           double overlapThreshold,
+                                                           SummaryTableList *auxiliarySummaryTableList) {
+    SummaryTableUpdaterArgs *args = (SummaryTableUpdaterArgs *) malloc(1 * sizeof(SummaryTableUpdaterArgs));
+    args->blockIterator = blockIterator;
+    args->copyBlockIterator = copyBlockIterator;
+    args->resetBlockIterator = resetBlockIterator;
+    args->destructBlockIterator = destructBlockIterator;
+    args->getNextBlock = getNextBlock;
+    args->summaryTableList = summaryTableList;
+    args->sizeBinArray = sizeBinArray;
+    args->overlapFuncCategoryIndex1 = overlapFuncCategoryIndex1;
+    args->categoryIndex1 = categoryIndex1;
+    args->getRefLabelFunction = getRefLabelFunction;
+    args->getQueryLabelFunction = getQueryLabelFunction;
+    args->metricType = metricType;
+    args->overlapThreshold = overlapThreshold;
+    args->auxiliarySummaryTableList = auxiliarySummaryTableList;
+    return args;
+}
+
+SummaryTableUpdaterArgs *SummaryTableUpdaterArgs_copy(SummaryTableUpdaterArgs *src) {
+    SummaryTableUpdaterArgs *dest = (SummaryTableUpdaterArgs *) malloc(1 * sizeof(SummaryTableUpdaterArgs));
+    dest->blockIterator = src->blockIterator;
+    dest->copyBlockIterator = src->copyBlockIterator;
+    dest->resetBlockIterator = src->resetBlockIterator;
+    dest->destructBlockIterator = src->destructBlockIterator;
+    dest->getNextBlock = src->getNextBlock;
+    dest->summaryTableList = src->summaryTableList;
+    dest->sizeBinArray = src->sizeBinArray;
+    dest->overlapFuncCategoryIndex1 = src->overlapFuncCategoryIndex1;
+    dest->categoryIndex1 = src->categoryIndex1;
+    dest->getRefLabelFunction = src->getRefLabelFunction;
+    dest->getQueryLabelFunction = src->getQueryLabelFunction;
+    dest->metricType = src->metricType;
+    dest->overlapThreshold = src->overlapThreshold;
+    dest->auxiliarySummaryTableList = src->auxiliarySummaryTableList;
+    return dest;
+}
+
+void SummaryTableUpdaterArgs_destruct(SummaryTableUpdaterArgs *args) {
+    free(args);
+}
+
+
+void
+SummaryTableList_addCreationJobsForAllCategory1(SummaryTableUpdaterArgs *argsTemplate, int sizeOfCategory1,
+                                                tpool_t *threadPool) {
+    for (int categoryIndex1 = 0; categoryIndex1 < sizeOfCategory1; categoryIndex1++) {
+        // make a copy of args
+        SummaryTableUpdaterArgs *argsToRun = SummaryTableUpdaterArgs_copy(argsTemplate);
+        // set the category index 1 whose related summary table is going to be updated
+        argsToRun->categoryIndex1 = categoryIndex1;
+        // create arg struct for tpool
+        work_arg_t *argWork = malloc(sizeof(work_arg_t));
+        argWork->data = (void *) argsToRun;
+        // Add a new job to the thread pool
+        tpool_add_work(threadPool,
+                       SummaryTableList_updateByUpdaterArgsForThreadPool,
+                       (void *) argWork);
+        //fprintf(stderr, "[%s] Created thread for updating summary table for category1 index %d (out of range [0-%d])\n",
+        //        get_timestamp(), categoryIndex1, sizeOfCategory1 - 1);
+    }
+}
+
+void SummaryTableList_updateByUpdaterArgsForThreadPool(void *argWork_) {
+    // get the arguments
+    work_arg_t *argWork = argWork_;
+    SummaryTableUpdaterArgs *args = argWork->data;
+    SummaryTableList_updateByUpdaterArgs(args);
+    SummaryTableUpdaterArgs_destruct(args);
+}
+
+// blockIterator can be created by either
+// ChunkIterator_construct or ptBlockItrPerContig_construct
+void SummaryTableList_updateByUpdaterArgs(SummaryTableUpdaterArgs *args) {
+    // fetch the arguments
+    void *(*copyBlockIterator)(void *) = args->copyBlockIterator;
+    void (*resetBlockIterator)(void *) = args->resetBlockIterator;
+    void (*destructBlockIterator)(void *) = args->destructBlockIterator;
+    ptBlock *(*getNextBlock)(void *, char *) = args->getNextBlock;
+    SummaryTableList *summaryTableList = args->summaryTableList;
+    bool (*overlapFuncCategoryIndex1)(CoverageInfo *, int) = args->overlapFuncCategoryIndex1;
+    int categoryIndex1 = args->categoryIndex1;
+    int8_t(*getRefLabelFunction)(Inference * ) = args->getRefLabelFunction;
+    int8_t(*getQueryLabelFunction)(Inference * ) = args->getQueryLabelFunction;
+
+    SummaryTableBlockContext context;
+    SummaryTableBlockContext_reset(&context);
+    // in the current implementation aux table can only be the table that contains total lengths
+    // of truth labels. It is required for computing AuN ratio values.
+    SummaryTableUpdater *updater = SummaryTableUpdater_construct(summaryTableList,
+                                                                 args->sizeBinArray,
+                                                                 categoryIndex1,
+                                                                 args->metricType,
+                                                                 args->overlapThreshold,
+                                                                 args->auxiliarySummaryTableList,
+                                                                 &context);
+
+    // make a copy of iterator and reset it
+    void *blockIterator = copyBlockIterator(args->blockIterator);
+    resetBlockIterator(blockIterator);
+
+    CoverageInfo *preCoverageInfo = NULL;
+
+    char ctg[200];
+    char preCtg[200];
+    preCtg[0] = '\0';
+
+    ptBlock *block = NULL;
+
+    while ((block = getNextBlock(blockIterator, ctg)) != NULL) {
+
+        // get coverage info for this block
+        CoverageInfo *coverageInfo = (CoverageInfo *) block->data;
+
+        // get labels
+        if (coverageInfo->data == NULL) {
+            fprintf(stderr, "[%s] Warning: inference data does not exist for updating summary tables.\n",
+                    get_timestamp());
+        }
+        Inference *inference = coverageInfo->data;
+        int refLabel = getRefLabelFunction(inference);
+        // if refLabel is -1 change it to numberOfRows - 1 since last row is for "Unk"
+        context.refLabel = refLabel == -1 ? summaryTableList->numberOfRows - 1 : refLabel;
+        int queryLabel = getQueryLabelFunction(inference);
+        // if queryLabel is -1 change it to numberOfColumns - 1 since last column is for "Unk"
+        context.queryLabel = queryLabel == -1 ? summaryTableList->numberOfColumns - 1 : queryLabel;
+        context.start = block->rfs;
+        context.end = block->rfe;
+        context.contigChanged = (preCtg[0] != '\0') && (strcmp(preCtg, ctg) != 0);
+
+        SummaryTableUpdater_updateByBlock(updater,
+                                          overlapFuncCategoryIndex1(coverageInfo, categoryIndex1),
+                                          overlapFuncCategoryIndex1(preCoverageInfo, categoryIndex1));
+
+        preCoverageInfo = coverageInfo;
+        strcpy(preCtg, ctg);
+        SummaryTableBlockContext_moveToNextBlock(&context);
+    }
+
+    SummaryTableUpdater_finish(updater, overlapFuncCategoryIndex1(preCoverageInfo, categoryIndex1));
+
+    SummaryTableUpdater_destruct(updater);
+    destructBlockIterator(blockIterator);
+}
+
+void SummaryTableList_constructAndFillByIterator(void *blockIterator,
+                                                 BlockIteratorType blockIteratorType,
+                                                 stList *categoryNames,
+                                                 CategoryType categoryType,
+                                                 IntBinArray *sizeBinArray,
+                                                 MetricType metricType,
+                                                 double overlapRatioThreshold,
+                                                 int numberOfLabelsWithUnknown,
+                                                 stList *labelNamesWithUnknown,
+                                                 ComparisonType comparisonType,
+                                                 SummaryTableList *auxiliarySummaryTableList,
+                                                 SummaryTableListFullCatalog *catalog,
+                                                 tpool_t *threadPool) {
+
+    ptBlock *(*getNextBlock)(void *, char *);
+    void *(*copyIterator)(void *);
+    void (*destructIterator)(void *);
+    void (*resetIterator)(void *);
+    if (blockIteratorType == ITERATOR_BY_CHUNK) {
+        copyIterator = ChunkIterator_copy;
+        destructIterator = ChunkIterator_destruct;
+        resetIterator = ChunkIterator_reset;
+        getNextBlock = ChunkIterator_getNextPtBlock;
+    } else if (blockIteratorType == ITERATOR_BY_COV_BLOCK) {
+        copyIterator = ptBlockItrPerContig_copy;
+        destructIterator = ptBlockItrPerContig_destruct;
+        resetIterator = ptBlockItrPerContig_reset;
+        getNextBlock = ptBlockItrPerContig_next;
+    } else if (blockIteratorType == ITERATOR_BY_COV_STREAM) {
+        copyIterator = CovStreamIterator_copy;
+        destructIterator = CovStreamIterator_destruct;
+        resetIterator = CovStreamIterator_reset;
+        getNextBlock = CovStreamIterator_next;
+    } else {
+        fprintf(stderr, "[%s] block iterator type is not valid.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+
+
+    bool (*overlapFuncCategoryIndex1)(CoverageInfo *, int);
+    if (categoryType == CATEGORY_ANNOTATION) {
+        overlapFuncCategoryIndex1 = CoverageInfo_overlapAnnotationIndex;
+    } else if (categoryType == CATEGORY_REGION) {
+        overlapFuncCategoryIndex1 = CoverageInfo_overlapRegionIndex;
+    } else {
+        fprintf(stderr, "[%s] category type is not valid.\n", get_timestamp());
+        exit(EXIT_FAILURE);
+    }
+
+    int8_t(*getRefLabelFunction)(Inference * );
+    if (comparisonType == COMPARISON_TRUTH_VS_PREDICTION || comparisonType == COMPARISON_TRUTH_VS_TRUTH) {
+        getRefLabelFunction = get_inference_truth_label;
+    } else {
+        getRefLabelFunction = get_inference_prediction_label;
+    }
+
+
+    int8_t(*getQueryLabelFunction)(Inference * );
+    if (comparisonType == COMPARISON_TRUTH_VS_PREDICTION || comparisonType == COMPARISON_PREDICTION_VS_PREDICTION) {
+        getQueryLabelFunction = get_inference_prediction_label;
+    } else {
+        getQueryLabelFunction = get_inference_truth_label;
+    }
+
+    // create summary table list
+    stList *categoryNames1 = categoryNames;
+    stList *categoryNames2 = sizeBinArray->names;
+
+    int sizeOfCategory1 = stList_length(categoryNames1);
+    int numberOfRows = numberOfLabelsWithUnknown;
+    int numberOfColumns = numberOfLabelsWithUnknown;
+    SummaryTableList *summaryTableList;
+    if (labelNamesWithUnknown == NULL) {
+        summaryTableList = SummaryTableList_construct(categoryNames1,
+                                                      categoryNames2,
+                                                      numberOfRows,
+                                                      numberOfColumns);
+    } else {
+        summaryTableList = SummaryTableList_constructByNames(categoryNames1,
+                                                             categoryNames2,
+                                                             labelNamesWithUnknown,
+                                                             labelNamesWithUnknown);
+    }
+    // insert summary table list to the catalog
+    SummaryTableListFullCatalog_update(catalog, summaryTableList, categoryType, metricType, comparisonType);
+
+    // create a template of update args with category 1 index set to -1
+    SummaryTableUpdaterArgs *argsTemplate = SummaryTableUpdaterArgs_construct((void *) blockIterator,
+                                                                              copyIterator,
+                                                                              resetIterator,
+                                                                              destructIterator,
+                                                                              getNextBlock,
+                                                                              summaryTableList,
+                                                                              sizeBinArray,
+                                                                              overlapFuncCategoryIndex1,
+                                                                              -1,
+                                                                              getRefLabelFunction,
+                                                                              getQueryLabelFunction,
+                                                                              metricType,
+                                                                              overlapRatioThreshold,
+                                                                              auxiliarySummaryTableList);
+    // update all tables with multi-threading
+    SummaryTableList_addCreationJobsForAllCategory1(argsTemplate, sizeOfCategory1, threadPool);
+
+    SummaryTableUpdaterArgs_destruct(argsTemplate);
+}
+
+
 bool test_SummaryTable_increment() {
     int numberOfRows = 2;
     int numberOfColumns = 2;
@@ -481,6 +841,197 @@ int test_ptBlock_updateSummaryTableListWithIterator(const char *covPath, const c
     return correct;
 }
 
+// compare the tables filled in one pass against the tables filled per category with the
+// older per table list API (auN tables are normalized at different times so they are compared with a tolerance)
+bool isCatalogEqual(SummaryTableListFullCatalog *expectedCatalog,
+                    SummaryTableListFullCatalog *catalog,
+                    int numberOfLabelsWithUnknown) {
+    bool correct = true;
+    for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+        for (int metricType = 0; metricType < NUMBER_OF_METRIC_TYPES; metricType++) {
+            for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+                SummaryTableList *expected = SummaryTableListFullCatalog_get(expectedCatalog, categoryType,
+                                                                             metricType, comparisonType);
+                SummaryTableList *filled = SummaryTableListFullCatalog_get(catalog, categoryType, metricType,
+                                                                           comparisonType);
+                if (expected == NULL || filled == NULL) {
+                    correct &= expected == filled;
+                    continue;
+                }
+                for (int c1 = 0; c1 < expected->numberOfCategories1; c1++) {
+                    for (int c2 = 0; c2 < expected->numberOfCategories2; c2++) {
+                        for (int r = 0; r < numberOfLabelsWithUnknown; r++) {
+                            for (int q = 0; q < numberOfLabelsWithUnknown; q++) {
+                                double expectedValue = SummaryTableList_getValue(expected, c1, c2, r, q);
+                                double value = SummaryTableList_getValue(filled, c1, c2, r, q);
+                                correct &= fabs(expectedValue - value) < 1e-9;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return correct;
+}
+
+bool test_SummaryTableListFullCatalog_constructAndFillAllTables(const char *covPath,
+                                                                const char *binArrayFilePath,
+                                                                BlockIteratorType blockIteratorType,
+                                                                int threads) {
+    void *iterator;
+    CoverageHeader *header = NULL;
+    ChunksCreator *chunksCreator = NULL;
+    stHash *blocksPerContig = NULL;
+    stList *templateChunks = NULL;
+    // small chunks for having partitions that start in the middle of contigs
+    int chunkCanonicalLen = 4;
+    if (blockIteratorType == ITERATOR_BY_CHUNK) {
+        int windowLen = 1;
+        chunksCreator = ChunksCreator_constructFromCov(covPath, NULL, chunkCanonicalLen, threads, windowLen);
+        if (ChunksCreator_parseChunks(chunksCreator) != 0) {
+            return false;
+        }
+        iterator = (void *) ChunkIterator_construct(chunksCreator);
+        header = chunksCreator->header;
+    } else if (blockIteratorType == ITERATOR_BY_COV_STREAM) {
+        templateChunks = ChunksCreator_constructTemplateChunks(covPath, NULL, chunkCanonicalLen);
+        header = CoverageHeader_construct(covPath);
+        iterator = (void *) CovStreamIterator_construct(covPath, templateChunks, header);
+    } else {
+        blocksPerContig = ptBlock_parse_coverage_info_blocks(covPath);
+        iterator = (void *) ptBlockItrPerContig_construct(blocksPerContig);
+        header = CoverageHeader_construct(covPath);
+    }
+    IntBinArray *binArray = IntBinArray_constructFromFile(binArrayFilePath);
+    int numberOfLabelsWithUnknown = header->numberOfLabels + 1;
+    double overlapRatioThreshold = 0.4;
+
+    SummaryTableListFullCatalog *catalog = SummaryTableListFullCatalog_constructAndFillAllTables(iterator,
+                                                                                               blockIteratorType,
+                                                                                               header,
+                                                                                               binArray,
+                                                                                               NULL,
+                                                                                               overlapRatioThreshold,
+                                                                                               threads);
+
+    SummaryTableListFullCatalog *expectedCatalog = SummaryTableListFullCatalog_constructNull(NUMBER_OF_CATEGORY_TYPES,
+                                                                                             NUMBER_OF_METRIC_TYPES,
+                                                                                             NUMBER_OF_COMPARISON_TYPES);
+    tpool_t *threadPool = tpool_create(threads);
+    // auN tables need the base-level tables to be filled beforehand
+    for (int metricType = 0; metricType < NUMBER_OF_METRIC_TYPES; metricType++) {
+        if (metricType == METRIC_AUN) tpool_wait(threadPool);
+        for (int categoryType = 0; categoryType < NUMBER_OF_CATEGORY_TYPES; categoryType++) {
+            stList *categoryNames = categoryType == CATEGORY_REGION ? header->regionNames : header->annotationNames;
+            for (int comparisonType = 0; comparisonType < NUMBER_OF_COMPARISON_TYPES; comparisonType++) {
+                if (!SummaryTableList_isTableListNeeded(header, metricType, comparisonType)) continue;
+                SummaryTableList *auxiliarySummaryTableList = NULL;
+                if (metricType == METRIC_AUN) {
+                    auxiliarySummaryTableList = SummaryTableListFullCatalog_get(expectedCatalog,
+                                                                                categoryType,
+                                                                                METRIC_BASE_LEVEL,
+                                                                                COMPARISON_TRUTH_VS_TRUTH);
+                }
+                SummaryTableList_constructAndFillByIterator(iterator,
+                                                            blockIteratorType,
+                                                            categoryNames,
+                                                            categoryType,
+                                                            binArray,
+                                                            metricType,
+                                                            overlapRatioThreshold,
+                                                            numberOfLabelsWithUnknown,
+                                                            NULL,
+                                                            comparisonType,
+                                                            auxiliarySummaryTableList,
+                                                            expectedCatalog,
+                                                            threadPool);
+            }
+        }
+    }
+    tpool_wait(threadPool);
+    tpool_destroy(threadPool);
+
+    bool correct = isCatalogEqual(expectedCatalog, catalog, numberOfLabelsWithUnknown);
+
+    if (blockIteratorType == ITERATOR_BY_CHUNK) {
+        ChunkIterator_destruct((ChunkIterator *) iterator);
+        ChunksCreator_destruct(chunksCreator);
+    } else if (blockIteratorType == ITERATOR_BY_COV_STREAM) {
+        CovStreamIterator_destruct((CovStreamIterator *) iterator);
+        stList_destruct(templateChunks);
+        CoverageHeader_destruct(header);
+    } else {
+        ptBlockItrPerContig_destruct((ptBlockItrPerContig *) iterator);
+        stHash_destruct(blocksPerContig);
+        CoverageHeader_destruct(header);
+    }
+    IntBinArray_destruct(binArray);
+    SummaryTableListFullCatalog_destruct(catalog);
+    SummaryTableListFullCatalog_destruct(expectedCatalog);
+    return correct;
+}
+
+// fill the tables for multiple prediction bed files in one pass and compare each catalog with
+// the catalog filled with a cov file that has the same prediction labels embedded
+bool test_SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(char *covPath,
+                                                                                stList *predictionBedPaths,
+                                                                                stList *expectedCovPaths,
+                                                                                const char *binArrayFilePath,
+                                                                                int threads) {
+    // small chunks for having partitions that start in the middle of contigs
+    int chunkCanonicalLen = 4;
+    double overlapRatioThreshold = 0.4;
+    IntBinArray *binArray = IntBinArray_constructFromFile(binArrayFilePath);
+
+    stList *templateChunks = ChunksCreator_constructTemplateChunks(covPath, NULL, chunkCanonicalLen);
+    CoverageHeader *header = CoverageHeader_construct(covPath);
+    CovStreamIterator *iterator = CovStreamIterator_construct(covPath, templateChunks, header);
+    stList *predictionBlockTables = stList_construct3(0, (void (*)(void *)) stHash_destruct);
+    for (int i = 0; i < stList_length(predictionBedPaths); i++) {
+        stList_append(predictionBlockTables,
+                      ptBlock_parse_inference_label_blocks(stList_get(predictionBedPaths, i), false, 2));
+    }
+    CovStreamIterator_setPredictionSets(iterator, predictionBlockTables);
+    stList *catalogs = SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(iterator,
+                                                                                            ITERATOR_BY_COV_STREAM,
+                                                                                            header,
+                                                                                            binArray,
+                                                                                            NULL,
+                                                                                            overlapRatioThreshold,
+                                                                                            threads);
+    bool correct = stList_length(catalogs) == stList_length(expectedCovPaths);
+    for (int i = 0; i < stList_length(expectedCovPaths) && correct; i++) {
+        char *expectedCovPath = stList_get(expectedCovPaths, i);
+        stList *expectedTemplateChunks = ChunksCreator_constructTemplateChunks(expectedCovPath, NULL,
+                                                                               chunkCanonicalLen);
+        CoverageHeader *expectedHeader = CoverageHeader_construct(expectedCovPath);
+        CovStreamIterator *expectedIterator = CovStreamIterator_construct(expectedCovPath, expectedTemplateChunks,
+                                                                          expectedHeader);
+        SummaryTableListFullCatalog *expectedCatalog = SummaryTableListFullCatalog_constructAndFillAllTables(
+                expectedIterator,
+                ITERATOR_BY_COV_STREAM,
+                expectedHeader,
+                binArray,
+                NULL,
+                overlapRatioThreshold,
+                threads);
+        correct &= isCatalogEqual(expectedCatalog, stList_get(catalogs, i), expectedHeader->numberOfLabels + 1);
+        SummaryTableListFullCatalog_destruct(expectedCatalog);
+        CovStreamIterator_destruct(expectedIterator);
+        CoverageHeader_destruct(expectedHeader);
+        stList_destruct(expectedTemplateChunks);
+    }
+
+    stList_destruct(catalogs);
+    CovStreamIterator_destruct(iterator);
+    stList_destruct(predictionBlockTables);
+    stList_destruct(templateChunks);
+    CoverageHeader_destruct(header);
+    IntBinArray_destruct(binArray);
+    return correct;
+}
+
 int main(int argc, char *argv[]) {
 
     bool allTestsPassed = true;
@@ -546,6 +1097,65 @@ int main(int argc, char *argv[]) {
     printf(test8Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
     allTestsPassed &= test8Passed;
 
+    // test 9
+    bool test9Passed = test_SummaryTableListFullCatalog_constructAndFillAllTables(
+            "tests/test_files/summary_table/test_1.cov",
+            "tests/test_files/summary_table/test_1_bin_array_with_all.txt",
+            ITERATOR_BY_COV_BLOCK,
+            3);
+    printf("[summary_table] Test filling all tables in one pass against filling per category:");
+    printf(test9Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test9Passed;
+
+    // test 10
+    bool test10Passed = test_SummaryTableListFullCatalog_constructAndFillAllTables(
+            "tests/test_files/summary_table/test_1.cov",
+            "tests/test_files/summary_table/test_1_bin_array_with_all.txt",
+            ITERATOR_BY_CHUNK,
+            5);
+    printf("[summary_table] Test filling all tables in partitions of chunks against filling per category:");
+    printf(test10Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test10Passed;
+
+    // test 11
+    bool test11Passed = test_SummaryTableListFullCatalog_constructAndFillAllTables(
+            "tests/test_files/summary_table/test_1.cov",
+            "tests/test_files/summary_table/test_1_bin_array_with_all.txt",
+            ITERATOR_BY_COV_STREAM,
+            5);
+    printf("[summary_table] Test filling all tables by streaming cov chunks against filling per category:");
+    printf(test11Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test11Passed;
+
+    // test 12
+    stList *predictionBedPaths = stList_construct();
+    stList_append(predictionBedPaths, "tests/test_files/summary_table/test_1.prediction_1.bed");
+    stList_append(predictionBedPaths, "tests/test_files/summary_table/test_1.prediction_2.bed");
+    stList *expectedCovPaths = stList_construct();
+    stList_append(expectedCovPaths, "tests/test_files/summary_table/test_1.cov");
+    stList_append(expectedCovPaths, "tests/test_files/summary_table/test_1.prediction_2.cov");
+    bool test12Passed = test_SummaryTableListFullCatalog_constructAndFillAllTablesPerPredictionSet(
+            "tests/test_files/summary_table/test_1.cov",
+            predictionBedPaths,
+            expectedCovPaths,
+            "tests/test_files/summary_table/test_1_bin_array_with_all.txt",
+            5);
+    stList_destruct(predictionBedPaths);
+    stList_destruct(expectedCovPaths);
+    printf("[summary_table] Test filling all tables for multiple prediction beds in one pass:");
+    printf(test12Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test12Passed;
+
+    // test 13
+    bool test13Passed = test_SummaryTableListFullCatalog_constructAndFillAllTables(
+            "tests/test_files/summary_table/test_2.cov",
+            "tests/test_files/summary_table/test_1_bin_array_with_all.txt",
+            ITERATOR_BY_COV_STREAM,
+            4);
+    printf("[summary_table] Test filling all tables with many overlapping annotations against filling per category:");
+    printf(test13Passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+    allTestsPassed &= test13Passed;
+
     if (allTestsPassed)
         return 0;
     else
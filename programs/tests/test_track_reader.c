@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <math.h>
 
 bool testParsingCov(const char *covPath) {
     bool correct = true;
@@ -240,6 +241,184 @@ bool testReadingFromMemory(const char *covPath, const char *faiPath) {
     return correct;
 }
 
+// one string per base with the contig name, position and all attributes of the track covering it
+stList *getAttributesPerBase(char *covPath) {
+    stList *attributesPerBase = stList_construct3(0, free);
+    TrackReader *trackReader = TrackReader_construct(covPath, NULL, false);
+    char str[2000];
+    while (0 < TrackReader_next(trackReader)) {
+        for (int pos = trackReader->s; pos <= trackReader->e; pos++) {
+            int len = sprintf(str, "%s:%d/%d", trackReader->ctg, pos, trackReader->ctgLen);
+            for (int i = 0; i < trackReader->attrbsLen; i++) {
+                len += sprintf(str + len, "\t%s", trackReader->attrbs[i]);
+            }
+            stList_append(attributesPerBase, copyString(str));
+        }
+    }
+    TrackReader_destruct(trackReader);
+    return attributesPerBase;
+}
+
+bool haveSameAttributesPerBase(char *covPath1, char *covPath2) {
+    stList *attributesPerBase1 = getAttributesPerBase(covPath1);
+    stList *attributesPerBase2 = getAttributesPerBase(covPath2);
+    bool correct = stList_length(attributesPerBase1) == stList_length(attributesPerBase2);
+    for (int i = 0; correct && i < stList_length(attributesPerBase1); i++) {
+        correct &= strcmp(stList_get(attributesPerBase1, i), stList_get(attributesPerBase2, i)) == 0;
+    }
+    stList_destruct(attributesPerBase1);
+    stList_destruct(attributesPerBase2);
+    return correct;
+}
+
+// the most frequent coverage value (at least 1) per region counted over the bases of the given cov file;
+// region 0 counts all bases and regions with no covered bases get 0
+int *getMostFrequentCoveragePerRegion(char *covPath, int numberOfRegions) {
+    int maxCoverage = 1000;
+    double **countsPerRegion = Double_construct2DArray(numberOfRegions, maxCoverage + 1);
+    for (int r = 0; r < numberOfRegions; r++) {
+        memset(countsPerRegion[r], 0, (maxCoverage + 1) * sizeof(double));
+    }
+    TrackReader *trackReader = TrackReader_construct(covPath, NULL, false);
+    while (0 < TrackReader_next(trackReader)) {
+        int coverage = min(atoi(trackReader->attrbs[0]), maxCoverage);
+        int regionIndex = atoi(trackReader->attrbs[4]);
+        int length = trackReader->e - trackReader->s + 1;
+        countsPerRegion[0][coverage] += length;
+        if (0 < regionIndex && regionIndex < numberOfRegions) countsPerRegion[regionIndex][coverage] += length;
+    }
+    TrackReader_destruct(trackReader);
+    int *coveragePerRegion = Int_construct1DArray(numberOfRegions);
+    for (int r = 0; r < numberOfRegions; r++) {
+        coveragePerRegion[r] = 0;
+        for (int c = 1; c <= maxCoverage; c++) {
+            if (countsPerRegion[r][coveragePerRegion[r]] < countsPerRegion[r][c]) coveragePerRegion[r] = c;
+        }
+    }
+    Double_destruct2DArray(countsPerRegion, numberOfRegions);
+    return coveragePerRegion;
+}
+
+// write a shard of the given cov file; only the contigs for which includeContig() returns true are written
+// and coverage values are multiplied by coverageRatio. If splitTracks is true each track is split into two tracks
+// and if removeLabels is true all truth/prediction labels are set to -1. The sum of coverage values multiplied
+// by track lengths is returned.
+double writeCovShard(char *covPath, char *shardPath, bool (*includeContig)(char *), double coverageRatio,
+                     bool splitTracks, bool removeLabels, int averageAlignmentLength) {
+    CoverageHeader *header = CoverageHeader_construct(covPath);
+    CoverageHeader *shardHeader = CoverageHeader_constructByAttributes(header->annotationNames,
+                                                                       header->regionCoverages,
+                                                                       header->numberOfRegions,
+                                                                       header->numberOfLabels,
+                                                                       header->isTruthAvailable,
+                                                                       header->isPredictionAvailable,
+                                                                       header->startOnlyMode,
+                                                                       averageAlignmentLength);
+    FILE *fp = fopen(shardPath, "w");
+    CoverageHeader_writeIntoFile(shardHeader, fp, false);
+    TrackReader *trackReader = TrackReader_construct(covPath, NULL, false);
+    char preCtg[1000] = "";
+    double coverageSum = 0.0;
+    while (0 < TrackReader_next(trackReader)) {
+        if (!includeContig(trackReader->ctg)) continue;
+        if (strcmp(preCtg, trackReader->ctg) != 0) {
+            fprintf(fp, ">%s %d\n", trackReader->ctg, trackReader->ctgLen);
+            strcpy(preCtg, trackReader->ctg);
+        }
+        int coverage = (int) (atoi(trackReader->attrbs[0]) * coverageRatio);
+        int coverageHighMapq = (int) (atoi(trackReader->attrbs[1]) * coverageRatio);
+        int coverageHighClip = (int) (atoi(trackReader->attrbs[2]) * coverageRatio);
+        char labels[100] = "";
+        for (int i = 5; i < trackReader->attrbsLen; i++) {
+            strcat(labels, removeLabels ? "\t-1" : "\t");
+            if (!removeLabels) strcat(labels, trackReader->attrbs[i]);
+        }
+        int mid = splitTracks ? (trackReader->s + trackReader->e) / 2 : trackReader->e;
+        for (int k = 0; k < 2; k++) {
+            int s = k == 0 ? trackReader->s : mid + 1;
+            int e = k == 0 ? mid : trackReader->e;
+            if (e < s) continue;
+            fprintf(fp, "%d\t%d\t%d\t%d\t%d\t%s\t%s%s\n", s, e, coverage, coverageHighMapq, coverageHighClip,
+                    trackReader->attrbs[3], trackReader->attrbs[4], labels);
+            coverageSum += (double) coverage * (e - s + 1);
+        }
+    }
+    fclose(fp);
+    TrackReader_destruct(trackReader);
+    CoverageHeader_destruct(header);
+    CoverageHeader_destruct(shardHeader);
+    return coverageSum;
+}
+
+bool isFirstContig(char *contig) {
+    return strcmp(contig, "ctg1") == 0;
+}
+
+bool isNotFirstContig(char *contig) {
+    return strcmp(contig, "ctg1") != 0;
+}
+
+bool isAnyContig(char *contig) {
+    return true;
+}
+
+// the coverage values in the given cov file should be divisible by 10
+bool testMergingCovShards(char *covPath, char *outputPath) {
+    bool correct = true;
+    // per-contig shards
+    writeCovShard(covPath, "tests/test_files/track_reader/tmp_shard_1.cov", isNotFirstContig, 1.0, false, false, 0);
+    writeCovShard(covPath, "tests/test_files/track_reader/tmp_shard_2.cov", isFirstContig, 1.0, false, false, 0);
+    stList *inputPaths = stList_construct3(0, free);
+    stList_append(inputPaths, copyString("tests/test_files/track_reader/tmp_shard_1.cov"));
+    stList_append(inputPaths, copyString("tests/test_files/track_reader/tmp_shard_2.cov"));
+    CovMerger *merger = CovMerger_construct(inputPaths, COV_MERGE_UNION);
+    CovMerger_write(merger, outputPath, 2);
+    correct &= haveSameAttributesPerBase(covPath, outputPath);
+    CovMerger_destruct(merger);
+    CoverageHeader *header = CoverageHeader_construct(covPath);
+    CoverageHeader *unionHeader = CoverageHeader_construct(outputPath);
+    correct &= unionHeader->numberOfAnnotations == header->numberOfAnnotations;
+    correct &= unionHeader->numberOfRegions == header->numberOfRegions;
+    correct &= unionHeader->numberOfLabels == header->numberOfLabels;
+    correct &= unionHeader->isTruthAvailable == header->isTruthAvailable;
+    correct &= unionHeader->isPredictionAvailable == header->isPredictionAvailable;
+    // region coverages are the most frequent coverage values of the merged tracks per region
+    int *expectedRegionCoverages = getMostFrequentCoveragePerRegion(covPath, header->numberOfRegions);
+    for (int r = 0; r < header->numberOfRegions; r++) {
+        correct &= unionHeader->regionCoverages[r] == expectedRegionCoverages[r];
+    }
+
+    // read-split shards; the second one has different breakpoints and no labels
+    double coverageSum1 = writeCovShard(covPath, "tests/test_files/track_reader/tmp_shard_1.cov", isAnyContig, 0.3,
+                                        false, false, 1000);
+    double coverageSum2 = writeCovShard(covPath, "tests/test_files/track_reader/tmp_shard_2.cov", isAnyContig, 0.7,
+                                        true, true, 2000);
+    merger = CovMerger_construct(inputPaths, COV_MERGE_SUM);
+    CovMerger_write(merger, outputPath, 2);
+    correct &= haveSameAttributesPerBase(covPath, outputPath);
+    CovMerger_destruct(merger);
+    CoverageHeader *sumHeader = CoverageHeader_construct(outputPath);
+    int averageAlignmentLength = (int) round(
+            (coverageSum1 + coverageSum2) / (coverageSum1 / 1000 + coverageSum2 / 2000));
+    correct &= sumHeader->averageAlignmentLength == averageAlignmentLength;
+    // merged coverage values are the same as the ones of the original file so the region coverages are too
+    correct &= sumHeader->numberOfRegions == header->numberOfRegions;
+    for (int r = 0; r < header->numberOfRegions; r++) {
+        correct &= sumHeader->regionCoverages[r] == expectedRegionCoverages[r];
+        correct &= 0 < sumHeader->regionCoverages[r];
+    }
+
+    remove("tests/test_files/track_reader/tmp_shard_1.cov");
+    remove("tests/test_files/track_reader/tmp_shard_2.cov");
+    remove(outputPath);
+    stList_destruct(inputPaths);
+    free(expectedRegionCoverages);
+    CoverageHeader_destruct(header);
+    CoverageHeader_destruct(unionHeader);
+    CoverageHeader_destruct(sumHeader);
+    return correct;
+}
+
 
 int main(int argc, char *argv[]) {
 
@@ -288,6 +467,18 @@ int main(int argc, char *argv[]) {
     printf("Test reading from memory with TrackReader:");
     printf(testReadingFromMemory_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
 
+    bool testMergingCovShards_passed = testMergingCovShards("tests/test_files/summary_table/test_2.cov",
+                                                            "tests/test_files/track_reader/tmp_merged.cov");
+    all_tests_passed &= testMergingCovShards_passed;
+    printf("Test merging cov shards in union and sum modes:");
+    printf(testMergingCovShards_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
+    bool testMergingCovShardsCompressed_passed = testMergingCovShards("tests/test_files/summary_table/test_2.cov",
+                                                                      "tests/test_files/track_reader/tmp_merged.cov.gz");
+    all_tests_passed &= testMergingCovShardsCompressed_passed;
+    printf("Test merging cov shards into a compressed file:");
+    printf(testMergingCovShardsCompressed_passed ? "\x1B[32m OK \x1B[0m\n" : "\x1B[31m FAIL \x1B[0m\n");
+
     if (all_tests_passed)
         return 0;
     else
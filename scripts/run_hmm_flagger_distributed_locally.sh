@@ -0,0 +1,76 @@
+#!/bin/bash
+
+# Run distributed EM of hmm_flagger with several local processes. Contigs are dealt
+# into shards with similar total lengths; each shard runs one E-step per iteration (--eStepOnly)
+# and the sufficient statistics are summed by the reducer (--reduceStats) to make the next model.
+# The initial model is made once (--initModel) so all shards start from the same model.
+# At the end the final inference is run on each shard with the last model.
+#
+# Usage: run_hmm_flagger_distributed_locally.sh <COV_FILE> <OUTPUT_DIR> <NUMBER_OF_SHARDS> <ITERATIONS> [OTHER_HMM_FLAGGER_OPTIONS]
+#   OTHER_HMM_FLAGGER_OPTIONS should include --collapsedComps (or --loadModel for the initial model)
+#   and --labelNames if the coverage file has truth labels
+#   The hmm_flagger binary can be set with the HMM_FLAGGER environment variable
+
+set -e
+
+COV_FILE=$1
+OUTPUT_DIR=$2
+NUMBER_OF_SHARDS=$3
+ITERATIONS=$4
+shift 4
+OTHER_OPTIONS="$@"
+HMM_FLAGGER=${HMM_FLAGGER:-hmm_flagger}
+
+mkdir -p ${OUTPUT_DIR}/shards
+# deal contigs into shards (longest contig first into the shard with the smallest total length)
+if [[ ${COV_FILE} == *.gz ]]; then CAT=zcat; else CAT=cat; fi
+${CAT} ${COV_FILE} | grep "^>" | sed 's/^>//' | sort -k2,2nr | \
+    awk -v n=${NUMBER_OF_SHARDS} -v dir=${OUTPUT_DIR}/shards '{
+        best = 0
+        for (i = 1; i < n; i++) if (len[i] < len[best]) best = i
+        len[best] += $2
+        print $1 > (dir"/shard_"best".txt")
+    }'
+
+# a model created in each shard would be seeded differently so the initial model is made once
+if [[ " ${OTHER_OPTIONS} " == *" --loadModel "* ]]; then
+    MODEL_OPTION=""
+else
+    ${HMM_FLAGGER} --input ${COV_FILE} --outputDir ${OUTPUT_DIR} --initModel ${OUTPUT_DIR}/model_initial.bin \
+        ${OTHER_OPTIONS} 2> ${OUTPUT_DIR}/init_model.log
+    MODEL_OPTION="--loadModel ${OUTPUT_DIR}/model_initial.bin"
+fi
+for ((ITER = 1; ITER <= ITERATIONS; ITER++)); do
+    ITER_DIR=${OUTPUT_DIR}/iteration_${ITER}
+    mkdir -p ${ITER_DIR}
+    rm -f ${ITER_DIR}/stats_list.txt
+    for SHARD in ${OUTPUT_DIR}/shards/shard_*.txt; do
+        SHARD_NAME=$(basename ${SHARD%.txt})
+        mkdir -p ${ITER_DIR}/${SHARD_NAME}
+        ${HMM_FLAGGER} --input ${COV_FILE} --outputDir ${ITER_DIR}/${SHARD_NAME} --contigsList ${SHARD} \
+            --eStepOnly ${ITER_DIR}/${SHARD_NAME}.stats.bin ${MODEL_OPTION} ${OTHER_OPTIONS} \
+            2> ${ITER_DIR}/${SHARD_NAME}.log &
+        echo ${ITER_DIR}/${SHARD_NAME}.stats.bin >> ${ITER_DIR}/stats_list.txt
+    done
+    wait
+    ${HMM_FLAGGER} --reduceStats ${ITER_DIR}/stats_list.txt --outputDir ${ITER_DIR} ${OTHER_OPTIONS} \
+        2> ${ITER_DIR}/reduce.log
+    MODEL_OPTION="--loadModel ${ITER_DIR}/model_final.bin"
+    echo "Iteration ${ITER}: loglikelihood = $(tail -n1 ${ITER_DIR}/loglikelihood.tsv), converged = $(cat ${ITER_DIR}/converged.txt)"
+    if [ "$(cat ${ITER_DIR}/converged.txt)" == "true" ]; then
+        break
+    fi
+done
+
+# final inference per shard
+FINAL_DIR=${OUTPUT_DIR}/final
+mkdir -p ${FINAL_DIR}
+for SHARD in ${OUTPUT_DIR}/shards/shard_*.txt; do
+    SHARD_NAME=$(basename ${SHARD%.txt})
+    mkdir -p ${FINAL_DIR}/${SHARD_NAME}
+    ${HMM_FLAGGER} --input ${COV_FILE} --outputDir ${FINAL_DIR}/${SHARD_NAME} --contigsList ${SHARD} \
+        ${MODEL_OPTION} ${OTHER_OPTIONS} 2> ${FINAL_DIR}/${SHARD_NAME}.log &
+done
+wait
+cat ${FINAL_DIR}/shard_*/final_flagger_prediction.bed | grep -v "^track" | sort -k1,1 -k2,2n > ${OUTPUT_DIR}/final_flagger_prediction.bed
+echo "Final prediction: ${OUTPUT_DIR}/final_flagger_prediction.bed"